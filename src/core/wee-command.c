@@ -2063,6 +2063,7 @@ command_filter_display (struct t_gui_filter *filter)
 COMMAND_CALLBACK(filter)
 {
     struct t_gui_filter *ptr_filter;
+    int filter_id;
 
     /* make C compiler happy */
     (void) pointer;
@@ -2121,7 +2122,7 @@ COMMAND_CALLBACK(filter)
                     if (!ptr_filter->enabled)
                     {
                         ptr_filter->enabled = 1;
-                        gui_filter_all_buffers ();
+                        gui_filter_apply (ptr_filter);
                         gui_chat_printf_date_tags (NULL, 0,
                                                    GUI_FILTER_TAG_NO_FILTER,
                                                    _("Filter \"%s\" enabled"),
@@ -2176,7 +2177,7 @@ COMMAND_CALLBACK(filter)
                     if (ptr_filter->enabled)
                     {
                         ptr_filter->enabled = 0;
-                        gui_filter_all_buffers ();
+                        gui_filter_unapply (ptr_filter->id);
                         gui_chat_printf_date_tags (NULL, 0,
                                                    GUI_FILTER_TAG_NO_FILTER,
                                                    _("Filter \"%s\" disabled"),
@@ -2226,7 +2227,10 @@ COMMAND_CALLBACK(filter)
                 if (ptr_filter)
                 {
                     ptr_filter->enabled ^= 1;
-                    gui_filter_all_buffers ();
+                    if (ptr_filter->enabled)
+                        gui_filter_apply (ptr_filter);
+                    else
+                        gui_filter_unapply (ptr_filter->id);
                 }
                 else
                 {
@@ -2267,7 +2271,7 @@ COMMAND_CALLBACK(filter)
                                      argv_eol[5]);
         if (ptr_filter)
         {
-            gui_filter_all_buffers ();
+            gui_filter_apply (ptr_filter);
             gui_chat_printf (NULL, "");
             gui_chat_printf_date_tags (NULL, 0, GUI_FILTER_TAG_NO_FILTER,
                                        _("Filter \"%s\" added:"),
@@ -2336,8 +2340,9 @@ COMMAND_CALLBACK(filter)
             ptr_filter = gui_filter_search_by_name (argv[2]);
             if (ptr_filter)
             {
+                filter_id = ptr_filter->id;
                 gui_filter_free (ptr_filter);
-                gui_filter_all_buffers ();
+                gui_filter_unapply (filter_id);
                 gui_chat_printf_date_tags (NULL, 0, GUI_FILTER_TAG_NO_FILTER,
                                            _("Filter \"%s\" deleted"),
                                            argv[2]);
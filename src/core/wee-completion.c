@@ -124,6 +124,8 @@ completion_list_add_buffers_names_cb (const void *pointer, void *data,
                                       struct t_gui_completion *completion)
 {
     struct t_gui_buffer *ptr_buffer;
+    struct t_arraylist *words;
+    char *name;
 
     /* make C compiler happy */
     (void) pointer;
@@ -131,13 +133,26 @@ completion_list_add_buffers_names_cb (const void *pointer, void *data,
     (void) completion_item;
     (void) buffer;
 
-    for (ptr_buffer = gui_buffers; ptr_buffer;
-         ptr_buffer = ptr_buffer->next_buffer)
+    words = gui_completion_cache_get ("buffers_names",
+                                      gui_buffers_generation);
+    if (!words)
     {
-        gui_completion_list_add (completion, ptr_buffer->name,
-                                 0, WEECHAT_LIST_POS_SORT);
+        words = gui_completion_cache_new ("buffers_names",
+                                          gui_buffers_generation);
+        if (!words)
+            return WEECHAT_RC_OK;
+        for (ptr_buffer = gui_buffers; ptr_buffer;
+             ptr_buffer = ptr_buffer->next_buffer)
+        {
+            name = strdup (ptr_buffer->name);
+            if (name)
+                arraylist_add (words, name);
+        }
     }
 
+    gui_completion_list_add_cache (completion, words,
+                                   0, WEECHAT_LIST_POS_SORT);
+
     return WEECHAT_RC_OK;
 }
 
@@ -763,6 +778,7 @@ completion_list_add_config_options_cb (const void *pointer, void *data,
     struct t_config_file *ptr_config;
     struct t_config_section *ptr_section;
     struct t_config_option *ptr_option;
+    struct t_arraylist *words;
     int length;
     char *option_full_name;
 
@@ -772,33 +788,42 @@ completion_list_add_config_options_cb (const void *pointer, void *data,
     (void) completion_item;
     (void) buffer;
 
-    for (ptr_config = config_files; ptr_config;
-         ptr_config = ptr_config->next_config)
+    words = gui_completion_cache_get ("config_options",
+                                      config_file_options_generation);
+    if (!words)
     {
-        for (ptr_section = ptr_config->sections; ptr_section;
-             ptr_section = ptr_section->next_section)
+        words = gui_completion_cache_new ("config_options",
+                                          config_file_options_generation);
+        if (!words)
+            return WEECHAT_RC_OK;
+        for (ptr_config = config_files; ptr_config;
+             ptr_config = ptr_config->next_config)
         {
-            for (ptr_option = ptr_section->options; ptr_option;
-                 ptr_option = ptr_option->next_option)
+            for (ptr_section = ptr_config->sections; ptr_section;
+                 ptr_section = ptr_section->next_section)
             {
-                length = strlen (ptr_config->name) + 1
-                    + strlen (ptr_section->name) + 1
-                    + strlen (ptr_option->name) + 1;
-                option_full_name = malloc (length);
-                if (option_full_name)
+                for (ptr_option = ptr_section->options; ptr_option;
+                     ptr_option = ptr_option->next_option)
                 {
-                    snprintf (option_full_name, length, "%s.%s.%s",
-                              ptr_config->name, ptr_section->name,
-                              ptr_option->name);
-                    gui_completion_list_add (completion,
-                                             option_full_name,
-                                             0, WEECHAT_LIST_POS_SORT);
-                    free (option_full_name);
+                    length = strlen (ptr_config->name) + 1
+                        + strlen (ptr_section->name) + 1
+                        + strlen (ptr_option->name) + 1;
+                    option_full_name = malloc (length);
+                    if (option_full_name)
+                    {
+                        snprintf (option_full_name, length, "%s.%s.%s",
+                                  ptr_config->name, ptr_section->name,
+                                  ptr_option->name);
+                        arraylist_add (words, option_full_name);
+                    }
                 }
             }
         }
     }
 
+    gui_completion_list_add_cache (completion, words,
+                                   0, WEECHAT_LIST_POS_SORT);
+
     return WEECHAT_RC_OK;
 }
 
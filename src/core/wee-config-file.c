@@ -49,6 +49,9 @@
 
 struct t_config_file *config_files = NULL;
 struct t_config_file *last_config_file = NULL;
+unsigned long config_file_options_generation = 0; /* incremented when an   */
+                                                  /* option is added,      */
+                                                  /* renamed or removed    */
 
 char *config_option_type_string[CONFIG_NUM_OPTION_TYPES] =
 { N_("boolean"), N_("integer"), N_("string"), N_("color") };
@@ -532,6 +535,8 @@ config_file_option_insert_in_section (struct t_config_option *option)
     if (!option || !option->section)
         return;
 
+    config_file_options_generation++;
+
     if (option->section->options)
     {
         pos_option = config_file_option_find_pos (option->section,
@@ -2949,6 +2954,7 @@ config_file_option_free (struct t_config_option *option)
     /* remove option from section */
     if (ptr_section)
     {
+        config_file_options_generation++;
         if (ptr_section->last_option == option)
             ptr_section->last_option = option->prev_option;
         if (option->prev_option)
@@ -178,6 +178,7 @@ struct t_config_option *config_look_quote_time_format;
 struct t_config_option *config_look_read_marker;
 struct t_config_option *config_look_read_marker_always_show;
 struct t_config_option *config_look_read_marker_string;
+struct t_config_option *config_look_refresh_max_fps;
 struct t_config_option *config_look_save_config_on_exit;
 struct t_config_option *config_look_save_layout_on_exit;
 struct t_config_option *config_look_scroll_amount;
@@ -275,7 +276,10 @@ struct t_config_option *config_completion_partial_completion_other;
 
 /* config, history section */
 
+struct t_config_option *config_history_compress_buffer_lines_minutes;
+struct t_config_option *config_history_compress_buffer_lines_number;
 struct t_config_option *config_history_display_default;
+struct t_config_option *config_history_index_buffer_lines;
 struct t_config_option *config_history_max_buffer_lines_minutes;
 struct t_config_option *config_history_max_buffer_lines_number;
 struct t_config_option *config_history_max_commands;
@@ -559,6 +563,24 @@ config_change_buffers (const void *pointer, void *data,
     gui_window_ask_refresh (1);
 }
 
+/*
+ * Callback for changes on options that change the height of lines in chat
+ * area (alignment of lines).
+ */
+
+void
+config_change_buffers_lines (const void *pointer, void *data,
+                             struct t_config_option *option)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    gui_window_line_heights_clear_all ();
+    gui_window_ask_refresh (1);
+}
+
 /*
  * Callback for changes on options that require a refresh of content of buffer.
  */
@@ -646,10 +668,54 @@ config_change_buffer_time_format (const void *pointer, void *data,
 
     gui_chat_time_length = gui_chat_get_time_length ();
     gui_chat_change_time_format ();
+    gui_window_line_heights_clear_all ();
     if (gui_init_ok)
         gui_window_ask_refresh (1);
 }
 
+/*
+ * Callback for changes on options "weechat.history.compress_buffer_lines_*".
+ */
+
+void
+config_change_compress_buffer_lines (const void *pointer, void *data,
+                                     struct t_config_option *option)
+{
+    struct t_gui_buffer *ptr_buffer;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    /* compression disabled: uncompress lines of all buffers */
+    if ((CONFIG_INTEGER(config_history_compress_buffer_lines_number) == 0)
+        && (CONFIG_INTEGER(config_history_compress_buffer_lines_minutes) == 0))
+    {
+        for (ptr_buffer = gui_buffers; ptr_buffer;
+             ptr_buffer = ptr_buffer->next_buffer)
+        {
+            gui_line_uncompress (ptr_buffer);
+        }
+    }
+}
+
+/*
+ * Callback for changes on option "weechat.history.index_buffer_lines".
+ */
+
+void
+config_change_index_buffer_lines (const void *pointer, void *data,
+                                  struct t_config_option *option)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    gui_line_index_build_all ();
+}
+
 /*
  * Computes the "prefix_max_length" on all buffers.
  */
@@ -756,6 +822,7 @@ config_change_nick_prefix_suffix (const void *pointer, void *data,
         + gui_chat_strlen_screen (CONFIG_STRING(config_look_nick_suffix));
 
     config_compute_prefix_max_length_all_buffers ();
+    gui_window_line_heights_clear_all ();
     gui_window_ask_refresh (1);
 }
 
@@ -776,6 +843,7 @@ config_change_prefix_same_nick (const void *pointer, void *data,
         gui_chat_strlen_screen (CONFIG_STRING(config_look_prefix_same_nick));
 
     config_compute_prefix_max_length_all_buffers ();
+    gui_window_line_heights_clear_all ();
     gui_window_ask_refresh (1);
 }
 
@@ -837,6 +905,22 @@ config_change_emphasized_attributes (const void *pointer, void *data,
     gui_window_ask_refresh (1);
 }
 
+/*
+ * Callback for changes on option "weechat.look.highlight".
+ */
+
+void
+config_change_highlight (const void *pointer, void *data,
+                         struct t_config_option *option)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    gui_buffer_highlight_matcher_reset_all ();
+}
+
 /*
  * Callback for changes on option "weechat.look.highlight_regex".
  */
@@ -1062,6 +1146,7 @@ config_change_prefix_align_min (const void *pointer, void *data,
     (void) option;
 
     config_compute_prefix_max_length_all_buffers ();
+    gui_window_line_heights_clear_all ();
     gui_window_ask_refresh (1);
 }
 
@@ -1132,6 +1217,7 @@ config_change_tab_width (const void *pointer, void *data,
     memset (config_tab_spaces, ' ', CONFIG_INTEGER(config_look_tab_width));
     config_tab_spaces[CONFIG_INTEGER(config_look_tab_width)] = '\0';
 
+    gui_window_line_heights_clear_all ();
     gui_window_ask_refresh (1);
 }
 
@@ -2457,7 +2543,7 @@ config_weechat_init_options ()
            "message (default))"),
         "time|buffer|prefix|suffix|message", 0, 0, "message", NULL, 0,
         NULL, NULL, NULL,
-        &config_change_buffers, NULL, NULL,
+        &config_change_buffers_lines, NULL, NULL,
         NULL, NULL, NULL);
     config_look_align_multiline_words = config_file_new_option (
         weechat_config_file, ptr_section,
@@ -2467,7 +2553,7 @@ config_weechat_init_options ()
            "will not be aligned, which can be useful to not break long URLs"),
         NULL, 0, 0, "on", NULL, 0,
         NULL, NULL, NULL,
-        &config_change_buffers, NULL, NULL,
+        &config_change_buffers_lines, NULL, NULL,
         NULL, NULL, NULL);
     config_look_bar_more_down = config_file_new_option (
         weechat_config_file, ptr_section,
@@ -2781,7 +2867,9 @@ config_weechat_init_options ()
            "sensitive), words may begin or end with \"*\" for partial match; "
            "example: \"test,(?-i)*toto*,flash*\""),
         NULL, 0, 0, "", NULL, 0,
-        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+        NULL, NULL, NULL,
+        &config_change_highlight, NULL, NULL,
+        NULL, NULL, NULL);
     config_look_highlight_regex = config_file_new_option (
         weechat_config_file, ptr_section,
         "highlight_regex", "string",
@@ -3198,7 +3286,7 @@ config_weechat_init_options ()
         N_("prefix alignment (none, left, right (default))"),
         "none|left|right", 0, 0, "right", NULL, 0,
         NULL, NULL, NULL,
-        &config_change_buffers, NULL, NULL,
+        &config_change_buffers_lines, NULL, NULL,
         NULL, NULL, NULL);
     config_look_prefix_align_max = config_file_new_option (
         weechat_config_file, ptr_section,
@@ -3206,7 +3294,7 @@ config_weechat_init_options ()
         N_("max size for prefix (0 = no max size)"),
         NULL, 0, 128, "0", NULL, 0,
         NULL, NULL, NULL,
-        &config_change_buffers, NULL, NULL,
+        &config_change_buffers_lines, NULL, NULL,
         NULL, NULL, NULL);
     config_look_prefix_align_min = config_file_new_option (
         weechat_config_file, ptr_section,
@@ -3223,7 +3311,7 @@ config_weechat_init_options ()
            "on screen)"),
         NULL, 0, 0, "+", NULL, 0,
         &config_check_prefix_align_more, NULL, NULL,
-        &config_change_buffers, NULL, NULL,
+        &config_change_buffers_lines, NULL, NULL,
         NULL, NULL, NULL);
     config_look_prefix_align_more_after = config_file_new_option (
         weechat_config_file, ptr_section,
@@ -3233,7 +3321,7 @@ config_weechat_init_options ()
            "the truncature char replaces last char of text"),
         NULL, 0, 0, "on", NULL, 0,
         NULL, NULL, NULL,
-        &config_change_buffers, NULL, NULL,
+        &config_change_buffers_lines, NULL, NULL,
         NULL, NULL, NULL);
     config_look_prefix_buffer_align = config_file_new_option (
         weechat_config_file, ptr_section,
@@ -3242,7 +3330,7 @@ config_weechat_init_options ()
            "with same number (none, left, right (default))"),
         "none|left|right", 0, 0, "right", NULL, 0,
         NULL, NULL, NULL,
-        &config_change_buffers, NULL, NULL,
+        &config_change_buffers_lines, NULL, NULL,
         NULL, NULL, NULL);
     config_look_prefix_buffer_align_max = config_file_new_option (
         weechat_config_file, ptr_section,
@@ -3251,7 +3339,7 @@ config_weechat_init_options ()
            "number (0 = no max size)"),
         NULL, 0, 128, "0", NULL, 0,
         NULL, NULL, NULL,
-        &config_change_buffers, NULL, NULL,
+        &config_change_buffers_lines, NULL, NULL,
         NULL, NULL, NULL);
     config_look_prefix_buffer_align_more = config_file_new_option (
         weechat_config_file, ptr_section,
@@ -3260,7 +3348,7 @@ config_weechat_init_options ()
            "merged with same number) (must be exactly one char on screen)"),
         NULL, 0, 0, "+", NULL, 0,
         &config_check_prefix_buffer_align_more, NULL, NULL,
-        &config_change_buffers, NULL, NULL,
+        &config_change_buffers_lines, NULL, NULL,
         NULL, NULL,  NULL);
     config_look_prefix_buffer_align_more_after = config_file_new_option (
         weechat_config_file, ptr_section,
@@ -3270,7 +3358,7 @@ config_weechat_init_options ()
            "the truncature char replaces last char of text"),
         NULL, 0, 0, "on", NULL, 0,
         NULL, NULL, NULL,
-        &config_change_buffers, NULL, NULL,
+        &config_change_buffers_lines, NULL, NULL,
         NULL, NULL, NULL);
     config_look_prefix_same_nick = config_file_new_option (
         weechat_config_file, ptr_section,
@@ -3289,7 +3377,7 @@ config_weechat_init_options ()
         N_("string displayed after prefix"),
         NULL, 0, 0, "|", NULL, 0,
         NULL, NULL, NULL,
-        &config_change_buffers, NULL, NULL,
+        &config_change_buffers_lines, NULL, NULL,
         NULL, NULL, NULL);
     config_look_quote_nick_prefix = config_file_new_option (
         weechat_config_file, ptr_section,
@@ -3335,6 +3423,15 @@ config_weechat_init_options ()
         NULL, NULL, NULL,
         &config_change_read_marker, NULL, NULL,
         NULL, NULL, NULL);
+    config_look_refresh_max_fps = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "refresh_max_fps", "integer",
+        N_("maximum number of screen refreshes per second (0 = no limit): "
+           "when a lot of messages are received, they are displayed "
+           "together at most this number of times per second; the screen "
+           "is always refreshed without delay after a key is pressed"),
+        NULL, 0, 1000, "60", NULL, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
     config_look_save_config_on_exit = config_file_new_option (
         weechat_config_file, ptr_section,
         "save_config_on_exit", "boolean",
@@ -4172,6 +4269,30 @@ config_weechat_init_options ()
         return 0;
     }
 
+    config_history_compress_buffer_lines_minutes = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "compress_buffer_lines_minutes", "integer",
+        N_("compress lines older than this number of minutes in each buffer "
+           "(0 = disable); lines are compressed by blocks and they are "
+           "uncompressed when the buffer is scrolled or searched, or when "
+           "they are read with hdata; lines of merged buffers are never "
+           "compressed"),
+        NULL, 0, INT_MAX, "0", NULL, 0,
+        NULL, NULL, NULL,
+        &config_change_compress_buffer_lines, NULL, NULL,
+        NULL, NULL, NULL);
+    config_history_compress_buffer_lines_number = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "compress_buffer_lines_number", "integer",
+        N_("number of lines kept uncompressed in each buffer, older lines "
+           "are compressed (0 = disable); lines are compressed by blocks and "
+           "they are uncompressed when the buffer is scrolled or searched, "
+           "or when they are read with hdata; lines of merged buffers are "
+           "never compressed"),
+        NULL, 0, INT_MAX, "0", NULL, 0,
+        NULL, NULL, NULL,
+        &config_change_compress_buffer_lines, NULL, NULL,
+        NULL, NULL, NULL);
     config_history_display_default = config_file_new_option (
         weechat_config_file, ptr_section,
         "display_default", "integer",
@@ -4179,6 +4300,17 @@ config_weechat_init_options ()
            "history listing (0 = unlimited)"),
         NULL, 0, INT_MAX, "5", NULL, 0,
         NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    config_history_index_buffer_lines = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "index_buffer_lines", "boolean",
+        N_("index text of lines (prefix and message) in buffers, to speed "
+           "up text search, filters and search of lines by scripts with "
+           "infolist \"buffer_lines\" (the index uses 20 bytes of memory "
+           "per line)"),
+        NULL, 0, 0, "off", NULL, 0,
+        NULL, NULL, NULL,
+        &config_change_index_buffer_lines, NULL, NULL,
+        NULL, NULL, NULL);
     config_history_max_buffer_lines_minutes = config_file_new_option (
         weechat_config_file, ptr_section,
         "max_buffer_lines_minutes", "integer",
@@ -228,6 +228,7 @@ extern struct t_config_option *config_look_quote_time_format;
 extern struct t_config_option *config_look_read_marker;
 extern struct t_config_option *config_look_read_marker_always_show;
 extern struct t_config_option *config_look_read_marker_string;
+extern struct t_config_option *config_look_refresh_max_fps;
 extern struct t_config_option *config_look_save_config_on_exit;
 extern struct t_config_option *config_look_save_layout_on_exit;
 extern struct t_config_option *config_look_scroll_amount;
@@ -319,7 +320,10 @@ extern struct t_config_option *config_completion_partial_completion_command_arg;
 extern struct t_config_option *config_completion_partial_completion_count;
 extern struct t_config_option *config_completion_partial_completion_other;
 
+extern struct t_config_option *config_history_compress_buffer_lines_minutes;
+extern struct t_config_option *config_history_compress_buffer_lines_number;
 extern struct t_config_option *config_history_display_default;
+extern struct t_config_option *config_history_index_buffer_lines;
 extern struct t_config_option *config_history_max_buffer_lines_minutes;
 extern struct t_config_option *config_history_max_buffer_lines_number;
 extern struct t_config_option *config_history_max_commands;
@@ -49,6 +49,13 @@ char *logical_ops[EVAL_NUM_LOGICAL_OPS] =
 char *comparisons[EVAL_NUM_COMPARISONS] =
 { "=~", "!~", "==", "!=", "<=", "<", ">=", ">" };
 
+struct t_hashtable *eval_cache = NULL; /* compiled expressions (key is     */
+                                       /* built with options + expression)  */
+int eval_exec_count = 0;               /* number of evaluations running     */
+struct t_hashtable *eval_pointers = NULL; /* hashtable "pointers" used when */
+                                       /* caller does not give one          */
+int eval_pointers_used = 0;            /* 1 if "eval_pointers" is used      */
+
 
 char *eval_replace_vars (const char *expr, struct t_hashtable *pointers,
                          struct t_hashtable *extra_vars, int extra_vars_eval,
@@ -289,6 +296,153 @@ end:
     return value;
 }
 
+/*
+ * Gets value of an option (format: file.section.option) or a secured data
+ * (format: sec.data.xxx).
+ *
+ * Returns the value, NULL if the option is not found.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+eval_get_option_value (const char *name)
+{
+    struct t_config_option *ptr_option;
+    const char *ptr_value;
+    char str_value[64];
+
+    if (strncmp (name, "sec.data.", 9) == 0)
+    {
+        ptr_value = hashtable_get (secure_hashtable_data, name + 9);
+        return strdup ((ptr_value) ? ptr_value : "");
+    }
+
+    config_file_search_with_string (name, NULL, NULL, &ptr_option, NULL);
+    if (!ptr_option)
+        return NULL;
+
+    if (!ptr_option->value)
+        return strdup ("");
+    switch (ptr_option->type)
+    {
+        case CONFIG_OPTION_TYPE_BOOLEAN:
+            return strdup (CONFIG_BOOLEAN(ptr_option) ? EVAL_STR_TRUE : EVAL_STR_FALSE);
+        case CONFIG_OPTION_TYPE_INTEGER:
+            if (ptr_option->string_values)
+                return strdup (ptr_option->string_values[CONFIG_INTEGER(ptr_option)]);
+            snprintf (str_value, sizeof (str_value),
+                      "%d", CONFIG_INTEGER(ptr_option));
+            return strdup (str_value);
+        case CONFIG_OPTION_TYPE_STRING:
+            return strdup (CONFIG_STRING(ptr_option));
+        case CONFIG_OPTION_TYPE_COLOR:
+            return strdup (gui_color_get_name (CONFIG_COLOR(ptr_option)));
+        case CONFIG_NUM_OPTION_TYPES:
+            break;
+    }
+
+    return strdup ("");
+}
+
+/*
+ * Splits the name of a hdata variable (format: hdata.var1.var2 or
+ * hdata[list].var1.var2 or hdata[ptr].var1.var2) into hdata name, list name
+ * (set to NULL if there is no list) and path (pointer in "text", set to NULL
+ * if there is no path).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (not enough memory)
+ *
+ * Note: hdata_name and list_name must be freed after use.
+ */
+
+int
+eval_split_hdata_name (const char *text, char **hdata_name, char **list_name,
+                       const char **path)
+{
+    const char *pos;
+    char *pos1, *pos2, *tmp;
+
+    *list_name = NULL;
+
+    pos = strchr (text, '.');
+    *hdata_name = (pos > text) ?
+        string_strndup (text, pos - text) : strdup (text);
+    *path = (pos) ? pos + 1 : NULL;
+
+    if (!*hdata_name)
+        return 0;
+
+    pos1 = strchr (*hdata_name, '[');
+    if (pos1 > *hdata_name)
+    {
+        pos2 = strchr (pos1 + 1, ']');
+        if (pos2 > pos1 + 1)
+            *list_name = string_strndup (pos1 + 1, pos2 - pos1 - 1);
+        tmp = string_strndup (*hdata_name, pos1 - *hdata_name);
+        if (tmp)
+        {
+            free (*hdata_name);
+            *hdata_name = tmp;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Gets value of a hdata variable, using name of hdata, optional list
+ * (name of list or pointer "0x..."), and path to the variable.
+ *
+ * If there is no list, the pointer is read in hashtable "pointers" (key is
+ * the hdata name).
+ *
+ * Returns the value, NULL if hdata or pointer is not found.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+eval_get_hdata_value (struct t_hashtable *pointers, const char *hdata_name,
+                      const char *list_name, const char *path)
+{
+    struct t_hdata *hdata;
+    void *pointer;
+    long unsigned int ptr;
+    int rc;
+
+    hdata = hook_hdata_get (NULL, hdata_name);
+    if (!hdata)
+        return NULL;
+
+    pointer = NULL;
+    if (list_name)
+    {
+        if (strncmp (list_name, "0x", 2) == 0)
+        {
+            rc = sscanf (list_name, "%lx", &ptr);
+            if ((rc == EOF) || (rc == 0))
+                return NULL;
+            pointer = (void *)ptr;
+            if (!hdata_check_pointer (hdata, NULL, pointer))
+                return NULL;
+        }
+        else
+            pointer = hdata_get_list (hdata, list_name);
+    }
+
+    if (!pointer)
+    {
+        pointer = hashtable_get (pointers, hdata_name);
+        if (!pointer)
+            return NULL;
+    }
+
+    return eval_hdata_get_value (hdata, pointer, path);
+}
+
 /*
  * Replaces variables, which can be, by order of priority:
  *   1. an extra variable from hashtable "extra_vars"
@@ -319,17 +473,13 @@ eval_replace_vars_cb (void *data, const char *text)
 {
     struct t_hashtable *pointers, *extra_vars;
     struct t_eval_regex *eval_regex;
-    struct t_config_option *ptr_option;
     struct t_gui_buffer *ptr_buffer;
-    char str_value[512], *value, *pos, *pos1, *pos2, *hdata_name, *list_name;
+    char str_value[512], *value, *pos, *pos2, *hdata_name, *list_name;
     char *tmp, *info_name, *hide_char, *hidden_string, *error, *condition;
     const char *prefix, *suffix, *ptr_value, *ptr_arguments, *ptr_string;
-    struct t_hdata *hdata;
-    void *pointer;
     int i, length_hide_char, length, index, rc, extra_vars_eval, screen;
     int count_suffix;
     long number;
-    long unsigned int ptr;
     time_t date;
     struct tm *date_tmp;
 
@@ -610,37 +760,9 @@ eval_replace_vars_cb (void *data, const char *text)
     }
 
     /* 12. option: if found, return this value */
-    if (strncmp (text, "sec.data.", 9) == 0)
-    {
-        ptr_value = hashtable_get (secure_hashtable_data, text + 9);
-        return strdup ((ptr_value) ? ptr_value : "");
-    }
-    else
-    {
-        config_file_search_with_string (text, NULL, NULL, &ptr_option, NULL);
-        if (ptr_option)
-        {
-            if (!ptr_option->value)
-                return strdup ("");
-            switch (ptr_option->type)
-            {
-                case CONFIG_OPTION_TYPE_BOOLEAN:
-                    return strdup (CONFIG_BOOLEAN(ptr_option) ? EVAL_STR_TRUE : EVAL_STR_FALSE);
-                case CONFIG_OPTION_TYPE_INTEGER:
-                    if (ptr_option->string_values)
-                        return strdup (ptr_option->string_values[CONFIG_INTEGER(ptr_option)]);
-                    snprintf (str_value, sizeof (str_value),
-                              "%d", CONFIG_INTEGER(ptr_option));
-                    return strdup (str_value);
-                case CONFIG_OPTION_TYPE_STRING:
-                    return strdup (CONFIG_STRING(ptr_option));
-                case CONFIG_OPTION_TYPE_COLOR:
-                    return strdup (gui_color_get_name (CONFIG_COLOR(ptr_option)));
-                case CONFIG_NUM_OPTION_TYPES:
-                    return strdup ("");
-            }
-        }
-    }
+    value = eval_get_option_value (text);
+    if (value)
+        return value;
 
     /* 13. local variable in buffer */
     ptr_buffer = hashtable_get (pointers, "buffer");
@@ -652,70 +774,10 @@ eval_replace_vars_cb (void *data, const char *text)
     }
 
     /* 14. hdata */
-    value = NULL;
-    hdata_name = NULL;
-    list_name = NULL;
-    pointer = NULL;
-
-    pos = strchr (text, '.');
-    if (pos > text)
-        hdata_name = string_strndup (text, pos - text);
-    else
-        hdata_name = strdup (text);
-
-    if (!hdata_name)
-        goto end;
-
-    pos1 = strchr (hdata_name, '[');
-    if (pos1 > hdata_name)
-    {
-        pos2 = strchr (pos1 + 1, ']');
-        if (pos2 > pos1 + 1)
-        {
-            list_name = string_strndup (pos1 + 1, pos2 - pos1 - 1);
-        }
-        tmp = string_strndup (hdata_name, pos1 - hdata_name);
-        if (tmp)
-        {
-            free (hdata_name);
-            hdata_name = tmp;
-        }
-    }
-
-    hdata = hook_hdata_get (NULL, hdata_name);
-    if (!hdata)
-        goto end;
-
-    if (list_name)
-    {
-        if (strncmp (list_name, "0x", 2) == 0)
-        {
-            rc = sscanf (list_name, "%lx", &ptr);
-            if ((rc != EOF) && (rc != 0))
-            {
-                pointer = (void *)ptr;
-                if (!hdata_check_pointer (hdata, NULL, pointer))
-                    goto end;
-            }
-            else
-                goto end;
-        }
-        else
-            pointer = hdata_get_list (hdata, list_name);
-    }
-
-    if (!pointer)
-    {
-        pointer = hashtable_get (pointers, hdata_name);
-        if (!pointer)
-            goto end;
-    }
-
-    value = eval_hdata_get_value (hdata, pointer, (pos) ? pos + 1 : NULL);
-
-end:
-    if (hdata_name)
-        free (hdata_name);
+    if (!eval_split_hdata_name (text, &hdata_name, &list_name, &ptr_string))
+        return strdup ("");
+    value = eval_get_hdata_value (pointers, hdata_name, list_name, ptr_string);
+    free (hdata_name);
     if (list_name)
         free (list_name);
 
@@ -1206,189 +1268,1192 @@ eval_replace_regex (const char *string, regex_t *regex, const char *replace,
 }
 
 /*
- * Evaluates an expression.
- *
- * The hashtable "pointers" must have string for keys, pointer for values.
- * The hashtable "extra_vars" must have string for keys and values.
- * The hashtable "options" must have string for keys and values.
- *
- * Supported options:
- *   - prefix: change the default prefix before variables to replace ("${")
- *   - suffix: change the default suffix after variables to replace ('}")
- *   - type:
- *       - condition: evaluate as a condition (use operators/parentheses,
- *         return a boolean)
- *
- * If the expression is a condition, it can contain:
- *   - conditions:  ==  != <  <=  >  >=
- *   - logical operators:  &&  ||
- *   - parentheses for priority
- *
- * Examples of simple expression without condition (the [ ] are NOT part of
- * result):
- *   >> ${window.buffer.number}
- *   == [2]
- *   >> buffer:${window.buffer.full_name}
- *   == [buffer:irc.freenode.#weechat]
- *   >> ${window.win_width}
- *   == [112]
- *   >> ${window.win_height}
- *   == [40]
- *
- * Examples of conditions:
- *   >> ${window.buffer.full_name} == irc.freenode.#weechat
- *   == [1]
- *   >> ${window.buffer.full_name} == irc.freenode.#test
- *   == [0]
- *   >> ${window.win_width} >= 30 && ${window.win_height} >= 20
- *   == [1]
+ * Creates a new node for a compiled expression.
  *
- * Note: result must be freed after use (if not NULL).
+ * Returns pointer to new node, NULL if error.
  */
 
-char *
-eval_expression (const char *expr, struct t_hashtable *pointers,
-                 struct t_hashtable *extra_vars, struct t_hashtable *options)
+struct t_eval_node *
+eval_node_new (enum t_eval_node_type type, int op, const char *string)
 {
-    int condition, extra_vars_eval, rc, pointers_allocated, regex_allocated;
-    char *value;
-    const char *prefix, *suffix;
-    const char *default_prefix = EVAL_DEFAULT_PREFIX;
-    const char *default_suffix = EVAL_DEFAULT_SUFFIX;
-    const char *ptr_value, *regex_replace;
-    struct t_gui_window *window;
-    regex_t *regex;
+    struct t_eval_node *new_node;
+    int i;
 
-    if (!expr)
+    new_node = malloc (sizeof (*new_node));
+    if (!new_node)
         return NULL;
 
-    condition = 0;
-    extra_vars_eval = 0;
-    pointers_allocated = 0;
-    regex_allocated = 0;
-    prefix = default_prefix;
-    suffix = default_suffix;
-    regex = NULL;
-    regex_replace = NULL;
-
-    if (pointers)
+    new_node->type = type;
+    new_node->op = op;
+    new_node->string = (string) ? strdup (string) : NULL;
+    new_node->value = NULL;
+    new_node->hdata_name = NULL;
+    new_node->hdata_list = NULL;
+    new_node->hdata_path = NULL;
+    new_node->nodes_count = 0;
+    new_node->nodes = NULL;
+    for (i = 0; i < 3; i++)
     {
-        regex = (regex_t *)hashtable_get (pointers, "regex");
+        new_node->child[i] = NULL;
     }
-    else
+    new_node->regex_string = NULL;
+    new_node->regex = NULL;
+
+    if (string && !new_node->string)
     {
-        /* create hashtable pointers if it's NULL */
-        pointers = hashtable_new (32,
-                                  WEECHAT_HASHTABLE_STRING,
-                                  WEECHAT_HASHTABLE_POINTER,
-                                  NULL,
-                                  NULL);
-        if (!pointers)
-            return NULL;
-        pointers_allocated = 1;
+        free (new_node);
+        return NULL;
     }
 
-    /*
-     * set window/buffer with pointer to current window/buffer
-     * (if not already defined in the hashtable)
-     */
-    if (gui_current_window)
+    return new_node;
+}
+
+/*
+ * Frees a node of a compiled expression (and its sub-nodes).
+ */
+
+void
+eval_node_free (struct t_eval_node *node)
+{
+    int i;
+
+    if (!node)
+        return;
+
+    if (node->string)
+        free (node->string);
+    if (node->value)
+        free (node->value);
+    if (node->hdata_name)
+        free (node->hdata_name);
+    if (node->hdata_list)
+        free (node->hdata_list);
+    for (i = 0; i < node->nodes_count; i++)
     {
-        if (!hashtable_has_key (pointers, "window"))
-            hashtable_set (pointers, "window", gui_current_window);
-        if (!hashtable_has_key (pointers, "buffer"))
-        {
-            window = (struct t_gui_window *)hashtable_get (pointers, "window");
-            if (window)
-                hashtable_set (pointers, "buffer", window->buffer);
-        }
+        eval_node_free (node->nodes[i]);
     }
-
-    /* read options */
-    if (options)
+    if (node->nodes)
+        free (node->nodes);
+    for (i = 0; i < 3; i++)
     {
-        /* check the type of evaluation */
-        ptr_value = hashtable_get (options, "type");
-        if (ptr_value && (strcmp (ptr_value, "condition") == 0))
-            condition = 1;
+        eval_node_free (node->child[i]);
+    }
+    if (node->regex_string)
+        free (node->regex_string);
+    if (node->regex)
+    {
+        regfree (node->regex);
+        free (node->regex);
+    }
 
-        /* check if extra vars must be evaluated */
-        ptr_value = hashtable_get (options, "extra");
-        if (ptr_value && (strcmp (ptr_value, "eval") == 0))
-            extra_vars_eval = 1;
+    free (node);
+}
 
-        /* check for custom prefix */
-        ptr_value = hashtable_get (options, "prefix");
-        if (ptr_value && ptr_value[0])
-            prefix = ptr_value;
+/*
+ * Adds a node at the end of a template.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (the node is freed)
+ */
 
-        /* check for custom suffix */
-        ptr_value = hashtable_get (options, "suffix");
-        if (ptr_value && ptr_value[0])
-            suffix = ptr_value;
+int
+eval_node_template_add (struct t_eval_node *template,
+                        struct t_eval_node *node)
+{
+    struct t_eval_node **new_nodes;
 
-        /* check for regex */
-        ptr_value = hashtable_get (options, "regex");
-        if (ptr_value)
-        {
-            regex = malloc (sizeof (*regex));
-            if (string_regcomp (regex, ptr_value,
-                                REG_EXTENDED | REG_ICASE) == 0)
-            {
-                regex_allocated = 1;
-            }
+    if (!node)
+        return 0;
+
+    new_nodes = realloc (template->nodes,
+                         (template->nodes_count + 1) * sizeof (*new_nodes));
+    if (!new_nodes)
+    {
+        eval_node_free (node);
+        return 0;
+    }
+    template->nodes = new_nodes;
+    template->nodes[template->nodes_count] = node;
+    template->nodes_count++;
+
+    return 1;
+}
+
+struct t_eval_node *eval_compile_condition (const char *expr,
+                                            const char *prefix,
+                                            const char *suffix);
+struct t_eval_node *eval_compile_template (const char *expr,
+                                           const char *prefix,
+                                           const char *suffix);
+
+/*
+ * Compiles a variable with a fixed name: the type of variable is checked
+ * once for all (in same order as function eval_replace_vars_cb), and the
+ * value is computed now if it does not depend on context.
+ *
+ * Returns pointer to node, NULL if error.
+ */
+
+struct t_eval_node *
+eval_compile_var (const char *name, const char *prefix, const char *suffix)
+{
+    struct t_eval_node *node;
+    const void *ptr[6];
+    const char *pos, *pos2;
+    char *condition, *tmp;
+    int extra_vars_eval;
+
+    node = eval_node_new (EVAL_NODE_VAR, EVAL_VAR_OTHER, name);
+    if (!node)
+        return NULL;
+
+    if (strncmp (name, "eval:", 5) == 0)
+    {
+        node->op = EVAL_VAR_EVAL;
+        node->child[0] = eval_compile_template (name + 5, prefix, suffix);
+        if (!node->child[0])
+            goto error;
+    }
+    else if ((strncmp (name, "esc:", 4) == 0)
+             || ((name[0] == '\\') && name[1] && (name[1] != '\\'))
+             || (strncmp (name, "hide:", 5) == 0)
+             || (strncmp (name, "cut:", 4) == 0)
+             || (strncmp (name, "cutscr:", 7) == 0))
+    {
+        /* value depends only on name */
+        node->op = EVAL_VAR_CONSTANT;
+        extra_vars_eval = 0;
+        ptr[0] = NULL;
+        ptr[1] = NULL;
+        ptr[2] = &extra_vars_eval;
+        ptr[3] = prefix;
+        ptr[4] = suffix;
+        ptr[5] = NULL;
+        node->value = eval_replace_vars_cb (ptr, name);
+        if (!node->value)
+            goto error;
+    }
+    else if ((strncmp (name, "re:", 3) == 0)
+             || (strncmp (name, "color:", 6) == 0)
+             || (strncmp (name, "info:", 5) == 0)
+             || ((strncmp (name, "date", 4) == 0)
+                 && (!name[4] || (name[4] == ':')))
+             || (strncmp (name, "env:", 4) == 0))
+    {
+        node->op = EVAL_VAR_OTHER;
+    }
+    else if (strncmp (name, "if:", 3) == 0)
+    {
+        node->op = EVAL_VAR_IF;
+        pos = eval_strstr_level (name + 3, "?", prefix, suffix, 1);
+        pos2 = (pos) ? eval_strstr_level (pos + 1, ":", prefix, suffix, 1) : NULL;
+        condition = (pos) ?
+            strndup (name + 3, pos - (name + 3)) : strdup (name + 3);
+        if (!condition)
+            goto error;
+        node->child[0] = eval_compile_condition (condition, prefix, suffix);
+        free (condition);
+        if (!node->child[0])
+            goto error;
+        if (pos)
+        {
+            tmp = (pos2) ?
+                strndup (pos + 1, pos2 - pos - 1) : strdup (pos + 1);
+            if (!tmp)
+                goto error;
+            node->child[1] = eval_compile_template (tmp, prefix, suffix);
+            free (tmp);
+            if (!node->child[1])
+                goto error;
+        }
+        if (pos2)
+        {
+            node->child[2] = eval_compile_template (pos2 + 1, prefix, suffix);
+            if (!node->child[2])
+                goto error;
+        }
+    }
+    else if (strncmp (name, "sec.data.", 9) == 0)
+    {
+        node->op = EVAL_VAR_OTHER;
+    }
+    else
+    {
+        /* option, local variable or hdata: split hdata name now */
+        node->op = EVAL_VAR_NAME;
+        if (!eval_split_hdata_name (node->string, &node->hdata_name,
+                                    &node->hdata_list, &node->hdata_path))
+        {
+            goto error;
+        }
+    }
+
+    return node;
+
+error:
+    eval_node_free (node);
+    return NULL;
+}
+
+/*
+ * Compiles a string with variables (same parsing as function
+ * string_replace_with_callback called by eval_replace_vars).
+ *
+ * Returns pointer to node, NULL if error.
+ */
+
+struct t_eval_node *
+eval_compile_template (const char *expr, const char *prefix,
+                       const char *suffix)
+{
+    struct t_eval_node *template, *node;
+    const char *ptr_expr, *pos_end_name;
+    char *text, *name;
+    int length_prefix, length_suffix, length_text, sub_count, sub_level;
+
+    template = eval_node_new (EVAL_NODE_TEMPLATE, 0, NULL);
+    if (!template)
+        return NULL;
+
+    text = malloc (strlen (expr) + 1);
+    if (!text)
+        goto error;
+    length_text = 0;
+
+    length_prefix = strlen (prefix);
+    length_suffix = strlen (suffix);
+
+    ptr_expr = expr;
+    while (ptr_expr[0])
+    {
+        if ((ptr_expr[0] == '\\') && (ptr_expr[1] == prefix[0]))
+        {
+            text[length_text++] = ptr_expr[1];
+            ptr_expr += 2;
+        }
+        else if (strncmp (ptr_expr, prefix, length_prefix) == 0)
+        {
+            sub_count = 0;
+            sub_level = 0;
+            pos_end_name = ptr_expr + length_prefix;
+            while (pos_end_name[0])
+            {
+                if (strncmp (pos_end_name, suffix, length_suffix) == 0)
+                {
+                    if (sub_level == 0)
+                        break;
+                    sub_level--;
+                }
+                if ((pos_end_name[0] == '\\')
+                    && (pos_end_name[1] == prefix[0]))
+                {
+                    pos_end_name++;
+                }
+                else if (strncmp (pos_end_name, prefix, length_prefix) == 0)
+                {
+                    sub_count++;
+                    sub_level++;
+                }
+                pos_end_name++;
+            }
+            /* prefix without matching suffix: end of string */
+            if (!pos_end_name[0])
+                break;
+            if (length_text > 0)
+            {
+                text[length_text] = '\0';
+                if (!eval_node_template_add (
+                        template, eval_node_new (EVAL_NODE_TEXT, 0, text)))
+                {
+                    goto error;
+                }
+                length_text = 0;
+            }
+            name = string_strndup (ptr_expr + length_prefix,
+                                   pos_end_name - (ptr_expr + length_prefix));
+            if (!name)
+                goto error;
+            if ((sub_count > 0) && (strncmp (name, "if:", 3) != 0))
+            {
+                /* name of variable contains variables */
+                node = eval_node_new (EVAL_NODE_VAR_DYNAMIC, 0, NULL);
+                if (node)
+                {
+                    node->child[0] = eval_compile_template (name, prefix,
+                                                            suffix);
+                    if (!node->child[0])
+                    {
+                        eval_node_free (node);
+                        node = NULL;
+                    }
+                }
+            }
             else
             {
-                free (regex);
-                regex = NULL;
+                node = eval_compile_var (name, prefix, suffix);
+            }
+            free (name);
+            if (!eval_node_template_add (template, node))
+                goto error;
+            ptr_expr = pos_end_name + length_suffix;
+        }
+        else
+        {
+            text[length_text++] = (ptr_expr++)[0];
+        }
+    }
+
+    text[length_text] = '\0';
+
+    /* only text: return a single text node */
+    if (template->nodes_count == 0)
+    {
+        node = eval_node_new (EVAL_NODE_TEXT, 0, text);
+        free (text);
+        eval_node_free (template);
+        return node;
+    }
+
+    if ((length_text > 0)
+        && !eval_node_template_add (template,
+                                    eval_node_new (EVAL_NODE_TEXT, 0, text)))
+    {
+        goto error;
+    }
+    free (text);
+
+    return template;
+
+error:
+    if (text)
+        free (text);
+    eval_node_free (template);
+    return NULL;
+}
+
+/*
+ * Compiles a condition (same parsing as function eval_expression_condition):
+ * logical operators and comparisons are split once for all.
+ *
+ * Sub-expressions between parentheses followed by other text are kept as
+ * string and evaluated with function eval_expression_condition (the value of
+ * sub-expression is part of the string evaluated then).
+ *
+ * Returns pointer to node, NULL if error.
+ */
+
+struct t_eval_node *
+eval_compile_condition (const char *expr, const char *prefix,
+                        const char *suffix)
+{
+    struct t_eval_node *node;
+    int logic, comp, level;
+    const char *pos, *pos_end;
+    char *expr2, *sub_expr;
+
+    node = NULL;
+    sub_expr = NULL;
+
+    /* skip spaces at beginning of string */
+    while (expr[0] == ' ')
+    {
+        expr++;
+    }
+    if (!expr[0])
+        return eval_node_new (EVAL_NODE_TEXT, 0, expr);
+
+    /* skip spaces at end of string */
+    pos_end = expr + strlen (expr) - 1;
+    while ((pos_end > expr) && (pos_end[0] == ' '))
+    {
+        pos_end--;
+    }
+
+    expr2 = string_strndup (expr, pos_end + 1 - expr);
+    if (!expr2)
+        return NULL;
+
+    /* search for a logical operator */
+    for (logic = 0; logic < EVAL_NUM_LOGICAL_OPS; logic++)
+    {
+        pos = eval_strstr_level (expr2, logical_ops[logic], "(", ")", 0);
+        if (pos > expr2)
+        {
+            pos_end = pos - 1;
+            while ((pos_end > expr2) && (pos_end[0] == ' '))
+            {
+                pos_end--;
+            }
+            sub_expr = string_strndup (expr2, pos_end + 1 - expr2);
+            if (!sub_expr)
+                goto error;
+            pos += strlen (logical_ops[logic]);
+            while (pos[0] == ' ')
+            {
+                pos++;
+            }
+            node = eval_node_new (EVAL_NODE_LOGICAL, logic, NULL);
+            if (!node)
+                goto error;
+            node->child[0] = eval_compile_condition (sub_expr, prefix, suffix);
+            node->child[1] = eval_compile_condition (pos, prefix, suffix);
+            if (!node->child[0] || !node->child[1])
+                goto error;
+            goto end;
+        }
+    }
+
+    /* search for a comparison */
+    for (comp = 0; comp < EVAL_NUM_COMPARISONS; comp++)
+    {
+        pos = eval_strstr_level (expr2, comparisons[comp], "(", ")", 0);
+        if (pos > expr2)
+        {
+            pos_end = pos - 1;
+            while ((pos_end > expr2) && (pos_end[0] == ' '))
+            {
+                pos_end--;
+            }
+            sub_expr = string_strndup (expr2, pos_end + 1 - expr2);
+            if (!sub_expr)
+                goto error;
+            pos += strlen (comparisons[comp]);
+            while (pos[0] == ' ')
+            {
+                pos++;
+            }
+            node = eval_node_new (EVAL_NODE_COMPARE, comp, NULL);
+            if (!node)
+                goto error;
+            if ((comp == EVAL_COMPARE_REGEX_MATCHING)
+                || (comp == EVAL_COMPARE_REGEX_NOT_MATCHING))
+            {
+                /* for regex: just replace vars in both expressions */
+                node->child[0] = eval_compile_template (sub_expr, prefix,
+                                                        suffix);
+                node->child[1] = eval_compile_template (pos, prefix, suffix);
+            }
+            else
+            {
+                /* other comparison: fully evaluate both expressions */
+                node->child[0] = eval_compile_condition (sub_expr, prefix,
+                                                         suffix);
+                node->child[1] = eval_compile_condition (pos, prefix, suffix);
+            }
+            if (!node->child[0] || !node->child[1])
+                goto error;
+            goto end;
+        }
+    }
+
+    /* sub-expression between parentheses */
+    if (expr2[0] == '(')
+    {
+        level = 0;
+        pos = expr2 + 1;
+        while (pos[0])
+        {
+            if (pos[0] == '(')
+                level++;
+            else if (pos[0] == ')')
+            {
+                if (level == 0)
+                    break;
+                level--;
+            }
+            pos++;
+        }
+        if ((pos[0] == ')') && !pos[1])
+        {
+            /* nothing around parentheses: compile the sub-expression */
+            sub_expr = string_strndup (expr2 + 1, pos - expr2 - 1);
+            if (!sub_expr)
+                goto error;
+            node = eval_compile_condition (sub_expr, prefix, suffix);
+            goto end;
+        }
+        node = eval_node_new (EVAL_NODE_CONDITION, 0, expr2);
+        goto end;
+    }
+
+    /* no logical operator neither comparison: just replace variables */
+    node = eval_compile_template (expr2, prefix, suffix);
+    goto end;
+
+error:
+    eval_node_free (node);
+    node = NULL;
+
+end:
+    free (expr2);
+    if (sub_expr)
+        free (sub_expr);
+
+    return node;
+}
+
+char *eval_node_exec (struct t_eval_node *node, const void **data);
+
+/*
+ * Evaluates a variable with a fixed name.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+eval_node_exec_var (struct t_eval_node *node, const void **data)
+{
+    struct t_hashtable *pointers, *extra_vars;
+    struct t_gui_buffer *ptr_buffer;
+    const char *ptr_value;
+    char *value;
+    int rc;
+
+    pointers = (struct t_hashtable *)data[0];
+    extra_vars = (struct t_hashtable *)data[1];
+
+    /* extra variables have higher priority */
+    if (extra_vars && hashtable_get (extra_vars, node->string))
+        return eval_replace_vars_cb ((void *)data, node->string);
+
+    switch (node->op)
+    {
+        case EVAL_VAR_CONSTANT:
+            return strdup (node->value);
+        case EVAL_VAR_EVAL:
+            return eval_node_exec (node->child[0], data);
+        case EVAL_VAR_IF:
+            value = eval_node_exec (node->child[0], data);
+            rc = eval_is_true (value);
+            if (value)
+                free (value);
+            if (rc)
+            {
+                value = (node->child[1]) ?
+                    eval_node_exec (node->child[1], data) :
+                    strdup (EVAL_STR_TRUE);
+            }
+            else
+            {
+                value = (node->child[2]) ?
+                    eval_node_exec (node->child[2], data) :
+                    ((node->child[1]) ? NULL : strdup (EVAL_STR_FALSE));
+            }
+            return (value) ? value : strdup ("");
+        case EVAL_VAR_NAME:
+            value = eval_get_option_value (node->string);
+            if (value)
+                return value;
+            ptr_buffer = hashtable_get (pointers, "buffer");
+            if (ptr_buffer)
+            {
+                ptr_value = hashtable_get (ptr_buffer->local_variables,
+                                           node->string);
+                if (ptr_value)
+                    return strdup (ptr_value);
+            }
+            value = eval_get_hdata_value (pointers, node->hdata_name,
+                                          node->hdata_list, node->hdata_path);
+            return (value) ? value : strdup ("");
+        default:
+            break;
+    }
+
+    return eval_replace_vars_cb ((void *)data, node->string);
+}
+
+/*
+ * Evaluates a comparison with a regex: the regex is compiled only if it is
+ * different from the last one compiled in this node.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+eval_node_compare_regex (struct t_eval_node *node, const char *string,
+                         const char *regex)
+{
+    int rc;
+
+    rc = 0;
+
+    if (!string || !regex)
+        goto end;
+
+    if (!node->regex_string || (strcmp (node->regex_string, regex) != 0))
+    {
+        if (node->regex_string)
+            free (node->regex_string);
+        if (node->regex)
+        {
+            regfree (node->regex);
+            free (node->regex);
+        }
+        node->regex_string = strdup (regex);
+        node->regex = (node->regex_string) ?
+            malloc (sizeof (*node->regex)) : NULL;
+        if (node->regex
+            && (string_regcomp (node->regex, regex,
+                                REG_EXTENDED | REG_ICASE | REG_NOSUB) != 0))
+        {
+            free (node->regex);
+            node->regex = NULL;
+        }
+    }
+
+    if (!node->regex)
+        goto end;
+
+    rc = (regexec (node->regex, string, 0, NULL, 0) == 0) ? 1 : 0;
+    if (node->op == EVAL_COMPARE_REGEX_NOT_MATCHING)
+        rc ^= 1;
+
+end:
+    return strdup ((rc) ? EVAL_STR_TRUE : EVAL_STR_FALSE);
+}
+
+/*
+ * Evaluates a node of a compiled expression.
+ *
+ * Argument "data" contains the same pointers as the data given to function
+ * eval_replace_vars_cb.
+ *
+ * Note: result must be freed after use (if not NULL).
+ */
+
+char *
+eval_node_exec (struct t_eval_node *node, const void **data)
+{
+    char **result, *value, *value2, *result_compare;
+    int i, rc;
+
+    switch (node->type)
+    {
+        case EVAL_NODE_TEXT:
+            return strdup (node->string);
+        case EVAL_NODE_TEMPLATE:
+            result = string_dyn_alloc (64);
+            if (!result)
+                return NULL;
+            for (i = 0; i < node->nodes_count; i++)
+            {
+                value = eval_node_exec (node->nodes[i], data);
+                if (value)
+                {
+                    string_dyn_concat (result, value);
+                    free (value);
+                }
+            }
+            return string_dyn_free (result, 0);
+        case EVAL_NODE_VAR:
+            return eval_node_exec_var (node, data);
+        case EVAL_NODE_VAR_DYNAMIC:
+            value = eval_node_exec (node->child[0], data);
+            value2 = eval_replace_vars_cb ((void *)data,
+                                           (value) ? value : "");
+            if (value)
+                free (value);
+            return value2;
+        case EVAL_NODE_LOGICAL:
+            value = eval_node_exec (node->child[0], data);
+            rc = eval_is_true (value);
+            if (value)
+                free (value);
+            if ((!rc && (node->op == EVAL_LOGICAL_OP_AND))
+                || (rc && (node->op == EVAL_LOGICAL_OP_OR)))
+            {
+                return strdup ((rc) ? EVAL_STR_TRUE : EVAL_STR_FALSE);
+            }
+            value = eval_node_exec (node->child[1], data);
+            rc = eval_is_true (value);
+            if (value)
+                free (value);
+            return strdup ((rc) ? EVAL_STR_TRUE : EVAL_STR_FALSE);
+        case EVAL_NODE_COMPARE:
+            value = eval_node_exec (node->child[0], data);
+            value2 = eval_node_exec (node->child[1], data);
+            result_compare = ((node->op == EVAL_COMPARE_REGEX_MATCHING)
+                              || (node->op == EVAL_COMPARE_REGEX_NOT_MATCHING)) ?
+                eval_node_compare_regex (node, value, value2) :
+                eval_compare (value, node->op, value2);
+            if (value)
+                free (value);
+            if (value2)
+                free (value2);
+            return result_compare;
+        case EVAL_NODE_CONDITION:
+            return eval_expression_condition (
+                node->string,
+                (struct t_hashtable *)data[0],
+                (struct t_hashtable *)data[1],
+                *((int *)data[2]),
+                (const char *)data[3],
+                (const char *)data[4]);
+        case EVAL_NUM_NODE_TYPES:
+            break;
+    }
+
+    return NULL;
+}
+
+/*
+ * Compiles an expression.
+ *
+ * The hashtable "options" is the same as in function eval_expression.
+ *
+ * The compiled expression can be evaluated many times with function
+ * eval_compiled_exec (with different pointers and extra variables), and must
+ * be freed by a call to eval_compiled_free.
+ *
+ * Returns pointer to compiled expression, NULL if error.
+ */
+
+struct t_eval_compiled *
+eval_compile (const char *expr, struct t_hashtable *options)
+{
+    struct t_eval_compiled *new_compiled;
+    const char *ptr_value;
+
+    if (!expr)
+        return NULL;
+
+    new_compiled = malloc (sizeof (*new_compiled));
+    if (!new_compiled)
+        return NULL;
+
+    new_compiled->condition = 0;
+    new_compiled->extra_vars_eval = 0;
+    new_compiled->prefix = NULL;
+    new_compiled->suffix = NULL;
+    new_compiled->regex_option = 0;
+    new_compiled->regex = NULL;
+    new_compiled->regex_replace = NULL;
+    new_compiled->expr = strdup (expr);
+    new_compiled->node = NULL;
+
+    /* read options */
+    if (options)
+    {
+        /* check the type of evaluation */
+        ptr_value = hashtable_get (options, "type");
+        if (ptr_value && (strcmp (ptr_value, "condition") == 0))
+            new_compiled->condition = 1;
+
+        /* check if extra vars must be evaluated */
+        ptr_value = hashtable_get (options, "extra");
+        if (ptr_value && (strcmp (ptr_value, "eval") == 0))
+            new_compiled->extra_vars_eval = 1;
+
+        /* check for custom prefix */
+        ptr_value = hashtable_get (options, "prefix");
+        if (ptr_value && ptr_value[0])
+            new_compiled->prefix = strdup (ptr_value);
+
+        /* check for custom suffix */
+        ptr_value = hashtable_get (options, "suffix");
+        if (ptr_value && ptr_value[0])
+            new_compiled->suffix = strdup (ptr_value);
+
+        /* check for regex */
+        ptr_value = hashtable_get (options, "regex");
+        if (ptr_value)
+        {
+            new_compiled->regex_option = 1;
+            new_compiled->regex = malloc (sizeof (*new_compiled->regex));
+            if (new_compiled->regex
+                && (string_regcomp (new_compiled->regex, ptr_value,
+                                    REG_EXTENDED | REG_ICASE) != 0))
+            {
+                free (new_compiled->regex);
+                new_compiled->regex = NULL;
             }
         }
 
         /* check for regex replacement (evaluated later) */
         ptr_value = hashtable_get (options, "regex_replace");
         if (ptr_value)
+            new_compiled->regex_replace = strdup (ptr_value);
+    }
+
+    if (!new_compiled->prefix)
+        new_compiled->prefix = strdup (EVAL_DEFAULT_PREFIX);
+    if (!new_compiled->suffix)
+        new_compiled->suffix = strdup (EVAL_DEFAULT_SUFFIX);
+
+    if (!new_compiled->expr || !new_compiled->prefix || !new_compiled->suffix)
+        goto error;
+
+    /* compile expression */
+    if (new_compiled->condition)
+    {
+        new_compiled->node = eval_compile_condition (new_compiled->expr,
+                                                     new_compiled->prefix,
+                                                     new_compiled->suffix);
+    }
+    else
+    {
+        /*
+         * the expression is always compiled as template, even with a regex
+         * replacement: the regex may be NULL on evaluation (if given in
+         * hashtable "pointers")
+         */
+        new_compiled->node = eval_compile_template (new_compiled->expr,
+                                                    new_compiled->prefix,
+                                                    new_compiled->suffix);
+    }
+    if (!new_compiled->node)
+        goto error;
+
+    return new_compiled;
+
+error:
+    eval_compiled_free (new_compiled);
+    return NULL;
+}
+
+/*
+ * Evaluates a compiled expression.
+ *
+ * The hashtables "pointers" and "extra_vars" are the same as in function
+ * eval_expression.
+ *
+ * Note: result must be freed after use (if not NULL).
+ */
+
+char *
+eval_compiled_exec (struct t_eval_compiled *compiled,
+                    struct t_hashtable *pointers,
+                    struct t_hashtable *extra_vars)
+{
+    int rc, pointers_allocated, pointers_shared;
+    char *value;
+    const void *ptr[6];
+    struct t_gui_window *window;
+    regex_t *regex;
+
+    if (!compiled)
+        return NULL;
+
+    pointers_allocated = 0;
+    pointers_shared = 0;
+    regex = NULL;
+
+    if (pointers)
+    {
+        regex = (regex_t *)hashtable_get (pointers, "regex");
+    }
+    else if (!eval_pointers_used
+             && (eval_pointers
+                 || (eval_pointers = hashtable_new (32,
+                                                    WEECHAT_HASHTABLE_STRING,
+                                                    WEECHAT_HASHTABLE_POINTER,
+                                                    NULL,
+                                                    NULL))))
+    {
+        /* use hashtable pointers kept for next evaluations */
+        hashtable_remove_all (eval_pointers);
+        pointers = eval_pointers;
+        eval_pointers_used = 1;
+        pointers_shared = 1;
+    }
+    else
+    {
+        /* create hashtable pointers (evaluation inside another one) */
+        pointers = hashtable_new (32,
+                                  WEECHAT_HASHTABLE_STRING,
+                                  WEECHAT_HASHTABLE_POINTER,
+                                  NULL,
+                                  NULL);
+        if (!pointers)
+            return NULL;
+        pointers_allocated = 1;
+    }
+
+    /*
+     * set window/buffer with pointer to current window/buffer
+     * (if not already defined in the hashtable)
+     */
+    if (gui_current_window)
+    {
+        if (!hashtable_has_key (pointers, "window"))
+            hashtable_set (pointers, "window", gui_current_window);
+        if (!hashtable_has_key (pointers, "buffer"))
         {
-            regex_replace = ptr_value;
+            window = (struct t_gui_window *)hashtable_get (pointers, "window");
+            if (window)
+                hashtable_set (pointers, "buffer", window->buffer);
         }
     }
 
-    /* evaluate expression */
-    if (condition)
+    /* regex given in options has higher priority */
+    if (compiled->regex_option)
+        regex = compiled->regex;
+
+    eval_exec_count++;
+
+    if (compiled->condition)
     {
         /* evaluate as condition (return a boolean: "0" or "1") */
-        value = eval_expression_condition (expr, pointers,
-                                           extra_vars, extra_vars_eval,
-                                           prefix, suffix);
+        ptr[0] = pointers;
+        ptr[1] = extra_vars;
+        ptr[2] = &compiled->extra_vars_eval;
+        ptr[3] = compiled->prefix;
+        ptr[4] = compiled->suffix;
+        ptr[5] = NULL;
+        value = eval_node_exec (compiled->node, ptr);
         rc = eval_is_true (value);
         if (value)
             free (value);
         value = strdup ((rc) ? EVAL_STR_TRUE : EVAL_STR_FALSE);
     }
+    else if (regex && compiled->regex_replace)
+    {
+        /* replace with regex */
+        value = eval_replace_regex (compiled->expr, regex,
+                                    compiled->regex_replace,
+                                    pointers, extra_vars,
+                                    compiled->extra_vars_eval,
+                                    compiled->prefix, compiled->suffix);
+    }
     else
     {
-        if (regex && regex_replace)
+        /* only replace variables in expression */
+        ptr[0] = pointers;
+        ptr[1] = extra_vars;
+        ptr[2] = &compiled->extra_vars_eval;
+        ptr[3] = compiled->prefix;
+        ptr[4] = compiled->suffix;
+        ptr[5] = NULL;
+        value = eval_node_exec (compiled->node, ptr);
+    }
+
+    eval_exec_count--;
+
+    if (pointers_allocated)
+        hashtable_free (pointers);
+    if (pointers_shared)
+    {
+        hashtable_remove_all (eval_pointers);
+        eval_pointers_used = 0;
+    }
+
+    return value;
+}
+
+/*
+ * Frees a compiled expression.
+ */
+
+void
+eval_compiled_free (struct t_eval_compiled *compiled)
+{
+    if (!compiled)
+        return;
+
+    if (compiled->prefix)
+        free (compiled->prefix);
+    if (compiled->suffix)
+        free (compiled->suffix);
+    if (compiled->regex)
+    {
+        regfree (compiled->regex);
+        free (compiled->regex);
+    }
+    if (compiled->regex_replace)
+        free (compiled->regex_replace);
+    if (compiled->expr)
+        free (compiled->expr);
+    eval_node_free (compiled->node);
+
+    free (compiled);
+}
+
+/*
+ * Callback called to free a compiled expression in cache.
+ */
+
+void
+eval_cache_free_value_cb (struct t_hashtable *hashtable,
+                          const void *key, void *value)
+{
+    /* make C compiler happy */
+    (void) hashtable;
+    (void) key;
+
+    eval_compiled_free ((struct t_eval_compiled *)value);
+}
+
+/*
+ * Builds the key of a compiled expression in cache: options that change the
+ * compiled expression are part of the key.
+ *
+ * Note: result must be freed after use with string_dyn_free.
+ */
+
+char **
+eval_cache_key (const char *expr, struct t_hashtable *options)
+{
+    const char *option_names[] = { "prefix", "suffix", "regex",
+                                   "regex_replace", NULL };
+    const char *ptr_value;
+    char **key, str_length[32];
+    int i;
+
+    key = string_dyn_alloc (64);
+    if (!key)
+        return NULL;
+
+    ptr_value = (options) ? hashtable_get (options, "type") : NULL;
+    string_dyn_concat (
+        key, (ptr_value && (strcmp (ptr_value, "condition") == 0)) ? "c" : "-");
+    ptr_value = (options) ? hashtable_get (options, "extra") : NULL;
+    string_dyn_concat (
+        key, (ptr_value && (strcmp (ptr_value, "eval") == 0)) ? "e" : "-");
+
+    for (i = 0; option_names[i]; i++)
+    {
+        ptr_value = (options) ? hashtable_get (options, option_names[i]) : NULL;
+        /* empty prefix/suffix is ignored (default is used) */
+        if (ptr_value && !ptr_value[0] && (i < 2))
+            ptr_value = NULL;
+        if (ptr_value)
         {
-            /* replace with regex */
-            value = eval_replace_regex (expr, regex, regex_replace,
-                                        pointers, extra_vars, extra_vars_eval,
-                                        prefix, suffix);
+            snprintf (str_length, sizeof (str_length),
+                      "%d:", (int)strlen (ptr_value));
+            string_dyn_concat (key, str_length);
+            string_dyn_concat (key, ptr_value);
         }
         else
         {
-            /* only replace variables in expression */
-            value = eval_replace_vars (expr, pointers,
-                                       extra_vars, extra_vars_eval,
-                                       prefix, suffix, NULL);
+            string_dyn_concat (key, "-");
         }
     }
 
-    if (pointers_allocated)
-        hashtable_free (pointers);
-    if (regex && regex_allocated)
+    string_dyn_concat (key, expr);
+
+    return key;
+}
+
+/*
+ * Evaluates an expression.
+ *
+ * The hashtable "pointers" must have string for keys, pointer for values.
+ * The hashtable "extra_vars" must have string for keys and values.
+ * The hashtable "options" must have string for keys and values.
+ *
+ * Supported options:
+ *   - prefix: change the default prefix before variables to replace ("${")
+ *   - suffix: change the default suffix after variables to replace ('}")
+ *   - type:
+ *       - condition: evaluate as a condition (use operators/parentheses,
+ *         return a boolean)
+ *
+ * If the expression is a condition, it can contain:
+ *   - conditions:  ==  != <  <=  >  >=
+ *   - logical operators:  &&  ||
+ *   - parentheses for priority
+ *
+ * Examples of simple expression without condition (the [ ] are NOT part of
+ * result):
+ *   >> ${window.buffer.number}
+ *   == [2]
+ *   >> buffer:${window.buffer.full_name}
+ *   == [buffer:irc.freenode.#weechat]
+ *   >> ${window.win_width}
+ *   == [112]
+ *   >> ${window.win_height}
+ *   == [40]
+ *
+ * Examples of conditions:
+ *   >> ${window.buffer.full_name} == irc.freenode.#weechat
+ *   == [1]
+ *   >> ${window.buffer.full_name} == irc.freenode.#test
+ *   == [0]
+ *   >> ${window.win_width} >= 30 && ${window.win_height} >= 20
+ *   == [1]
+ *
+ * Note: result must be freed after use (if not NULL).
+ */
+
+char *
+eval_expression (const char *expr, struct t_hashtable *pointers,
+                 struct t_hashtable *extra_vars, struct t_hashtable *options)
+{
+    struct t_eval_compiled *compiled;
+    char **key, *value;
+    int cached;
+
+    if (!expr)
+        return NULL;
+
+    key = eval_cache_key (expr, options);
+    if (!key)
+        return NULL;
+
+    if (!eval_cache)
     {
-        regfree (regex);
-        free (regex);
+        eval_cache = hashtable_new (64,
+                                    WEECHAT_HASHTABLE_STRING,
+                                    WEECHAT_HASHTABLE_POINTER,
+                                    NULL,
+                                    NULL);
+        if (eval_cache)
+            eval_cache->callback_free_value = &eval_cache_free_value_cb;
     }
 
+    compiled = (eval_cache) ? hashtable_get (eval_cache, *key) : NULL;
+    cached = (compiled) ? 1 : 0;
+    if (!compiled)
+    {
+        compiled = eval_compile (expr, options);
+        if (!compiled)
+        {
+            string_dyn_free (key, 1);
+            return NULL;
+        }
+        /*
+         * cache is cleared when it is full (only if no evaluation is running,
+         * because compiled expressions may be in use)
+         */
+        if (eval_cache && (eval_cache->items_count >= EVAL_CACHE_MAX_SIZE)
+            && (eval_exec_count == 0))
+        {
+            hashtable_remove_all (eval_cache);
+        }
+        if (eval_cache && (eval_cache->items_count < EVAL_CACHE_MAX_SIZE))
+        {
+            if (hashtable_set (eval_cache, *key, compiled))
+                cached = 1;
+        }
+    }
+
+    string_dyn_free (key, 1);
+
+    value = eval_compiled_exec (compiled, pointers, extra_vars);
+
+    if (!cached)
+        eval_compiled_free (compiled);
+
     return value;
 }
+
+/*
+ * Ends evaluation of expressions: frees cache of compiled expressions.
+ */
+
+void
+eval_end ()
+{
+    if (eval_cache)
+    {
+        hashtable_free (eval_cache);
+        eval_cache = NULL;
+    }
+    if (eval_pointers)
+    {
+        hashtable_free (eval_pointers);
+        eval_pointers = NULL;
+    }
+    eval_pointers_used = 0;
+}
@@ -28,6 +28,9 @@
 #define EVAL_DEFAULT_PREFIX "${"
 #define EVAL_DEFAULT_SUFFIX "}"
 
+/* max number of compiled expressions kept in cache */
+#define EVAL_CACHE_MAX_SIZE 512
+
 struct t_hashtable;
 
 enum t_eval_logical_op
@@ -52,6 +55,31 @@ enum t_eval_comparison
     EVAL_NUM_COMPARISONS,
 };
 
+enum t_eval_node_type
+{
+    EVAL_NODE_TEXT = 0,                /* text (without variables)          */
+    EVAL_NODE_TEMPLATE,                /* list of texts and variables       */
+    EVAL_NODE_VAR,                     /* variable with a fixed name        */
+    EVAL_NODE_VAR_DYNAMIC,             /* variable with name built by vars  */
+    EVAL_NODE_LOGICAL,                 /* logical operator (&& ||)          */
+    EVAL_NODE_COMPARE,                 /* comparison (== != < ... =~ !~)    */
+    EVAL_NODE_CONDITION,               /* condition evaluated as a string   */
+    /* number of node types */
+    EVAL_NUM_NODE_TYPES,
+};
+
+enum t_eval_var_type
+{
+    EVAL_VAR_CONSTANT = 0,             /* value computed on compilation     */
+                                       /* (esc:, hide:, cut:, cutscr:)      */
+    EVAL_VAR_EVAL,                     /* eval:xxx                          */
+    EVAL_VAR_IF,                       /* if:condition?value1:value2        */
+    EVAL_VAR_NAME,                     /* option, local var or hdata        */
+    EVAL_VAR_OTHER,                    /* other (evaluated with its name)   */
+    /* number of variable types */
+    EVAL_NUM_VAR_TYPES,
+};
+
 struct t_eval_regex
 {
     const char *result;
@@ -59,10 +87,48 @@ struct t_eval_regex
     int last_match;
 };
 
+struct t_eval_node
+{
+    enum t_eval_node_type type;        /* type of node                      */
+    int op;                            /* logical op, comparison, var type  */
+    char *string;                      /* text, name of variable, condition */
+    char *value;                       /* value of constant variable        */
+    char *hdata_name;                  /* hdata name (variable)             */
+    char *hdata_list;                  /* hdata list (variable)             */
+    const char *hdata_path;            /* hdata path (pointer in "string")  */
+    int nodes_count;                   /* number of nodes (template)        */
+    struct t_eval_node **nodes;        /* nodes (template)                  */
+    struct t_eval_node *child[3];      /* operands of operator/comparison,  */
+                                       /* name of dynamic variable,         */
+                                       /* condition/values for "if:"        */
+    char *regex_string;                /* last regex compiled (=~ and !~)   */
+    regex_t *regex;                    /* compiled regex (NULL if invalid)  */
+};
+
+struct t_eval_compiled
+{
+    int condition;                     /* 1 if evaluated as condition       */
+    int extra_vars_eval;               /* 1 if extra vars are evaluated     */
+    char *prefix;                      /* prefix before variables           */
+    char *suffix;                      /* suffix after variables            */
+    int regex_option;                  /* 1 if option "regex" was given     */
+    regex_t *regex;                    /* regex (option "regex")            */
+    char *regex_replace;               /* replacement text (with regex)     */
+    char *expr;                        /* expression                        */
+    struct t_eval_node *node;          /* compiled expression               */
+};
+
 extern int eval_is_true (const char *value);
+extern struct t_eval_compiled *eval_compile (const char *expr,
+                                             struct t_hashtable *options);
+extern char *eval_compiled_exec (struct t_eval_compiled *compiled,
+                                 struct t_hashtable *pointers,
+                                 struct t_hashtable *extra_vars);
+extern void eval_compiled_free (struct t_eval_compiled *compiled);
 extern char *eval_expression (const char *expr,
                               struct t_hashtable *pointers,
                               struct t_hashtable *extra_vars,
                               struct t_hashtable *options);
+extern void eval_end ();
 
 #endif /* WEECHAT_EVAL_H */
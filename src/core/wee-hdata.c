@@ -132,6 +132,7 @@ hdata_new (struct t_weechat_plugin *plugin, const char *hdata_name,
         new_hdata->delete_allowed = delete_allowed;
         new_hdata->callback_update = callback_update;
         new_hdata->callback_update_data = callback_update_data;
+        new_hdata->callback_read = NULL;
         new_hdata->update_pending = 0;
     }
 
@@ -813,6 +814,9 @@ hdata_pointer (struct t_hdata *hdata, void *pointer, const char *name)
     var = hashtable_get (hdata->hash_var, ptr_name);
     if (var && (var->offset >= 0))
     {
+        /* the pointer may be computed on access (for example lines) */
+        if (hdata->callback_read)
+            (hdata->callback_read) (hdata, pointer, ptr_name);
         if (var->array_size && (index >= 0))
             return (*((void ***)(pointer + var->offset)))[index];
         else
@@ -1196,6 +1200,7 @@ hdata_print_log_map_cb (void *data, struct t_hashtable *hashtable,
     log_printf ("  delete_allowed . . . . : %d",    (int)ptr_hdata->delete_allowed);
     log_printf ("  callback_update. . . . : 0x%lx", ptr_hdata->callback_update);
     log_printf ("  callback_update_data . : 0x%lx", ptr_hdata->callback_update_data);
+    log_printf ("  callback_read. . . . . : 0x%lx", ptr_hdata->callback_read);
     log_printf ("  update_pending . . . . : %d",    (int)ptr_hdata->update_pending);
     hashtable_map (ptr_hdata->hash_var, &hdata_print_log_var_map_cb, NULL);
 }
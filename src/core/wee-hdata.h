@@ -66,6 +66,10 @@ struct t_hdata
      void *pointer,
      struct t_hashtable *hashtable);
     void *callback_update_data;        /* data sent to update callback      */
+    void (*callback_read)              /* read callback (core only), called */
+    (struct t_hdata *hdata,            /* before a pointer is read          */
+     void *pointer,
+     const char *name);
 
     /* internal vars */
     char update_pending;               /* update pending: hdata_set allowed */
@@ -55,7 +55,6 @@
 #include "../gui/gui-bar.h"
 #include "../gui/gui-bar-window.h"
 #include "../gui/gui-buffer.h"
-#include "../gui/gui-color.h"
 #include "../gui/gui-completion.h"
 #include "../gui/gui-focus.h"
 #include "../gui/gui-line.h"
@@ -2475,19 +2474,10 @@ void
 hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
 {
     struct t_hook *ptr_hook, *next_hook;
-    char *prefix_no_color, *message_no_color;
 
-    if (!line->data->message || !line->data->message[0])
-        return;
-
-    prefix_no_color = (line->data->prefix) ?
-        gui_color_decode (line->data->prefix, NULL) : NULL;
-
-    message_no_color = gui_color_decode (line->data->message, NULL);
-    if (!message_no_color)
+    if (!line->data->message || !line->data->message[0]
+        || !line->data->message_no_color)
     {
-        if (prefix_no_color)
-            free (prefix_no_color);
         return;
     }
 
@@ -2504,8 +2494,8 @@ hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
                 || (buffer == HOOK_PRINT(ptr_hook, buffer)))
             && (!HOOK_PRINT(ptr_hook, message)
                 || !HOOK_PRINT(ptr_hook, message)[0]
-                || string_strcasestr (prefix_no_color, HOOK_PRINT(ptr_hook, message))
-                || string_strcasestr (message_no_color, HOOK_PRINT(ptr_hook, message))))
+                || string_strcasestr (line->data->prefix_no_color, HOOK_PRINT(ptr_hook, message))
+                || string_strcasestr (line->data->message_no_color, HOOK_PRINT(ptr_hook, message))))
         {
             /* check if tags match */
             if (!HOOK_PRINT(ptr_hook, tags_array)
@@ -2521,8 +2511,8 @@ hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
                      line->data->tags_count,
                      (const char **)line->data->tags_array,
                      (int)line->data->displayed, (int)line->data->highlight,
-                     (HOOK_PRINT(ptr_hook, strip_colors)) ? prefix_no_color : line->data->prefix,
-                     (HOOK_PRINT(ptr_hook, strip_colors)) ? message_no_color : line->data->message);
+                     (HOOK_PRINT(ptr_hook, strip_colors)) ? line->data->prefix_no_color : line->data->prefix,
+                     (HOOK_PRINT(ptr_hook, strip_colors)) ? line->data->message_no_color : line->data->message);
                 ptr_hook->running = 0;
             }
         }
@@ -2530,11 +2520,6 @@ hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
         ptr_hook = next_hook;
     }
 
-    if (prefix_no_color)
-        free (prefix_no_color);
-    if (message_no_color)
-        free (message_no_color);
-
     hook_exec_end ();
 }
 
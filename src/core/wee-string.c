@@ -1304,6 +1304,371 @@ string_has_highlight_regex (const char *string, const char *regex)
     return rc;
 }
 
+/*
+ * Returns child of a node in highlight automaton for a byte (in lower case).
+ *
+ * Returns index of child node, -1 if not found.
+ */
+
+int
+string_highlight_node_child (struct t_string_highlight *highlight, int node,
+                             unsigned char byte)
+{
+    int child;
+
+    for (child = highlight->nodes[node].child; child >= 0;
+         child = highlight->nodes[child].sibling)
+    {
+        if (highlight->nodes[child].byte == byte)
+            return child;
+    }
+
+    return -1;
+}
+
+/*
+ * Adds a node in highlight automaton, as child of another node.
+ *
+ * Returns index of new node, -1 if error.
+ */
+
+int
+string_highlight_node_add (struct t_string_highlight *highlight, int parent,
+                           unsigned char byte)
+{
+    struct t_string_highlight_node *new_nodes;
+    int new_size, node;
+
+    if (highlight->nodes_count >= highlight->nodes_size)
+    {
+        new_size = (highlight->nodes_size > 0) ?
+            highlight->nodes_size * 2 : 64;
+        new_nodes = realloc (highlight->nodes,
+                             new_size * sizeof (highlight->nodes[0]));
+        if (!new_nodes)
+            return -1;
+        highlight->nodes = new_nodes;
+        highlight->nodes_size = new_size;
+    }
+
+    node = highlight->nodes_count;
+    highlight->nodes[node].byte = byte;
+    highlight->nodes[node].child = -1;
+    highlight->nodes[node].sibling = -1;
+    highlight->nodes[node].fail = 0;
+    highlight->nodes[node].dict = -1;
+    highlight->nodes[node].word = -1;
+    if (parent >= 0)
+    {
+        highlight->nodes[node].sibling = highlight->nodes[parent].child;
+        highlight->nodes[parent].child = node;
+    }
+    highlight->nodes_count++;
+
+    return node;
+}
+
+/*
+ * Compiles a list of words to highlight (same format as function
+ * string_has_highlight) in a multi-pattern matcher: all words are searched
+ * with a single pass on the string by function string_highlight_match.
+ *
+ * Note: result must be freed after use with function string_highlight_free.
+ *
+ * Returns pointer to compiled words, NULL if error.
+ */
+
+struct t_string_highlight *
+string_highlight_compile (const char *highlight_words)
+{
+    struct t_string_highlight *new_highlight;
+    struct t_string_highlight_word *ptr_word;
+    char *pos, *pos_end;
+    int end, length, flags, wildcard_start, wildcard_end, i, node, child;
+    int fail, *queue, queue_start, queue_end;
+    unsigned char byte;
+
+    if (!highlight_words)
+        return NULL;
+
+    new_highlight = malloc (sizeof (*new_highlight));
+    if (!new_highlight)
+        return NULL;
+
+    new_highlight->words_string = strdup (highlight_words);
+    new_highlight->words_count = 0;
+    new_highlight->words = NULL;
+    new_highlight->words_skip = NULL;
+    new_highlight->nodes_count = 0;
+    new_highlight->nodes_size = 0;
+    new_highlight->nodes = NULL;
+    if (!new_highlight->words_string)
+        goto error;
+
+    /* one word max by comma */
+    length = 1;
+    for (pos = new_highlight->words_string; pos[0]; pos++)
+    {
+        if (pos[0] == ',')
+            length++;
+    }
+    new_highlight->words = malloc (length * sizeof (new_highlight->words[0]));
+    new_highlight->words_skip = malloc (length *
+                                        sizeof (new_highlight->words_skip[0]));
+    if (!new_highlight->words || !new_highlight->words_skip)
+        goto error;
+
+    /* root node */
+    if (string_highlight_node_add (new_highlight, -1, 0) < 0)
+        goto error;
+
+    /* split words and add them in the tree */
+    pos = new_highlight->words_string;
+    end = 0;
+    while (!end)
+    {
+        flags = 0;
+        pos = (char *)string_regex_flags (pos, REG_ICASE, &flags);
+
+        pos_end = strchr (pos, ',');
+        if (!pos_end)
+        {
+            pos_end = strchr (pos, '\0');
+            end = 1;
+        }
+
+        length = pos_end - pos;
+        pos_end[0] = '\0';
+        wildcard_start = 0;
+        wildcard_end = 0;
+        if (length > 0)
+        {
+            if ((wildcard_start = (pos[0] == '*')))
+            {
+                pos++;
+                length--;
+            }
+            if ((wildcard_end = (*(pos_end - 1) == '*')))
+            {
+                *(pos_end - 1) = '\0';
+                length--;
+            }
+        }
+
+        if (length > 0)
+        {
+            node = 0;
+            for (i = 0; i < length; i++)
+            {
+                byte = (unsigned char)pos[i];
+                if ((byte >= 'A') && (byte <= 'Z'))
+                    byte += ('a' - 'A');
+                child = string_highlight_node_child (new_highlight, node, byte);
+                if (child < 0)
+                {
+                    child = string_highlight_node_add (new_highlight, node,
+                                                       byte);
+                    if (child < 0)
+                        goto error;
+                }
+                node = child;
+            }
+            ptr_word = &new_highlight->words[new_highlight->words_count];
+            ptr_word->word = pos;
+            ptr_word->length = length;
+            ptr_word->case_sensitive = (flags & REG_ICASE) ? 0 : 1;
+            ptr_word->wildcard_start = wildcard_start;
+            ptr_word->wildcard_end = wildcard_end;
+            ptr_word->next_word = new_highlight->nodes[node].word;
+            new_highlight->nodes[node].word = new_highlight->words_count;
+            new_highlight->words_count++;
+        }
+
+        if (!end)
+            pos = pos_end + 1;
+    }
+
+    /* build failure links (breadth-first traversal of tree) */
+    queue = malloc (new_highlight->nodes_count * sizeof (*queue));
+    if (!queue)
+        goto error;
+    queue_start = 0;
+    queue_end = 0;
+    for (child = new_highlight->nodes[0].child; child >= 0;
+         child = new_highlight->nodes[child].sibling)
+    {
+        queue[queue_end++] = child;
+    }
+    while (queue_start < queue_end)
+    {
+        node = queue[queue_start++];
+        for (child = new_highlight->nodes[node].child; child >= 0;
+             child = new_highlight->nodes[child].sibling)
+        {
+            byte = new_highlight->nodes[child].byte;
+            fail = new_highlight->nodes[node].fail;
+            while ((fail > 0)
+                   && (string_highlight_node_child (new_highlight, fail,
+                                                    byte) < 0))
+            {
+                fail = new_highlight->nodes[fail].fail;
+            }
+            fail = string_highlight_node_child (new_highlight, fail, byte);
+            new_highlight->nodes[child].fail = (fail >= 0) ? fail : 0;
+            fail = new_highlight->nodes[child].fail;
+            new_highlight->nodes[child].dict =
+                (new_highlight->nodes[fail].word >= 0) ?
+                fail : new_highlight->nodes[fail].dict;
+            queue[queue_end++] = child;
+        }
+    }
+    free (queue);
+
+    return new_highlight;
+
+error:
+    string_highlight_free (new_highlight);
+    return NULL;
+}
+
+/*
+ * Checks if a word found in a string is a highlight (the word must be
+ * surrounded by delimiters, except on the side of a wildcard).
+ *
+ * Returns:
+ *   1: word is a highlight
+ *   0: word is not a highlight
+ */
+
+int
+string_highlight_match_word (struct t_string_highlight *highlight,
+                             int index_word, const char *string, int start)
+{
+    struct t_string_highlight_word *ptr_word;
+    const char *match, *match_pre, *match_post;
+    int startswith, endswith;
+
+    ptr_word = &highlight->words[index_word];
+
+    /*
+     * like function string_has_highlight, a match starting inside the
+     * previous match of the same word is ignored
+     */
+    if (start < highlight->words_skip[index_word])
+        return 0;
+
+    match = string + start;
+    if (ptr_word->case_sensitive
+        && (strncmp (match, ptr_word->word, ptr_word->length) != 0))
+    {
+        return 0;
+    }
+
+    highlight->words_skip[index_word] = start + ptr_word->length;
+
+    match_pre = utf8_prev_char (string, match);
+    if (!match_pre)
+        match_pre = match - 1;
+    match_post = match + ptr_word->length;
+    startswith = ((match == string) || (!string_is_word_char_highlight (match_pre)));
+    endswith = ((!match_post[0]) || (!string_is_word_char_highlight (match_post)));
+
+    return ((ptr_word->wildcard_start && ptr_word->wildcard_end)
+            || (!ptr_word->wildcard_start && !ptr_word->wildcard_end
+                && startswith && endswith)
+            || (ptr_word->wildcard_start && endswith)
+            || (ptr_word->wildcard_end && startswith)) ? 1 : 0;
+}
+
+/*
+ * Checks if a string has a highlight, using words compiled with function
+ * string_highlight_compile (the string is read only once, whatever the
+ * number of words).
+ *
+ * Returns:
+ *   1: string has a highlight
+ *   0: string has no highlight
+ */
+
+int
+string_highlight_match (struct t_string_highlight *highlight,
+                        const char *string)
+{
+    int i, pos, node, child, index_word;
+    unsigned char byte;
+
+    if (!highlight || (highlight->words_count == 0) || !string || !string[0])
+        return 0;
+
+    for (i = 0; i < highlight->words_count; i++)
+    {
+        highlight->words_skip[i] = 0;
+    }
+
+    node = 0;
+    for (pos = 0; string[pos]; pos++)
+    {
+        byte = (unsigned char)string[pos];
+        if ((byte >= 'A') && (byte <= 'Z'))
+            byte += ('a' - 'A');
+        while (1)
+        {
+            child = string_highlight_node_child (highlight, node, byte);
+            if (child >= 0)
+            {
+                node = child;
+                break;
+            }
+            if (node == 0)
+                break;
+            node = highlight->nodes[node].fail;
+        }
+
+        /* check all words ending at this position */
+        for (child = (highlight->nodes[node].word >= 0) ?
+                 node : highlight->nodes[node].dict;
+             child > 0;
+             child = highlight->nodes[child].dict)
+        {
+            for (index_word = highlight->nodes[child].word; index_word >= 0;
+                 index_word = highlight->words[index_word].next_word)
+            {
+                if (string_highlight_match_word (
+                        highlight, index_word, string,
+                        pos + 1 - highlight->words[index_word].length))
+                {
+                    return 1;
+                }
+            }
+        }
+    }
+
+    /* no highlight found */
+    return 0;
+}
+
+/*
+ * Frees words compiled with function string_highlight_compile.
+ */
+
+void
+string_highlight_free (struct t_string_highlight *highlight)
+{
+    if (!highlight)
+        return;
+
+    if (highlight->words_string)
+        free (highlight->words_string);
+    if (highlight->words)
+        free (highlight->words);
+    if (highlight->words_skip)
+        free (highlight->words_skip);
+    if (highlight->nodes)
+        free (highlight->nodes);
+
+    free (highlight);
+}
+
 /*
  * Replaces a string by new one in a string.
  *
@@ -33,6 +33,47 @@ struct t_string_dyn
     string_dyn_size_t size;            /* size of string (including '\0')   */
 };
 
+/*
+ * highlight words compiled in a multi-pattern matcher (Aho-Corasick
+ * automaton on bytes converted to lower case)
+ */
+
+struct t_string_highlight_word
+{
+    const char *word;                  /* word (without wildcards)          */
+    int length;                        /* length of word (in bytes)         */
+    int case_sensitive;                /* 1 if word is case sensitive       */
+    int wildcard_start;                /* 1 if word begins with "*"         */
+    int wildcard_end;                  /* 1 if word ends with "*"           */
+    int next_word;                     /* next word ending on same node     */
+                                       /* (-1 if no other word)             */
+};
+
+struct t_string_highlight_node
+{
+    unsigned char byte;                /* byte (lower case) to reach node   */
+    int child;                         /* first child (-1 if no child)      */
+    int sibling;                       /* next sibling (-1 if no sibling)   */
+    int fail;                          /* node with longest proper suffix   */
+    int dict;                          /* first node with words on failure  */
+                                       /* links (-1 if no node)             */
+    int word;                          /* first word ending on this node    */
+                                       /* (-1 if no word)                   */
+};
+
+struct t_string_highlight
+{
+    char *words_string;                /* copy of words (words point here)  */
+    int words_count;                   /* number of words                   */
+    struct t_string_highlight_word *words; /* words to highlight            */
+    int *words_skip;                   /* for each word: position where     */
+                                       /* next match can start (during a    */
+                                       /* search only)                      */
+    int nodes_count;                   /* number of nodes                   */
+    int nodes_size;                    /* allocated nodes                   */
+    struct t_string_highlight_node *nodes; /* nodes (node 0 is the root)    */
+};
+
 struct t_hashtable;
 
 extern char *string_strndup (const char *string, int length);
@@ -76,6 +117,10 @@ extern int string_has_highlight (const char *string,
 extern int string_has_highlight_regex_compiled (const char *string,
                                                 regex_t *regex);
 extern int string_has_highlight_regex (const char *string, const char *regex);
+extern struct t_string_highlight *string_highlight_compile (const char *highlight_words);
+extern int string_highlight_match (struct t_string_highlight *highlight,
+                                   const char *string);
+extern void string_highlight_free (struct t_string_highlight *highlight);
 extern char *string_replace_regex (const char *string, void *regex,
                                    const char *replace,
                                    const char reference_char,
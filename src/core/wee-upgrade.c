@@ -163,6 +163,7 @@ upgrade_weechat_save_buffers (struct t_upgrade_file *upgrade_file)
         }
 
         /* save buffer lines */
+        gui_line_uncompress (ptr_buffer);
         for (ptr_line = ptr_buffer->own_lines->first_line; ptr_line;
              ptr_line = ptr_line->next_line)
         {
@@ -692,6 +692,7 @@ gui_chat_display_time_to_prefix (struct t_gui_window *window,
     char *prefix_no_color, *prefix_highlighted, *ptr_prefix, *ptr_prefix2;
     char *ptr_prefix_color;
     const char *short_name, *str_color, *ptr_nick_prefix, *ptr_nick_suffix;
+    const char *str_time;
     int i, length, length_allowed, num_spaces, prefix_length, extra_spaces;
     int chars_displayed, nick_offline, prefix_is_nick, length_nick_prefix_suffix;
     int chars_to_display;
@@ -709,12 +710,13 @@ gui_chat_display_time_to_prefix (struct t_gui_window *window,
     }
 
     /* display time */
-    if (window->buffer->time_for_each_line
-        && line->data->str_time && line->data->str_time[0])
+    str_time = (window->buffer->time_for_each_line) ?
+        gui_chat_get_time_string_cached (line->data->date) : NULL;
+    if (str_time && str_time[0])
     {
         if (window->win_chat_cursor_y < window->coords_size)
             window->coords[window->win_chat_cursor_y].time_x1 = window->win_chat_cursor_x;
-        gui_chat_display_word (window, line, line->data->str_time,
+        gui_chat_display_word (window, line, str_time,
                                NULL, 1, num_lines, count,
                                pre_lines_displayed, lines_displayed,
                                simulate,
@@ -1220,6 +1222,164 @@ gui_chat_display_time_to_prefix (struct t_gui_window *window,
         free (ptr_prefix);
 }
 
+/*
+ * Checks if the "day changed" message must be displayed before a line
+ * (if after == 0) or after a line (if after == 1).
+ *
+ * Before a line, the message is displayed only for the first line of buffer
+ * (with a date), if its date is not today; after a line, the message is
+ * displayed if the day of next line (or today for the last line) is
+ * different.
+ *
+ * If date1 and date2 are not NULL, they are set with the dates to display
+ * in message (date1 is not set for a message before a line).
+ *
+ * Returns:
+ *   1: message must be displayed
+ *   0: message must not be displayed
+ */
+
+int
+gui_chat_line_day_changed (struct t_gui_window *window,
+                           struct t_gui_line *line, int after,
+                           struct tm *date1, struct tm *date2)
+{
+    struct t_gui_line *ptr_line;
+    struct tm local_time, local_time2;
+    struct timeval tv_time;
+    time_t seconds;
+
+    if ((line->data->date == 0)
+        || !CONFIG_BOOLEAN(config_look_day_change)
+        || !window->buffer->day_change)
+    {
+        return 0;
+    }
+
+    /* search previous/next line with a date */
+    ptr_line = (after) ?
+        gui_line_get_next_displayed (line) : gui_line_get_prev_displayed (line);
+    while (ptr_line && (ptr_line->data->date == 0))
+    {
+        ptr_line = (after) ?
+            gui_line_get_next_displayed (ptr_line) :
+            gui_line_get_prev_displayed (ptr_line);
+    }
+
+    if (ptr_line)
+    {
+        /* before a line: message is displayed only for first line */
+        if (!after)
+            return 0;
+        seconds = ptr_line->data->date;
+    }
+    else
+    {
+        /* first/last line => compare with current system time */
+        gettimeofday (&tv_time, NULL);
+        seconds = tv_time.tv_sec;
+    }
+
+    localtime_r (&line->data->date, &local_time);
+    localtime_r (&seconds, &local_time2);
+    if ((local_time.tm_mday == local_time2.tm_mday)
+        && (local_time.tm_mon == local_time2.tm_mon)
+        && (local_time.tm_year == local_time2.tm_year))
+    {
+        return 0;
+    }
+
+    if (after)
+    {
+        if (date1)
+            memcpy (date1, &local_time, sizeof (*date1));
+        if (date2)
+            memcpy (date2, &local_time2, sizeof (*date2));
+    }
+    else
+    {
+        if (date2)
+            memcpy (date2, &local_time, sizeof (*date2));
+    }
+
+    return 1;
+}
+
+/*
+ * Checks if cache of line heights in window is still valid for the buffer
+ * displayed and the window size; if not, the cache is cleared.
+ */
+
+void
+gui_chat_line_heights_check (struct t_gui_window *window)
+{
+    struct t_gui_window_line_heights *ptr_heights;
+
+    ptr_heights = window->line_heights;
+
+    if ((ptr_heights->lines != window->buffer->lines)
+        || (ptr_heights->chat_width != window->win_chat_width)
+        || (ptr_heights->chat_real_width != gui_chat_get_real_width (window))
+        || (ptr_heights->prefix_max_length != window->buffer->lines->prefix_max_length)
+        || (ptr_heights->buffer_max_length != window->buffer->lines->buffer_max_length)
+        || (ptr_heights->time_for_each_line != window->buffer->time_for_each_line)
+        || (ptr_heights->display_tags != gui_chat_display_tags))
+    {
+        gui_window_line_heights_clear (window);
+        ptr_heights->lines = window->buffer->lines;
+        ptr_heights->chat_width = window->win_chat_width;
+        ptr_heights->chat_real_width = gui_chat_get_real_width (window);
+        ptr_heights->prefix_max_length = window->buffer->lines->prefix_max_length;
+        ptr_heights->buffer_max_length = window->buffer->lines->buffer_max_length;
+        ptr_heights->time_for_each_line = window->buffer->time_for_each_line;
+        ptr_heights->display_tags = gui_chat_display_tags;
+    }
+}
+
+/*
+ * Returns number of lines on screen used to display a line (same value as
+ * gui_chat_display_line in simulation mode).
+ *
+ * The height of time, prefix and message is kept in a cache in window, so
+ * that the line is not rendered again each time its height is needed (for
+ * example when scrolling); the "day changed" messages and read marker depend
+ * on other lines and are always checked.
+ */
+
+int
+gui_chat_get_line_height (struct t_gui_window *window,
+                          struct t_gui_line *line)
+{
+    int height, extra_lines;
+
+    if (!line)
+        return 0;
+
+    extra_lines = gui_chat_line_day_changed (window, line, 0, NULL, NULL)
+        + gui_chat_line_day_changed (window, line, 1, NULL, NULL)
+        + gui_chat_marker_for_line (window->buffer, line);
+
+    gui_chat_line_heights_check (window);
+
+    height = gui_window_line_heights_get (window, line);
+    if (height < 0)
+    {
+        height = gui_chat_display_line (window, line, 0, 1) - extra_lines;
+        /*
+         * with no alignment of prefix, the prefix hidden for the same nick
+         * as previous line changes the height: do not cache it
+         */
+        if (!CONFIG_STRING(config_look_prefix_same_nick)
+            || !CONFIG_STRING(config_look_prefix_same_nick)[0]
+            || (CONFIG_INTEGER(config_look_prefix_align) != CONFIG_LOOK_PREFIX_ALIGN_NONE))
+        {
+            gui_window_line_heights_set (window, line, height);
+        }
+    }
+
+    return height + extra_lines;
+}
+
 /*
  * Displays a line in the chat window.
  *
@@ -1241,10 +1401,8 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
     int word_length_with_spaces, word_length;
     char *message_with_tags, *message_with_search;
     const char *ptr_data, *ptr_end_offset, *ptr_style, *next_char;
-    struct t_gui_line *ptr_prev_line, *ptr_next_line;
+    const char *str_time;
     struct tm local_time, local_time2;
-    struct timeval tv_time;
-    time_t seconds, *ptr_time;
 
     if (!line)
         return 0;
@@ -1263,7 +1421,7 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
             return 0;
         x = window->win_chat_cursor_x;
         y = window->win_chat_cursor_y;
-        num_lines = gui_chat_display_line (window, line, 0, 1);
+        num_lines = gui_chat_get_line_height (window, line);
         window->win_chat_cursor_x = x;
         window->win_chat_cursor_y = y;
         gui_window_current_emphasis = 0;
@@ -1273,43 +1431,18 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
     lines_displayed = 0;
 
     /* display message before first line of buffer if date is not today */
-    if ((line->data->date != 0)
-        && CONFIG_BOOLEAN(config_look_day_change)
-        && window->buffer->day_change)
+    if (gui_chat_line_day_changed (window, line, 0, NULL, &local_time2))
     {
-        ptr_time = NULL;
-        ptr_prev_line = gui_line_get_prev_displayed (line);
-        if (ptr_prev_line)
-        {
-            while (ptr_prev_line && (ptr_prev_line->data->date == 0))
-            {
-                ptr_prev_line = gui_line_get_prev_displayed (ptr_prev_line);
-            }
-        }
-        if (!ptr_prev_line)
-        {
-            gettimeofday (&tv_time, NULL);
-            seconds = tv_time.tv_sec;
-            localtime_r (&seconds, &local_time);
-            localtime_r (&line->data->date, &local_time2);
-            if ((local_time.tm_mday != local_time2.tm_mday)
-                || (local_time.tm_mon != local_time2.tm_mon)
-                || (local_time.tm_year != local_time2.tm_year))
-            {
-                gui_chat_display_day_changed (window, NULL, &local_time2,
-                                              simulate);
-                gui_chat_display_new_line (window, num_lines, count,
-                                           &lines_displayed, simulate);
-                pre_lines_displayed++;
-            }
-        }
+        gui_chat_display_day_changed (window, NULL, &local_time2, simulate);
+        gui_chat_display_new_line (window, num_lines, count,
+                                   &lines_displayed, simulate);
+        pre_lines_displayed++;
     }
 
     /* calculate marker position (maybe not used for this line!) */
-    if (window->buffer->time_for_each_line && line->data->str_time)
-        read_marker_x = x + gui_chat_strlen_screen (line->data->str_time);
-    else
-        read_marker_x = x;
+    str_time = (window->buffer->time_for_each_line) ?
+        gui_chat_get_time_string_cached (line->data->date) : NULL;
+    read_marker_x = (str_time) ? x + gui_chat_strlen_screen (str_time) : x;
     read_marker_y = y;
 
     /* display time and prefix */
@@ -1473,45 +1606,12 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
         free (message_with_search);
 
     /* display message if day has changed after this line */
-    if ((line->data->date != 0)
-        && CONFIG_BOOLEAN(config_look_day_change)
-        && window->buffer->day_change)
+    if (gui_chat_line_day_changed (window, line, 1, &local_time, &local_time2))
     {
-        ptr_time = NULL;
-        ptr_next_line = gui_line_get_next_displayed (line);
-        if (ptr_next_line)
-        {
-            while (ptr_next_line && (ptr_next_line->data->date == 0))
-            {
-                ptr_next_line = gui_line_get_next_displayed (ptr_next_line);
-            }
-        }
-        if (ptr_next_line)
-        {
-            /* get time of next line */
-            ptr_time = &ptr_next_line->data->date;
-        }
-        else
-        {
-            /* it was the last line => compare with current system time */
-            gettimeofday (&tv_time, NULL);
-            seconds = tv_time.tv_sec;
-            ptr_time = &seconds;
-        }
-        if (ptr_time && (*ptr_time != 0))
-        {
-            localtime_r (&line->data->date, &local_time);
-            localtime_r (ptr_time, &local_time2);
-            if ((local_time.tm_mday != local_time2.tm_mday)
-                || (local_time.tm_mon != local_time2.tm_mon)
-                || (local_time.tm_year != local_time2.tm_year))
-            {
-                gui_chat_display_day_changed (window, &local_time, &local_time2,
-                                              simulate);
-                gui_chat_display_new_line (window, num_lines, count,
-                                           &lines_displayed, simulate);
-            }
-        }
+        gui_chat_display_day_changed (window, &local_time, &local_time2,
+                                      simulate);
+        gui_chat_display_new_line (window, num_lines, count,
+                                   &lines_displayed, simulate);
     }
 
     /* display read marker (after line) */
@@ -1529,10 +1629,13 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
     }
     else
     {
-        /* display marker if line is matching user search */
+        /*
+         * display marker if line is matching user search (only lines
+         * displayed are checked, so the bloom filter of line is not used)
+         */
         if (window->buffer->text_search != GUI_TEXT_SEARCH_DISABLED)
         {
-            if (gui_line_search_text (window->buffer, line))
+            if (gui_line_search_text (window->buffer, line, NULL))
             {
                 gui_window_set_weechat_color (GUI_WINDOW_OBJECTS(window)->win_chat,
                                               GUI_COLOR_CHAT_TEXT_FOUND);
@@ -1641,7 +1744,7 @@ gui_chat_calculate_line_diff (struct t_gui_window *window,
             *line = gui_line_get_last_displayed (window->buffer);
             if (!(*line))
                 return;
-            current_size = gui_chat_display_line (window, *line, 0, 1);
+            current_size = gui_chat_get_line_height (window, *line);
             if (current_size == 0)
                 current_size = 1;
             *line_pos = current_size - 1;
@@ -1653,11 +1756,11 @@ gui_chat_calculate_line_diff (struct t_gui_window *window,
             if (!(*line))
                 return;
             *line_pos = 0;
-            current_size = gui_chat_display_line (window, *line, 0, 1);
+            current_size = gui_chat_get_line_height (window, *line);
         }
     }
     else
-        current_size = gui_chat_display_line (window, *line, 0, 1);
+        current_size = gui_chat_get_line_height (window, *line);
 
     while ((*line) && (difference != 0))
     {
@@ -1668,10 +1771,10 @@ gui_chat_calculate_line_diff (struct t_gui_window *window,
                 (*line_pos)--;
             else
             {
-                *line = gui_line_get_prev_displayed (*line);
+                *line = gui_line_get_prev_displayed_uncompress (*line);
                 if (*line)
                 {
-                    current_size = gui_chat_display_line (window, *line, 0, 1);
+                    current_size = gui_chat_get_line_height (window, *line);
                     if (current_size == 0)
                         current_size = 1;
                     *line_pos = current_size - 1;
@@ -1689,7 +1792,7 @@ gui_chat_calculate_line_diff (struct t_gui_window *window,
                 *line = gui_line_get_next_displayed (*line);
                 if (*line)
                 {
-                    current_size = gui_chat_display_line (window, *line, 0, 1);
+                    current_size = gui_chat_get_line_height (window, *line);
                     if (current_size == 0)
                         current_size = 1;
                     *line_pos = 0;
@@ -1716,6 +1819,148 @@ gui_chat_calculate_line_diff (struct t_gui_window *window,
     }
 }
 
+/*
+ * Saves last line displayed at bottom of chat area, with the context of
+ * display (this line and new lines added after it can then be drawn without
+ * drawing the whole chat area).
+ */
+
+void
+gui_chat_bottom_set (struct t_gui_window *window, struct t_gui_line *line,
+                     int line_rows)
+{
+    struct t_gui_window_chat_bottom *ptr_bottom;
+
+    ptr_bottom = window->chat_bottom;
+    if (!ptr_bottom)
+        return;
+
+    ptr_bottom->line = line;
+    ptr_bottom->line_rows = line_rows;
+    ptr_bottom->lines = window->buffer->lines;
+    ptr_bottom->chat_width = window->win_chat_width;
+    ptr_bottom->chat_height = window->win_chat_height;
+    ptr_bottom->prefix_max_length = window->buffer->lines->prefix_max_length;
+    ptr_bottom->buffer_max_length = window->buffer->lines->buffer_max_length;
+    ptr_bottom->last_read_line = window->buffer->lines->last_read_line;
+    ptr_bottom->first_line_not_read = window->buffer->lines->first_line_not_read;
+    ptr_bottom->time_for_each_line = window->buffer->time_for_each_line;
+    ptr_bottom->display_tags = gui_chat_display_tags;
+    ptr_bottom->current_window = (window == gui_current_window) ? 1 : 0;
+}
+
+/*
+ * Checks if last line displayed at bottom of chat area is still valid: the
+ * window must be displayed at bottom of buffer, with same context of display.
+ *
+ * Returns:
+ *   1: last line at bottom is valid
+ *   0: last line at bottom is not valid (chat area must be fully drawn)
+ */
+
+int
+gui_chat_bottom_is_valid (struct t_gui_window *window)
+{
+    struct t_gui_window_chat_bottom *ptr_bottom;
+
+    ptr_bottom = window->chat_bottom;
+
+    return (ptr_bottom
+            && ptr_bottom->line
+            && ptr_bottom->line->data->displayed
+            && !window->scroll->start_line
+            && (window->buffer->text_search == GUI_TEXT_SEARCH_DISABLED)
+            && window->coords
+            && (window->coords_size == window->win_chat_height)
+            && (ptr_bottom->lines == window->buffer->lines)
+            && (ptr_bottom->chat_width == window->win_chat_width)
+            && (ptr_bottom->chat_height == window->win_chat_height)
+            && (ptr_bottom->prefix_max_length == window->buffer->lines->prefix_max_length)
+            && (ptr_bottom->buffer_max_length == window->buffer->lines->buffer_max_length)
+            && (ptr_bottom->last_read_line == window->buffer->lines->last_read_line)
+            && (ptr_bottom->first_line_not_read == window->buffer->lines->first_line_not_read)
+            && (ptr_bottom->time_for_each_line == window->buffer->time_for_each_line)
+            && (ptr_bottom->display_tags == gui_chat_display_tags)
+            && (ptr_bottom->current_window == ((window == gui_current_window) ? 1 : 0))) ?
+        1 : 0;
+}
+
+/*
+ * Draws new lines added at the end of a formatted buffer, when window is
+ * displayed at bottom of buffer: the chat area is scrolled up by the number
+ * of rows added (the terminal can do it with its scroll region), then the
+ * last line previously displayed (its height may change, for example with
+ * the read marker) and the new lines are drawn; other rows are not drawn
+ * again.
+ *
+ * Returns:
+ *   1: new lines drawn
+ *   0: new lines not drawn (chat area must be fully drawn)
+ */
+
+int
+gui_chat_draw_new_lines (struct t_gui_window *window)
+{
+    struct t_gui_line *ptr_line, *ptr_last_line;
+    int rows, scroll_rows, start_row, last_line_rows, i;
+
+    if (!gui_chat_bottom_is_valid (window))
+        return 0;
+
+    /* count rows used by last line displayed and new lines */
+    rows = 0;
+    for (ptr_line = window->chat_bottom->line; ptr_line;
+         ptr_line = gui_line_get_next_displayed (ptr_line))
+    {
+        rows += gui_chat_get_line_height (window, ptr_line);
+        if (rows > window->win_chat_height)
+            return 0;
+    }
+
+    scroll_rows = rows - window->chat_bottom->line_rows;
+    if (scroll_rows < 0)
+        return 0;
+    start_row = window->win_chat_height - rows;
+
+    /* scroll chat area and coordinates of lines */
+    if (scroll_rows > 0)
+    {
+        scrollok (GUI_WINDOW_OBJECTS(window)->win_chat, TRUE);
+        wscrl (GUI_WINDOW_OBJECTS(window)->win_chat, scroll_rows);
+        scrollok (GUI_WINDOW_OBJECTS(window)->win_chat, FALSE);
+        memmove (window->coords, window->coords + scroll_rows,
+                 (window->coords_size - scroll_rows) * sizeof (window->coords[0]));
+        window->scroll->first_line_displayed = 0;
+    }
+    for (i = start_row; i < window->coords_size; i++)
+    {
+        gui_window_coords_init_line (window, i);
+    }
+
+    /* display last line displayed and new lines */
+    window->win_chat_cursor_x = 0;
+    window->win_chat_cursor_y = start_row;
+    ptr_last_line = NULL;
+    last_line_rows = 0;
+    for (ptr_line = window->chat_bottom->line; ptr_line;
+         ptr_line = gui_line_get_next_displayed (ptr_line))
+    {
+        ptr_last_line = ptr_line;
+        last_line_rows = gui_chat_display_line (window, ptr_line, 0, 0);
+    }
+
+    gui_chat_bottom_set (window, ptr_last_line, last_line_rows);
+
+    /* cursor is below end line of chat window? */
+    if (window->win_chat_cursor_y > window->win_chat_height - 1)
+    {
+        window->win_chat_cursor_x = 0;
+        window->win_chat_cursor_y = window->win_chat_height - 1;
+    }
+
+    return 1;
+}
+
 /*
  * Draws chat window for a formatted buffer.
  */
@@ -1723,7 +1968,7 @@ gui_chat_calculate_line_diff (struct t_gui_window *window,
 void
 gui_chat_draw_formatted_buffer (struct t_gui_window *window)
 {
-    struct t_gui_line *ptr_line, *ptr_line2;
+    struct t_gui_line *ptr_line, *ptr_line2, *ptr_last_line;
     int auto_search_first_line, line_pos, line_pos2, count;
     int old_scrolling, old_lines_after;
 
@@ -1780,9 +2025,8 @@ gui_chat_draw_formatted_buffer (struct t_gui_window *window)
     {
         /* display end of first line at top of screen */
         count = gui_chat_display_line (window, ptr_line,
-                                       gui_chat_display_line (window,
-                                                              ptr_line,
-                                                              0, 1) -
+                                       gui_chat_get_line_height (window,
+                                                                 ptr_line) -
                                        line_pos, 0);
         ptr_line = gui_line_get_next_displayed (ptr_line);
         window->scroll->first_line_displayed = 0;
@@ -1792,12 +2036,25 @@ gui_chat_draw_formatted_buffer (struct t_gui_window *window)
             (ptr_line == gui_line_get_first_displayed (window->buffer));
 
     /* display lines */
+    ptr_last_line = NULL;
     while (ptr_line && (window->win_chat_cursor_y <= window->win_chat_height - 1))
     {
+        ptr_last_line = ptr_line;
         count = gui_chat_display_line (window, ptr_line, 0, 0);
         ptr_line = gui_line_get_next_displayed (ptr_line);
     }
 
+    /*
+     * if chat area is full and ends with last line of buffer, save this line
+     * so that only new lines are drawn on next refresh
+     */
+    if (auto_search_first_line && !ptr_line && ptr_last_line
+        && (window->win_chat_cursor_y == window->win_chat_height)
+        && (window->buffer->text_search == GUI_TEXT_SEARCH_DISABLED))
+    {
+        gui_chat_bottom_set (window, ptr_last_line, count);
+    }
+
     old_scrolling = window->scroll->scrolling;
     old_lines_after = window->scroll->lines_after;
 
@@ -1807,7 +2064,7 @@ gui_chat_draw_formatted_buffer (struct t_gui_window *window)
     /* if so, disable scroll indicator */
     if (!ptr_line && window->scroll->scrolling)
     {
-        if ((count == gui_chat_display_line (window, gui_line_get_last_displayed (window->buffer), 0, 1))
+        if ((count == gui_chat_get_line_height (window, gui_line_get_last_displayed (window->buffer)))
             || (count == window->win_chat_height))
             window->scroll->scrolling = 0;
     }
@@ -1903,23 +2160,15 @@ gui_chat_draw_free_buffer (struct t_gui_window *window, int clear_chat)
 char *
 gui_chat_get_bare_line (struct t_gui_line *line)
 {
-    char *prefix, *message, str_time[256], *str_line;
-    const char *tag_prefix_nick;
+    char str_time[256], *str_line;
+    const char *prefix, *message, *tag_prefix_nick;
     struct tm *local_time;
     int length;
 
-    prefix = NULL;
-    message = NULL;
-    str_line = NULL;
-
-    prefix = (line->data->prefix) ?
-        gui_color_decode (line->data->prefix, NULL) : strdup ("");
-    if (!prefix)
-        goto end;
-    message = (line->data->message) ?
-        gui_color_decode (line->data->message, NULL) : strdup ("");
-    if (!message)
-        goto end;
+    prefix = (line->data->prefix_no_color) ?
+        line->data->prefix_no_color : "";
+    message = (line->data->message_no_color) ?
+        line->data->message_no_color : "";
 
     str_time[0] = '\0';
     if (line->data->buffer->time_for_each_line
@@ -1950,12 +2199,6 @@ gui_chat_get_bare_line (struct t_gui_line *line)
                   message);
     }
 
-end:
-    if (prefix)
-        free (prefix);
-    if (message)
-        free (message);
-
     return str_line;
 }
 
@@ -2063,13 +2306,23 @@ gui_chat_draw (struct t_gui_buffer *buffer, int clear_chat)
             && (ptr_win->win_chat_x >= 0) && (ptr_win->win_chat_y >= 0)
             && (GUI_WINDOW_OBJECTS(ptr_win)->win_chat))
         {
-            gui_window_coords_alloc (ptr_win);
-
             gui_chat_reset_style (ptr_win, NULL, 0, 1,
                                   GUI_COLOR_CHAT_INACTIVE_WINDOW,
                                   GUI_COLOR_CHAT_INACTIVE_BUFFER,
                                   GUI_COLOR_CHAT);
 
+            /* only new lines added at the end of buffer to draw? */
+            if (!clear_chat && buffer->chat_refresh_new_lines
+                && (ptr_win->buffer->type == GUI_BUFFER_TYPE_FORMATTED)
+                && gui_chat_draw_new_lines (ptr_win))
+            {
+                wnoutrefresh (GUI_WINDOW_OBJECTS(ptr_win)->win_chat);
+                continue;
+            }
+
+            gui_window_chat_bottom_reset (ptr_win);
+            gui_window_coords_alloc (ptr_win);
+
             if (clear_chat)
             {
                 snprintf (format_empty, sizeof (format_empty),
@@ -2087,6 +2340,7 @@ gui_chat_draw (struct t_gui_buffer *buffer, int clear_chat)
             switch (ptr_win->buffer->type)
             {
                 case GUI_BUFFER_TYPE_FORMATTED:
+                    gui_line_uncompress_for_window (ptr_win);
                     /* min 2 lines for chat area */
                     if (ptr_win->win_chat_height < 2)
                         mvwaddstr (GUI_WINDOW_OBJECTS(ptr_win)->win_chat, 0, 0, "...");
@@ -2116,4 +2370,5 @@ gui_chat_draw (struct t_gui_buffer *buffer, int clear_chat)
 
 end:
     buffer->chat_refresh_needed = 0;
+    buffer->chat_refresh_new_lines = 0;
 }
@@ -297,6 +297,101 @@ gui_key_default_bindings (int context)
     }
 }
 
+/*
+ * Adds chars of keyboard buffer (starting at index "start") directly to the
+ * pasted text, without handling each char as a key: chars are added while
+ * they are printable and no key of current context begins with them.
+ *
+ * Signal "key_pressed" is sent once with all chars added (instead of once per
+ * char).
+ *
+ * Returns number of chars of keyboard buffer added to pasted text, 0 if the
+ * chars must be handled as keys.
+ */
+
+int
+gui_key_flush_paste_text (int start, int save_undo)
+{
+    int i, length;
+    char key_start[2], *text, *ptr_char, *next_char, *ptr_error;
+
+    if (!local_utf8 || gui_key_grab || gui_mouse_event_pending
+        || gui_cursor_mode || gui_key_combo_buffer[0]
+        || (gui_current_window->buffer->text_search != GUI_TEXT_SEARCH_DISABLED)
+        || (gui_key_get_current_context () != GUI_KEY_CONTEXT_DEFAULT))
+    {
+        return 0;
+    }
+
+    key_start[1] = '\0';
+    for (i = start; i < gui_key_buffer_size; i++)
+    {
+        if ((gui_key_buffer[i] < 32) || (gui_key_buffer[i] == 127))
+            break;
+        key_start[0] = (char)gui_key_buffer[i];
+        if (gui_key_search_part (gui_current_window->buffer,
+                                 GUI_KEY_CONTEXT_DEFAULT, key_start)
+            || gui_key_search_part (NULL, GUI_KEY_CONTEXT_DEFAULT, key_start))
+        {
+            break;
+        }
+    }
+    length = i - start;
+    if (length == 0)
+        return 0;
+
+    text = malloc (length + 1);
+    if (!text)
+        return 0;
+    for (i = 0; i < length; i++)
+    {
+        text[i] = (char)gui_key_buffer[start + i];
+    }
+    text[length] = '\0';
+
+    /*
+     * replace invalid chars by "?", and leave an incomplete UTF-8 char at the
+     * end of text in keyboard buffer (it is handled as a key)
+     */
+    ptr_char = text;
+    while (ptr_char && ptr_char[0])
+    {
+        (void) utf8_is_valid (ptr_char, -1, &ptr_error);
+        if (!ptr_error)
+            break;
+        next_char = (char *)utf8_next_char (ptr_error);
+        if (next_char && next_char[0])
+        {
+            ptr_char = ptr_error;
+            while (ptr_char < next_char)
+            {
+                ptr_char[0] = '?';
+                ptr_char++;
+            }
+        }
+        else
+        {
+            ptr_error[0] = '\0';
+            break;
+        }
+        ptr_char = next_char;
+    }
+    length = strlen (text);
+
+    if (length > 0)
+    {
+        (void) hook_signal_send ("key_pressed",
+                                 WEECHAT_HOOK_SIGNAL_STRING, text);
+        if (save_undo)
+            gui_buffer_undo_snap (gui_current_window->buffer);
+        gui_key_paste_text_add (gui_current_window->buffer, text, save_undo);
+    }
+
+    free (text);
+
+    return length;
+}
+
 /*
  * Flushes keyboard buffer.
  */
@@ -304,7 +399,7 @@ gui_key_default_bindings (int context)
 void
 gui_key_flush (int paste)
 {
-    int i, key, last_key_used, insert_ok, undo_done;
+    int i, key, last_key_used, insert_ok, undo_done, length_paste;
     static char key_str[64] = { '\0' };
     static int length_key_str = 0;
     char key_temp[2], *key_utf, *input_old, *ptr_char, *next_char, *ptr_error;
@@ -329,6 +424,20 @@ gui_key_flush (int paste)
     old_buffer = NULL;
     for (i = 0; i < gui_key_buffer_size; i++)
     {
+        /* pasted text which is not a key is added to input at once */
+        if (paste && !key_str[0])
+        {
+            length_paste = gui_key_flush_paste_text (i,
+                                                     (!undo_done) ? 1 : 0);
+            if (length_paste > 0)
+            {
+                undo_done = 1;
+                i += length_paste - 1;
+                last_key_used = i;
+                continue;
+            }
+        }
+
         key = gui_key_buffer[i];
         insert_ok = 1;
         utf_partial_char[0] = '\0';
@@ -423,11 +532,22 @@ gui_key_flush (int paste)
             {
                 if (!paste || !undo_done)
                     gui_buffer_undo_snap (gui_current_window->buffer);
-                gui_input_insert_string (gui_current_window->buffer,
-                                         key_str, -1);
-                gui_input_text_changed_modifier_and_signal (gui_current_window->buffer,
-                                                            (!paste || !undo_done) ? 1 : 0,
-                                                            1); /* stop completion */
+                if (paste
+                    && (gui_current_window->buffer->text_search == GUI_TEXT_SEARCH_DISABLED))
+                {
+                    /* pasted text is inserted in input at once, later */
+                    gui_key_paste_text_add (gui_current_window->buffer,
+                                            key_str,
+                                            (!undo_done) ? 1 : 0);
+                }
+                else
+                {
+                    gui_input_insert_string (gui_current_window->buffer,
+                                             key_str, -1);
+                    gui_input_text_changed_modifier_and_signal (gui_current_window->buffer,
+                                                                (!paste || !undo_done) ? 1 : 0,
+                                                                1); /* stop completion */
+                }
                 undo_done = 1;
             }
 
@@ -489,6 +609,9 @@ gui_key_flush (int paste)
             last_key_used = i;
     }
 
+    /* insert pasted text in input */
+    gui_key_paste_text_insert ();
+
     if (last_key_used == gui_key_buffer_size - 1)
         gui_key_buffer_reset ();
     else if (last_key_used >= 0)
@@ -506,7 +629,8 @@ int
 gui_key_read_cb (const void *pointer, void *data, int fd)
 {
     int ret, i, accept_paste, cancel_paste, text_added_to_buffer, pos;
-    unsigned char buffer[4096];
+    int paste_bracketed, old_size, start_index;
+    static unsigned char buffer[65536];
 
     /* make C compiler happy */
     (void) pointer;
@@ -516,6 +640,8 @@ gui_key_read_cb (const void *pointer, void *data, int fd)
     accept_paste = 0;
     cancel_paste = 0;
     text_added_to_buffer = 0;
+    paste_bracketed = gui_key_paste_bracketed;
+    old_size = gui_key_buffer_size;
 
     ret = read (STDIN_FILENO, buffer, sizeof (buffer));
     if (ret == 0)
@@ -598,7 +724,20 @@ gui_key_read_cb (const void *pointer, void *data, int fd)
 
     if (gui_key_paste_bracketed)
     {
-        pos = gui_key_buffer_search (0, -1, GUI_KEY_BRACKETED_PASTE_END);
+        /*
+         * if bracketed paste was already started before this read, search
+         * end of paste only in the new chars (and the few chars before,
+         * in case the code was split between two reads)
+         */
+        start_index = 0;
+        if (paste_bracketed && (old_size <= gui_key_buffer_size))
+        {
+            start_index = old_size - (GUI_KEY_BRACKETED_PASTE_LENGTH - 1);
+            if (start_index < 0)
+                start_index = 0;
+        }
+        pos = gui_key_buffer_search (start_index, -1,
+                                     GUI_KEY_BRACKETED_PASTE_END);
         if (pos >= 0)
         {
             /* remove the code for end of bracketed paste (ESC[201~) */
@@ -620,5 +759,8 @@ gui_key_read_cb (const void *pointer, void *data, int fd)
         }
     }
 
+    /* display result of keys without delay (refresh rate is not limited) */
+    gui_main_refresh_immediate = 1;
+
     return WEECHAT_RC_OK;
 }
@@ -29,6 +29,7 @@
 #include <string.h>
 #include <signal.h>
 #include <time.h>
+#include <sys/time.h>
 
 #include "../../core/weechat.h"
 #include "../../core/wee-command.h"
@@ -47,6 +48,7 @@
 #include "../gui-buffer.h"
 #include "../gui-chat.h"
 #include "../gui-color.h"
+#include "../gui-completion.h"
 #include "../gui-cursor.h"
 #include "../gui-filter.h"
 #include "../gui-hotlist.h"
@@ -64,6 +66,10 @@ volatile sig_atomic_t gui_signal_sigwinch_received = 0;  /* sigwinch signal */
                                        /* (terminal has been resized)       */
 int gui_term_cols = 0;                 /* number of columns in terminal     */
 int gui_term_lines = 0;                /* number of lines in terminal       */
+int gui_main_refresh_immediate = 0;    /* 1 to refresh screen without delay */
+                                       /* (for example after a key pressed) */
+struct timeval gui_main_last_refresh;  /* last refresh of screen            */
+struct t_hook *gui_main_refresh_timer = NULL; /* timer for delayed refresh  */
 
 
 /*
@@ -419,6 +425,117 @@ gui_main_refreshes ()
     }
 }
 
+/*
+ * Checks if something must be refreshed on screen (by function
+ * gui_main_refreshes).
+ *
+ * Returns:
+ *   1: refresh needed
+ *   0: nothing to refresh
+ */
+
+int
+gui_main_refresh_needed ()
+{
+    struct t_gui_window *ptr_win;
+    struct t_gui_buffer *ptr_buffer;
+    struct t_gui_bar *ptr_bar;
+
+    if (gui_color_buffer_refresh_needed || gui_window_refresh_needed)
+        return 1;
+
+    for (ptr_buffer = gui_buffers; ptr_buffer;
+         ptr_buffer = ptr_buffer->next_buffer)
+    {
+        if (ptr_buffer->chat_refresh_needed)
+            return 1;
+        if (ptr_buffer->own_lines
+            && (ptr_buffer->own_lines->buffer_max_length_refresh
+                || ptr_buffer->own_lines->prefix_max_length_refresh))
+        {
+            return 1;
+        }
+        if (ptr_buffer->mixed_lines
+            && (ptr_buffer->mixed_lines->buffer_max_length_refresh
+                || ptr_buffer->mixed_lines->prefix_max_length_refresh))
+        {
+            return 1;
+        }
+    }
+
+    for (ptr_bar = gui_bars; ptr_bar; ptr_bar = ptr_bar->next_bar)
+    {
+        if (ptr_bar->bar_refresh_needed)
+            return 1;
+    }
+
+    for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
+    {
+        if (ptr_win->refresh_needed)
+            return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Callback for timer of delayed refresh: nothing is done here, the screen is
+ * refreshed by the main loop after timers are executed.
+ */
+
+int
+gui_main_refresh_timer_cb (const void *pointer, void *data,
+                           int remaining_calls)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) remaining_calls;
+
+    gui_main_refresh_timer = NULL;
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Checks if screen can be refreshed now (called only if a refresh is needed),
+ * according to option weechat.look.refresh_max_fps; if the last refresh is
+ * too recent, a timer is scheduled so that the main loop wakes up for the
+ * delayed refresh (and meanwhile it processes other events, which are
+ * displayed together).
+ *
+ * Returns:
+ *   1: screen can be refreshed now
+ *   0: refresh must be delayed
+ */
+
+int
+gui_main_refresh_allowed ()
+{
+    struct timeval tv_now;
+    long long interval, elapsed;
+    int max_fps;
+
+    max_fps = CONFIG_INTEGER(config_look_refresh_max_fps);
+    if ((max_fps <= 0) || gui_main_refresh_immediate)
+        return 1;
+
+    gettimeofday (&tv_now, NULL);
+    interval = 1000000LL / max_fps;
+    elapsed = util_timeval_diff (&gui_main_last_refresh, &tv_now);
+    if ((elapsed < 0) || (elapsed >= interval))
+        return 1;
+
+    if (!gui_main_refresh_timer)
+    {
+        gui_main_refresh_timer = hook_timer (
+            NULL, (interval - elapsed + 999) / 1000, 0, 1,
+            &gui_main_refresh_timer_cb, NULL, NULL);
+    }
+
+    return 0;
+}
+
 /*
  * Main loop for WeeChat with ncurses GUI.
  */
@@ -440,6 +557,9 @@ gui_main_loop ()
 
     gui_window_ask_refresh (1);
 
+    gui_main_last_refresh.tv_sec = 0;
+    gui_main_last_refresh.tv_usec = 0;
+
     while (!weechat_quit)
     {
         /* execute timer hooks */
@@ -452,6 +572,7 @@ gui_main_loop ()
             gui_color_pairs_auto_reset_last = time (NULL);
             gui_color_pairs_auto_reset = 0;
             gui_color_pairs_auto_reset_pending = 1;
+            gui_main_refresh_immediate = 1;
         }
 
         if (gui_signal_sigwinch_received)
@@ -459,11 +580,24 @@ gui_main_loop ()
             gui_window_ask_refresh (2);
             gui_signal_sigwinch_received = 0;
             send_signal_sigwinch = 1;
+            gui_main_refresh_immediate = 1;
         }
 
-        gui_main_refreshes ();
-        if (gui_window_refresh_needed && !gui_window_bare_display)
+        /* send signal "hotlist_changed" (once) if hotlist has changed */
+        gui_hotlist_send_changed_signal ();
+
+        /*
+         * refresh screen only if something has changed (so that the timer
+         * for a delayed refresh is scheduled only if a refresh is delayed)
+         */
+        if (gui_main_refresh_needed () && gui_main_refresh_allowed ())
+        {
             gui_main_refreshes ();
+            if (gui_window_refresh_needed && !gui_window_bare_display)
+                gui_main_refreshes ();
+            gettimeofday (&gui_main_last_refresh, NULL);
+            gui_main_refresh_immediate = 0;
+        }
 
         if (send_signal_sigwinch)
         {
@@ -568,6 +702,9 @@ gui_main_end (int clean_exit)
 
         /* free some variables used for hotlist */
         gui_hotlist_end ();
+
+        /* free some variables used for completion */
+        gui_completion_end ();
     }
 
     /* end of Curses output */
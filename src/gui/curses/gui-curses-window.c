@@ -1259,6 +1259,12 @@ gui_window_switch_to_buffer (struct t_gui_window *window,
                                                        window->win_chat_width,
                                                        window->win_chat_y,
                                                        window->win_chat_x);
+        /*
+         * allow use of insert/delete line of terminal: new lines at bottom
+         * of chat area are displayed by scrolling it
+         */
+        if (GUI_WINDOW_OBJECTS(window)->win_chat)
+            idlok (GUI_WINDOW_OBJECTS(window)->win_chat, TRUE);
     }
     gui_window_draw_separators (window);
     gui_buffer_ask_chat_refresh (window->buffer, 2);
@@ -1354,6 +1360,9 @@ gui_window_page_up (struct t_gui_window *window)
     switch (window->buffer->type)
     {
         case GUI_BUFFER_TYPE_FORMATTED:
+            /* first line displayed: uncompress lines before it (if any) */
+            if (window->scroll->first_line_displayed)
+                gui_line_uncompress_blocks (window->buffer, 1);
             if (!window->scroll->first_line_displayed)
             {
                 gui_chat_calculate_line_diff (window, &window->scroll->start_line,
@@ -1450,6 +1459,9 @@ gui_window_scroll_up (struct t_gui_window *window)
     switch (window->buffer->type)
     {
         case GUI_BUFFER_TYPE_FORMATTED:
+            /* first line displayed: uncompress lines before it (if any) */
+            if (window->scroll->first_line_displayed)
+                gui_line_uncompress_blocks (window->buffer, 1);
             if (!window->scroll->first_line_displayed)
             {
                 gui_chat_calculate_line_diff (window, &window->scroll->start_line,
@@ -1539,6 +1551,7 @@ gui_window_scroll_top (struct t_gui_window *window)
     switch (window->buffer->type)
     {
         case GUI_BUFFER_TYPE_FORMATTED:
+            gui_line_uncompress (window->buffer);
             if (!window->scroll->first_line_displayed)
             {
                 window->scroll->start_line = gui_line_get_first_displayed (window->buffer);
@@ -72,6 +72,7 @@ struct t_gui_bar_window_curses_objects
 };
 
 extern int gui_term_cols, gui_term_lines;
+extern int gui_main_refresh_immediate;
 extern struct t_gui_color *gui_weechat_colors;
 extern int gui_color_term_colors;
 extern int gui_color_num_pairs;
@@ -92,6 +93,11 @@ extern int gui_color_weechat_get_pair (int weechat_color);
 extern void gui_color_alloc ();
 
 /* chat functions */
+extern int gui_chat_display_line (struct t_gui_window *window,
+                                  struct t_gui_line *line,
+                                  int count, int simulate);
+extern int gui_chat_get_line_height (struct t_gui_window *window,
+                                     struct t_gui_line *line);
 extern void gui_chat_calculate_line_diff (struct t_gui_window *window,
                                           struct t_gui_line **line,
                                           int *line_pos, int difference);
@@ -25,6 +25,7 @@
 
 #include <stdlib.h>
 #include <stddef.h>
+#include <limits.h>
 #include <string.h>
 
 #include "../core/weechat.h"
@@ -64,6 +65,9 @@ char *gui_bar_item_names[GUI_BAR_NUM_ITEMS] =
   "buffer_zoom", "buffer_nicklist_count", "scroll", "hotlist", "completion",
   "buffer_title", "buffer_nicklist", "window_number", "mouse_status", "away"
 };
+struct t_hashtable *gui_bar_item_index = NULL;  /* positions of items in  */
+                                                /* bars (key: item name) */
+int gui_bar_item_index_refresh_needed = 1;      /* index must be built   */
 char *gui_bar_items_default_for_bars[][2] =
 { { GUI_BAR_DEFAULT_NAME_INPUT,
     "[input_prompt]+(away),[input_search],[input_paste],input_text" },
@@ -365,12 +369,15 @@ gui_bar_item_get_vars (const char *item_name,
  *               returns: color(delimiter) + "[" +
  *                        (value of item "time") + color(delimiter) + "]"
  *
+ * Argument extra_info is given to the callback only if the item is built with
+ * rows of bar window (otherwise the callback receives NULL).
+ *
  * Note: result must be freed after use.
  */
 
 char *
 gui_bar_item_get_value (struct t_gui_bar *bar, struct t_gui_window *window,
-                        int item, int subitem)
+                        int item, int subitem, struct t_hashtable *extra_info)
 {
     char *item_value, delimiter_color[32], bar_color[32];
     char *result, str_attr[8];
@@ -404,7 +411,7 @@ gui_bar_item_get_value (struct t_gui_bar *bar, struct t_gui_window *window,
                 ptr_item,
                 window,
                 buffer,
-                NULL);
+                (ptr_item->rows_window) ? extra_info : NULL);
         }
         if (item_value && !item_value[0])
         {
@@ -497,6 +504,45 @@ gui_bar_item_get_value (struct t_gui_bar *bar, struct t_gui_window *window,
     return result;
 }
 
+/*
+ * Checks if an item of a bar is built with rows of bar window (these rows
+ * are then given to the item callback in extra_info).
+ *
+ * Returns:
+ *   1: item is built with rows of bar window
+ *   0: item is built with all rows
+ */
+
+int
+gui_bar_item_rows_window (struct t_gui_bar *bar, struct t_gui_window *window,
+                          int item, int subitem)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_bar_item *ptr_item;
+
+    if (!bar || !bar->items_array[item][subitem]
+        || !bar->items_name[item][subitem])
+    {
+        return 0;
+    }
+
+    buffer = (window) ?
+        window->buffer : ((gui_current_window) ? gui_current_window->buffer : NULL);
+
+    if (bar->items_buffer[item][subitem])
+    {
+        buffer = gui_buffer_search_by_full_name (bar->items_buffer[item][subitem]);
+        if (!buffer)
+            return 0;
+    }
+
+    ptr_item = gui_bar_item_search_with_plugin ((buffer) ? buffer->plugin : NULL,
+                                                0,
+                                                bar->items_name[item][subitem]);
+
+    return (ptr_item && ptr_item->rows_window) ? 1 : 0;
+}
+
 /*
  * Counts number of lines in item.
  */
@@ -556,6 +602,7 @@ gui_bar_item_new (struct t_weechat_plugin *plugin, const char *name,
         new_bar_item->build_callback = build_callback;
         new_bar_item->build_callback_pointer = build_callback_pointer;
         new_bar_item->build_callback_data = build_callback_data;
+        new_bar_item->rows_window = 0;
 
         /* add bar item to bar items queue */
         new_bar_item->prev_item = last_gui_bar_item;
@@ -573,6 +620,99 @@ gui_bar_item_new (struct t_weechat_plugin *plugin, const char *name,
     return NULL;
 }
 
+/*
+ * Callback called to free positions of an item in index.
+ */
+
+void
+gui_bar_item_index_free_value_cb (struct t_hashtable *hashtable,
+                                  const void *key, void *value)
+{
+    struct t_gui_bar_item_position *ptr_position, *next_position;
+
+    /* make C compiler happy */
+    (void) hashtable;
+    (void) key;
+
+    ptr_position = (struct t_gui_bar_item_position *)value;
+    while (ptr_position)
+    {
+        next_position = ptr_position->next_position;
+        free (ptr_position);
+        ptr_position = next_position;
+    }
+}
+
+/*
+ * Builds index of items used in bars: for each item name, list of positions
+ * (bar, item, sub item), sorted like bars and items.
+ *
+ * The index is built again on next update of an item when items of a bar
+ * have changed (or when a bar is deleted).
+ */
+
+void
+gui_bar_item_index_build ()
+{
+    struct t_gui_bar *ptr_bar;
+    struct t_gui_bar_item_position *new_position, *ptr_position;
+    int i, j;
+
+    if (gui_bar_item_index)
+    {
+        hashtable_remove_all (gui_bar_item_index);
+    }
+    else
+    {
+        gui_bar_item_index = hashtable_new (32,
+                                            WEECHAT_HASHTABLE_STRING,
+                                            WEECHAT_HASHTABLE_POINTER,
+                                            NULL,
+                                            NULL);
+        if (!gui_bar_item_index)
+            return;
+        gui_bar_item_index->callback_free_value = &gui_bar_item_index_free_value_cb;
+    }
+
+    for (ptr_bar = gui_bars; ptr_bar; ptr_bar = ptr_bar->next_bar)
+    {
+        for (i = 0; i < ptr_bar->items_count; i++)
+        {
+            for (j = 0; j < ptr_bar->items_subcount[i]; j++)
+            {
+                if (!ptr_bar->items_name[i][j])
+                    continue;
+                new_position = malloc (sizeof (*new_position));
+                if (!new_position)
+                    continue;
+                new_position->bar = ptr_bar;
+                new_position->item = i;
+                new_position->subitem = j;
+                new_position->next_position = NULL;
+
+                /* add position at the end of list */
+                ptr_position = hashtable_get (gui_bar_item_index,
+                                              ptr_bar->items_name[i][j]);
+                if (ptr_position)
+                {
+                    while (ptr_position->next_position)
+                    {
+                        ptr_position = ptr_position->next_position;
+                    }
+                    ptr_position->next_position = new_position;
+                }
+                else
+                {
+                    hashtable_set (gui_bar_item_index,
+                                   ptr_bar->items_name[i][j], new_position);
+                }
+            }
+        }
+    }
+
+    gui_bar_item_index_refresh_needed = 0;
+}
+
 /*
  * Updates an item on all bars displayed on screen.
  */
@@ -583,53 +723,53 @@ gui_bar_item_update (const char *item_name)
     struct t_gui_bar *ptr_bar;
     struct t_gui_window *ptr_window;
     struct t_gui_bar_window *ptr_bar_window;
-    int i, j, check_bar_conditions, condition_ok;
+    struct t_gui_bar_item_position *ptr_position;
+    int check_bar_conditions, condition_ok;
 
     if (!item_name)
         return;
 
-    for (ptr_bar = gui_bars; ptr_bar; ptr_bar = ptr_bar->next_bar)
+    if (gui_bar_item_index_refresh_needed)
+        gui_bar_item_index_build ();
+
+    ptr_position = (gui_bar_item_index) ?
+        hashtable_get (gui_bar_item_index, item_name) : NULL;
+    while (ptr_position)
     {
+        ptr_bar = ptr_position->bar;
         check_bar_conditions = 0;
 
-        for (i = 0; i < ptr_bar->items_count; i++)
+        /* positions of item in this bar */
+        while (ptr_position && (ptr_position->bar == ptr_bar))
         {
-            for (j = 0; j < ptr_bar->items_subcount[i]; j++)
+            if (!CONFIG_BOOLEAN(ptr_bar->options[GUI_BAR_OPTION_HIDDEN]))
+                check_bar_conditions = 1;
+
+            if (CONFIG_INTEGER(ptr_bar->options[GUI_BAR_OPTION_TYPE]) == GUI_BAR_TYPE_ROOT)
             {
-                if (ptr_bar->items_name[i][j]
-                    && (strcmp (ptr_bar->items_name[i][j], item_name) == 0))
+                if (ptr_bar->bar_window)
                 {
-                    if (!CONFIG_BOOLEAN(ptr_bar->options[GUI_BAR_OPTION_HIDDEN]))
-                        check_bar_conditions = 1;
-
-                    if (CONFIG_INTEGER(ptr_bar->options[GUI_BAR_OPTION_TYPE]) == GUI_BAR_TYPE_ROOT)
-                    {
-                        if (ptr_bar->bar_window)
-                        {
-                            ptr_bar->bar_window->items_refresh_needed[i][j] = 1;
-                        }
-                    }
-                    else
+                    ptr_bar->bar_window->items_refresh_needed[ptr_position->item][ptr_position->subitem] = 1;
+                }
+            }
+            else
+            {
+                for (ptr_window = gui_windows; ptr_window;
+                     ptr_window = ptr_window->next_window)
+                {
+                    ptr_bar_window = gui_bar_window_search_bar (ptr_window,
+                                                                ptr_bar);
+                    if (ptr_bar_window)
                     {
-                        for (ptr_window = gui_windows; ptr_window;
-                             ptr_window = ptr_window->next_window)
-                        {
-                            for (ptr_bar_window = ptr_window->bar_windows;
-                                 ptr_bar_window;
-                                 ptr_bar_window = ptr_bar_window->next_bar_window)
-                            {
-                                if (ptr_bar_window->bar == ptr_bar)
-                                {
-                                    ptr_bar_window->items_refresh_needed[i][j] = 1;
-                                }
-                            }
-                        }
+                        ptr_bar_window->items_refresh_needed[ptr_position->item][ptr_position->subitem] = 1;
                     }
-                    gui_bar_ask_refresh (ptr_bar);
                 }
             }
+            ptr_position = ptr_position->next_position;
         }
 
+        gui_bar_ask_refresh (ptr_bar);
+
         /*
          * evaluate bar conditions (if needed) to check if bar must be toggled
          * (hidden if shown, or shown if hidden)
@@ -1658,8 +1798,58 @@ gui_bar_item_buffer_title_cb (const void *pointer, void *data,
     return (buffer->title) ? strdup (buffer->title) : NULL;
 }
 
+/*
+ * Returns color for a nick/group in nicklist: the color can be a color name
+ * or the name of a color option (if it contains a dot).
+ */
+
+const char *
+gui_bar_item_nicklist_get_color (const char *color)
+{
+    struct t_config_option *ptr_option;
+
+    if (!color)
+        return NULL;
+
+    if (strchr (color, '.'))
+    {
+        config_file_search_with_string (color, NULL, NULL, &ptr_option, NULL);
+        return (ptr_option) ?
+            gui_color_get_custom (gui_color_get_name (CONFIG_COLOR(ptr_option))) : NULL;
+    }
+
+    return gui_color_get_custom (color);
+}
+
+/*
+ * Returns length of a nick/group in nicklist (number of chars displayed on
+ * screen, without colors).
+ */
+
+int
+gui_bar_item_nicklist_get_length (struct t_gui_buffer *buffer,
+                                  struct t_gui_nick_group *group,
+                                  struct t_gui_nick *nick)
+{
+    if (nick)
+    {
+        return ((buffer->nicklist_display_groups) ? nick->group->level : 0)
+            + ((nick->prefix) ? utf8_strlen_screen (nick->prefix) : 0)
+            + utf8_strlen_screen (nick->name);
+    }
+
+    return group->level - 1
+        + utf8_strlen_screen (gui_nicklist_get_group_start (group->name));
+}
+
 /*
  * Bar item with nicklist.
+ *
+ * If the bar window gives the visible rows in extra_info, only these rows
+ * are formatted, and other rows are replaced by a space (the first one is
+ * padded to the length of the longest hidden row, so that the bar size
+ * computed with content is the same; this is not done if the bar has a fixed
+ * size).
  */
 
 char *
@@ -1671,49 +1861,60 @@ gui_bar_item_buffer_nicklist_cb (const void *pointer, void *data,
 {
     struct t_gui_nick_group *ptr_group;
     struct t_gui_nick *ptr_nick;
-    struct t_config_option *ptr_option;
-    int i, length;
-    char *str_nicklist;
+    const char *ptr_value, *ptr_color;
+    char **str_nicklist, *error;
+    long number;
+    int i, row, rows_start, rows_height, size_fixed, length, padding;
 
     /* make C compiler happy */
     (void) pointer;
     (void) data;
     (void) item;
     (void) window;
-    (void) extra_info;
 
     if (!buffer)
         return NULL;
 
-    length = 1;
-    ptr_group = NULL;
-    ptr_nick = NULL;
-    gui_nicklist_get_next_item (buffer, &ptr_group, &ptr_nick);
-    while (ptr_group || ptr_nick)
+    /* rows displayed in the bar window (by default all rows) */
+    rows_start = 0;
+    rows_height = INT_MAX;
+    size_fixed = 0;
+    if (extra_info)
     {
-        if ((ptr_nick && ptr_nick->visible)
-            || (ptr_group && !ptr_nick
-                && buffer->nicklist_display_groups
-                && ptr_group->visible))
+        ptr_value = hashtable_get (extra_info, "_bar_window_rows_start");
+        if (ptr_value)
         {
-            if (ptr_nick)
-                length += ptr_nick->group->level + 16 /* color */
-                    + ((ptr_nick->prefix) ? strlen (ptr_nick->prefix) : 0)
-                    + 16 /* color */
-                    + strlen (ptr_nick->name) + 1;
-            else
-                length += ptr_group->level - 1
-                    + 16 /* color */
-                    + strlen (gui_nicklist_get_group_start (ptr_group->name))
-                    + 1;
+            error = NULL;
+            number = strtol (ptr_value, &error, 10);
+            if (error && !error[0])
+            {
+                ptr_value = hashtable_get (extra_info,
+                                           "_bar_window_rows_height");
+                if (ptr_value)
+                {
+                    rows_start = number;
+                    error = NULL;
+                    number = strtol (ptr_value, &error, 10);
+                    if (error && !error[0] && (number >= 0))
+                        rows_height = number;
+                    else
+                        rows_start = 0;
+                }
+            }
         }
-        gui_nicklist_get_next_item (buffer, &ptr_group, &ptr_nick);
+        ptr_value = hashtable_get (extra_info, "_bar_window_size_fixed");
+        if (ptr_value && (strcmp (ptr_value, "1") == 0))
+            size_fixed = 1;
     }
 
-    str_nicklist = malloc (length);
-    if (str_nicklist)
+    /*
+     * get length of the longest hidden row (not needed if bar size is fixed:
+     * the content does not change the size of bar window)
+     */
+    padding = 0;
+    if ((rows_height != INT_MAX) && !size_fixed)
     {
-        str_nicklist[0] = '\0';
+        row = 0;
         ptr_group = NULL;
         ptr_nick = NULL;
         gui_nicklist_get_next_item (buffer, &ptr_group, &ptr_nick);
@@ -1724,81 +1925,85 @@ gui_bar_item_buffer_nicklist_cb (const void *pointer, void *data,
                     && buffer->nicklist_display_groups
                     && ptr_group->visible))
             {
-                if (str_nicklist[0])
-                    strcat (str_nicklist, "\n");
+                if ((row < rows_start) || (row - rows_start >= rows_height))
+                {
+                    length = gui_bar_item_nicklist_get_length (buffer,
+                                                               ptr_group,
+                                                               ptr_nick);
+                    if (length > padding)
+                        padding = length;
+                }
+                row++;
+            }
+            gui_nicklist_get_next_item (buffer, &ptr_group, &ptr_nick);
+        }
+    }
+
+    str_nicklist = string_dyn_alloc (256);
+    if (!str_nicklist)
+        return NULL;
 
-                if (ptr_nick)
+    row = 0;
+    ptr_group = NULL;
+    ptr_nick = NULL;
+    gui_nicklist_get_next_item (buffer, &ptr_group, &ptr_nick);
+    while (ptr_group || ptr_nick)
+    {
+        if ((ptr_nick && ptr_nick->visible)
+            || (ptr_group && !ptr_nick
+                && buffer->nicklist_display_groups
+                && ptr_group->visible))
+        {
+            if (row > 0)
+                string_dyn_concat (str_nicklist, "\n");
+
+            if ((row < rows_start) || (row - rows_start >= rows_height))
+            {
+                /* hidden row: not formatted */
+                string_dyn_concat (str_nicklist, " ");
+                for (i = 1; i < padding; i++)
                 {
-                    if (buffer->nicklist_display_groups)
-                    {
-                        for (i = 0; i < ptr_nick->group->level; i++)
-                        {
-                            strcat (str_nicklist, " ");
-                        }
-                    }
-                    if (ptr_nick->prefix_color)
-                    {
-                        if (strchr (ptr_nick->prefix_color, '.'))
-                        {
-                            config_file_search_with_string (ptr_nick->prefix_color,
-                                                            NULL, NULL, &ptr_option,
-                                                            NULL);
-                            if (ptr_option)
-                                strcat (str_nicklist, gui_color_get_custom (gui_color_get_name (CONFIG_COLOR(ptr_option))));
-                        }
-                        else
-                        {
-                            strcat (str_nicklist, gui_color_get_custom (ptr_nick->prefix_color));
-                        }
-                    }
-                    if (ptr_nick->prefix)
-                        strcat (str_nicklist, ptr_nick->prefix);
-                    if (ptr_nick->color)
-                    {
-                        if (strchr (ptr_nick->color, '.'))
-                        {
-                            config_file_search_with_string (ptr_nick->color,
-                                                            NULL, NULL, &ptr_option,
-                                                            NULL);
-                            if (ptr_option)
-                                strcat (str_nicklist, gui_color_get_custom (gui_color_get_name (CONFIG_COLOR(ptr_option))));
-                        }
-                        else
-                        {
-                            strcat (str_nicklist, gui_color_get_custom (ptr_nick->color));
-                        }
-                    }
-                    strcat (str_nicklist, ptr_nick->name);
+                    string_dyn_concat (str_nicklist, " ");
                 }
-                else
+                padding = 0;
+            }
+            else if (ptr_nick)
+            {
+                if (buffer->nicklist_display_groups)
                 {
-                    for (i = 0; i < ptr_group->level - 1; i++)
-                    {
-                        strcat (str_nicklist, " ");
-                    }
-                    if (ptr_group->color)
+                    for (i = 0; i < ptr_nick->group->level; i++)
                     {
-                        if (strchr (ptr_group->color, '.'))
-                        {
-                            config_file_search_with_string (ptr_group->color,
-                                                            NULL, NULL, &ptr_option,
-                                                            NULL);
-                            if (ptr_option)
-                                strcat (str_nicklist, gui_color_get_custom (gui_color_get_name (CONFIG_COLOR(ptr_option))));
-                        }
-                        else
-                        {
-                            strcat (str_nicklist, gui_color_get_custom (ptr_group->color));
-                        }
+                        string_dyn_concat (str_nicklist, " ");
                     }
-                    strcat (str_nicklist, gui_nicklist_get_group_start (ptr_group->name));
                 }
+                ptr_color = gui_bar_item_nicklist_get_color (ptr_nick->prefix_color);
+                if (ptr_color)
+                    string_dyn_concat (str_nicklist, ptr_color);
+                if (ptr_nick->prefix)
+                    string_dyn_concat (str_nicklist, ptr_nick->prefix);
+                ptr_color = gui_bar_item_nicklist_get_color (ptr_nick->color);
+                if (ptr_color)
+                    string_dyn_concat (str_nicklist, ptr_color);
+                string_dyn_concat (str_nicklist, ptr_nick->name);
             }
-            gui_nicklist_get_next_item (buffer, &ptr_group, &ptr_nick);
+            else
+            {
+                for (i = 0; i < ptr_group->level - 1; i++)
+                {
+                    string_dyn_concat (str_nicklist, " ");
+                }
+                ptr_color = gui_bar_item_nicklist_get_color (ptr_group->color);
+                if (ptr_color)
+                    string_dyn_concat (str_nicklist, ptr_color);
+                string_dyn_concat (str_nicklist,
+                                   gui_nicklist_get_group_start (ptr_group->name));
+            }
+            row++;
         }
+        gui_nicklist_get_next_item (buffer, &ptr_group, &ptr_nick);
     }
 
-    return str_nicklist;
+    return string_dyn_free (str_nicklist, 0);
 }
 
 /*
@@ -2082,6 +2287,7 @@ gui_bar_item_hook_signal (const char *signal, const char *item)
 void
 gui_bar_item_init ()
 {
+    struct t_gui_bar_item *ptr_item;
     char name[128];
 
     /* input paste */
@@ -2296,9 +2502,11 @@ gui_bar_item_init ()
                               gui_bar_item_names[GUI_BAR_ITEM_BUFFER_TITLE]);
 
     /* buffer nicklist */
-    gui_bar_item_new (NULL,
-                      gui_bar_item_names[GUI_BAR_ITEM_BUFFER_NICKLIST],
-                      &gui_bar_item_buffer_nicklist_cb, NULL, NULL);
+    ptr_item = gui_bar_item_new (NULL,
+                                 gui_bar_item_names[GUI_BAR_ITEM_BUFFER_NICKLIST],
+                                 &gui_bar_item_buffer_nicklist_cb, NULL, NULL);
+    if (ptr_item)
+        ptr_item->rows_window = 1;
     gui_bar_item_hook_signal ("nicklist_*",
                               gui_bar_item_names[GUI_BAR_ITEM_BUFFER_NICKLIST]);
     gui_bar_item_hook_signal ("window_switch",
@@ -2358,6 +2566,49 @@ gui_bar_item_end ()
 
     /* remove bar items */
     gui_bar_item_free_all ();
+
+    /* remove index of items used in bars */
+    if (gui_bar_item_index)
+    {
+        hashtable_free (gui_bar_item_index);
+        gui_bar_item_index = NULL;
+    }
+    gui_bar_item_index_refresh_needed = 1;
+}
+
+/*
+ * Callback for updating bar item.
+ */
+
+int
+gui_bar_item_hdata_bar_item_update_cb (void *data,
+                                       struct t_hdata *hdata,
+                                       void *pointer,
+                                       struct t_hashtable *hashtable)
+{
+    const char *value;
+    struct t_gui_bar_item *ptr_item;
+    int rc;
+
+    /* make C compiler happy */
+    (void) data;
+
+    ptr_item = (struct t_gui_bar_item *)pointer;
+
+    rc = 0;
+
+    if (hashtable_has_key (hashtable, "rows_window"))
+    {
+        value = hashtable_get (hashtable, "rows_window");
+        if (value)
+        {
+            hdata_set (hdata, pointer, "rows_window", value);
+            rc++;
+            gui_bar_item_update (ptr_item->name);
+        }
+    }
+
+    return rc;
 }
 
 /*
@@ -2375,7 +2626,7 @@ gui_bar_item_hdata_bar_item_cb (const void *pointer, void *data,
     (void) data;
 
     hdata = hdata_new (NULL, hdata_name, "prev_item", "next_item",
-                       0, 0, NULL, NULL);
+                       0, 0, &gui_bar_item_hdata_bar_item_update_cb, NULL);
     if (hdata)
     {
         HDATA_VAR(struct t_gui_bar_item, plugin, POINTER, 0, NULL, "plugin");
@@ -2383,6 +2634,7 @@ gui_bar_item_hdata_bar_item_cb (const void *pointer, void *data,
         HDATA_VAR(struct t_gui_bar_item, build_callback, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_bar_item, build_callback_pointer, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_bar_item, build_callback_data, POINTER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_bar_item, rows_window, INTEGER, 1, NULL, NULL);
         HDATA_VAR(struct t_gui_bar_item, prev_item, POINTER, 0, NULL, hdata_name);
         HDATA_VAR(struct t_gui_bar_item, next_item, POINTER, 0, NULL, hdata_name);
         HDATA_LIST(gui_bar_items, WEECHAT_HDATA_LIST_CHECK_POINTERS);
@@ -2422,6 +2674,8 @@ gui_bar_item_add_to_infolist (struct t_infolist *infolist,
         return 0;
     if (!infolist_new_var_pointer (ptr_item, "build_callback_data", bar_item->build_callback_data))
         return 0;
+    if (!infolist_new_var_integer (ptr_item, "rows_window", bar_item->rows_window))
+        return 0;
 
     return 1;
 }
@@ -2445,6 +2699,7 @@ gui_bar_item_print_log ()
         log_printf ("  build_callback . . . . : 0x%lx", ptr_item->build_callback);
         log_printf ("  build_callback_pointer : 0x%lx", ptr_item->build_callback_pointer);
         log_printf ("  build_callback_data. . : 0x%lx", ptr_item->build_callback_data);
+        log_printf ("  rows_window. . . . . . : %d",    ptr_item->rows_window);
         log_printf ("  prev_item. . . . . . . : 0x%lx", ptr_item->prev_item);
         log_printf ("  next_item. . . . . . . : 0x%lx", ptr_item->next_item);
     }
@@ -49,6 +49,7 @@ enum t_gui_bar_item_weechat
     GUI_BAR_NUM_ITEMS,
 };
 
+struct t_gui_bar;
 struct t_gui_window;
 
 struct t_gui_bar_item
@@ -64,6 +65,8 @@ struct t_gui_bar_item
                                      /* callback called for building item   */
     const void *build_callback_pointer; /* pointer for callback             */
     void *build_callback_data;          /* data for callback                */
+    int rows_window;                 /* 1 if item is built with rows of     */
+                                     /* bar window (given in extra_info)    */
     struct t_gui_bar_item *prev_item; /* link to previous bar item          */
     struct t_gui_bar_item *next_item; /* link to next bar item              */
 };
@@ -74,12 +77,23 @@ struct t_gui_bar_item_hook
     struct t_gui_bar_item_hook *next_hook; /* next hook                     */
 };
 
+/* position of an item in a bar (index of bar items by name) */
+
+struct t_gui_bar_item_position
+{
+    struct t_gui_bar *bar;              /* bar using the item               */
+    int item;                           /* index of item in bar             */
+    int subitem;                        /* index of sub item in bar         */
+    struct t_gui_bar_item_position *next_position; /* next position         */
+};
+
 /* variables */
 
 extern struct t_gui_bar_item *gui_bar_items;
 extern struct t_gui_bar_item *last_gui_bar_item;
 extern char *gui_bar_item_names[];
 extern char *gui_bar_items_default_for_bars[][2];
+extern int gui_bar_item_index_refresh_needed;
 
 /* functions */
 
@@ -95,6 +109,10 @@ extern void gui_bar_item_get_vars (const char *item_name,
                                    char **buffer, char **prefix, char **name,
                                    char **suffix);
 extern char *gui_bar_item_get_value (struct t_gui_bar *bar,
+                                     struct t_gui_window *window,
+                                     int item, int subitem,
+                                     struct t_hashtable *extra_info);
+extern int gui_bar_item_rows_window (struct t_gui_bar *bar,
                                      struct t_gui_window *window,
                                      int item, int subitem);
 extern int gui_bar_item_count_lines (char *string);
@@ -30,6 +30,7 @@
 
 #include "../core/weechat.h"
 #include "../core/wee-config.h"
+#include "../core/wee-hashtable.h"
 #include "../core/wee-hdata.h"
 #include "../core/wee-infolist.h"
 #include "../core/wee-log.h"
@@ -448,6 +449,9 @@ gui_bar_window_content_alloc (struct t_gui_bar_window *bar_window)
     bar_window->items_content = NULL;
     bar_window->items_num_lines = NULL;
     bar_window->items_refresh_needed = NULL;
+    bar_window->items_rows_start = NULL;
+    bar_window->rows_scroll_y = -1;
+    bar_window->rows_height = -1;
     bar_window->screen_col_size = 0;
     bar_window->screen_lines = 0;
     bar_window->items_subcount = calloc (1,
@@ -470,12 +474,18 @@ gui_bar_window_content_alloc (struct t_gui_bar_window *bar_window)
                                                sizeof (*bar_window->items_refresh_needed));
     if (!bar_window->items_refresh_needed)
         goto error;
+    bar_window->items_rows_start = calloc (1,
+                                           bar_window->items_count *
+                                           sizeof (*bar_window->items_rows_start));
+    if (!bar_window->items_rows_start)
+        goto error;
 
     for (i = 0; i < bar_window->items_count; i++)
     {
         bar_window->items_content[i] = NULL;
         bar_window->items_num_lines[i] = NULL;
         bar_window->items_refresh_needed[i] = NULL;
+        bar_window->items_rows_start[i] = NULL;
     }
 
     for (i = 0; i < bar_window->items_count; i++)
@@ -493,6 +503,10 @@ gui_bar_window_content_alloc (struct t_gui_bar_window *bar_window)
                                                       sizeof (**bar_window->items_refresh_needed));
         if (!bar_window->items_refresh_needed[i])
             goto error;
+        bar_window->items_rows_start[i] = malloc (bar_window->items_subcount[i] *
+                                                  sizeof (**bar_window->items_rows_start));
+        if (!bar_window->items_rows_start[i])
+            goto error;
         for (j = 0; j < bar_window->items_subcount[i]; j++)
         {
             if (bar_window->items_content[i])
@@ -501,6 +515,8 @@ gui_bar_window_content_alloc (struct t_gui_bar_window *bar_window)
                 bar_window->items_num_lines[i][j] = 0;
             if (bar_window->items_refresh_needed[i])
                 bar_window->items_refresh_needed[i][j] = 1;
+            if (bar_window->items_rows_start[i])
+                bar_window->items_rows_start[i][j] = -1;
         }
     }
     return;
@@ -541,6 +557,16 @@ error:
         free (bar_window->items_refresh_needed);
         bar_window->items_refresh_needed = NULL;
     }
+    if (bar_window->items_rows_start)
+    {
+        for (i = 0; i < bar_window->items_count; i++)
+        {
+            if (bar_window->items_rows_start[i])
+                free (bar_window->items_rows_start[i]);
+        }
+        free (bar_window->items_rows_start);
+        bar_window->items_rows_start = NULL;
+    }
 }
 
 /*
@@ -570,6 +596,7 @@ gui_bar_window_content_free (struct t_gui_bar_window *bar_window)
             free (bar_window->items_content[i]);
             free (bar_window->items_num_lines[i]);
             free (bar_window->items_refresh_needed[i]);
+            free (bar_window->items_rows_start[i]);
         }
         free (bar_window->items_subcount);
         bar_window->items_subcount = NULL;
@@ -579,11 +606,95 @@ gui_bar_window_content_free (struct t_gui_bar_window *bar_window)
         bar_window->items_num_lines = NULL;
         free (bar_window->items_refresh_needed);
         bar_window->items_refresh_needed = NULL;
+        free (bar_window->items_rows_start);
+        bar_window->items_rows_start = NULL;
     }
 }
 
+/*
+ * Checks if items of a bar window can be built with only the rows visible
+ * on screen: each line of content is displayed on one row (vertical
+ * filling) and the height of bar window does not depend on content.
+ *
+ * Returns:
+ *   1: items can be built with visible rows only
+ *   0: items must be built with all rows
+ */
+
+int
+gui_bar_window_content_visible_rows (struct t_gui_bar_window *bar_window)
+{
+    if (!bar_window)
+        return 0;
+
+    if (gui_bar_get_filling (bar_window->bar) != GUI_BAR_FILLING_VERTICAL)
+        return 0;
+
+    switch (CONFIG_INTEGER(bar_window->bar->options[GUI_BAR_OPTION_POSITION]))
+    {
+        case GUI_BAR_POSITION_LEFT:
+        case GUI_BAR_POSITION_RIGHT:
+            return 1;
+        default:
+            break;
+    }
+
+    return (CONFIG_INTEGER(bar_window->bar->options[GUI_BAR_OPTION_SIZE]) > 0) ?
+        1 : 0;
+}
+
+/*
+ * Returns the row where an item starts in content of a bar window with
+ * vertical filling (previous items must have been built).
+ */
+
+int
+gui_bar_window_content_get_item_row (struct t_gui_bar_window *bar_window,
+                                     int index_item, int index_subitem)
+{
+    int i, sub, row, at_least_one_item, first_sub_item;
+    const char *ptr_content;
+
+    row = 0;
+    at_least_one_item = 0;
+    for (i = 0; i <= index_item; i++)
+    {
+        first_sub_item = 1;
+        for (sub = 0; sub < bar_window->items_subcount[i]; sub++)
+        {
+            if ((i == index_item) && (sub == index_subitem))
+                return (at_least_one_item && first_sub_item) ? row + 1 : row;
+            ptr_content = bar_window->items_content[i][sub];
+            if (ptr_content && ptr_content[0])
+            {
+                /* first sub item starts on a new line */
+                if (at_least_one_item && first_sub_item)
+                    row++;
+                row += bar_window->items_num_lines[i][sub] - 1;
+                first_sub_item = 0;
+                at_least_one_item = 1;
+            }
+        }
+    }
+
+    return row;
+}
+
 /*
  * Builds content of an item for a bar window.
+ *
+ * If the bar window displays one line of content per row and if the item is
+ * built with rows of bar window (for example "buffer_nicklist"), the rows
+ * visible on screen are given to the item callback in extra_info, with these
+ * keys:
+ *   _bar_window_rows_start: first visible row (relative to the first line
+ *                           of item, it can be negative)
+ *   _bar_window_rows_height: number of visible rows
+ *   _bar_window_size_fixed: "1" if the bar has a fixed size (the size of bar
+ *                           window does not depend on content)
+ * The callback can then format only these rows; other rows must not be empty
+ * (for example a single space) so that scroll in bar window is still
+ * possible.
  */
 
 void
@@ -591,6 +702,10 @@ gui_bar_window_content_build_item (struct t_gui_bar_window *bar_window,
                                    struct t_gui_window *window,
                                    int index_item, int index_subitem)
 {
+    struct t_hashtable *extra_info;
+    char str_value[32];
+    int row;
+
     if (!bar_window)
         return;
 
@@ -602,14 +717,50 @@ gui_bar_window_content_build_item (struct t_gui_bar_window *bar_window,
             bar_window->items_content[index_item][index_subitem] = NULL;
         }
         bar_window->items_num_lines[index_item][index_subitem] = 0;
+        bar_window->items_rows_start[index_item][index_subitem] = -1;
 
         /* build item, but only if there's a buffer in window */
         if ((window && window->buffer)
             || (gui_current_window && gui_current_window->buffer))
         {
+            extra_info = NULL;
+            if (gui_bar_window_content_visible_rows (bar_window)
+                && gui_bar_item_rows_window (bar_window->bar, window,
+                                             index_item, index_subitem))
+            {
+                extra_info = hashtable_new (32,
+                                            WEECHAT_HASHTABLE_STRING,
+                                            WEECHAT_HASHTABLE_STRING,
+                                            NULL, NULL);
+                if (extra_info)
+                {
+                    row = gui_bar_window_content_get_item_row (bar_window,
+                                                               index_item,
+                                                               index_subitem);
+                    snprintf (str_value, sizeof (str_value), "%d",
+                              bar_window->scroll_y - row);
+                    hashtable_set (extra_info, "_bar_window_rows_start",
+                                   str_value);
+                    snprintf (str_value, sizeof (str_value), "%d",
+                              bar_window->height);
+                    hashtable_set (extra_info, "_bar_window_rows_height",
+                                   str_value);
+                    if (CONFIG_INTEGER(bar_window->bar->options[GUI_BAR_OPTION_SIZE]) > 0)
+                    {
+                        hashtable_set (extra_info, "_bar_window_size_fixed",
+                                       "1");
+                    }
+                    bar_window->items_rows_start[index_item][index_subitem] = row;
+                    bar_window->rows_scroll_y = bar_window->scroll_y;
+                    bar_window->rows_height = bar_window->height;
+                }
+            }
             bar_window->items_content[index_item][index_subitem] =
                 gui_bar_item_get_value (bar_window->bar, window,
-                                        index_item, index_subitem);
+                                        index_item, index_subitem,
+                                        extra_info);
+            if (extra_info)
+                hashtable_free (extra_info);
             bar_window->items_num_lines[index_item][index_subitem] =
                 gui_bar_item_count_lines (bar_window->items_content[index_item][index_subitem]);
             bar_window->items_refresh_needed[index_item][index_subitem] = 0;
@@ -655,6 +806,18 @@ gui_bar_window_content_get (struct t_gui_bar_window *bar_window,
     if (!bar_window)
         return NULL;
 
+    /*
+     * item built with rows of bar window: build it again if it does not start
+     * on the same row any more (previous items have a different size)
+     */
+    if ((bar_window->items_rows_start[index_item][index_subitem] >= 0)
+        && (bar_window->items_rows_start[index_item][index_subitem] !=
+            gui_bar_window_content_get_item_row (bar_window,
+                                                 index_item, index_subitem)))
+    {
+        bar_window->items_refresh_needed[index_item][index_subitem] = 1;
+    }
+
     /* rebuild content if refresh is needed */
     if (bar_window->items_refresh_needed[index_item][index_subitem])
     {
@@ -720,6 +883,28 @@ gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
               GUI_COLOR_BAR_START_ITEM);
     length_start_item = strlen (str_start_item);
 
+    /*
+     * items built with rows of bar window: build them again if bar window has
+     * been scrolled or resized (or if rows can not be used any more); other
+     * items are not built again
+     */
+    if ((bar_window->rows_height >= 0)
+        && (!gui_bar_window_content_visible_rows (bar_window)
+            || (bar_window->rows_scroll_y != bar_window->scroll_y)
+            || (bar_window->rows_height != bar_window->height)))
+    {
+        for (i = 0; i < bar_window->items_count; i++)
+        {
+            for (sub = 0; sub < bar_window->items_subcount[i]; sub++)
+            {
+                if (bar_window->items_rows_start[i][sub] >= 0)
+                    bar_window->items_refresh_needed[i][sub] = 1;
+            }
+        }
+        bar_window->rows_scroll_y = -1;
+        bar_window->rows_height = -1;
+    }
+
     content_length = 1;
     content = malloc (content_length);
     if (content)
@@ -985,6 +1170,28 @@ gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
         content = NULL;
     }
 
+    /*
+     * items built with visible rows only and bar window scrolled after the
+     * end of content: scroll to the end and build items again
+     */
+    if (content && (bar_window->rows_height >= 0)
+        && (bar_window->scroll_y > 0))
+    {
+        lines = gui_bar_item_count_lines (content);
+        if (bar_window->scroll_y > lines - bar_window->height)
+        {
+            bar_window->scroll_y = lines - bar_window->height;
+            if (bar_window->scroll_y < 0)
+                bar_window->scroll_y = 0;
+            if (bar_window->scroll_y != bar_window->rows_scroll_y)
+            {
+                free (content);
+                return gui_bar_window_content_get_with_filling (bar_window,
+                                                                window);
+            }
+        }
+    }
+
     return content;
 }
 
@@ -1154,6 +1361,9 @@ gui_bar_window_new (struct t_gui_bar *bar, struct t_gui_window *window)
         new_bar_window->items_content = NULL;
         new_bar_window->items_num_lines = NULL;
         new_bar_window->items_refresh_needed = NULL;
+        new_bar_window->items_rows_start = NULL;
+        new_bar_window->rows_scroll_y = -1;
+        new_bar_window->rows_height = -1;
         new_bar_window->screen_col_size = 0;
         new_bar_window->screen_lines = 0;
         new_bar_window->coords_count = 0;
@@ -1552,6 +1762,9 @@ gui_bar_window_hdata_bar_window_cb (const void *pointer, void *data,
         HDATA_VAR(struct t_gui_bar_window, items_content, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_bar_window, items_num_lines, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_bar_window, items_refresh_needed, POINTER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_bar_window, items_rows_start, POINTER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_bar_window, rows_scroll_y, INTEGER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_bar_window, rows_height, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_bar_window, screen_col_size, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_bar_window, screen_lines, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_bar_window, coords_count, INTEGER, 0, NULL, NULL);
@@ -1668,13 +1881,15 @@ gui_bar_window_print_log (struct t_gui_bar_window *bar_window)
             for (j = 0; j < bar_window->items_subcount[i]; j++)
             {
                 log_printf ("    items_content[%03d][%03d]: '%s' "
-                            "(item: '%s', num_lines: %d, refresh_needed: %d)",
+                            "(item: '%s', num_lines: %d, refresh_needed: %d, "
+                            "rows_start: %d)",
                             i, j,
                             bar_window->items_content[i][j],
                             (bar_window->items_count >= i + 1) ?
                             bar_window->bar->items_array[i][j] : "?",
                             bar_window->items_num_lines[i][j],
-                            bar_window->items_refresh_needed[i][j]);
+                            bar_window->items_refresh_needed[i][j],
+                            bar_window->items_rows_start[i][j]);
             }
         }
         else
@@ -1682,6 +1897,8 @@ gui_bar_window_print_log (struct t_gui_bar_window *bar_window)
             log_printf ("    items_content. . . . . . : 0x%lx", bar_window->items_content);
         }
     }
+    log_printf ("    rows_scroll_y. . . . . : %d", bar_window->rows_scroll_y);
+    log_printf ("    rows_height. . . . . . : %d", bar_window->rows_height);
     log_printf ("    screen_col_size. . . . : %d", bar_window->screen_col_size);
     log_printf ("    screen_lines . . . . . : %d", bar_window->screen_lines);
     log_printf ("    coords_count . . . . . : %d", bar_window->coords_count);
@@ -48,6 +48,11 @@ struct t_gui_bar_window
     char ***items_content;          /* content for each (sub)item of bar    */
     int **items_num_lines;          /* number of lines for each (sub)item   */
     int **items_refresh_needed;     /* refresh needed for (sub)item?        */
+    int **items_rows_start;         /* row of (sub)item built with rows of  */
+                                    /* bar window (-1 if built with all rows)*/
+    int rows_scroll_y;              /* scroll_y and height used to build    */
+    int rows_height;                /* items with visible rows only         */
+                                    /* (-1 if items are built with all rows)*/
     int screen_col_size;            /* size of columns on screen            */
                                     /* (for filling with columns)           */
     int screen_lines;               /* number of lines on screen            */
@@ -73,6 +78,7 @@ extern void gui_bar_window_search_by_xy (struct t_gui_window *window,
                                          struct t_gui_buffer **buffer);
 extern void gui_bar_window_calculate_pos_size (struct t_gui_bar_window *bar_window,
                                                struct t_gui_window *window);
+extern int gui_bar_window_content_visible_rows (struct t_gui_bar_window *bar_window);
 extern void gui_bar_window_content_build (struct t_gui_bar_window *bar_window,
                                           struct t_gui_window *window);
 extern char *gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
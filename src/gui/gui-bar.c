@@ -762,6 +762,9 @@ gui_bar_free_items_arrays (struct t_gui_bar *bar)
         bar->items_subcount = NULL;
     }
     bar->items_count = 0;
+
+    /* items have changed: index of items in bars must be built again */
+    gui_bar_item_index_refresh_needed = 1;
 }
 
 /*
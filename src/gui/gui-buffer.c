@@ -64,6 +64,9 @@
 struct t_gui_buffer *gui_buffers = NULL;           /* first buffer          */
 struct t_gui_buffer *last_gui_buffer = NULL;       /* last buffer           */
 int gui_buffers_count = 0;                         /* number of buffers     */
+unsigned long gui_buffers_generation = 0;          /* incremented when a    */
+                                                   /* buffer is added,      */
+                                                   /* renamed or closed     */
 
 /* history of last visited buffers */
 struct t_gui_buffer_visited *gui_buffers_visited = NULL;
@@ -159,6 +162,8 @@ gui_buffer_build_full_name (struct t_gui_buffer *buffer)
     if (!buffer)
         return;
 
+    gui_buffers_generation++;
+
     if (buffer->full_name)
         free (buffer->full_name);
     length = strlen (gui_buffer_get_plugin_name (buffer)) + 1 +
@@ -186,6 +191,7 @@ gui_buffer_local_var_add (struct t_gui_buffer *buffer, const char *name,
 
     ptr_value = hashtable_get (buffer->local_variables, name);
     hashtable_set (buffer->local_variables, name, value);
+    gui_buffer_highlight_matcher_reset (buffer);
     (void) hook_signal_send ((ptr_value) ?
                              "buffer_localvar_changed" : "buffer_localvar_added",
                              WEECHAT_HOOK_SIGNAL_POINTER, buffer);
@@ -207,6 +213,7 @@ gui_buffer_local_var_remove (struct t_gui_buffer *buffer, const char *name)
     if (ptr_value)
     {
         hashtable_remove (buffer->local_variables, name);
+        gui_buffer_highlight_matcher_reset (buffer);
         (void) hook_signal_send ("buffer_localvar_removed",
                                  WEECHAT_HOOK_SIGNAL_POINTER, buffer);
     }
@@ -222,6 +229,7 @@ gui_buffer_local_var_remove_all (struct t_gui_buffer *buffer)
     if (buffer && buffer->local_variables)
     {
         hashtable_remove_all (buffer->local_variables);
+        gui_buffer_highlight_matcher_reset (buffer);
         (void) hook_signal_send ("buffer_localvar_removed",
                                  WEECHAT_HOOK_SIGNAL_POINTER, buffer);
     }
@@ -639,6 +647,7 @@ gui_buffer_new (struct t_weechat_plugin *plugin,
     new_buffer->lines = new_buffer->own_lines;
     new_buffer->time_for_each_line = 1;
     new_buffer->chat_refresh_needed = 2;
+    new_buffer->chat_refresh_new_lines = 0;
 
     /* nicklist */
     new_buffer->nicklist = 0;
@@ -699,6 +708,7 @@ gui_buffer_new (struct t_weechat_plugin *plugin,
 
     /* highlight */
     new_buffer->highlight_words = NULL;
+    new_buffer->highlight_matcher = NULL;
     new_buffer->highlight_regex = NULL;
     new_buffer->highlight_regex_compiled = NULL;
     new_buffer->highlight_tags_restrict = NULL;
@@ -720,6 +730,7 @@ gui_buffer_new (struct t_weechat_plugin *plugin,
     new_buffer->keys = NULL;
     new_buffer->last_key = NULL;
     new_buffer->keys_count = 0;
+    new_buffer->keys_trie = NULL;
 
     /* local variables */
     new_buffer->local_variables = hashtable_new (32,
@@ -1154,6 +1165,25 @@ gui_buffer_get_pointer (struct t_gui_buffer *buffer, const char *property)
     return NULL;
 }
 
+/*
+ * Sets flag "chat_refresh_needed" for new lines added at the end of buffer:
+ * if no other refresh is pending, only these new lines will be drawn in the
+ * chat area of windows displayed at bottom of buffer.
+ */
+
+void
+gui_buffer_ask_chat_refresh_new_lines (struct t_gui_buffer *buffer)
+{
+    if (!buffer)
+        return;
+
+    if (!buffer->chat_refresh_needed)
+    {
+        buffer->chat_refresh_needed = 1;
+        buffer->chat_refresh_new_lines = 1;
+    }
+}
+
 /*
  * Sets flag "chat_refresh_needed".
  */
@@ -1164,6 +1194,9 @@ gui_buffer_ask_chat_refresh (struct t_gui_buffer *buffer, int refresh)
     if (!buffer)
         return;
 
+    if (refresh > 0)
+        buffer->chat_refresh_new_lines = 0;
+
     if (refresh > buffer->chat_refresh_needed)
         buffer->chat_refresh_needed = refresh;
 }
@@ -1185,6 +1218,8 @@ gui_buffer_set_name (struct t_gui_buffer *buffer, const char *name)
 
     gui_buffer_local_var_add (buffer, "name", name);
 
+    gui_window_line_heights_clear_buffer (buffer);
+
     (void) hook_signal_send ("buffer_renamed",
                              WEECHAT_HOOK_SIGNAL_POINTER, buffer);
 }
@@ -1211,6 +1246,8 @@ gui_buffer_set_short_name (struct t_gui_buffer *buffer, const char *short_name)
         buffer->mixed_lines->buffer_max_length_refresh = 1;
     gui_buffer_ask_chat_refresh (buffer, 1);
 
+    gui_window_line_heights_clear_buffer (buffer);
+
     (void) hook_signal_send ("buffer_renamed",
                              WEECHAT_HOOK_SIGNAL_POINTER, buffer);
 }
@@ -1315,6 +1352,94 @@ gui_buffer_set_nicklist_display_groups (struct t_gui_buffer *buffer,
     gui_window_ask_refresh (1);
 }
 
+/*
+ * Resets highlight words compiled for a buffer (they will be compiled again
+ * on next highlight check).
+ *
+ * This must be called when highlight words of buffer, local variables of
+ * buffer or option weechat.look.highlight are changed.
+ */
+
+void
+gui_buffer_highlight_matcher_reset (struct t_gui_buffer *buffer)
+{
+    if (!buffer)
+        return;
+
+    if (buffer->highlight_matcher)
+    {
+        string_highlight_free (buffer->highlight_matcher);
+        buffer->highlight_matcher = NULL;
+    }
+}
+
+/*
+ * Resets highlight words compiled for all buffers.
+ */
+
+void
+gui_buffer_highlight_matcher_reset_all ()
+{
+    struct t_gui_buffer *ptr_buffer;
+
+    for (ptr_buffer = gui_buffers; ptr_buffer;
+         ptr_buffer = ptr_buffer->next_buffer)
+    {
+        gui_buffer_highlight_matcher_reset (ptr_buffer);
+    }
+}
+
+/*
+ * Gets highlight words compiled for a buffer: highlight words of buffer and
+ * global highlight words (option weechat.look.highlight), with local
+ * variables replaced.
+ *
+ * The words are compiled on first call, then kept in buffer until they are
+ * reset.
+ *
+ * Returns pointer to compiled words, NULL if error.
+ */
+
+struct t_string_highlight *
+gui_buffer_get_highlight_matcher (struct t_gui_buffer *buffer)
+{
+    char *buffer_words, *global_words, **words;
+
+    if (!buffer)
+        return NULL;
+
+    if (buffer->highlight_matcher)
+        return buffer->highlight_matcher;
+
+    words = string_dyn_alloc (256);
+    if (!words)
+        return NULL;
+
+    buffer_words = gui_buffer_string_replace_local_var (buffer,
+                                                        buffer->highlight_words);
+    global_words = gui_buffer_string_replace_local_var (
+        buffer, CONFIG_STRING(config_look_highlight));
+
+    if (buffer_words && buffer_words[0])
+        string_dyn_concat (words, buffer_words);
+    if (global_words && global_words[0])
+    {
+        if ((*words)[0])
+            string_dyn_concat (words, ",");
+        string_dyn_concat (words, global_words);
+    }
+
+    buffer->highlight_matcher = string_highlight_compile (*words);
+
+    if (buffer_words)
+        free (buffer_words);
+    if (global_words)
+        free (global_words);
+    string_dyn_free (words, 1);
+
+    return buffer->highlight_matcher;
+}
+
 /*
  * Sets highlight words for a buffer.
  */
@@ -1330,6 +1455,7 @@ gui_buffer_set_highlight_words (struct t_gui_buffer *buffer,
         free (buffer->highlight_words);
     buffer->highlight_words = (new_highlight_words && new_highlight_words[0]) ?
         strdup (new_highlight_words) : NULL;
+    gui_buffer_highlight_matcher_reset (buffer);
 }
 
 /*
@@ -2694,6 +2820,8 @@ gui_buffer_close (struct t_gui_buffer *buffer)
 
     gui_buffer_visited_remove_by_buffer (buffer);
 
+    gui_filter_job_remove_buffer (buffer);
+
     /* compute "number - 1" on next buffers if auto renumber is ON */
     if (CONFIG_BOOLEAN(config_look_buffer_auto_renumber))
     {
@@ -2707,9 +2835,9 @@ gui_buffer_close (struct t_gui_buffer *buffer)
     /* free all lines */
     gui_line_free_all (buffer);
     if (buffer->own_lines)
-        free (buffer->own_lines);
+        gui_lines_free (buffer->own_lines);
     if (buffer->mixed_lines)
-        free (buffer->mixed_lines);
+        gui_lines_free (buffer->mixed_lines);
 
     /* free some data */
     gui_buffer_undo_free_all (buffer);
@@ -2722,6 +2850,7 @@ gui_buffer_close (struct t_gui_buffer *buffer)
         hashtable_free (buffer->hotlist_max_level_nicks);
     gui_key_free_all (&buffer->keys, &buffer->last_key,
                       &buffer->keys_count);
+    gui_key_trie_free (buffer->keys_trie);
     gui_buffer_local_var_remove_all (buffer);
     hashtable_free (buffer->local_variables);
     if (buffer->plugin_name_for_upgrade)
@@ -2747,6 +2876,8 @@ gui_buffer_close (struct t_gui_buffer *buffer)
     }
     if (buffer->highlight_words)
         free (buffer->highlight_words);
+    if (buffer->highlight_matcher)
+        string_highlight_free (buffer->highlight_matcher);
     if (buffer->highlight_regex)
         free (buffer->highlight_regex);
     if (buffer->highlight_regex_compiled)
@@ -2803,6 +2934,7 @@ gui_buffer_close (struct t_gui_buffer *buffer)
 
     if (gui_buffers_count > 0)
         gui_buffers_count--;
+    gui_buffers_generation++;
 
     (void) hook_signal_send ("buffer_closed",
                              WEECHAT_HOOK_SIGNAL_POINTER, buffer);
@@ -3204,6 +3336,8 @@ gui_buffer_move_to_number (struct t_gui_buffer *buffer, int number)
         last_gui_buffer = ptr_last_buffer;
     }
 
+    gui_hotlist_resort ();
+
     (void) hook_signal_send ("buffer_moved",
                              WEECHAT_HOOK_SIGNAL_POINTER, buffer);
 }
@@ -3295,6 +3429,8 @@ gui_buffer_swap (int number1, int number2)
             break;
     }
 
+    gui_hotlist_resort ();
+
     /* send signals */
     (void) hook_signal_send ("buffer_moved",
                              WEECHAT_HOOK_SIGNAL_POINTER, ptr_first_buffer[0]);
@@ -3403,6 +3539,8 @@ gui_buffer_merge (struct t_gui_buffer *buffer,
 
     gui_window_ask_refresh (1);
 
+    gui_hotlist_resort ();
+
     (void) hook_signal_send ("buffer_merged",
                              WEECHAT_HOOK_SIGNAL_POINTER, buffer);
 }
@@ -3537,6 +3675,8 @@ gui_buffer_unmerge (struct t_gui_buffer *buffer, int number)
 
     gui_window_ask_refresh (1);
 
+    gui_hotlist_resort ();
+
     (void) hook_signal_send ("buffer_unmerged",
                              WEECHAT_HOOK_SIGNAL_POINTER, buffer);
 }
@@ -3688,6 +3828,8 @@ gui_buffer_sort_by_layout_number ()
         gui_buffer_insert (ptr_buffer);
         ptr_buffer = ptr_next_buffer;
     }
+
+    gui_hotlist_resort ();
 }
 
 /*
@@ -4108,6 +4250,7 @@ gui_buffer_hdata_buffer_cb (const void *pointer, void *data,
         HDATA_VAR(struct t_gui_buffer, lines, POINTER, 0, NULL, "lines");
         HDATA_VAR(struct t_gui_buffer, time_for_each_line, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, chat_refresh_needed, INTEGER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_buffer, chat_refresh_new_lines, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nicklist, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nicklist_case_sensitive, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nicklist_root, POINTER, 0, NULL, "nick_group");
@@ -4149,6 +4292,7 @@ gui_buffer_hdata_buffer_cb (const void *pointer, void *data,
         HDATA_VAR(struct t_gui_buffer, text_search_found, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, text_search_input, STRING, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, highlight_words, STRING, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_buffer, highlight_matcher, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, highlight_regex, STRING, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, highlight_regex_compiled, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, highlight_tags_restrict, STRING, 0, NULL, NULL);
@@ -4389,8 +4533,7 @@ gui_buffer_dump_hexa (struct t_gui_buffer *buffer)
 {
     struct t_gui_line *ptr_line;
     int num_line;
-    char *prefix_without_colors, *message_without_colors, *tags;
-    char buf[256];
+    char *tags, buf[256];
 
     log_printf ("[buffer dump hexa (addr:0x%lx)]", buffer);
     num_line = 1;
@@ -4398,19 +4541,13 @@ gui_buffer_dump_hexa (struct t_gui_buffer *buffer)
          ptr_line = ptr_line->next_line)
     {
         /* display line without colors */
-        prefix_without_colors = (ptr_line->data->prefix) ?
-            gui_color_decode (ptr_line->data->prefix, NULL) : NULL;
-        message_without_colors = (ptr_line->data->message) ?
-            gui_color_decode (ptr_line->data->message, NULL) : NULL;
         log_printf ("");
         log_printf ("  line %d: %s | %s",
                     num_line,
-                    (prefix_without_colors) ? prefix_without_colors : "(null)",
-                    (message_without_colors) ? message_without_colors : "(null)");
-        if (prefix_without_colors)
-            free (prefix_without_colors);
-        if (message_without_colors)
-            free (message_without_colors);
+                    (ptr_line->data->prefix_no_color) ?
+                    ptr_line->data->prefix_no_color : "(null)",
+                    (ptr_line->data->message_no_color) ?
+                    ptr_line->data->message_no_color : "(null)");
         tags = string_build_with_split_string ((const char **)ptr_line->data->tags_array,
                                                ",");
         log_printf ("  tags: '%s', displayed: %d, highlight: %d",
@@ -4515,6 +4652,7 @@ gui_buffer_print_log ()
         log_printf ("  lines . . . . . . . . . : 0x%lx", ptr_buffer->lines);
         log_printf ("  time_for_each_line. . . : %d",    ptr_buffer->time_for_each_line);
         log_printf ("  chat_refresh_needed . . : %d",    ptr_buffer->chat_refresh_needed);
+        log_printf ("  chat_refresh_new_lines. : %d",    ptr_buffer->chat_refresh_new_lines);
         log_printf ("  nicklist. . . . . . . . : %d",    ptr_buffer->nicklist);
         log_printf ("  nicklist_case_sensitive : %d",    ptr_buffer->nicklist_case_sensitive);
         log_printf ("  nicklist_root . . . . . : 0x%lx", ptr_buffer->nicklist_root);
@@ -4565,6 +4703,7 @@ gui_buffer_print_log ()
         log_printf ("  text_search_found . . . : %d",    ptr_buffer->text_search_found);
         log_printf ("  text_search_input . . . : '%s'",  ptr_buffer->text_search_input);
         log_printf ("  highlight_words . . . . : '%s'",  ptr_buffer->highlight_words);
+        log_printf ("  highlight_matcher . . . : 0x%lx", ptr_buffer->highlight_matcher);
         log_printf ("  highlight_regex . . . . : '%s'",  ptr_buffer->highlight_regex);
         log_printf ("  highlight_regex_compiled: 0x%lx", ptr_buffer->highlight_regex_compiled);
         log_printf ("  highlight_tags_restrict. . . : '%s'",  ptr_buffer->highlight_tags_restrict);
@@ -4577,6 +4716,7 @@ gui_buffer_print_log ()
         log_printf ("  keys. . . . . . . . . . : 0x%lx", ptr_buffer->keys);
         log_printf ("  last_key. . . . . . . . : 0x%lx", ptr_buffer->last_key);
         log_printf ("  keys_count. . . . . . . : %d",    ptr_buffer->keys_count);
+        log_printf ("  keys_trie . . . . . . . : 0x%lx", ptr_buffer->keys_trie);
         log_printf ("  local_variables . . . . : 0x%lx", ptr_buffer->local_variables);
         log_printf ("  prev_buffer . . . . . . : 0x%lx", ptr_buffer->prev_buffer);
         log_printf ("  next_buffer . . . . . . : 0x%lx", ptr_buffer->next_buffer);
@@ -4623,10 +4763,10 @@ gui_buffer_print_log ()
             num--;
             tags = string_build_with_split_string ((const char **)ptr_line->data->tags_array,
                                                    ",");
-            log_printf ("       line N-%05d: y:%d, str_time:'%s', tags:'%s', "
+            log_printf ("       line N-%05d: y:%d, date:%ld, tags:'%s', "
                         "displayed:%d, highlight:%d, refresh_needed:%d, "
                         "prefix:'%s'",
-                        num, ptr_line->data->y, ptr_line->data->str_time,
+                        num, ptr_line->data->y, (long)ptr_line->data->date,
                         (tags) ? tags  : "",
                         (int)(ptr_line->data->displayed),
                         (int)(ptr_line->data->highlight),
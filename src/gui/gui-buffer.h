@@ -24,8 +24,10 @@
 #include <regex.h>
 
 struct t_hashtable;
+struct t_gui_key_trie;
 struct t_gui_window;
 struct t_infolist;
+struct t_string_highlight;
 
 enum t_gui_buffer_type
 {
@@ -124,6 +126,8 @@ struct t_gui_buffer
     int time_for_each_line;            /* time is displayed for each line?  */
     int chat_refresh_needed;           /* refresh for chat is needed ?      */
                                        /* (1=refresh, 2=erase+refresh)      */
+    int chat_refresh_new_lines;        /* 1 if refresh is only for new lines*/
+                                       /* added at the end of buffer        */
 
     /* nicklist */
     int nicklist;                      /* = 1 if nicklist is enabled        */
@@ -188,6 +192,8 @@ struct t_gui_buffer
 
     /* highlight settings for buffer */
     char *highlight_words;             /* list of words to highlight        */
+    struct t_string_highlight *highlight_matcher; /* buffer + global words   */
+                                       /* compiled (NULL = not yet built)   */
     char *highlight_regex;             /* regex for highlight               */
     regex_t *highlight_regex_compiled; /* compiled regex                    */
     char *highlight_tags_restrict;     /* restrict highlight to these tags  */
@@ -206,6 +212,8 @@ struct t_gui_buffer
     struct t_gui_key *keys;            /* keys specific to buffer           */
     struct t_gui_key *last_key;        /* last key for buffer               */
     int keys_count;                    /* number of keys in buffer          */
+    struct t_gui_key_trie *keys_trie;  /* trie of keys (built when a key    */
+                                       /* is pressed, NULL if not built)    */
 
     /* local variables */
     struct t_hashtable *local_variables; /* local variables                 */
@@ -227,6 +235,7 @@ struct t_gui_buffer_visited
 extern struct t_gui_buffer *gui_buffers;
 extern struct t_gui_buffer *last_gui_buffer;
 extern int gui_buffers_count;
+extern unsigned long gui_buffers_generation;
 extern struct t_gui_buffer_visited *gui_buffers_visited;
 extern struct t_gui_buffer_visited *last_gui_buffer_visited;
 extern int gui_buffers_visited_index;
@@ -275,10 +284,14 @@ extern const char *gui_buffer_get_string (struct t_gui_buffer *buffer,
                                           const char *property);
 extern void *gui_buffer_get_pointer (struct t_gui_buffer *buffer,
                                      const char *property);
+extern void gui_buffer_ask_chat_refresh_new_lines (struct t_gui_buffer *buffer);
 extern void gui_buffer_ask_chat_refresh (struct t_gui_buffer *buffer,
                                          int refresh);
 extern void gui_buffer_set_title (struct t_gui_buffer *buffer,
                                   const char *new_title);
+extern void gui_buffer_highlight_matcher_reset (struct t_gui_buffer *buffer);
+extern void gui_buffer_highlight_matcher_reset_all ();
+extern struct t_string_highlight *gui_buffer_get_highlight_matcher (struct t_gui_buffer *buffer);
 extern void gui_buffer_set_highlight_words (struct t_gui_buffer *buffer,
                                             const char *new_highlight_words);
 extern void gui_buffer_set_highlight_regex (struct t_gui_buffer *buffer,
@@ -57,6 +57,10 @@ struct t_gui_buffer *gui_chat_mute_buffer = NULL; /* mute buffer            */
 int gui_chat_display_tags = 0;                  /* display tags?            */
 char *gui_chat_lines_waiting_buffer = NULL;     /* lines waiting for core   */
                                                 /* buffer                   */
+struct t_gui_chat_time_cache gui_chat_time_cache[GUI_CHAT_TIME_CACHE_SIZE];
+                                                /* time strings of lines    */
+int gui_chat_time_format_generation = 1;        /* incremented when time    */
+                                                /* format is changed        */
 
 
 /*
@@ -524,29 +528,49 @@ gui_chat_get_time_length ()
 }
 
 /*
- * Changes time format for all lines of all buffers.
+ * Gets time string of a line, for display (with colors).
+ *
+ * Time strings are not stored in lines: they are built when lines are
+ * displayed, and kept in a small cache indexed by date, so that lines
+ * printed in the same second share the same string.
+ *
+ * Note: result must not be freed, and it is valid only until next call to
+ * this function or to function gui_chat_change_time_format.
  */
 
-void
-gui_chat_change_time_format ()
+const char *
+gui_chat_get_time_string_cached (time_t date)
 {
-    struct t_gui_buffer *ptr_buffer;
-    struct t_gui_line *ptr_line;
+    struct t_gui_chat_time_cache *ptr_cache;
+
+    if (date == 0)
+        return NULL;
 
-    for (ptr_buffer = gui_buffers; ptr_buffer;
-         ptr_buffer = ptr_buffer->next_buffer)
+    ptr_cache = &gui_chat_time_cache[(unsigned long)date
+                                     % GUI_CHAT_TIME_CACHE_SIZE];
+
+    if ((ptr_cache->format_generation != gui_chat_time_format_generation)
+        || (ptr_cache->date != date))
     {
-        for (ptr_line = ptr_buffer->lines->first_line; ptr_line;
-             ptr_line = ptr_line->next_line)
-        {
-            if (ptr_line->data->date != 0)
-            {
-                if (ptr_line->data->str_time)
-                    free (ptr_line->data->str_time);
-                ptr_line->data->str_time = gui_chat_get_time_string (ptr_line->data->date);
-            }
-        }
+        if (ptr_cache->str_time)
+            free (ptr_cache->str_time);
+        ptr_cache->date = date;
+        ptr_cache->format_generation = gui_chat_time_format_generation;
+        ptr_cache->str_time = gui_chat_get_time_string (date);
     }
+
+    return ptr_cache->str_time;
+}
+
+/*
+ * Changes time format for all lines of all buffers: time strings in cache
+ * are built again with the new format on next display.
+ */
+
+void
+gui_chat_change_time_format ()
+{
+    gui_chat_time_format_generation++;
 }
 
 /*
@@ -835,7 +859,7 @@ gui_chat_printf_date_tags (struct t_gui_buffer *buffer, time_t date,
     }
 
     if (gui_init_ok && at_least_one_message_printed)
-        gui_buffer_ask_chat_refresh (buffer, 1);
+        gui_buffer_ask_chat_refresh_new_lines (buffer);
 
     free (vbuffer);
 }
@@ -1108,4 +1132,15 @@ gui_chat_end ()
         free (gui_chat_lines_waiting_buffer);
         gui_chat_lines_waiting_buffer = NULL;
     }
+
+    /* free time strings */
+    for (i = 0; i < GUI_CHAT_TIME_CACHE_SIZE; i++)
+    {
+        if (gui_chat_time_cache[i].str_time)
+        {
+            free (gui_chat_time_cache[i].str_time);
+            gui_chat_time_cache[i].str_time = NULL;
+        }
+        gui_chat_time_cache[i].format_generation = 0;
+    }
 }
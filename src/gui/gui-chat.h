@@ -38,6 +38,9 @@ struct t_gui_line;
 #define GUI_CHAT_PREFIX_JOIN_DEFAULT    "-->"
 #define GUI_CHAT_PREFIX_QUIT_DEFAULT    "<--"
 
+/* number of time strings kept in cache (indexed by date) */
+#define GUI_CHAT_TIME_CACHE_SIZE 256
+
 enum t_gui_chat_prefix
 {
     GUI_CHAT_PREFIX_ERROR = 0,
@@ -56,6 +59,14 @@ enum t_gui_chat_mute
     GUI_CHAT_MUTE_ALL_BUFFERS,
 };
 
+struct t_gui_chat_time_cache
+{
+    time_t date;                       /* date of line                      */
+    int format_generation;             /* generation of time format used    */
+    char *str_time;                    /* time string (with colors), may be */
+                                       /* NULL if no time is displayed      */
+};
+
 extern char *gui_chat_prefix[GUI_CHAT_NUM_PREFIXES];
 extern char gui_chat_prefix_empty[];
 extern int gui_chat_time_length;
@@ -81,6 +92,7 @@ extern void gui_chat_get_word_info (struct t_gui_window *window,
                                     int *word_length_with_spaces,
                                     int *word_length);
 extern char *gui_chat_get_time_string (time_t date);
+extern const char *gui_chat_get_time_string_cached (time_t date);
 extern int gui_chat_get_time_length ();
 extern void gui_chat_change_time_format ();
 extern char *gui_chat_build_string_prefix_message (struct t_gui_line *line);
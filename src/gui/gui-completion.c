@@ -36,6 +36,7 @@
 #include "../core/wee-arraylist.h"
 #include "../core/wee-completion.h"
 #include "../core/wee-config.h"
+#include "../core/wee-hashtable.h"
 #include "../core/wee-hdata.h"
 #include "../core/wee-hook.h"
 #include "../core/wee-list.h"
@@ -50,6 +51,9 @@
 int gui_completion_freeze = 0;         /* 1 to freeze completions (do not   */
                                        /* stop partial completion on key)   */
 
+struct t_hashtable *gui_completion_cache = NULL; /* words of completion     */
+                                                 /* items, by item name     */
+
 
 /*
  * Compares two words in completion list.
@@ -280,6 +284,28 @@ gui_completion_search_command (struct t_weechat_plugin *plugin,
         hook_incomplete_command : NULL;
 }
 
+/*
+ * Checks if first char of string is ignored (for nick comparison).
+ *
+ * Returns:
+ *   1: char is ignored
+ *   0: char is not ignored
+ */
+
+int
+gui_completion_nick_is_ignored_char (const char *string)
+{
+    int char_size;
+    char utf_char[16];
+
+    char_size = utf8_char_size (string);
+    memcpy (utf_char, string, char_size);
+    utf_char[char_size] = '\0';
+
+    return (strstr (CONFIG_STRING(config_completion_nick_ignore_chars),
+                    utf_char)) ? 1 : 0;
+}
+
 /*
  * Checks if nick has one or more ignored chars (for nick comparison).
  *
@@ -291,61 +317,39 @@ gui_completion_search_command (struct t_weechat_plugin *plugin,
 int
 gui_completion_nick_has_ignored_chars (const char *string)
 {
-    int char_size;
-    char utf_char[16];
-
     while (string[0])
     {
-        char_size = utf8_char_size (string);
-        memcpy (utf_char, string, char_size);
-        utf_char[char_size] = '\0';
-
-        if (strstr (CONFIG_STRING(config_completion_nick_ignore_chars),
-                    utf_char))
+        if (gui_completion_nick_is_ignored_char (string))
             return 1;
-
-        string += char_size;
+        string += utf8_char_size (string);
     }
     return 0;
 }
 
 /*
- * Duplicates a nick and ignores some chars.
+ * Skips ignored chars at beginning of nick (for nick comparison).
  *
- * Note: result must be freed after use.
+ * Returns pointer to first char which is not ignored in nick.
  */
 
-char *
-gui_completion_nick_strdup_ignore_chars (const char *string)
+const char *
+gui_completion_nick_skip_ignored_chars (const char *string)
 {
-    int char_size;
-    char *result, *pos, utf_char[16];
-
-    result = malloc (strlen (string) + 1);
-    pos = result;
-    while (string[0])
+    while (string[0] && gui_completion_nick_is_ignored_char (string))
     {
-        char_size = utf8_char_size (string);
-        memcpy (utf_char, string, char_size);
-        utf_char[char_size] = '\0';
-
-        if (!strstr (CONFIG_STRING(config_completion_nick_ignore_chars),
-                     utf_char))
-        {
-            memcpy (pos, utf_char, char_size);
-            pos += char_size;
-        }
-
-        string += char_size;
+        string += utf8_char_size (string);
     }
-    pos[0] = '\0';
-    return result;
+    return string;
 }
 
 /*
  * Locale and case independent string comparison with max length for nicks
  * (alpha or digits only).
  *
+ * If base word has no ignored chars, the ignored chars in nick are skipped
+ * during comparison (nothing is allocated, so this function can be called
+ * for each nick of a large channel).
+ *
  * Returns:
  *   < 0: base_word < nick
  *     0: base_word == nick
@@ -355,8 +359,7 @@ gui_completion_nick_strdup_ignore_chars (const char *string)
 int
 gui_completion_nickncmp (const char *base_word, const char *nick, int max)
 {
-    char *base_word2, *nick2;
-    int return_cmp;
+    int count, diff;
 
     if (!CONFIG_STRING(config_completion_nick_ignore_chars)
         || !CONFIG_STRING(config_completion_nick_ignore_chars)[0]
@@ -364,16 +367,25 @@ gui_completion_nickncmp (const char *base_word, const char *nick, int max)
         || gui_completion_nick_has_ignored_chars (base_word))
         return string_strncasecmp (base_word, nick, max);
 
-    base_word2 = gui_completion_nick_strdup_ignore_chars (base_word);
-    nick2 = gui_completion_nick_strdup_ignore_chars (nick);
-
-    return_cmp = string_strncasecmp (base_word2, nick2,
-                                     utf8_strlen (base_word2));
-
-    free (base_word2);
-    free (nick2);
+    max = utf8_strlen (base_word);
+    count = 0;
+    nick = gui_completion_nick_skip_ignored_chars (nick);
+    while ((count < max) && base_word[0] && nick[0])
+    {
+        diff = utf8_charcasecmp (base_word, nick);
+        if (diff != 0)
+            return (diff < 0) ? -1 : 1;
+
+        base_word = utf8_next_char (base_word);
+        nick = gui_completion_nick_skip_ignored_chars (
+            nick + utf8_char_size (nick));
+        count++;
+    }
 
-    return return_cmp;
+    if (count >= max)
+        return 0;
+    else
+        return (base_word[0]) ? 1 : ((nick[0]) ? -1 : 0);
 }
 
 /*
@@ -432,6 +444,202 @@ gui_completion_list_add (struct t_gui_completion *completion, const char *word,
     }
 }
 
+/*
+ * Compares two words in a cache of completion words.
+ */
+
+int
+gui_completion_cache_word_compare_cb (void *data,
+                                      struct t_arraylist *arraylist,
+                                      void *pointer1, void *pointer2)
+{
+    /* make C compiler happy */
+    (void) data;
+    (void) arraylist;
+
+    return string_strcasecmp ((const char *)pointer1,
+                              (const char *)pointer2);
+}
+
+/*
+ * Frees a word in a cache of completion words.
+ */
+
+void
+gui_completion_cache_word_free_cb (void *data,
+                                   struct t_arraylist *arraylist,
+                                   void *pointer)
+{
+    /* make C compiler happy */
+    (void) data;
+    (void) arraylist;
+
+    free (pointer);
+}
+
+/*
+ * Frees a cache of completion words (value of hashtable
+ * gui_completion_cache).
+ */
+
+void
+gui_completion_cache_free_value_cb (struct t_hashtable *hashtable,
+                                    const void *key, void *value)
+{
+    struct t_gui_completion_cache *ptr_cache;
+
+    /* make C compiler happy */
+    (void) hashtable;
+    (void) key;
+
+    ptr_cache = (struct t_gui_completion_cache *)value;
+
+    arraylist_free (ptr_cache->words);
+    free (ptr_cache);
+}
+
+/*
+ * Gets words cached for a completion item.
+ *
+ * The generation is a counter incremented by the source of words each time
+ * words change (for example when an option is added or removed): the words
+ * are returned only if they have been cached with the same generation.
+ *
+ * Returns pointer to arraylist with words (sorted, case is ignored), NULL if
+ * there is no cache or if cache is outdated.
+ */
+
+struct t_arraylist *
+gui_completion_cache_get (const char *completion_item,
+                          unsigned long generation)
+{
+    struct t_gui_completion_cache *ptr_cache;
+
+    if (!gui_completion_cache || !completion_item)
+        return NULL;
+
+    ptr_cache = hashtable_get (gui_completion_cache, completion_item);
+    if (!ptr_cache || (ptr_cache->generation != generation))
+        return NULL;
+
+    return ptr_cache->words;
+}
+
+/*
+ * Creates a new cache of words for a completion item (any existing cache for
+ * this item is freed).
+ *
+ * The caller must add words (allocated strings, freed with the cache) in the
+ * arraylist returned.
+ *
+ * Returns pointer to arraylist for words, NULL if error.
+ */
+
+struct t_arraylist *
+gui_completion_cache_new (const char *completion_item,
+                          unsigned long generation)
+{
+    struct t_gui_completion_cache *new_cache;
+
+    if (!completion_item)
+        return NULL;
+
+    if (!gui_completion_cache)
+    {
+        gui_completion_cache = hashtable_new (32,
+                                              WEECHAT_HASHTABLE_STRING,
+                                              WEECHAT_HASHTABLE_POINTER,
+                                              NULL,
+                                              NULL);
+        if (!gui_completion_cache)
+            return NULL;
+        gui_completion_cache->callback_free_value = &gui_completion_cache_free_value_cb;
+    }
+
+    new_cache = malloc (sizeof (*new_cache));
+    if (!new_cache)
+        return NULL;
+
+    new_cache->generation = generation;
+    new_cache->words = arraylist_new (
+        256, 1, 0,
+        &gui_completion_cache_word_compare_cb, NULL,
+        &gui_completion_cache_word_free_cb, NULL);
+    if (!new_cache->words)
+    {
+        free (new_cache);
+        return NULL;
+    }
+
+    if (!hashtable_set (gui_completion_cache, completion_item, new_cache))
+    {
+        arraylist_free (new_cache->words);
+        free (new_cache);
+        return NULL;
+    }
+
+    return new_cache->words;
+}
+
+/*
+ * Adds words from a cache to completion list.
+ *
+ * Words are sorted, so only words beginning with base word are read (they
+ * are found with a binary search).
+ */
+
+void
+gui_completion_list_add_cache (struct t_gui_completion *completion,
+                               struct t_arraylist *words,
+                               int nick_completion, const char *where)
+{
+    int length, start, end, middle;
+
+    if (!completion || !words)
+        return;
+
+    start = 0;
+    end = words->size;
+
+    /*
+     * with nick completion, ignored chars can be anywhere in words, so all
+     * words are read
+     */
+    if (!nick_completion
+        && completion->base_word && completion->base_word[0])
+    {
+        length = utf8_strlen (completion->base_word);
+
+        /* search first word beginning with base word */
+        while (start < end)
+        {
+            middle = start + ((end - start) / 2);
+            if (string_strncasecmp ((const char *)words->data[middle],
+                                    completion->base_word, length) < 0)
+                start = middle + 1;
+            else
+                end = middle;
+        }
+
+        /* search first word after words beginning with base word */
+        end = start;
+        while ((end < words->size)
+               && (string_strncasecmp ((const char *)words->data[end],
+                                       completion->base_word, length) == 0))
+        {
+            end++;
+        }
+    }
+
+    while (start < end)
+    {
+        gui_completion_list_add (completion,
+                                 (const char *)words->data[start],
+                                 nick_completion, where);
+        start++;
+    }
+}
+
 /*
  * Custom completion by a plugin.
  */
@@ -1475,3 +1683,17 @@ gui_completion_print_log (struct t_gui_completion *completion)
                              "partial completion word");
     }
 }
+
+/*
+ * Frees all completion data.
+ */
+
+void
+gui_completion_end ()
+{
+    if (gui_completion_cache)
+    {
+        hashtable_free (gui_completion_cache);
+        gui_completion_cache = NULL;
+    }
+}
@@ -25,6 +25,8 @@
 #define GUI_COMPLETION_COMMAND_ARG  2
 #define GUI_COMPLETION_AUTO         3
 
+struct t_hashtable;
+
 struct t_gui_completion_word
 {
     char *word;                   /* word matching completion                */
@@ -62,9 +64,16 @@ struct t_gui_completion
     struct t_arraylist *partial_list;
 };
 
+struct t_gui_completion_cache
+{
+    unsigned long generation;     /* generation of source of words           */
+    struct t_arraylist *words;    /* words (sorted, case is ignored)         */
+};
+
 /* completion variables */
 
 extern int gui_completion_freeze;
+extern struct t_hashtable *gui_completion_cache;
 
 /* completion functions */
 
@@ -75,6 +84,14 @@ extern void gui_completion_stop (struct t_gui_completion *completion);
 extern void gui_completion_list_add (struct t_gui_completion *completion,
                                      const char *word,
                                      int nick_completion, const char *where);
+extern struct t_arraylist *gui_completion_cache_get (const char *completion_item,
+                                                     unsigned long generation);
+extern struct t_arraylist *gui_completion_cache_new (const char *completion_item,
+                                                     unsigned long generation);
+extern void gui_completion_list_add_cache (struct t_gui_completion *completion,
+                                           struct t_arraylist *words,
+                                           int nick_completion,
+                                           const char *where);
 extern void gui_completion_search (struct t_gui_completion *completion,
                                    int direction, const char *data, int size,
                                    int pos);
@@ -87,5 +104,6 @@ extern struct t_hdata *gui_completion_hdata_completion_partial_cb (const void *p
                                                                    void *data,
                                                                    const char *hdata_name);
 extern void gui_completion_print_log (struct t_gui_completion *completion);
+extern void gui_completion_end ();
 
 #endif /* WEECHAT_GUI_COMPLETION_H */
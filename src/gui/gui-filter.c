@@ -27,6 +27,7 @@
 #include <stddef.h>
 #include <string.h>
 #include <regex.h>
+#include <sys/time.h>
 
 #include "../core/weechat.h"
 #include "../core/wee-config.h"
@@ -35,6 +36,7 @@
 #include "../core/wee-infolist.h"
 #include "../core/wee-log.h"
 #include "../core/wee-string.h"
+#include "../core/wee-util.h"
 #include "../plugins/plugin.h"
 #include "gui-filter.h"
 #include "gui-buffer.h"
@@ -46,121 +48,173 @@
 struct t_gui_filter *gui_filters = NULL;           /* first filter          */
 struct t_gui_filter *last_gui_filter = NULL;       /* last filter           */
 int gui_filters_enabled = 1;                       /* filters enabled?      */
+int gui_filters_last_id = 0;                       /* id of last filter     */
+
+struct t_gui_filter_job *gui_filter_jobs = NULL;   /* first filter job      */
+struct t_gui_filter_job *last_gui_filter_job = NULL; /* last filter job     */
+struct t_hook *gui_filter_jobs_timer = NULL;       /* timer to run jobs     */
 
 
 /*
- * Checks if a line must be displayed or not (filtered).
+ * Checks if a filter hides a line (the filter must be enabled, this is not
+ * checked by this function).
  *
  * Returns:
- *   1: line must be displayed (not filtered)
- *   0: line must be hidden (filtered)
+ *   1: filter hides line
+ *   0: filter does not hide line
  */
 
 int
-gui_filter_check_line (struct t_gui_line_data *line_data)
+gui_filter_match_line (struct t_gui_filter *filter,
+                       struct t_gui_line_data *line_data)
 {
-    struct t_gui_filter *ptr_filter;
     int rc;
 
+    /* check buffer */
+    if (!gui_buffer_match_list_split (line_data->buffer,
+                                      filter->num_buffers,
+                                      filter->buffers))
+    {
+        return 0;
+    }
+
+    /* check tags */
+    if ((strcmp (filter->tags, "*") != 0)
+        && !gui_line_match_tags (line_data,
+                                 filter->tags_count,
+                                 filter->tags_array))
+    {
+        return 0;
+    }
+
+    /* check line with regex */
+    rc = 1;
+    if (!filter->regex_prefix && !filter->regex_message)
+        rc = 0;
+    if ((!filter->regex_index
+         || (gui_line_index_match_prefix (line_data, filter->regex_index)
+             && gui_line_index_match_message (line_data, filter->regex_index)))
+        && gui_line_match_regex (line_data,
+                                 filter->regex_prefix,
+                                 filter->regex_message))
+    {
+        rc = 0;
+    }
+    if (filter->regex && (filter->regex[0] == '!'))
+        rc ^= 1;
+
+    return (rc == 0) ? 1 : 0;
+}
+
+/*
+ * Searches for the first enabled filter hiding a line.
+ *
+ * Returns pointer to filter found, NULL if line is displayed.
+ */
+
+struct t_gui_filter *
+gui_filter_search_hiding_line (struct t_gui_line_data *line_data)
+{
+    struct t_gui_filter *ptr_filter;
+
     /* line is always displayed if filters are disabled (globally or in buffer) */
     if (!gui_filters_enabled || !line_data->buffer->filter)
-        return 1;
+        return NULL;
 
     if (gui_line_has_tag_no_filter (line_data))
-        return 1;
+        return NULL;
 
     for (ptr_filter = gui_filters; ptr_filter;
          ptr_filter = ptr_filter->next_filter)
     {
-        if (ptr_filter->enabled)
+        if (ptr_filter->enabled
+            && gui_filter_match_line (ptr_filter, line_data))
         {
-            /* check buffer */
-            if (gui_buffer_match_list_split (line_data->buffer,
-                                             ptr_filter->num_buffers,
-                                             ptr_filter->buffers))
-            {
-                if ((strcmp (ptr_filter->tags, "*") == 0)
-                    || (gui_line_match_tags (line_data,
-                                             ptr_filter->tags_count,
-                                             ptr_filter->tags_array)))
-                {
-                    /* check line with regex */
-                    rc = 1;
-                    if (!ptr_filter->regex_prefix && !ptr_filter->regex_message)
-                        rc = 0;
-                    if (gui_line_match_regex (line_data,
-                                              ptr_filter->regex_prefix,
-                                              ptr_filter->regex_message))
-                    {
-                        rc = 0;
-                    }
-                    if (ptr_filter->regex && (ptr_filter->regex[0] == '!'))
-                        rc ^= 1;
-                    if (rc == 0)
-                        return 0;
-                }
-            }
+            return ptr_filter;
         }
     }
 
     /* no tag or regex matching, then line is displayed */
-    return 1;
+    return NULL;
 }
 
 /*
- * Filters a buffer, using message filters.
+ * Filters a line: sets flag "displayed" and id of filter hiding the line.
  *
- * If line_data is NULL, filters all lines in buffer.
- * If line_data is not NULL, filters only this line_data.
+ * Note: counters of hidden lines are not updated by this function.
+ *
+ * Returns:
+ *   1: flag "displayed" has changed
+ *   0: flag "displayed" has not changed
  */
 
-void
-gui_filter_buffer (struct t_gui_buffer *buffer,
-                   struct t_gui_line_data *line_data)
+int
+gui_filter_line (struct t_gui_line_data *line_data)
 {
-    struct t_gui_line *ptr_line;
-    struct t_gui_line_data *ptr_line_data;
-    struct t_gui_window *ptr_window;
-    int lines_changed, line_displayed, lines_hidden;
+    struct t_gui_filter *ptr_filter;
+    int displayed;
 
-    lines_changed = 0;
-    lines_hidden = buffer->lines->lines_hidden;
+    ptr_filter = gui_filter_search_hiding_line (line_data);
 
-    ptr_line = buffer->lines->first_line;
-    while (ptr_line || line_data)
-    {
-        ptr_line_data = (line_data) ? line_data : ptr_line->data;
+    displayed = (ptr_filter) ? 0 : 1;
+    line_data->filter_id = (ptr_filter) ? ptr_filter->id : 0;
 
-        line_displayed = gui_filter_check_line (ptr_line_data);
+    if (line_data->displayed == displayed)
+        return 0;
 
-        if (ptr_line_data->displayed != line_displayed)
-        {
-            lines_changed = 1;
-            lines_hidden += (line_displayed) ? -1 : 1;
-        }
+    line_data->displayed = displayed;
+    return 1;
+}
 
-        ptr_line_data->displayed = line_displayed;
+/*
+ * Updates counters of hidden lines in buffer (own and mixed lines) after
+ * a line of buffer has been hidden or displayed.
+ */
 
-        if (line_data)
-            break;
+void
+gui_filter_line_hidden_changed (struct t_gui_line_data *line_data)
+{
+    struct t_gui_buffer *ptr_buffer;
+    int diff;
 
-        ptr_line = ptr_line->next_line;
+    ptr_buffer = line_data->buffer;
+    diff = (line_data->displayed) ? -1 : 1;
+
+    ptr_buffer->own_lines->lines_hidden += diff;
+    if (ptr_buffer->own_lines->lines_hidden < 0)
+        ptr_buffer->own_lines->lines_hidden = 0;
+    if (ptr_buffer->mixed_lines)
+    {
+        ptr_buffer->mixed_lines->lines_hidden += diff;
+        if (ptr_buffer->mixed_lines->lines_hidden < 0)
+            ptr_buffer->mixed_lines->lines_hidden = 0;
     }
+}
 
-    if (line_data)
-        line_data->buffer->lines->prefix_max_length_refresh = 1;
-    else
-        buffer->lines->prefix_max_length_refresh = 1;
+/*
+ * Refreshes a buffer after some lines have been filtered.
+ *
+ * Argument "lines_hidden" is the number of hidden lines in buffer before
+ * lines were filtered.
+ */
+
+void
+gui_filter_buffer_refresh (struct t_gui_buffer *buffer, int lines_hidden,
+                           int lines_changed)
+{
+    struct t_gui_window *ptr_window;
 
     if (buffer->lines->lines_hidden != lines_hidden)
     {
-        buffer->lines->lines_hidden = lines_hidden;
         (void) hook_signal_send ("buffer_lines_hidden",
                                  WEECHAT_HOOK_SIGNAL_POINTER, buffer);
     }
 
     if (lines_changed)
     {
+        buffer->own_lines->prefix_max_length_refresh = 1;
+        buffer->lines->prefix_max_length_refresh = 1;
+
         /* force a full refresh of buffer */
         gui_buffer_ask_chat_refresh (buffer, 2);
 
@@ -172,7 +226,7 @@ gui_filter_buffer (struct t_gui_buffer *buffer,
         for (ptr_window = gui_windows; ptr_window;
              ptr_window = ptr_window->next_window)
         {
-            if ((ptr_window->buffer == buffer)
+            if ((ptr_window->buffer->lines == buffer->lines)
                 && ptr_window->scroll->start_line
                 && !ptr_window->scroll->start_line->data->displayed)
             {
@@ -184,8 +238,304 @@ gui_filter_buffer (struct t_gui_buffer *buffer,
     }
 }
 
+/*
+ * Filters a buffer, using message filters.
+ *
+ * If line_data is NULL, filters all lines in buffer (and pending filter jobs
+ * for this buffer are removed, they are not needed any more).
+ * If line_data is not NULL, filters only this line_data.
+ */
+
+void
+gui_filter_buffer (struct t_gui_buffer *buffer,
+                   struct t_gui_line_data *line_data)
+{
+    struct t_gui_line *ptr_line;
+    struct t_gui_line_data *ptr_line_data;
+    int lines_changed, lines_hidden;
+
+    if (!line_data)
+        gui_filter_job_remove_buffer (buffer);
+
+    lines_changed = 0;
+    lines_hidden = buffer->lines->lines_hidden;
+
+    ptr_line = buffer->own_lines->first_line;
+    while (ptr_line || line_data)
+    {
+        ptr_line_data = (line_data) ? line_data : ptr_line->data;
+
+        if (gui_filter_line (ptr_line_data))
+        {
+            gui_filter_line_hidden_changed (ptr_line_data);
+            lines_changed = 1;
+        }
+
+        if (line_data)
+            break;
+
+        ptr_line = ptr_line->next_line;
+    }
+
+    gui_filter_buffer_refresh (buffer, lines_hidden, lines_changed);
+}
+
+/*
+ * Adds a job to filter lines of a buffer.
+ *
+ * The job is run immediately, and if the buffer has too many lines, the
+ * job is continued later by a timer (so that WeeChat is not blocked when
+ * buffers have a lot of lines).
+ */
+
+void
+gui_filter_job_add (struct t_gui_buffer *buffer, int type, int filter_id)
+{
+    struct t_gui_filter_job *new_job;
+
+    if (!buffer->own_lines->first_line)
+        return;
+
+    /* a job on all lines with all filters replaces previous jobs */
+    if (type == GUI_FILTER_JOB_ALL)
+        gui_filter_job_remove_buffer (buffer);
+
+    new_job = malloc (sizeof (*new_job));
+    if (!new_job)
+    {
+        /* not enough memory to delay job: filter whole buffer now */
+        gui_filter_buffer (buffer, NULL);
+        return;
+    }
+
+    new_job->buffer = buffer;
+    new_job->type = type;
+    new_job->filter_id = filter_id;
+    new_job->next_line = buffer->own_lines->first_line;
+
+    new_job->prev_job = last_gui_filter_job;
+    new_job->next_job = NULL;
+    if (last_gui_filter_job)
+        last_gui_filter_job->next_job = new_job;
+    else
+        gui_filter_jobs = new_job;
+    last_gui_filter_job = new_job;
+}
+
+/*
+ * Frees a filter job.
+ */
+
+void
+gui_filter_job_free (struct t_gui_filter_job *job)
+{
+    if (job->prev_job)
+        (job->prev_job)->next_job = job->next_job;
+    if (job->next_job)
+        (job->next_job)->prev_job = job->prev_job;
+    if (gui_filter_jobs == job)
+        gui_filter_jobs = job->next_job;
+    if (last_gui_filter_job == job)
+        last_gui_filter_job = job->prev_job;
+
+    free (job);
+
+    if (!gui_filter_jobs && gui_filter_jobs_timer)
+    {
+        unhook (gui_filter_jobs_timer);
+        gui_filter_jobs_timer = NULL;
+    }
+}
+
+/*
+ * Removes all filter jobs of a buffer (called when buffer is closed or when
+ * all lines of buffer are filtered).
+ */
+
+void
+gui_filter_job_remove_buffer (struct t_gui_buffer *buffer)
+{
+    struct t_gui_filter_job *ptr_job, *ptr_next_job;
+
+    ptr_job = gui_filter_jobs;
+    while (ptr_job)
+    {
+        ptr_next_job = ptr_job->next_job;
+        if (ptr_job->buffer == buffer)
+            gui_filter_job_free (ptr_job);
+        ptr_job = ptr_next_job;
+    }
+}
+
+/*
+ * Moves filter jobs to next line if they are on a line which is removed from
+ * a buffer.
+ */
+
+void
+gui_filter_job_remove_line (struct t_gui_line *line)
+{
+    struct t_gui_filter_job *ptr_job;
+
+    for (ptr_job = gui_filter_jobs; ptr_job; ptr_job = ptr_job->next_job)
+    {
+        if (ptr_job->next_line == line)
+            ptr_job->next_line = line->next_line;
+    }
+}
+
+/*
+ * Runs first filter job for at most "max_time" microseconds.
+ *
+ * Returns:
+ *   1: job is done (and freed)
+ *   0: job is not done (time is over)
+ */
+
+int
+gui_filter_job_run (struct t_gui_filter_job *job, long long max_time)
+{
+    struct t_gui_buffer *ptr_buffer;
+    struct t_gui_filter *ptr_filter;
+    struct t_gui_line_data *ptr_line_data;
+    struct timeval tv_start, tv_now;
+    int lines_hidden, lines_changed, count, done;
+
+    gettimeofday (&tv_start, NULL);
+
+    /* filter added or enabled (job is done if it has been disabled since) */
+    ptr_filter = NULL;
+    if (job->type == GUI_FILTER_JOB_APPLY)
+    {
+        ptr_filter = gui_filter_search_by_id (job->filter_id);
+        if (!ptr_filter || !ptr_filter->enabled || !gui_filters_enabled
+            || !job->buffer->filter)
+        {
+            gui_filter_job_free (job);
+            return 1;
+        }
+    }
+
+    lines_hidden = job->buffer->lines->lines_hidden;
+    lines_changed = 0;
+    count = 0;
+    done = 1;
+
+    while (job->next_line)
+    {
+        ptr_line_data = job->next_line->data;
+        switch (job->type)
+        {
+            case GUI_FILTER_JOB_ALL:
+                if (gui_filter_line (ptr_line_data))
+                {
+                    gui_filter_line_hidden_changed (ptr_line_data);
+                    lines_changed = 1;
+                }
+                break;
+            case GUI_FILTER_JOB_APPLY:
+                /* only a displayed line can be hidden by the filter */
+                if (ptr_line_data->displayed
+                    && !gui_line_has_tag_no_filter (ptr_line_data)
+                    && gui_filter_match_line (ptr_filter, ptr_line_data))
+                {
+                    ptr_line_data->displayed = 0;
+                    ptr_line_data->filter_id = ptr_filter->id;
+                    gui_filter_line_hidden_changed (ptr_line_data);
+                    lines_changed = 1;
+                }
+                break;
+            case GUI_FILTER_JOB_UNAPPLY:
+                /* only a line hidden by the filter can be displayed again */
+                if (!ptr_line_data->displayed
+                    && (ptr_line_data->filter_id == job->filter_id)
+                    && gui_filter_line (ptr_line_data))
+                {
+                    gui_filter_line_hidden_changed (ptr_line_data);
+                    lines_changed = 1;
+                }
+                break;
+        }
+        job->next_line = job->next_line->next_line;
+
+        count++;
+        if (job->next_line && (count % GUI_FILTER_JOB_LINES_CHECK_TIME == 0))
+        {
+            gettimeofday (&tv_now, NULL);
+            if (util_timeval_diff (&tv_start, &tv_now) >= max_time)
+            {
+                done = 0;
+                break;
+            }
+        }
+    }
+
+    /*
+     * job is freed before refresh of buffer, because a callback of signal
+     * sent may change filters or close the buffer
+     */
+    ptr_buffer = job->buffer;
+    if (done)
+        gui_filter_job_free (job);
+
+    gui_filter_buffer_refresh (ptr_buffer, lines_hidden, lines_changed);
+
+    return done;
+}
+
+/*
+ * Callback for timer running filter jobs.
+ */
+
+int
+gui_filter_jobs_timer_cb (const void *pointer, void *data,
+                          int remaining_calls)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) remaining_calls;
+
+    gui_filter_jobs_run ();
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Runs filter jobs (in order) during a time slice, then schedules a timer
+ * to continue later if some jobs are not done.
+ */
+
+void
+gui_filter_jobs_run ()
+{
+    struct timeval tv_start, tv_now;
+    long long time_left;
+
+    gettimeofday (&tv_start, NULL);
+
+    while (gui_filter_jobs)
+    {
+        gettimeofday (&tv_now, NULL);
+        time_left = (GUI_FILTER_JOB_TIME_SLICE * 1000)
+            - util_timeval_diff (&tv_start, &tv_now);
+        if ((time_left <= 0) || !gui_filter_job_run (gui_filter_jobs, time_left))
+            break;
+    }
+
+    if (gui_filter_jobs && !gui_filter_jobs_timer)
+    {
+        gui_filter_jobs_timer = hook_timer (NULL, 1, 0, 0,
+                                            &gui_filter_jobs_timer_cb,
+                                            NULL, NULL);
+    }
+}
+
 /*
  * Filters all buffers, using message filters.
+ *
+ * Lines are filtered by jobs: buffers with a lot of lines are filtered in
+ * background.
  */
 
 void
@@ -196,8 +546,61 @@ gui_filter_all_buffers ()
     for (ptr_buffer = gui_buffers; ptr_buffer;
          ptr_buffer = ptr_buffer->next_buffer)
     {
-        gui_filter_buffer (ptr_buffer, NULL);
+        gui_filter_job_add (ptr_buffer, GUI_FILTER_JOB_ALL, 0);
+    }
+
+    gui_filter_jobs_run ();
+}
+
+/*
+ * Applies a filter which has been added or enabled: only buffers matching
+ * the filter are filtered, and only displayed lines are checked with this
+ * filter.
+ */
+
+void
+gui_filter_apply (struct t_gui_filter *filter)
+{
+    struct t_gui_buffer *ptr_buffer;
+
+    if (!filter || !filter->enabled || !gui_filters_enabled)
+        return;
+
+    for (ptr_buffer = gui_buffers; ptr_buffer;
+         ptr_buffer = ptr_buffer->next_buffer)
+    {
+        if (ptr_buffer->filter
+            && gui_buffer_match_list_split (ptr_buffer,
+                                            filter->num_buffers,
+                                            filter->buffers))
+        {
+            gui_filter_job_add (ptr_buffer, GUI_FILTER_JOB_APPLY, filter->id);
+        }
+    }
+
+    gui_filter_jobs_run ();
+}
+
+/*
+ * Unapplies a filter which has been disabled or which is deleted: only lines
+ * hidden by this filter are checked again (with all filters).
+ *
+ * This function can be called before or after the filter is freed.
+ */
+
+void
+gui_filter_unapply (int filter_id)
+{
+    struct t_gui_buffer *ptr_buffer;
+
+    for (ptr_buffer = gui_buffers; ptr_buffer;
+         ptr_buffer = ptr_buffer->next_buffer)
+    {
+        if (ptr_buffer->own_lines->lines_hidden > 0)
+            gui_filter_job_add (ptr_buffer, GUI_FILTER_JOB_UNAPPLY, filter_id);
     }
+
+    gui_filter_jobs_run ();
 }
 
 /*
@@ -254,6 +657,28 @@ gui_filter_search_by_name (const char *name)
     return NULL;
 }
 
+/*
+ * Searches for a filter by id.
+ *
+ * Returns pointer to filter found, NULL if not found.
+ */
+
+struct t_gui_filter *
+gui_filter_search_by_id (int id)
+{
+    struct t_gui_filter *ptr_filter;
+
+    for (ptr_filter = gui_filters; ptr_filter;
+         ptr_filter = ptr_filter->next_filter)
+    {
+        if (ptr_filter->id == id)
+            return ptr_filter;
+    }
+
+    /* filter not found */
+    return NULL;
+}
+
 /*
  * Displays an error when a new filter is created.
  */
@@ -280,6 +705,7 @@ gui_filter_new (int enabled, const char *name, const char *buffer_name,
                 const char *tags, const char *regex)
 {
     struct t_gui_filter *new_filter;
+    struct t_gui_line_index *regex_index;
     regex_t *regex1, *regex2;
     char *pos_tab, *regex_prefix, **tags_array, buf[512], str_error[512];
     const char *ptr_start_regex, *pos_regex_message;
@@ -307,6 +733,7 @@ gui_filter_new (int enabled, const char *name, const char *buffer_name,
 
     regex1 = NULL;
     regex2 = NULL;
+    regex_index = NULL;
 
     if (strcmp (ptr_start_regex, "*") != 0)
     {
@@ -373,6 +800,23 @@ gui_filter_new (int enabled, const char *name, const char *buffer_name,
             }
         }
 
+        /* literal strings can be searched with the bloom filter of lines */
+        if (gui_line_index_is_literal (regex_prefix)
+            || gui_line_index_is_literal (pos_regex_message))
+        {
+            regex_index = malloc (sizeof (*regex_index));
+            if (regex_index)
+            {
+                gui_line_index_compute (
+                    regex_index,
+                    (gui_line_index_is_literal (regex_prefix)) ?
+                    regex_prefix : NULL,
+                    (gui_line_index_is_literal (pos_regex_message)) ?
+                    pos_regex_message : NULL,
+                    1);
+            }
+        }
+
         if (regex_prefix)
             free (regex_prefix);
     }
@@ -382,6 +826,7 @@ gui_filter_new (int enabled, const char *name, const char *buffer_name,
     if (new_filter)
     {
         /* init filter */
+        new_filter->id = ++gui_filters_last_id;
         new_filter->enabled = enabled;
         new_filter->name = strdup (name);
         new_filter->buffer_name = strdup ((buffer_name) ? buffer_name : "*");
@@ -414,6 +859,7 @@ gui_filter_new (int enabled, const char *name, const char *buffer_name,
         new_filter->regex = strdup (regex);
         new_filter->regex_prefix = regex1;
         new_filter->regex_message = regex2;
+        new_filter->regex_index = regex_index;
 
         /* add filter to filters list */
         new_filter->prev_filter = last_gui_filter;
@@ -502,6 +948,8 @@ gui_filter_free (struct t_gui_filter *filter)
         regfree (filter->regex_message);
         free (filter->regex_message);
     }
+    if (filter->regex_index)
+        free (filter->regex_index);
 
     /* remove filter from filters list */
     if (filter->prev_filter)
@@ -549,6 +997,7 @@ gui_filter_hdata_filter_cb (const void *pointer, void *data,
                        0, 0, NULL, NULL);
     if (hdata)
     {
+        HDATA_VAR(struct t_gui_filter, id, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_filter, enabled, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_filter, name, STRING, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_filter, buffer_name, STRING, 0, NULL, NULL);
@@ -560,6 +1009,7 @@ gui_filter_hdata_filter_cb (const void *pointer, void *data,
         HDATA_VAR(struct t_gui_filter, regex, STRING, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_filter, regex_prefix, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_filter, regex_message, POINTER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_filter, regex_index, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_filter, prev_filter, POINTER, 0, NULL, hdata_name);
         HDATA_VAR(struct t_gui_filter, next_filter, POINTER, 0, NULL, hdata_name);
         HDATA_LIST(gui_filters, WEECHAT_HDATA_LIST_CHECK_POINTERS);
@@ -630,16 +1080,19 @@ void
 gui_filter_print_log ()
 {
     struct t_gui_filter *ptr_filter;
+    struct t_gui_filter_job *ptr_job;
     int i;
 
     log_printf ("");
     log_printf ("gui_filters_enabled = %d", gui_filters_enabled);
+    log_printf ("gui_filters_last_id = %d", gui_filters_last_id);
 
     for (ptr_filter = gui_filters; ptr_filter;
          ptr_filter = ptr_filter->next_filter)
     {
         log_printf ("");
         log_printf ("[filter (addr:0x%lx)]", ptr_filter);
+        log_printf ("  id . . . . . . . . . . : %d",    ptr_filter->id);
         log_printf ("  enabled. . . . . . . . : %d",    ptr_filter->enabled);
         log_printf ("  name . . . . . . . . . : '%s'",  ptr_filter->name);
         log_printf ("  buffer_name. . . . . . : '%s'",  ptr_filter->buffer_name);
@@ -653,7 +1106,20 @@ gui_filter_print_log ()
         log_printf ("  regex. . . . . . . . . : '%s'",  ptr_filter->regex);
         log_printf ("  regex_prefix . . . . . : 0x%lx", ptr_filter->regex_prefix);
         log_printf ("  regex_message. . . . . : 0x%lx", ptr_filter->regex_message);
+        log_printf ("  regex_index. . . . . . : 0x%lx", ptr_filter->regex_index);
         log_printf ("  prev_filter. . . . . . : 0x%lx", ptr_filter->prev_filter);
         log_printf ("  next_filter. . . . . . : 0x%lx", ptr_filter->next_filter);
     }
+
+    for (ptr_job = gui_filter_jobs; ptr_job; ptr_job = ptr_job->next_job)
+    {
+        log_printf ("");
+        log_printf ("[filter job (addr:0x%lx)]", ptr_job);
+        log_printf ("  buffer . . . . . . . . : 0x%lx", ptr_job->buffer);
+        log_printf ("  type . . . . . . . . . : %d",    ptr_job->type);
+        log_printf ("  filter_id. . . . . . . : %d",    ptr_job->filter_id);
+        log_printf ("  next_line. . . . . . . : 0x%lx", ptr_job->next_line);
+        log_printf ("  prev_job . . . . . . . : 0x%lx", ptr_job->prev_job);
+        log_printf ("  next_job . . . . . . . : 0x%lx", ptr_job->next_job);
+    }
 }
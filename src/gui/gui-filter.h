@@ -24,12 +24,29 @@
 
 #define GUI_FILTER_TAG_NO_FILTER "no_filter"
 
+/*
+ * filter jobs: lines of buffers are filtered during a time slice (in
+ * milliseconds), then a timer continues the jobs later
+ */
+#define GUI_FILTER_JOB_TIME_SLICE       20
+#define GUI_FILTER_JOB_LINES_CHECK_TIME 256 /* check time every N lines     */
+
+/* types of filter jobs */
+#define GUI_FILTER_JOB_ALL      0      /* check lines with all filters      */
+#define GUI_FILTER_JOB_APPLY    1      /* check displayed lines with filter */
+                                       /* added or enabled                  */
+#define GUI_FILTER_JOB_UNAPPLY  2      /* check lines hidden by filter      */
+                                       /* deleted or disabled               */
+
 /* filter structures */
 
+struct t_gui_line;
 struct t_gui_line_data;
+struct t_gui_line_index;
 
 struct t_gui_filter
 {
+    int id;                            /* unique id (used in lines)         */
     int enabled;                       /* 1 if filter enabled, otherwise 0  */
     char *name;                        /* filter name                       */
     char *buffer_name;                 /* name of buffer(s)                 */
@@ -41,24 +58,44 @@ struct t_gui_filter
     char *regex;                       /* regex                             */
     regex_t *regex_prefix;             /* regex for line prefix             */
     regex_t *regex_message;            /* regex for line message            */
+    struct t_gui_line_index *regex_index; /* index of regex (NULL if regex  */
+                                       /* is not a literal string)          */
     struct t_gui_filter *prev_filter;  /* link to previous filter           */
     struct t_gui_filter *next_filter;  /* link to next filter               */
 };
 
+struct t_gui_filter_job
+{
+    struct t_gui_buffer *buffer;       /* buffer with lines to filter       */
+    int type;                          /* type of job (GUI_FILTER_JOB_xxx)  */
+    int filter_id;                     /* filter applied or unapplied       */
+    struct t_gui_line *next_line;      /* next line to filter (own lines)   */
+    struct t_gui_filter_job *prev_job; /* link to previous job              */
+    struct t_gui_filter_job *next_job; /* link to next job                  */
+};
+
 /* filter variables */
 
 extern struct t_gui_filter *gui_filters;
 extern struct t_gui_filter *last_gui_filter;
 extern int gui_filters_enabled;
+extern struct t_gui_filter_job *gui_filter_jobs;
+extern struct t_gui_filter_job *last_gui_filter_job;
 
 /* filter functions */
 
-extern int gui_filter_check_line (struct t_gui_line_data *line_data);
+extern int gui_filter_line (struct t_gui_line_data *line_data);
 extern void gui_filter_buffer (struct t_gui_buffer *buffer,
                                struct t_gui_line_data *line_data);
+extern void gui_filter_job_remove_buffer (struct t_gui_buffer *buffer);
+extern void gui_filter_job_remove_line (struct t_gui_line *line);
+extern void gui_filter_jobs_run ();
 extern void gui_filter_all_buffers ();
+extern void gui_filter_apply (struct t_gui_filter *filter);
+extern void gui_filter_unapply (int filter_id);
 extern void gui_filter_global_enable ();
 extern void gui_filter_global_disable ();
+extern struct t_gui_filter *gui_filter_search_by_id (int id);
 extern struct t_gui_filter *gui_filter_search_by_name (const char *name);
 extern struct t_gui_filter *gui_filter_new (int enabled,
                                             const char *name,
@@ -33,6 +33,7 @@
 #include "gui-bar.h"
 #include "gui-bar-window.h"
 #include "gui-buffer.h"
+#include "gui-chat.h"
 #include "gui-color.h"
 #include "gui-focus.h"
 #include "gui-line.h"
@@ -166,7 +167,7 @@ struct t_hashtable *
 gui_focus_to_hashtable (struct t_gui_focus_info *focus_info, const char *key)
 {
     struct t_hashtable *hashtable;
-    char str_value[128], *str_time, *str_prefix, *str_tags, *str_message;
+    char str_value[128], *str_time, *str_tags;
     const char *nick;
 
     hashtable = hashtable_new (32,
@@ -217,13 +218,12 @@ gui_focus_to_hashtable (struct t_gui_focus_info *focus_info, const char *key)
     /* chat area */
     FOCUS_INT("_chat", focus_info->chat);
     str_time = NULL;
-    str_prefix = NULL;
     if (focus_info->chat_line)
     {
-        str_time = gui_color_decode (((focus_info->chat_line)->data)->str_time, NULL);
-        str_prefix = gui_color_decode (((focus_info->chat_line)->data)->prefix, NULL);
+        str_time = gui_color_decode (
+            gui_chat_get_time_string_cached (((focus_info->chat_line)->data)->date),
+            NULL);
         str_tags = string_build_with_split_string ((const char **)((focus_info->chat_line)->data)->tags_array, ",");
-        str_message = gui_color_decode (((focus_info->chat_line)->data)->message, NULL);
         nick = gui_line_get_nick_tag (focus_info->chat_line);
         FOCUS_PTR("_chat_line", focus_info->chat_line);
         FOCUS_INT("_chat_line_x", focus_info->chat_line_x);
@@ -233,16 +233,14 @@ gui_focus_to_hashtable (struct t_gui_focus_info *focus_info, const char *key)
         FOCUS_STR_VAR("_chat_line_time", str_time);
         FOCUS_STR_VAR("_chat_line_tags", str_tags);
         FOCUS_STR_VAR("_chat_line_nick", nick);
-        FOCUS_STR_VAR("_chat_line_prefix", str_prefix);
-        FOCUS_STR_VAR("_chat_line_message", str_message);
+        FOCUS_STR_VAR("_chat_line_prefix",
+                      ((focus_info->chat_line)->data)->prefix_no_color);
+        FOCUS_STR_VAR("_chat_line_message",
+                      ((focus_info->chat_line)->data)->message_no_color);
         if (str_time)
             free (str_time);
-        if (str_prefix)
-            free (str_prefix);
         if (str_tags)
             free (str_tags);
-        if (str_message)
-            free (str_message);
     }
     else
     {
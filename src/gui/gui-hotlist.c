@@ -28,6 +28,7 @@
 #include <string.h>
 
 #include "../core/weechat.h"
+#include "../core/wee-arraylist.h"
 #include "../core/wee-config.h"
 #include "../core/wee-eval.h"
 #include "../core/wee-hashtable.h"
@@ -45,6 +46,8 @@
 
 struct t_gui_hotlist *gui_hotlist = NULL;
 struct t_gui_hotlist *last_gui_hotlist = NULL;
+struct t_arraylist *gui_hotlist_sorted = NULL; /* hotlists in same order as */
+                                               /* list (to find position)   */
 struct t_gui_buffer *gui_hotlist_initial_buffer = NULL;
 struct t_hashtable *gui_hotlist_hashtable_add_conditions_pointers = NULL;
 struct t_hashtable *gui_hotlist_hashtable_add_conditions_vars = NULL;
@@ -52,37 +55,139 @@ struct t_hashtable *gui_hotlist_hashtable_add_conditions_options = NULL;
 
 int gui_add_hotlist = 1;                    /* 0 is for temporarily disable */
                                             /* hotlist add for all buffers  */
+int gui_hotlist_changed = 0;                /* 1 if signal "hotlist_changed"*/
+                                            /* must be sent                 */
 
 
 /*
- * Sends signal "hotlist_changed".
+ * Asks to send signal "hotlist_changed".
+ *
+ * The signal is sent by the main loop (function
+ * gui_hotlist_send_changed_signal), so it is sent only once even if the
+ * hotlist changes many times in the same loop.
  */
 
 void
 gui_hotlist_changed_signal ()
 {
+    gui_hotlist_changed = 1;
+}
+
+/*
+ * Sends signal "hotlist_changed" if the hotlist has changed since last call.
+ */
+
+void
+gui_hotlist_send_changed_signal ()
+{
+    if (!gui_hotlist_changed)
+        return;
+
+    gui_hotlist_changed = 0;
+
     (void) hook_signal_send ("hotlist_changed",
                              WEECHAT_HOOK_SIGNAL_STRING, NULL);
 }
 
 /*
- * Searches for hotlist with buffer pointer.
+ * Compares two hotlists, according to option weechat.look.hotlist_sort.
  *
- * Returns pointer to hotlist found, NULL if not found.
+ * Returns:
+ *   < 0: hotlist1 is before hotlist2
+ *     0: hotlist1 and hotlist2 have same position
+ *   > 0: hotlist1 is after hotlist2
  */
 
-struct t_gui_hotlist *
-gui_hotlist_search (struct t_gui_hotlist *hotlist, struct t_gui_buffer *buffer)
+int
+gui_hotlist_compare (struct t_gui_hotlist *hotlist1,
+                     struct t_gui_hotlist *hotlist2)
 {
-    struct t_gui_hotlist *ptr_hotlist;
+    long long diff;
 
-    for (ptr_hotlist = hotlist; ptr_hotlist;
-         ptr_hotlist = ptr_hotlist->next_hotlist)
+    switch (CONFIG_INTEGER(config_look_hotlist_sort))
     {
-        if (ptr_hotlist->buffer == buffer)
-            return ptr_hotlist;
+        case CONFIG_LOOK_HOTLIST_SORT_GROUP_TIME_ASC:
+        case CONFIG_LOOK_HOTLIST_SORT_GROUP_TIME_DESC:
+        case CONFIG_LOOK_HOTLIST_SORT_GROUP_NUMBER_ASC:
+        case CONFIG_LOOK_HOTLIST_SORT_GROUP_NUMBER_DESC:
+            /* group by priority (higher priority first) */
+            if (hotlist1->priority != hotlist2->priority)
+                return (hotlist1->priority > hotlist2->priority) ? -1 : 1;
+            break;
+    }
+
+    switch (CONFIG_INTEGER(config_look_hotlist_sort))
+    {
+        case CONFIG_LOOK_HOTLIST_SORT_GROUP_TIME_ASC:
+            diff = util_timeval_diff (&(hotlist1->creation_time),
+                                      &(hotlist2->creation_time));
+            return (diff > 0) ? -1 : ((diff < 0) ? 1 : 0);
+        case CONFIG_LOOK_HOTLIST_SORT_GROUP_TIME_DESC:
+            diff = util_timeval_diff (&(hotlist1->creation_time),
+                                      &(hotlist2->creation_time));
+            return (diff < 0) ? -1 : ((diff > 0) ? 1 : 0);
+        case CONFIG_LOOK_HOTLIST_SORT_GROUP_NUMBER_ASC:
+        case CONFIG_LOOK_HOTLIST_SORT_NUMBER_ASC:
+            return (hotlist1->buffer->number < hotlist2->buffer->number) ?
+                -1 : ((hotlist1->buffer->number > hotlist2->buffer->number) ? 1 : 0);
+        case CONFIG_LOOK_HOTLIST_SORT_GROUP_NUMBER_DESC:
+        case CONFIG_LOOK_HOTLIST_SORT_NUMBER_DESC:
+            return (hotlist1->buffer->number > hotlist2->buffer->number) ?
+                -1 : ((hotlist1->buffer->number < hotlist2->buffer->number) ? 1 : 0);
     }
-    return NULL;
+
+    return 0;
+}
+
+/*
+ * Searches for index of a hotlist in sorted hotlists.
+ *
+ * Returns index of hotlist, -1 if not found.
+ */
+
+int
+gui_hotlist_search_index (struct t_gui_hotlist *hotlist)
+{
+    int start, end, middle, size, i;
+
+    size = arraylist_size (gui_hotlist_sorted);
+
+    /* binary search of first hotlist with same position */
+    start = 0;
+    end = size;
+    while (start < end)
+    {
+        middle = (start + end) / 2;
+        if (gui_hotlist_compare (arraylist_get (gui_hotlist_sorted, middle),
+                                 hotlist) < 0)
+        {
+            start = middle + 1;
+        }
+        else
+        {
+            end = middle;
+        }
+    }
+    for (i = start; i < size; i++)
+    {
+        if (arraylist_get (gui_hotlist_sorted, i) == hotlist)
+            return i;
+        if (gui_hotlist_compare (arraylist_get (gui_hotlist_sorted, i),
+                                 hotlist) != 0)
+            break;
+    }
+
+    /*
+     * not found: hotlist is not sorted any more (for example if buffers have
+     * been moved), then search in all hotlists
+     */
+    for (i = 0; i < size; i++)
+    {
+        if (arraylist_get (gui_hotlist_sorted, i) == hotlist)
+            return i;
+    }
+
+    return -1;
 }
 
 /*
@@ -90,48 +195,30 @@ gui_hotlist_search (struct t_gui_hotlist *hotlist, struct t_gui_buffer *buffer)
  */
 
 void
-gui_hotlist_free (struct t_gui_hotlist **hotlist,
-                  struct t_gui_hotlist **last_hotlist,
-                  struct t_gui_hotlist *ptr_hotlist)
+gui_hotlist_free (struct t_gui_hotlist *ptr_hotlist)
 {
-    struct t_gui_hotlist *new_hotlist;
+    int index;
 
     if (!ptr_hotlist)
         return;
 
     ptr_hotlist->buffer->hotlist = NULL;
 
+    index = gui_hotlist_search_index (ptr_hotlist);
+    if (index >= 0)
+        arraylist_remove (gui_hotlist_sorted, index);
+
     /* remove hotlist from queue */
-    if (*last_hotlist == ptr_hotlist)
-        *last_hotlist = ptr_hotlist->prev_hotlist;
+    if (last_gui_hotlist == ptr_hotlist)
+        last_gui_hotlist = ptr_hotlist->prev_hotlist;
     if (ptr_hotlist->prev_hotlist)
-    {
         (ptr_hotlist->prev_hotlist)->next_hotlist = ptr_hotlist->next_hotlist;
-        new_hotlist = *hotlist;
-    }
     else
-        new_hotlist = ptr_hotlist->next_hotlist;
-
+        gui_hotlist = ptr_hotlist->next_hotlist;
     if (ptr_hotlist->next_hotlist)
         (ptr_hotlist->next_hotlist)->prev_hotlist = ptr_hotlist->prev_hotlist;
 
     free (ptr_hotlist);
-    *hotlist = new_hotlist;
-}
-
-/*
- * Frees all hotlists.
- */
-
-void
-gui_hotlist_free_all (struct t_gui_hotlist **hotlist,
-                      struct t_gui_hotlist **last_hotlist)
-{
-    /* remove all hotlists */
-    while (*hotlist)
-    {
-        gui_hotlist_free (hotlist, last_hotlist, *hotlist);
-    }
 }
 
 /*
@@ -166,121 +253,89 @@ gui_hotlist_check_buffer_notify (struct t_gui_buffer *buffer,
 }
 
 /*
- * Searches for position of hotlist (to keep hotlist sorted).
+ * Searches for position of a new hotlist (to keep hotlist sorted): a binary
+ * search is done in sorted hotlists, the new hotlist is after hotlists with
+ * same position.
+ *
+ * Returns index where the new hotlist must be inserted.
  */
 
-struct t_gui_hotlist *
-gui_hotlist_find_pos (struct t_gui_hotlist *hotlist,
-                      struct t_gui_hotlist *new_hotlist)
+int
+gui_hotlist_find_pos (struct t_gui_hotlist *new_hotlist)
 {
-    struct t_gui_hotlist *ptr_hotlist;
+    int start, end, middle;
 
-    switch (CONFIG_INTEGER(config_look_hotlist_sort))
+    start = 0;
+    end = arraylist_size (gui_hotlist_sorted);
+    while (start < end)
     {
-        case CONFIG_LOOK_HOTLIST_SORT_GROUP_TIME_ASC:
-            for (ptr_hotlist = hotlist; ptr_hotlist;
-                 ptr_hotlist = ptr_hotlist->next_hotlist)
-            {
-                if ((new_hotlist->priority > ptr_hotlist->priority)
-                    || ((new_hotlist->priority == ptr_hotlist->priority)
-                        && (util_timeval_diff (&(new_hotlist->creation_time),
-                                               &(ptr_hotlist->creation_time)) > 0)))
-                    return ptr_hotlist;
-            }
-            break;
-        case CONFIG_LOOK_HOTLIST_SORT_GROUP_TIME_DESC:
-            for (ptr_hotlist = hotlist; ptr_hotlist;
-                 ptr_hotlist = ptr_hotlist->next_hotlist)
-            {
-                if ((new_hotlist->priority > ptr_hotlist->priority)
-                    || ((new_hotlist->priority == ptr_hotlist->priority)
-                        && (util_timeval_diff (&(new_hotlist->creation_time),
-                                               &(ptr_hotlist->creation_time)) < 0)))
-                    return ptr_hotlist;
-            }
-            break;
-        case CONFIG_LOOK_HOTLIST_SORT_GROUP_NUMBER_ASC:
-            for (ptr_hotlist = hotlist; ptr_hotlist;
-                 ptr_hotlist = ptr_hotlist->next_hotlist)
-            {
-                if ((new_hotlist->priority > ptr_hotlist->priority)
-                    || ((new_hotlist->priority == ptr_hotlist->priority)
-                        && (new_hotlist->buffer->number < ptr_hotlist->buffer->number)))
-                    return ptr_hotlist;
-            }
-            break;
-        case CONFIG_LOOK_HOTLIST_SORT_GROUP_NUMBER_DESC:
-            for (ptr_hotlist = hotlist; ptr_hotlist;
-                 ptr_hotlist = ptr_hotlist->next_hotlist)
-            {
-                if ((new_hotlist->priority > ptr_hotlist->priority)
-                    || ((new_hotlist->priority == ptr_hotlist->priority)
-                        && (new_hotlist->buffer->number > ptr_hotlist->buffer->number)))
-                    return ptr_hotlist;
-            }
-            break;
-        case CONFIG_LOOK_HOTLIST_SORT_NUMBER_ASC:
-            for (ptr_hotlist = hotlist; ptr_hotlist;
-                 ptr_hotlist = ptr_hotlist->next_hotlist)
-            {
-                if (new_hotlist->buffer->number < ptr_hotlist->buffer->number)
-                    return ptr_hotlist;
-            }
-            break;
-        case CONFIG_LOOK_HOTLIST_SORT_NUMBER_DESC:
-            for (ptr_hotlist = hotlist; ptr_hotlist;
-                 ptr_hotlist = ptr_hotlist->next_hotlist)
-            {
-                if (new_hotlist->buffer->number > ptr_hotlist->buffer->number)
-                    return ptr_hotlist;
-            }
-            break;
+        middle = (start + end) / 2;
+        if (gui_hotlist_compare (new_hotlist,
+                                 arraylist_get (gui_hotlist_sorted, middle)) < 0)
+        {
+            end = middle;
+        }
+        else
+        {
+            start = middle + 1;
+        }
     }
-    return NULL;
+
+    return start;
 }
 
 /*
  * Adds new hotlist in list.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
  */
 
-void
-gui_hotlist_add_hotlist (struct t_gui_hotlist **hotlist,
-                         struct t_gui_hotlist **last_hotlist,
-                         struct t_gui_hotlist *new_hotlist)
+int
+gui_hotlist_add_hotlist (struct t_gui_hotlist *new_hotlist)
 {
     struct t_gui_hotlist *pos_hotlist;
+    int index;
 
-    if (*hotlist)
+    if (!gui_hotlist_sorted)
     {
-        pos_hotlist = gui_hotlist_find_pos (*hotlist, new_hotlist);
+        gui_hotlist_sorted = arraylist_new (32, 0, 1,
+                                            NULL, NULL, NULL, NULL);
+        if (!gui_hotlist_sorted)
+            return 0;
+    }
 
-        if (pos_hotlist)
-        {
-            /* insert hotlist into the hotlist (before hotlist found) */
-            new_hotlist->prev_hotlist = pos_hotlist->prev_hotlist;
-            new_hotlist->next_hotlist = pos_hotlist;
-            if (pos_hotlist->prev_hotlist)
-                (pos_hotlist->prev_hotlist)->next_hotlist = new_hotlist;
-            else
-                *hotlist = new_hotlist;
-            pos_hotlist->prev_hotlist = new_hotlist;
-        }
+    index = gui_hotlist_find_pos (new_hotlist);
+    pos_hotlist = arraylist_get (gui_hotlist_sorted, index);
+
+    if (arraylist_insert (gui_hotlist_sorted, index, new_hotlist) < 0)
+        return 0;
+
+    if (pos_hotlist)
+    {
+        /* insert hotlist into the hotlist (before hotlist found) */
+        new_hotlist->prev_hotlist = pos_hotlist->prev_hotlist;
+        new_hotlist->next_hotlist = pos_hotlist;
+        if (pos_hotlist->prev_hotlist)
+            (pos_hotlist->prev_hotlist)->next_hotlist = new_hotlist;
         else
-        {
-            /* add hotlist to the end */
-            new_hotlist->prev_hotlist = *last_hotlist;
-            new_hotlist->next_hotlist = NULL;
-            (*last_hotlist)->next_hotlist = new_hotlist;
-            *last_hotlist = new_hotlist;
-        }
+            gui_hotlist = new_hotlist;
+        pos_hotlist->prev_hotlist = new_hotlist;
     }
     else
     {
-        new_hotlist->prev_hotlist = NULL;
+        /* add hotlist to the end */
+        new_hotlist->prev_hotlist = last_gui_hotlist;
         new_hotlist->next_hotlist = NULL;
-        *hotlist = new_hotlist;
-        *last_hotlist = new_hotlist;
+        if (last_gui_hotlist)
+            last_gui_hotlist->next_hotlist = new_hotlist;
+        else
+            gui_hotlist = new_hotlist;
+        last_gui_hotlist = new_hotlist;
     }
+
+    return 1;
 }
 
 /*
@@ -375,7 +430,7 @@ gui_hotlist_add (struct t_gui_buffer *buffer,
         count[i] = 0;
     }
 
-    ptr_hotlist = gui_hotlist_search (gui_hotlist, buffer);
+    ptr_hotlist = buffer->hotlist;
     if (ptr_hotlist)
     {
         /* return if priority is greater or equal than the one to add */
@@ -391,7 +446,7 @@ gui_hotlist_add (struct t_gui_buffer *buffer,
          * and go on
          */
         memcpy (count, ptr_hotlist->count, sizeof (ptr_hotlist->count));
-        gui_hotlist_free (&gui_hotlist, &last_gui_hotlist, ptr_hotlist);
+        gui_hotlist_free (ptr_hotlist);
     }
 
     new_hotlist = malloc (sizeof (*new_hotlist));
@@ -407,13 +462,17 @@ gui_hotlist_add (struct t_gui_buffer *buffer,
     else
         gettimeofday (&(new_hotlist->creation_time), NULL);
     new_hotlist->buffer = buffer;
-    buffer->hotlist = new_hotlist;
     memcpy (new_hotlist->count, count, sizeof (new_hotlist->count));
     new_hotlist->count[priority]++;
     new_hotlist->next_hotlist = NULL;
     new_hotlist->prev_hotlist = NULL;
 
-    gui_hotlist_add_hotlist (&gui_hotlist, &last_gui_hotlist, new_hotlist);
+    if (!gui_hotlist_add_hotlist (new_hotlist))
+    {
+        free (new_hotlist);
+        return NULL;
+    }
+    buffer->hotlist = new_hotlist;
 
     gui_hotlist_changed_signal ();
 
@@ -421,56 +480,34 @@ gui_hotlist_add (struct t_gui_buffer *buffer,
 }
 
 /*
- * Duplicates a hotlist element.
- *
- * Returns pointer to new hotlist, NULL if error.
- */
-
-struct t_gui_hotlist *
-gui_hotlist_dup (struct t_gui_hotlist *hotlist)
-{
-    struct t_gui_hotlist *new_hotlist;
-
-    new_hotlist = malloc (sizeof (*new_hotlist));
-    if (new_hotlist)
-    {
-        new_hotlist->priority = hotlist->priority;
-        memcpy (&(new_hotlist->creation_time), &(hotlist->creation_time),
-                sizeof (new_hotlist->creation_time));
-        new_hotlist->buffer = hotlist->buffer;
-        memcpy (new_hotlist->count, hotlist->count, sizeof (hotlist->count));
-        new_hotlist->prev_hotlist = NULL;
-        new_hotlist->next_hotlist = NULL;
-        return new_hotlist;
-    }
-    return NULL;
-}
-
-/*
- * Resorts hotlist with new sort type.
+ * Resorts hotlist with new sort type (or after buffers have been moved, if
+ * hotlist is sorted by buffer number).
  */
 
 void
 gui_hotlist_resort ()
 {
-    struct t_gui_hotlist *new_hotlist, *last_new_hotlist;
-    struct t_gui_hotlist *ptr_hotlist, *element;
+    struct t_gui_hotlist *ptr_hotlist, *next_hotlist;
 
-    /* copy and resort hotlist in new linked list */
-    new_hotlist = NULL;
-    last_new_hotlist = NULL;
-    for (ptr_hotlist = gui_hotlist; ptr_hotlist;
-         ptr_hotlist = ptr_hotlist->next_hotlist)
+    if (!gui_hotlist)
+        return;
+
+    /* insert again all hotlists, with new sort */
+    ptr_hotlist = gui_hotlist;
+    gui_hotlist = NULL;
+    last_gui_hotlist = NULL;
+    arraylist_clear (gui_hotlist_sorted);
+    while (ptr_hotlist)
     {
-        element = gui_hotlist_dup (ptr_hotlist);
-        gui_hotlist_add_hotlist (&new_hotlist, &last_new_hotlist, element);
+        next_hotlist = ptr_hotlist->next_hotlist;
+        if (!gui_hotlist_add_hotlist (ptr_hotlist))
+        {
+            ptr_hotlist->buffer->hotlist = NULL;
+            free (ptr_hotlist);
+        }
+        ptr_hotlist = next_hotlist;
     }
 
-    gui_hotlist_free_all (&gui_hotlist, &last_gui_hotlist);
-
-    gui_hotlist = new_hotlist;
-    last_gui_hotlist = last_new_hotlist;
-
     gui_hotlist_changed_signal ();
 }
 
@@ -503,7 +540,7 @@ gui_hotlist_clear (int level_mask)
         ptr_next_hotlist = ptr_hotlist->next_hotlist;
         if (level_mask & (1 << ptr_hotlist->priority))
         {
-            gui_hotlist_free (&gui_hotlist, &last_gui_hotlist, ptr_hotlist);
+            gui_hotlist_free (ptr_hotlist);
             hotlist_changed = 1;
         }
         ptr_hotlist = ptr_next_hotlist;
@@ -554,7 +591,7 @@ gui_hotlist_remove_buffer (struct t_gui_buffer *buffer,
 
         if (buffer_to_remove)
         {
-            gui_hotlist_free (&gui_hotlist, &last_gui_hotlist, ptr_hotlist);
+            gui_hotlist_free (ptr_hotlist);
             hotlist_changed = 1;
         }
 
@@ -705,6 +742,11 @@ gui_hotlist_print_log ()
 void
 gui_hotlist_end ()
 {
+    if (gui_hotlist_sorted)
+    {
+        arraylist_free (gui_hotlist_sorted);
+        gui_hotlist_sorted = NULL;
+    }
     if (gui_hotlist_hashtable_add_conditions_pointers)
     {
         hashtable_free (gui_hotlist_hashtable_add_conditions_pointers);
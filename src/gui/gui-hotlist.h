@@ -56,6 +56,7 @@ extern int gui_add_hotlist;
 
 /* hotlist functions */
 
+extern void gui_hotlist_send_changed_signal ();
 extern struct t_gui_hotlist *gui_hotlist_add (struct t_gui_buffer *buffer,
                                               enum t_gui_hotlist_priority priority,
                                               struct timeval *creation_time);
@@ -69,6 +69,22 @@ gui_input_optimize_size (struct t_gui_buffer *buffer,
 
     optimal_size = ((new_size / GUI_BUFFER_INPUT_BLOCK_SIZE) *
                     GUI_BUFFER_INPUT_BLOCK_SIZE) + GUI_BUFFER_INPUT_BLOCK_SIZE;
+
+    /*
+     * the allocated size grows exponentially and is reduced only if the input
+     * uses less than a quarter of it, so that a long input does not need a
+     * realloc each time a block is crossed (when typing or deleting chars)
+     */
+    if (optimal_size > buffer->input_buffer_alloc)
+    {
+        if (optimal_size < buffer->input_buffer_alloc * 2)
+            optimal_size = buffer->input_buffer_alloc * 2;
+    }
+    else if (optimal_size > buffer->input_buffer_alloc / 4)
+    {
+        optimal_size = buffer->input_buffer_alloc;
+    }
+
     if (buffer->input_buffer_alloc != optimal_size)
     {
         input_buffer2 = realloc (buffer->input_buffer, optimal_size);
@@ -84,6 +100,29 @@ gui_input_optimize_size (struct t_gui_buffer *buffer,
     return 1;
 }
 
+/*
+ * Returns pointer to char at position "pos" (number of chars) in input.
+ *
+ * If the input has only single-byte chars (size is equal to length), the
+ * pointer is computed without reading the UTF-8 string.
+ */
+
+char *
+gui_input_get_pos_ptr (struct t_gui_buffer *buffer, int pos)
+{
+    if (pos < 0)
+        pos = 0;
+
+    if (buffer->input_buffer_size == buffer->input_buffer_length)
+    {
+        if (pos > buffer->input_buffer_size)
+            pos = buffer->input_buffer_size;
+        return buffer->input_buffer + pos;
+    }
+
+    return (char *)utf8_add_offset (buffer->input_buffer, pos);
+}
+
 /*
  * Replaces full input by another string, trying to keep cursor position if new
  * string is long enough.
@@ -245,7 +284,7 @@ void
 gui_input_insert_string (struct t_gui_buffer *buffer, const char *string,
                          int pos)
 {
-    int size, length;
+    int size, length, offset;
     char *string_utf8, *ptr_start;
 
     if (buffer->input)
@@ -262,6 +301,9 @@ gui_input_insert_string (struct t_gui_buffer *buffer, const char *string,
         size = strlen (string_utf8);
         length = utf8_strlen (string_utf8);
 
+        /* offset must be computed before the size of input is changed */
+        offset = gui_input_get_pos_ptr (buffer, pos) - buffer->input_buffer;
+
         if (gui_input_optimize_size (buffer,
                                      buffer->input_buffer_size + size,
                                      buffer->input_buffer_length + length))
@@ -269,12 +311,11 @@ gui_input_insert_string (struct t_gui_buffer *buffer, const char *string,
             buffer->input_buffer[buffer->input_buffer_size] = '\0';
 
             /* move end of string to the right */
-            ptr_start = (char *)utf8_add_offset (buffer->input_buffer, pos);
+            ptr_start = buffer->input_buffer + offset;
             memmove (ptr_start + size, ptr_start, strlen (ptr_start));
 
             /* insert new string */
-            ptr_start = (char *)utf8_add_offset (buffer->input_buffer, pos);
-            strncpy (ptr_start, string_utf8, size);
+            memcpy (ptr_start, string_utf8, size);
 
             buffer->input_buffer_pos += length;
         }
@@ -783,8 +824,7 @@ gui_input_delete_previous_char (struct t_gui_buffer *buffer)
     if (buffer->input && (buffer->input_buffer_pos > 0))
     {
         gui_buffer_undo_snap (buffer);
-        pos = (char *)utf8_add_offset (buffer->input_buffer,
-                                       buffer->input_buffer_pos);
+        pos = gui_input_get_pos_ptr (buffer, buffer->input_buffer_pos);
         pos_last = (char *)utf8_prev_char (buffer->input_buffer, pos);
         char_size = pos - pos_last;
         size_to_move = strlen (pos);
@@ -816,8 +856,7 @@ gui_input_delete_next_char (struct t_gui_buffer *buffer)
         && (buffer->input_buffer_pos < buffer->input_buffer_length))
     {
         gui_buffer_undo_snap (buffer);
-        pos = (char *)utf8_add_offset (buffer->input_buffer,
-                                       buffer->input_buffer_pos);
+        pos = gui_input_get_pos_ptr (buffer, buffer->input_buffer_pos);
         pos_next = (char *)utf8_next_char (pos);
         char_size = pos_next - pos;
         size_to_move = strlen (pos_next);
@@ -847,8 +886,7 @@ gui_input_delete_previous_word (struct t_gui_buffer *buffer)
     if (buffer->input && (buffer->input_buffer_pos > 0))
     {
         gui_buffer_undo_snap (buffer);
-        start = (char *)utf8_add_offset (buffer->input_buffer,
-                                         buffer->input_buffer_pos - 1);
+        start = gui_input_get_pos_ptr (buffer, buffer->input_buffer_pos - 1);
         string = start;
         while (string && !string_is_word_char_input (string))
         {
@@ -908,8 +946,7 @@ gui_input_delete_next_word (struct t_gui_buffer *buffer)
     if (buffer->input)
     {
         gui_buffer_undo_snap (buffer);
-        start = (char *)utf8_add_offset (buffer->input_buffer,
-                                         buffer->input_buffer_pos);
+        start = gui_input_get_pos_ptr (buffer, buffer->input_buffer_pos);
         string = start;
         length_deleted = 0;
         while (string[0])
@@ -952,8 +989,7 @@ gui_input_delete_beginning_of_line (struct t_gui_buffer *buffer)
     if (buffer->input && (buffer->input_buffer_pos > 0))
     {
         gui_buffer_undo_snap (buffer);
-        start = (char *)utf8_add_offset (buffer->input_buffer,
-                                         buffer->input_buffer_pos);
+        start = gui_input_get_pos_ptr (buffer, buffer->input_buffer_pos);
         size_deleted = start - buffer->input_buffer;
         length_deleted = utf8_strnlen (buffer->input_buffer, size_deleted);
         gui_input_clipboard_copy (buffer->input_buffer,
@@ -988,8 +1024,7 @@ gui_input_delete_end_of_line (struct t_gui_buffer *buffer)
     if (buffer->input)
     {
         gui_buffer_undo_snap (buffer);
-        start = (char *)utf8_add_offset (buffer->input_buffer,
-                                         buffer->input_buffer_pos);
+        start = gui_input_get_pos_ptr (buffer, buffer->input_buffer_pos);
         size_deleted = strlen (start);
         gui_input_clipboard_copy (start, size_deleted);
         start[0] = '\0';
@@ -1041,14 +1076,13 @@ gui_input_transpose_chars (struct t_gui_buffer *buffer)
         if (buffer->input_buffer_pos == buffer->input_buffer_length)
             buffer->input_buffer_pos--;
 
-        start = (char *)utf8_add_offset (buffer->input_buffer,
-                                         buffer->input_buffer_pos);
+        start = gui_input_get_pos_ptr (buffer, buffer->input_buffer_pos);
         prev_char = (char *)utf8_prev_char (buffer->input_buffer, start);
         size_prev_char = start - prev_char;
         size_start_char = utf8_char_size (start);
 
         memcpy (saved_char, prev_char, size_prev_char);
-        memcpy (prev_char, start, size_start_char);
+        memmove (prev_char, start, size_start_char);
         memcpy (prev_char + size_start_char, saved_char, size_prev_char);
 
         buffer->input_buffer_pos++;
@@ -1130,8 +1164,7 @@ gui_input_move_previous_word (struct t_gui_buffer *buffer)
     if (buffer->input
         && (buffer->input_buffer_pos > 0))
     {
-        pos = (char *)utf8_add_offset (buffer->input_buffer,
-                                       buffer->input_buffer_pos - 1);
+        pos = gui_input_get_pos_ptr (buffer, buffer->input_buffer_pos - 1);
         while (pos && !string_is_word_char_input (pos))
         {
             pos = (char *)utf8_prev_char (buffer->input_buffer, pos);
@@ -1169,8 +1202,7 @@ gui_input_move_next_word (struct t_gui_buffer *buffer)
     if (buffer->input
         && (buffer->input_buffer_pos < buffer->input_buffer_length))
     {
-        pos = (char *)utf8_add_offset (buffer->input_buffer,
-                                       buffer->input_buffer_pos);
+        pos = gui_input_get_pos_ptr (buffer, buffer->input_buffer_pos);
         while (pos[0] && !string_is_word_char_input (pos))
         {
             pos = (char *)utf8_next_char (pos);
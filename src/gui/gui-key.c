@@ -63,6 +63,9 @@ struct t_gui_key *gui_default_keys[GUI_KEY_NUM_CONTEXTS]; /* default keys   */
 struct t_gui_key *last_gui_default_key[GUI_KEY_NUM_CONTEXTS];
 int gui_keys_count[GUI_KEY_NUM_CONTEXTS];            /* keys number         */
 int gui_default_keys_count[GUI_KEY_NUM_CONTEXTS];    /* default keys number */
+struct t_gui_key_trie *gui_keys_trie[GUI_KEY_NUM_CONTEXTS]; /* key tries  */
+unsigned long gui_keys_generation = 0; /* incremented when a key is added   */
+                                       /* or removed (in any list of keys)  */
 
 char *gui_key_context_string[GUI_KEY_NUM_CONTEXTS] =
 { "default", "search", "cursor", "mouse" };
@@ -88,6 +91,11 @@ int gui_key_paste_bracketed = 0;    /* bracketed paste mode detected        */
 struct t_hook *gui_key_paste_bracketed_timer = NULL;
                                     /* timer for bracketed paste            */
 int gui_key_paste_lines = 0;        /* number of lines for pending paste    */
+char **gui_key_paste_text = NULL;   /* pasted text not yet inserted in      */
+                                    /* input (dynamic string)               */
+struct t_gui_buffer *gui_key_paste_text_buffer = NULL;
+                                    /* buffer for pasted text               */
+int gui_key_paste_text_save_undo = 0; /* save undo when text is inserted    */
 
 time_t gui_key_last_activity_time = 0; /* last activity time (key)          */
 
@@ -115,6 +123,7 @@ gui_key_init ()
         last_gui_default_key[i] = NULL;
         gui_keys_count[i] = 0;
         gui_default_keys_count[i] = 0;
+        gui_keys_trie[i] = NULL;
         gui_key_default_bindings (i);
         gui_default_keys[i] = gui_keys[i];
         last_gui_default_key[i] = last_gui_key[i];
@@ -426,6 +435,8 @@ gui_key_insert_sorted (struct t_gui_key **keys,
     }
 
     (*keys_count)++;
+
+    gui_keys_generation++;
 }
 
 /*
@@ -726,10 +737,204 @@ gui_key_cmp (const char *key, const char *search, int context)
     return 0;
 }
 
+/*
+ * Frees a node of a trie of keys (and all its children).
+ */
+
+void
+gui_key_trie_node_free (struct t_gui_key_trie_node *node)
+{
+    int i;
+
+    if (!node)
+        return;
+
+    for (i = 0; i < node->children_count; i++)
+    {
+        gui_key_trie_node_free (node->children[i]);
+    }
+    if (node->children_bytes)
+        free (node->children_bytes);
+    if (node->children)
+        free (node->children);
+
+    free (node);
+}
+
+/*
+ * Frees a trie of keys.
+ */
+
+void
+gui_key_trie_free (struct t_gui_key_trie *trie)
+{
+    if (!trie)
+        return;
+
+    gui_key_trie_node_free (trie->root);
+
+    free (trie);
+}
+
+/*
+ * Allocates a new node in a trie of keys.
+ *
+ * Returns pointer to new node, NULL if error.
+ */
+
+struct t_gui_key_trie_node *
+gui_key_trie_node_alloc ()
+{
+    struct t_gui_key_trie_node *new_node;
+
+    new_node = malloc (sizeof (*new_node));
+    if (!new_node)
+        return NULL;
+
+    new_node->key = NULL;
+    new_node->children_count = 0;
+    new_node->children_bytes = NULL;
+    new_node->children = NULL;
+
+    return new_node;
+}
+
+/*
+ * Searches for child of a node with a byte (binary search in sorted bytes of
+ * children).
+ *
+ * If the child is not found and argument "create" is 1, the child is created
+ * and inserted in children of node.
+ *
+ * Returns pointer to child found (or created), NULL if not found or error.
+ */
+
+struct t_gui_key_trie_node *
+gui_key_trie_node_get_child (struct t_gui_key_trie_node *node,
+                             unsigned char byte, int create)
+{
+    struct t_gui_key_trie_node *new_child, **new_children;
+    unsigned char *new_children_bytes;
+    int start, end, middle;
+
+    start = 0;
+    end = node->children_count;
+    while (start < end)
+    {
+        middle = start + ((end - start) / 2);
+        if (node->children_bytes[middle] == byte)
+            return node->children[middle];
+        if (node->children_bytes[middle] < byte)
+            start = middle + 1;
+        else
+            end = middle;
+    }
+
+    if (!create)
+        return NULL;
+
+    /* child not found: insert a new child at position "start" */
+    new_children_bytes = realloc (
+        node->children_bytes,
+        (node->children_count + 1) * sizeof (node->children_bytes[0]));
+    if (!new_children_bytes)
+        return NULL;
+    node->children_bytes = new_children_bytes;
+    new_children = realloc (
+        node->children,
+        (node->children_count + 1) * sizeof (node->children[0]));
+    if (!new_children)
+        return NULL;
+    node->children = new_children;
+
+    new_child = gui_key_trie_node_alloc ();
+    if (!new_child)
+        return NULL;
+
+    if (start < node->children_count)
+    {
+        memmove (&node->children_bytes[start + 1],
+                 &node->children_bytes[start],
+                 (node->children_count - start) * sizeof (node->children_bytes[0]));
+        memmove (&node->children[start + 1],
+                 &node->children[start],
+                 (node->children_count - start) * sizeof (node->children[0]));
+    }
+    node->children_bytes[start] = byte;
+    node->children[start] = new_child;
+    node->children_count++;
+
+    return new_child;
+}
+
+/*
+ * Builds a trie with a list of keys: each node of trie has a pointer to the
+ * first key in list beginning with the bytes leading to this node.
+ *
+ * Keys beginning with "@" (areas) are ignored in contexts "cursor" and
+ * "mouse".
+ *
+ * Returns pointer to new trie, NULL if error.
+ */
+
+struct t_gui_key_trie *
+gui_key_trie_build (struct t_gui_key *keys, int context)
+{
+    struct t_gui_key_trie *new_trie;
+    struct t_gui_key_trie_node *ptr_node;
+    struct t_gui_key *ptr_key;
+    const unsigned char *ptr_byte;
+
+    new_trie = malloc (sizeof (*new_trie));
+    if (!new_trie)
+        return NULL;
+
+    new_trie->context = context;
+    new_trie->generation = gui_keys_generation;
+    new_trie->root = gui_key_trie_node_alloc ();
+    if (!new_trie->root)
+    {
+        free (new_trie);
+        return NULL;
+    }
+
+    for (ptr_key = keys; ptr_key; ptr_key = ptr_key->next_key)
+    {
+        if (!ptr_key->key
+            || (((context == GUI_KEY_CONTEXT_CURSOR)
+                 || (context == GUI_KEY_CONTEXT_MOUSE))
+                && (ptr_key->key[0] == '@')))
+        {
+            continue;
+        }
+        ptr_node = new_trie->root;
+        if (!ptr_node->key)
+            ptr_node->key = ptr_key;
+        for (ptr_byte = (const unsigned char *)ptr_key->key; ptr_byte[0];
+             ptr_byte++)
+        {
+            ptr_node = gui_key_trie_node_get_child (ptr_node, ptr_byte[0], 1);
+            if (!ptr_node)
+            {
+                gui_key_trie_free (new_trie);
+                return NULL;
+            }
+            if (!ptr_node->key)
+                ptr_node->key = ptr_key;
+        }
+    }
+
+    return new_trie;
+}
+
 /*
  * Searches for a key (maybe part of string).
  *
- * Returns pointer to key found, NULL if not found.
+ * Except in context "mouse" (where keys can contain wildcards), the keys are
+ * searched in a trie, built on first search and rebuilt after keys have
+ * changed, so the search does not depend on the number of keys.
+ *
+ * Returns pointer to first key beginning with "key", NULL if not found.
  */
 
 struct t_gui_key *
@@ -737,6 +942,38 @@ gui_key_search_part (struct t_gui_buffer *buffer, int context,
                      const char *key)
 {
     struct t_gui_key *ptr_key;
+    struct t_gui_key_trie **ptr_trie;
+    struct t_gui_key_trie_node *ptr_node;
+    const unsigned char *ptr_byte;
+
+    if (context != GUI_KEY_CONTEXT_MOUSE)
+    {
+        ptr_trie = (buffer) ? &buffer->keys_trie : &gui_keys_trie[context];
+        if (*ptr_trie
+            && (((*ptr_trie)->context != context)
+                || ((*ptr_trie)->generation != gui_keys_generation)))
+        {
+            gui_key_trie_free (*ptr_trie);
+            *ptr_trie = NULL;
+        }
+        if (!*ptr_trie)
+        {
+            *ptr_trie = gui_key_trie_build ((buffer) ?
+                                            buffer->keys : gui_keys[context],
+                                            context);
+        }
+        if (*ptr_trie)
+        {
+            ptr_node = (*ptr_trie)->root;
+            for (ptr_byte = (const unsigned char *)key; ptr_node && ptr_byte[0];
+                 ptr_byte++)
+            {
+                ptr_node = gui_key_trie_node_get_child (ptr_node,
+                                                        ptr_byte[0], 0);
+            }
+            return (ptr_node) ? ptr_node->key : NULL;
+        }
+    }
 
     for (ptr_key = (buffer) ? buffer->keys : gui_keys[context]; ptr_key;
          ptr_key = ptr_key->next_key)
@@ -1378,6 +1615,8 @@ gui_key_pressed (const char *key_str)
             gui_key_combo_buffer[0] = '\0';
             if ((rc != WEECHAT_RC_OK_EAT) && ptr_key->command)
             {
+                /* the command may use input: insert pasted text first */
+                gui_key_paste_text_insert ();
                 commands = string_split_command (ptr_key->command, ';');
                 if (commands)
                 {
@@ -1404,6 +1643,7 @@ gui_key_pressed (const char *key_str)
             gui_key_combo_buffer[0] = '\0';
             return 0;
         }
+        gui_key_paste_text_insert ();
         if (gui_key_focus (gui_key_combo_buffer, GUI_KEY_CONTEXT_CURSOR))
         {
             gui_key_combo_buffer[0] = '\0';
@@ -1473,6 +1713,8 @@ gui_key_free (struct t_gui_key **keys, struct t_gui_key **last_key,
     free (key);
 
     (*keys_count)--;
+
+    gui_keys_generation++;
 }
 
 /*
@@ -1548,12 +1790,34 @@ gui_key_buffer_reset ()
 void
 gui_key_buffer_add (unsigned char key)
 {
+    int new_alloc, *new_buffer;
+
     if (!gui_key_buffer)
         gui_key_buffer_reset ();
 
     gui_key_buffer_size++;
 
-    gui_key_buffer_optimize ();
+    /*
+     * grow buffer if needed: size is doubled, so that a large paste is added
+     * without a reallocation for each key (the size is optimized when the
+     * buffer is reset)
+     */
+    if (gui_key_buffer
+        && ((int)(gui_key_buffer_size * sizeof (int)) > gui_key_buffer_alloc))
+    {
+        new_alloc = gui_key_buffer_alloc * 2;
+        new_buffer = realloc (gui_key_buffer, new_alloc);
+        if (new_buffer)
+        {
+            gui_key_buffer = new_buffer;
+            gui_key_buffer_alloc = new_alloc;
+        }
+        else
+        {
+            free (gui_key_buffer);
+            gui_key_buffer = NULL;
+        }
+    }
 
     if (gui_key_buffer)
     {
@@ -1822,6 +2086,69 @@ gui_key_paste_bracketed_stop ()
     gui_key_paste_bracketed = 0;
 }
 
+/*
+ * Adds text to the pasted text, which is inserted in input of buffer by
+ * function gui_key_paste_text_insert: the whole text pasted is inserted at
+ * once, instead of inserting each char of text (which is very slow with a
+ * large paste).
+ */
+
+void
+gui_key_paste_text_add (struct t_gui_buffer *buffer, const char *text,
+                        int save_undo)
+{
+    if (!buffer || !text || !text[0])
+        return;
+
+    if (gui_key_paste_text_buffer && (gui_key_paste_text_buffer != buffer))
+        gui_key_paste_text_insert ();
+
+    if (!gui_key_paste_text)
+        gui_key_paste_text = string_dyn_alloc (256);
+
+    if (!gui_key_paste_text || !string_dyn_concat (gui_key_paste_text, text))
+    {
+        /* not enough memory: insert text now */
+        gui_input_insert_string (buffer, text, -1);
+        gui_input_text_changed_modifier_and_signal (buffer, save_undo, 1);
+        return;
+    }
+
+    if (!gui_key_paste_text_buffer)
+    {
+        gui_key_paste_text_buffer = buffer;
+        gui_key_paste_text_save_undo = save_undo;
+    }
+}
+
+/*
+ * Inserts pasted text in input of buffer (if some text was added with
+ * function gui_key_paste_text_add).
+ */
+
+void
+gui_key_paste_text_insert ()
+{
+    struct t_gui_buffer *ptr_buffer;
+
+    if (!gui_key_paste_text_buffer)
+        return;
+
+    ptr_buffer = gui_key_paste_text_buffer;
+    gui_key_paste_text_buffer = NULL;
+
+    if (gui_buffer_valid (ptr_buffer) && (*gui_key_paste_text)[0])
+    {
+        gui_input_insert_string (ptr_buffer, *gui_key_paste_text, -1);
+        gui_input_text_changed_modifier_and_signal (
+            ptr_buffer,
+            gui_key_paste_text_save_undo,
+            1); /* stop completion */
+    }
+
+    string_dyn_copy (gui_key_paste_text, NULL);
+}
+
 /*
  * Accepts paste from user.
  */
@@ -1871,6 +2198,13 @@ gui_key_end ()
     if (gui_key_buffer)
         free (gui_key_buffer);
 
+    /* free pasted text */
+    if (gui_key_paste_text)
+    {
+        string_dyn_free (gui_key_paste_text, 1);
+        gui_key_paste_text = NULL;
+    }
+
     for (i = 0; i < GUI_KEY_NUM_CONTEXTS; i++)
     {
         /* free keys */
@@ -1879,6 +2213,9 @@ gui_key_end ()
         /* free default keys */
         gui_key_free_all (&gui_default_keys[i], &last_gui_default_key[i],
                           &gui_default_keys_count[i]);
+        /* free trie of keys */
+        gui_key_trie_free (gui_keys_trie[i]);
+        gui_keys_trie[i] = NULL;
     }
 }
 
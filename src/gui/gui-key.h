@@ -64,6 +64,24 @@ struct t_gui_key
     struct t_gui_key *next_key;     /* link to next key                     */
 };
 
+struct t_gui_key_trie_node
+{
+    struct t_gui_key *key;          /* first key in list beginning with the */
+                                    /* bytes leading to this node           */
+    int children_count;             /* number of children                   */
+    unsigned char *children_bytes;  /* bytes of children (sorted)           */
+    struct t_gui_key_trie_node **children; /* children nodes                */
+};
+
+struct t_gui_key_trie
+{
+    int context;                    /* context used to build trie           */
+    unsigned long generation;       /* value of gui_keys_generation when    */
+                                    /* trie was built (trie is outdated if  */
+                                    /* keys have changed since)             */
+    struct t_gui_key_trie_node *root; /* root node (empty key)              */
+};
+
 /* key variables */
 
 extern struct t_gui_key *gui_keys[GUI_KEY_NUM_CONTEXTS];
@@ -87,6 +105,7 @@ extern time_t gui_key_last_activity_time;
 
 extern void gui_key_init ();
 extern int gui_key_search_context (const char *context);
+extern int gui_key_get_current_context ();
 extern void gui_key_grab_init (int grab_command, const char *delay);
 extern char *gui_key_get_internal_code (const char *key);
 extern char *gui_key_get_expanded_name (const char *key);
@@ -97,6 +116,9 @@ extern struct t_gui_key *gui_key_new (struct t_gui_buffer *buffer,
                                       const char *command);
 extern struct t_gui_key *gui_key_search (struct t_gui_key *keys,
                                          const char *key);
+extern void gui_key_trie_free (struct t_gui_key_trie *trie);
+extern struct t_gui_key *gui_key_search_part (struct t_gui_buffer *buffer,
+                                             int context, const char *key);
 extern struct t_gui_key *gui_key_bind (struct t_gui_buffer *buffer,
                                        int context,
                                        const char *key,
@@ -124,6 +146,9 @@ extern void gui_key_paste_replace_tabs ();
 extern void gui_key_paste_start ();
 extern int gui_key_get_paste_lines ();
 extern int gui_key_paste_check (int bracketed_paste);
+extern void gui_key_paste_text_add (struct t_gui_buffer *buffer,
+                                    const char *text, int save_undo);
+extern void gui_key_paste_text_insert ();
 extern void gui_key_paste_bracketed_timer_remove ();
 extern void gui_key_paste_bracketed_timer_add ();
 extern void gui_key_paste_bracketed_start ();
@@ -27,6 +27,7 @@
 #include <stddef.h>
 #include <string.h>
 #include <time.h>
+#include <zlib.h>
 
 #include "../core/weechat.h"
 #include "../core/wee-config.h"
@@ -71,24 +72,211 @@ gui_lines_alloc ()
         new_lines->buffer_max_length_refresh = 0;
         new_lines->prefix_max_length = CONFIG_INTEGER(config_look_prefix_align_min);
         new_lines->prefix_max_length_refresh = 0;
+        new_lines->first_slab = NULL;
+        new_lines->last_slab = NULL;
+        new_lines->first_block = NULL;
+        new_lines->last_block = NULL;
+        new_lines->lines_compressed = 0;
+        new_lines->lines_count_total = 0;
     }
 
     return new_lines;
 }
 
 /*
- * Frees a "t_gui_lines" structure.
+ * Frees all blocks of compressed lines in a "t_gui_lines" structure.
+ */
+
+void
+gui_lines_free_blocks (struct t_gui_lines *lines)
+{
+    struct t_gui_line_block *ptr_next_block;
+
+    while (lines->first_block)
+    {
+        ptr_next_block = lines->first_block->next_block;
+        free (lines->first_block);
+        lines->first_block = ptr_next_block;
+    }
+    lines->last_block = NULL;
+    lines->lines_compressed = 0;
+    lines->lines_count_total = lines->lines_count;
+}
+
+/*
+ * Frees a "t_gui_lines" structure (and all its slabs and blocks of
+ * compressed lines).
  */
 
 void
 gui_lines_free (struct t_gui_lines *lines)
 {
+    struct t_gui_line_slab *ptr_next_slab;
+
     if (!lines)
         return;
 
+    gui_lines_free_blocks (lines);
+
+    while (lines->first_slab)
+    {
+        ptr_next_slab = lines->first_slab->next_slab;
+        free (lines->first_slab);
+        lines->first_slab = ptr_next_slab;
+    }
+
     free (lines);
 }
 
+/*
+ * Creates a new slab for lines and inserts it after slab "prev_slab" (if
+ * "prev_slab" is NULL, the new slab is the first one).
+ *
+ * Returns pointer to new slab, NULL if error.
+ */
+
+struct t_gui_line_slab *
+gui_line_slab_new (struct t_gui_lines *lines,
+                   struct t_gui_line_slab *prev_slab, int slab_size)
+{
+    struct t_gui_line_slab *new_slab;
+
+    new_slab = malloc (GUI_LINE_SLAB_ALIGN(sizeof (*new_slab)) + slab_size);
+    if (!new_slab)
+        return NULL;
+    new_slab->data = (char *)new_slab + GUI_LINE_SLAB_ALIGN(sizeof (*new_slab));
+    new_slab->size = slab_size;
+    new_slab->used = 0;
+    new_slab->lines_count = 0;
+    new_slab->prev_slab = prev_slab;
+    new_slab->next_slab = (prev_slab) ? prev_slab->next_slab : lines->first_slab;
+    if (new_slab->prev_slab)
+        (new_slab->prev_slab)->next_slab = new_slab;
+    else
+        lines->first_slab = new_slab;
+    if (new_slab->next_slab)
+        (new_slab->next_slab)->prev_slab = new_slab;
+    else
+        lines->last_slab = new_slab;
+
+    return new_slab;
+}
+
+/*
+ * Allocates memory for a line in a slab.
+ *
+ * If argument "old" is 0, the line is a new line (added at the end of
+ * buffer): it is allocated in the last slab of lines (a new slab is created
+ * if there is not enough space in the last one).
+ *
+ * If argument "old" is 1, the line is older than all lines of buffer (line
+ * uncompressed from a block): it is allocated in the slab "*slab" (slab of
+ * the previous line uncompressed from the same block), or in a new slab
+ * inserted after "*slab" (before the first slab if "*slab" is NULL), so that
+ * the order of slabs remains the order of lines and that slabs are freed when
+ * oldest lines are removed.
+ *
+ * Returns pointer to memory allocated, NULL if error.
+ */
+
+void *
+gui_line_slab_alloc (struct t_gui_lines *lines, int size, int old,
+                     struct t_gui_line_slab **slab)
+{
+    struct t_gui_line_slab *ptr_slab;
+    void *pointer;
+    int slab_size;
+
+    /* align size so that next line in slab is aligned too */
+    size = GUI_LINE_SLAB_ALIGN(size);
+
+    ptr_slab = (old) ? *slab : lines->last_slab;
+
+    if (!ptr_slab || (ptr_slab->size - ptr_slab->used < size))
+    {
+        if (old)
+        {
+            /* a block of lines fills about one slab of max size */
+            slab_size = GUI_LINE_SLAB_MAX_SIZE;
+        }
+        else
+        {
+            slab_size = GUI_LINE_SLAB_MIN_SIZE;
+            if (ptr_slab)
+            {
+                slab_size = ptr_slab->size * 2;
+                if (slab_size > GUI_LINE_SLAB_MAX_SIZE)
+                    slab_size = GUI_LINE_SLAB_MAX_SIZE;
+            }
+        }
+        if (slab_size < size)
+            slab_size = size;
+        ptr_slab = gui_line_slab_new (lines, ptr_slab, slab_size);
+        if (!ptr_slab)
+            return NULL;
+    }
+
+    pointer = ptr_slab->data + ptr_slab->used;
+    ptr_slab->used += size;
+    ptr_slab->lines_count++;
+    *slab = ptr_slab;
+
+    return pointer;
+}
+
+/*
+ * Releases a line allocated in a slab: when the slab does not contain any
+ * line, it is freed (or reused if it is the last slab).
+ */
+
+void
+gui_line_slab_free_line (struct t_gui_lines *lines,
+                         struct t_gui_line_slab *slab)
+{
+    slab->lines_count--;
+    if (slab->lines_count > 0)
+        return;
+
+    if (slab == lines->last_slab)
+    {
+        /* keep the last slab for next lines */
+        slab->used = 0;
+        return;
+    }
+
+    if (slab->prev_slab)
+        (slab->prev_slab)->next_slab = slab->next_slab;
+    if (slab->next_slab)
+        (slab->next_slab)->prev_slab = slab->prev_slab;
+    if (lines->first_slab == slab)
+        lines->first_slab = slab->next_slab;
+    if (lines->last_slab == slab)
+        lines->last_slab = slab->prev_slab;
+
+    free (slab);
+}
+
+/*
+ * Checks if a pointer (string in line data) is in the slab of line, which
+ * means that it has been allocated with the line and must not be freed.
+ *
+ * Returns:
+ *   1: pointer is in slab
+ *   0: pointer is not in slab (allocated with malloc)
+ */
+
+int
+gui_line_slab_contains (struct t_gui_line_data *line_data,
+                        const void *pointer)
+{
+    if (!line_data || !line_data->slab || !pointer)
+        return 0;
+
+    return (((const char *)pointer >= line_data->slab->data)
+            && ((const char *)pointer < line_data->slab->data
+                + line_data->slab->size)) ? 1 : 0;
+}
+
 /*
  * Allocates array with tags in a line_data.
  */
@@ -120,12 +308,68 @@ gui_line_tags_free (struct t_gui_line_data *line_data)
 
     if (line_data->tags_array)
     {
-        string_free_split_shared (line_data->tags_array);
+        if (!gui_line_slab_contains (line_data, line_data->tags_array))
+            string_free_split_shared (line_data->tags_array);
         line_data->tags_count = 0;
         line_data->tags_array = NULL;
     }
 }
 
+/*
+ * Splits tags of a line (separated by commas) in a slab.
+ *
+ * If tags_array is NULL, only the number of tags and the length of strings
+ * (in *length) are computed; otherwise the tags are copied in "strings" and
+ * the array tags_array is filled (with a NULL pointer at the end).
+ *
+ * Empty tags are ignored (like function string_split does).
+ *
+ * Returns number of tags.
+ */
+
+int
+gui_line_tags_split_slab (const char *tags, char **tags_array, char *strings,
+                          int *length)
+{
+    const char *ptr_tags, *pos;
+    int count, length_tag;
+
+    count = 0;
+    if (length)
+        *length = 0;
+
+    if (!tags)
+        return 0;
+
+    ptr_tags = tags;
+    while (ptr_tags[0])
+    {
+        pos = strchr (ptr_tags, ',');
+        length_tag = (pos) ? pos - ptr_tags : (int)strlen (ptr_tags);
+        if (length_tag > 0)
+        {
+            if (tags_array)
+            {
+                memcpy (strings, ptr_tags, length_tag);
+                strings[length_tag] = '\0';
+                tags_array[count] = strings;
+                strings += length_tag + 1;
+            }
+            if (length)
+                *length += length_tag + 1;
+            count++;
+        }
+        if (!pos)
+            break;
+        ptr_tags = pos + 1;
+    }
+
+    if (tags_array)
+        tags_array[count] = NULL;
+
+    return count;
+}
+
 /*
  * Checks if prefix on line is a nick and is the same as nick on previous line.
  *
@@ -430,186 +674,512 @@ gui_line_get_next_displayed (struct t_gui_line *line)
 }
 
 /*
- * Searches for text in a line.
- *
- * Returns:
- *   1: text found in line
- *   0: text not found in line
+ * Frees prefix and message without colors in a line data (this must be done
+ * before prefix or message is changed).
  */
 
-int
-gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
+void
+gui_line_no_color_free (struct t_gui_line_data *line_data)
 {
-    char *prefix, *message;
-    int rc;
-
-    if (!line || !line->data->message
-        || !buffer->input_buffer || !buffer->input_buffer[0])
+    if (line_data->prefix_no_color)
     {
-        return 0;
+        string_shared_free (line_data->prefix_no_color);
+        line_data->prefix_no_color = NULL;
+    }
+    if (line_data->message_no_color)
+    {
+        if ((line_data->message_no_color != line_data->message)
+            && !gui_line_slab_contains (line_data,
+                                        line_data->message_no_color))
+        {
+            free (line_data->message_no_color);
+        }
+        line_data->message_no_color = NULL;
     }
+}
 
-    rc = 0;
+/*
+ * Builds prefix and message without colors in a line data (they must have
+ * been freed before with function gui_line_no_color_free).
+ *
+ * The message without colors is the message itself if it has no colors.
+ */
 
-    if ((buffer->text_search_where & GUI_TEXT_SEARCH_IN_PREFIX)
-        && line->data->prefix)
+void
+gui_line_no_color_build (struct t_gui_line_data *line_data)
+{
+    char *prefix, *message;
+
+    if (line_data->prefix)
     {
-        prefix = gui_color_decode (line->data->prefix, NULL);
+        prefix = gui_color_decode (line_data->prefix, NULL);
         if (prefix)
         {
-            if (buffer->text_search_regex)
-            {
-                if (buffer->text_search_regex_compiled)
-                {
-                    if (regexec (buffer->text_search_regex_compiled,
-                                 prefix, 0, NULL, 0) == 0)
-                    {
-                        rc = 1;
-                    }
-                }
-            }
-            else if ((buffer->text_search_exact
-                      && (strstr (prefix, buffer->input_buffer)))
-                     || (!buffer->text_search_exact
-                         && (string_strcasestr (prefix, buffer->input_buffer))))
-            {
-                rc = 1;
-            }
+            line_data->prefix_no_color = (char *)string_shared_get (prefix);
             free (prefix);
         }
     }
 
-    if (!rc && (buffer->text_search_where & GUI_TEXT_SEARCH_IN_MESSAGE))
+    if (line_data->message)
     {
-        message = gui_color_decode (line->data->message, NULL);
-        if (message)
+        message = gui_color_decode (line_data->message, NULL);
+        if (message && (strcmp (message, line_data->message) == 0))
         {
-            if (buffer->text_search_regex)
-            {
-                if (buffer->text_search_regex_compiled)
-                {
-                    if (regexec (buffer->text_search_regex_compiled,
-                                 message, 0, NULL, 0) == 0)
-                    {
-                        rc = 1;
-                    }
-                }
-            }
-            else if ((buffer->text_search_exact
-                      && (strstr (message, buffer->input_buffer)))
-                     || (!buffer->text_search_exact
-                         && (string_strcasestr (message, buffer->input_buffer))))
-            {
-                rc = 1;
-            }
             free (message);
+            message = line_data->message;
         }
+        line_data->message_no_color = message;
     }
-
-    return rc;
 }
 
 /*
- * Checks if a line matches regex.
+ * Checks if a regular expression is a literal string (without any special
+ * char), so that the bloom filter of lines can be used with it.
  *
  * Returns:
- *   1: line matches regex
- *   0: line does not match regex
+ *   1: regex is a literal string
+ *   0: regex has special chars (or is empty)
  */
 
 int
-gui_line_match_regex (struct t_gui_line_data *line_data, regex_t *regex_prefix,
-                      regex_t *regex_message)
+gui_line_index_is_literal (const char *regex)
 {
-    char *prefix, *message;
-    int match_prefix, match_message;
-
-    if (!line_data || (!regex_prefix && !regex_message))
+    if (!regex || !regex[0])
         return 0;
 
-    prefix = NULL;
-    message = NULL;
+    return (strpbrk (regex, "\\^$.[]|()*+?{}")) ? 0 : 1;
+}
 
-    match_prefix = 1;
-    match_message = 1;
+/*
+ * Adds trigrams of a string in an index (bit field with "size" integers).
+ *
+ * Chars are converted to lower case (only ASCII chars, like function
+ * string_strcasestr does).
+ *
+ * If regex_icase is 1, the string is searched with a case insensitive regex,
+ * which can match non-ASCII chars with ASCII chars: trigrams with non-ASCII
+ * chars or with chars "i", "k" and "s" (which have non-ASCII upper/lower case
+ * equivalents) are skipped.
+ */
 
-    if (line_data->prefix)
+void
+gui_line_index_add_string (unsigned int *index, int size, const char *string,
+                           int regex_icase)
+{
+    unsigned int trigram, hash, bit;
+    int length;
+    unsigned char c;
+
+    if (!string)
+        return;
+
+    trigram = 0;
+    length = 0;
+    while (string[0])
     {
-        prefix = gui_color_decode (line_data->prefix, NULL);
-        if (!prefix
-            || (regex_prefix && (regexec (regex_prefix, prefix, 0, NULL, 0) != 0)))
-            match_prefix = 0;
+        c = (unsigned char)string[0];
+        if ((c >= 'A') && (c <= 'Z'))
+            c += ('a' - 'A');
+        if (regex_icase
+            && ((c >= 128) || (c == 'i') || (c == 'k') || (c == 's')))
+        {
+            length = 0;
+        }
+        else
+        {
+            trigram = ((trigram << 8) | c) & 0xFFFFFF;
+            length++;
+            if (length >= 3)
+            {
+                hash = (trigram * 2654435761U) & 0xFFFFFFFF;
+                bit = (hash >> 16) % (size * 32);
+                index[bit / 32] |= 1U << (bit % 32);
+            }
+        }
+        string++;
     }
-    else
+}
+
+/*
+ * Computes index of a text searched in prefix and/or message (prefix and
+ * message can be NULL).
+ *
+ * If regex_icase is 1, the strings are case insensitive regex (literal
+ * strings only, see function gui_line_index_is_literal).
+ */
+
+void
+gui_line_index_compute (struct t_gui_line_index *index,
+                        const char *prefix, const char *message,
+                        int regex_icase)
+{
+    memset (index, 0, sizeof (*index));
+
+    gui_line_index_add_string (index->prefix, GUI_LINE_INDEX_PREFIX_SIZE,
+                               prefix, regex_icase);
+    gui_line_index_add_string (index->message, GUI_LINE_INDEX_MESSAGE_SIZE,
+                               message, regex_icase);
+}
+
+/*
+ * Builds bloom filter of a line (with prefix and message without colors).
+ *
+ * If option weechat.history.index_buffer_lines is off, all bits are set in
+ * the index, so that the line is always checked by searches.
+ */
+
+void
+gui_line_index_build (struct t_gui_line_data *line_data)
+{
+    if (!CONFIG_BOOLEAN(config_history_index_buffer_lines))
     {
-        if (regex_prefix)
-            match_prefix = 0;
+        memset (&line_data->index, 0xFF, sizeof (line_data->index));
+        return;
     }
 
-    if (line_data->message)
+    memset (&line_data->index, 0, sizeof (line_data->index));
+
+    if (line_data->prefix_no_color)
     {
-        message = gui_color_decode (line_data->message, NULL);
-        if (!message
-            || (regex_message && (regexec (regex_message, message, 0, NULL, 0) != 0)))
-            match_message = 0;
+        gui_line_index_add_string (line_data->index.prefix,
+                                   GUI_LINE_INDEX_PREFIX_SIZE,
+                                   line_data->prefix_no_color, 0);
     }
-    else
+    else if (line_data->prefix)
     {
-        if (regex_message)
-            match_message = 0;
+        memset (line_data->index.prefix, 0xFF,
+                sizeof (line_data->index.prefix));
     }
 
-    if (prefix)
-        free (prefix);
-    if (message)
-        free (message);
+    if (line_data->message_no_color)
+    {
+        gui_line_index_add_string (line_data->index.message,
+                                   GUI_LINE_INDEX_MESSAGE_SIZE,
+                                   line_data->message_no_color, 0);
+    }
+    else if (line_data->message)
+    {
+        memset (line_data->index.message, 0xFF,
+                sizeof (line_data->index.message));
+    }
+}
 
-    return (match_prefix && match_message);
+/*
+ * Builds bloom filter of lines in all buffers (compressed lines are indexed
+ * when they are uncompressed).
+ */
+
+void
+gui_line_index_build_all ()
+{
+    struct t_gui_buffer *ptr_buffer;
+    struct t_gui_line *ptr_line;
+
+    for (ptr_buffer = gui_buffers; ptr_buffer;
+         ptr_buffer = ptr_buffer->next_buffer)
+    {
+        for (ptr_line = ptr_buffer->own_lines->first_line; ptr_line;
+             ptr_line = ptr_line->next_line)
+        {
+            gui_line_index_build (ptr_line->data);
+        }
+    }
 }
 
 /*
- * Checks if a line has tag "no_filter" (which means that line should never been
- * filtered: it is always displayed).
+ * Checks if all bits of an index are set in another index.
  *
  * Returns:
- *   1: line has tag "no_filter"
- *   0: line does not have tag "no_filter"
+ *   1: all bits are set
+ *   0: at least one bit is not set
  */
 
 int
-gui_line_has_tag_no_filter (struct t_gui_line_data *line_data)
+gui_line_index_contains (const unsigned int *index,
+                         const unsigned int *search, int size)
 {
     int i;
 
-    for (i = 0; i < line_data->tags_count; i++)
+    for (i = 0; i < size; i++)
     {
-        if (strcmp (line_data->tags_array[i], GUI_FILTER_TAG_NO_FILTER) == 0)
-            return 1;
+        if ((index[i] & search[i]) != search[i])
+            return 0;
     }
 
-    /* tag not found, line may be filtered */
-    return 0;
+    return 1;
 }
 
 /*
- * Checks if line matches tags.
+ * Checks if the prefix of a line can match a text, using bloom filter of line
+ * and index of text (built with function gui_line_index_compute).
  *
  * Returns:
- *   1: line matches tags
- *   0: line does not match tags
+ *   1: prefix can contain the text (the prefix must then be checked)
+ *   0: prefix does not contain the text
  */
 
 int
-gui_line_match_tags (struct t_gui_line_data *line_data,
-                     int tags_count, char ***tags_array)
+gui_line_index_match_prefix (struct t_gui_line_data *line_data,
+                             struct t_gui_line_index *index)
 {
-    int i, j, k, match, tag_found, tag_negated;
-
-    if (!line_data)
-        return 0;
+    return gui_line_index_contains (line_data->index.prefix, index->prefix,
+                                    GUI_LINE_INDEX_PREFIX_SIZE);
+}
 
-    if (line_data->tags_count == 0)
-        return 0;
+/*
+ * Checks if the message of a line can match a text, using bloom filter of line
+ * and index of text (built with function gui_line_index_compute).
+ *
+ * Returns:
+ *   1: message can contain the text (the message must then be checked)
+ *   0: message does not contain the text
+ */
+
+int
+gui_line_index_match_message (struct t_gui_line_data *line_data,
+                              struct t_gui_line_index *index)
+{
+    return gui_line_index_contains (line_data->index.message, index->message,
+                                    GUI_LINE_INDEX_MESSAGE_SIZE);
+}
+
+/*
+ * Computes index of text searched in a buffer (input of buffer), to check
+ * quickly the bloom filter of lines: it is computed once per search and
+ * given to function gui_line_search_text for each line.
+ *
+ * Returns pointer to index (argument "index"), NULL if the bloom filter of
+ * lines can not be used (regex which is not a literal string).
+ */
+
+struct t_gui_line_index *
+gui_line_search_text_index (struct t_gui_buffer *buffer,
+                            struct t_gui_line_index *index)
+{
+    if (!buffer->input_buffer || !buffer->input_buffer[0]
+        || (buffer->text_search_regex
+            && !gui_line_index_is_literal (buffer->input_buffer)))
+    {
+        return NULL;
+    }
+
+    gui_line_index_compute (
+        index, buffer->input_buffer, buffer->input_buffer,
+        (buffer->text_search_regex && !buffer->text_search_exact) ? 1 : 0);
+
+    return index;
+}
+
+/*
+ * Searches for text in a line.
+ *
+ * Argument "index" is the index of text searched (built with function
+ * gui_line_search_text_index), NULL to check the line without its bloom
+ * filter.
+ *
+ * Returns:
+ *   1: text found in line
+ *   0: text not found in line
+ */
+
+int
+gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line,
+                      struct t_gui_line_index *index)
+{
+    const char *prefix, *message;
+    int rc;
+
+    if (!line || !line->data->message
+        || !buffer->input_buffer || !buffer->input_buffer[0])
+    {
+        return 0;
+    }
+
+    rc = 0;
+
+    prefix = line->data->prefix_no_color;
+    if ((buffer->text_search_where & GUI_TEXT_SEARCH_IN_PREFIX)
+        && prefix
+        && (!index || gui_line_index_match_prefix (line->data, index)))
+    {
+        if (buffer->text_search_regex)
+        {
+            if (buffer->text_search_regex_compiled)
+            {
+                if (regexec (buffer->text_search_regex_compiled,
+                             prefix, 0, NULL, 0) == 0)
+                {
+                    rc = 1;
+                }
+            }
+        }
+        else if ((buffer->text_search_exact
+                  && (strstr (prefix, buffer->input_buffer)))
+                 || (!buffer->text_search_exact
+                     && (string_strcasestr (prefix, buffer->input_buffer))))
+        {
+            rc = 1;
+        }
+    }
+
+    message = line->data->message_no_color;
+    if (!rc && (buffer->text_search_where & GUI_TEXT_SEARCH_IN_MESSAGE)
+        && message
+        && (!index || gui_line_index_match_message (line->data, index)))
+    {
+        if (buffer->text_search_regex)
+        {
+            if (buffer->text_search_regex_compiled)
+            {
+                if (regexec (buffer->text_search_regex_compiled,
+                             message, 0, NULL, 0) == 0)
+                {
+                    rc = 1;
+                }
+            }
+        }
+        else if ((buffer->text_search_exact
+                  && (strstr (message, buffer->input_buffer)))
+                 || (!buffer->text_search_exact
+                     && (string_strcasestr (message, buffer->input_buffer))))
+        {
+            rc = 1;
+        }
+    }
+
+    return rc;
+}
+
+/*
+ * Checks if a line has a text (case insensitive) in prefix or message.
+ *
+ * Argument "index" is the index of text (built with function
+ * gui_line_index_compute), it is used to skip quickly lines which can not
+ * contain the text.
+ *
+ * Returns:
+ *   1: text found in line
+ *   0: text not found in line
+ */
+
+int
+gui_line_has_text (struct t_gui_line_data *line_data,
+                   struct t_gui_line_index *index, const char *text)
+{
+    if (!line_data || !index || !text || !text[0])
+        return 0;
+
+    if (line_data->prefix_no_color
+        && gui_line_index_match_prefix (line_data, index)
+        && string_strcasestr (line_data->prefix_no_color, text))
+    {
+        return 1;
+    }
+
+    if (line_data->message_no_color
+        && gui_line_index_match_message (line_data, index)
+        && string_strcasestr (line_data->message_no_color, text))
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Checks if a line matches regex.
+ *
+ * Returns:
+ *   1: line matches regex
+ *   0: line does not match regex
+ */
+
+int
+gui_line_match_regex (struct t_gui_line_data *line_data, regex_t *regex_prefix,
+                      regex_t *regex_message)
+{
+    int match_prefix, match_message;
+
+    if (!line_data || (!regex_prefix && !regex_message))
+        return 0;
+
+    match_prefix = 1;
+    match_message = 1;
+
+    if (line_data->prefix)
+    {
+        if (!line_data->prefix_no_color
+            || (regex_prefix && (regexec (regex_prefix,
+                                          line_data->prefix_no_color,
+                                          0, NULL, 0) != 0)))
+            match_prefix = 0;
+    }
+    else
+    {
+        if (regex_prefix)
+            match_prefix = 0;
+    }
+
+    if (line_data->message)
+    {
+        if (!line_data->message_no_color
+            || (regex_message && (regexec (regex_message,
+                                           line_data->message_no_color,
+                                           0, NULL, 0) != 0)))
+            match_message = 0;
+    }
+    else
+    {
+        if (regex_message)
+            match_message = 0;
+    }
+
+    return (match_prefix && match_message);
+}
+
+/*
+ * Checks if a line has tag "no_filter" (which means that line should never been
+ * filtered: it is always displayed).
+ *
+ * Returns:
+ *   1: line has tag "no_filter"
+ *   0: line does not have tag "no_filter"
+ */
+
+int
+gui_line_has_tag_no_filter (struct t_gui_line_data *line_data)
+{
+    int i;
+
+    for (i = 0; i < line_data->tags_count; i++)
+    {
+        if (strcmp (line_data->tags_array[i], GUI_FILTER_TAG_NO_FILTER) == 0)
+            return 1;
+    }
+
+    /* tag not found, line may be filtered */
+    return 0;
+}
+
+/*
+ * Checks if line matches tags.
+ *
+ * Returns:
+ *   1: line matches tags
+ *   0: line does not match tags
+ */
+
+int
+gui_line_match_tags (struct t_gui_line_data *line_data,
+                     int tags_count, char ***tags_array)
+{
+    int i, j, k, match, tag_found, tag_negated;
+
+    if (!line_data)
+        return 0;
+
+    if (line_data->tags_count == 0)
+        return 0;
 
     for (i = 0; i < tags_count; i++)
     {
@@ -699,8 +1269,7 @@ int
 gui_line_has_highlight (struct t_gui_line *line)
 {
     int rc, i, no_highlight, action, length;
-    char *msg_no_color, *ptr_msg_no_color, *highlight_words;
-    const char *ptr_nick;
+    const char *ptr_nick, *ptr_msg_no_color;
 
     /*
      * highlights are disabled on this buffer? (special value "-" means that
@@ -773,11 +1342,10 @@ gui_line_has_highlight (struct t_gui_line *line)
             return 0;
     }
 
-    /* remove color codes from line message */
-    msg_no_color = gui_color_decode (line->data->message, NULL);
-    if (!msg_no_color)
+    /* message without color codes */
+    ptr_msg_no_color = line->data->message_no_color;
+    if (!ptr_msg_no_color)
         return 0;
-    ptr_msg_no_color = msg_no_color;
 
     /*
      * if the line is an action message and that we know the nick, we skip
@@ -802,26 +1370,12 @@ gui_line_has_highlight (struct t_gui_line *line)
 
     /*
      * there is highlight on line if one of buffer highlight words matches line
-     * or one of global highlight words matches line
+     * or one of global highlight words matches line (all words are compiled
+     * together in buffer, so the message is read only once)
      */
-    highlight_words = gui_buffer_string_replace_local_var (line->data->buffer,
-                                                           line->data->buffer->highlight_words);
-    rc = string_has_highlight (ptr_msg_no_color,
-                               (highlight_words) ?
-                               highlight_words : line->data->buffer->highlight_words);
-    if (highlight_words)
-        free (highlight_words);
-
-    if (!rc)
-    {
-        highlight_words = gui_buffer_string_replace_local_var (line->data->buffer,
-                                                               CONFIG_STRING(config_look_highlight));
-        rc = string_has_highlight (ptr_msg_no_color,
-                                   (highlight_words) ?
-                                   highlight_words : CONFIG_STRING(config_look_highlight));
-        if (highlight_words)
-            free (highlight_words);
-    }
+    rc = string_highlight_match (
+        gui_buffer_get_highlight_matcher (line->data->buffer),
+        ptr_msg_no_color);
 
     if (!rc && config_highlight_regex)
     {
@@ -835,8 +1389,6 @@ gui_line_has_highlight (struct t_gui_line *line)
                                                   line->data->buffer->highlight_regex_compiled);
     }
 
-    free (msg_no_color);
-
     return rc;
 }
 
@@ -928,22 +1480,27 @@ gui_line_compute_prefix_max_length (struct t_gui_lines *lines)
 }
 
 /*
- * Adds a line to a "t_gui_lines" structure.
+ * Inserts a line in a "t_gui_lines" structure, before "next_line" (if
+ * "next_line" is NULL, the line is added at the end).
  */
 
 void
-gui_line_add_to_list (struct t_gui_lines *lines,
-                      struct t_gui_line *line)
+gui_line_insert_in_list (struct t_gui_lines *lines,
+                         struct t_gui_line *line,
+                         struct t_gui_line *next_line)
 {
     int prefix_length, prefix_is_nick;
 
-    if (!lines->first_line)
+    line->prev_line = (next_line) ? next_line->prev_line : lines->last_line;
+    line->next_line = next_line;
+    if (line->prev_line)
+        (line->prev_line)->next_line = line;
+    else
         lines->first_line = line;
+    if (next_line)
+        next_line->prev_line = line;
     else
-        (lines->last_line)->next_line = line;
-    line->prev_line = lines->last_line;
-    line->next_line = NULL;
-    lines->last_line = line;
+        lines->last_line = line;
 
     /* adjust "prefix_max_length" if this prefix length is > max */
     gui_line_get_prefix_for_display (line, NULL, &prefix_length, NULL,
@@ -958,6 +1515,47 @@ gui_line_add_to_list (struct t_gui_lines *lines,
         (lines->lines_hidden)++;
 
     lines->lines_count++;
+    lines->lines_count_total = lines->lines_count + lines->lines_compressed;
+}
+
+/*
+ * Adds a line to a "t_gui_lines" structure.
+ */
+
+void
+gui_line_add_to_list (struct t_gui_lines *lines,
+                      struct t_gui_line *line)
+{
+    gui_line_insert_in_list (lines, line, NULL);
+}
+
+/*
+ * Frees a line with its data (the line must not be in a list any more).
+ */
+
+void
+gui_line_free_data (struct t_gui_lines *lines, struct t_gui_line *line)
+{
+    struct t_gui_line_slab *ptr_slab;
+
+    ptr_slab = line->data->slab;
+    gui_line_tags_free (line->data);
+    gui_line_no_color_free (line->data);
+    if (line->data->prefix)
+        string_shared_free (line->data->prefix);
+    if (line->data->message
+        && !gui_line_slab_contains (line->data, line->data->message))
+    {
+        free (line->data->message);
+    }
+    if (ptr_slab)
+    {
+        /* line and its data are in the slab */
+        gui_line_slab_free_line (lines, ptr_slab);
+        return;
+    }
+    free (line->data);
+    free (line);
 }
 
 /*
@@ -974,192 +1572,677 @@ gui_line_remove_from_list (struct t_gui_buffer *buffer,
     struct t_gui_window_scroll *ptr_scroll;
     int prefix_length, prefix_is_nick;
 
-    for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
+    for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
+    {
+        /* reset scroll for any window scroll starting with this line */
+        for (ptr_scroll = ptr_win->scroll; ptr_scroll;
+             ptr_scroll = ptr_scroll->next_scroll)
+        {
+            if (ptr_scroll->start_line == line)
+            {
+                ptr_scroll->start_line = ptr_scroll->start_line->next_line;
+                ptr_scroll->start_line_pos = 0;
+                if (ptr_scroll->start_line)
+                {
+                    gui_buffer_ask_chat_refresh (buffer, 2);
+                }
+                else
+                {
+                    ptr_scroll->first_line_displayed = 1;
+                    ptr_scroll->scrolling = 0;
+                    ptr_scroll->lines_after = 0;
+                    gui_window_ask_refresh (1);
+                }
+            }
+
+            if (ptr_scroll->text_search_start_line == line)
+                ptr_scroll->text_search_start_line = NULL;
+        }
+        /* remove line from coords */
+        gui_window_coords_remove_line (ptr_win, line);
+        /* remove line from cache of line heights */
+        gui_window_line_heights_remove_line (ptr_win, line);
+    }
+
+    gui_line_get_prefix_for_display (line, NULL, &prefix_length, NULL,
+                                     &prefix_is_nick);
+    if (prefix_is_nick)
+        prefix_length += config_length_nick_prefix_suffix;
+    if (prefix_length == lines->prefix_max_length)
+        lines->prefix_max_length_refresh = 1;
+
+    /* move read marker if it was on line we are removing */
+    if (lines->last_read_line == line)
+    {
+        lines->last_read_line = lines->last_read_line->prev_line;
+        lines->first_line_not_read = (lines->last_read_line) ? 0 : 1;
+        gui_buffer_ask_chat_refresh (buffer, 1);
+    }
+
+    /* adjust "lines_hidden" if the line was hidden */
+    if (!line->data->displayed && (lines->lines_hidden > 0))
+        (lines->lines_hidden)--;
+
+    /* move filter jobs which are on this line */
+    gui_filter_job_remove_line (line);
+
+    /* remove line from list */
+    if (line->prev_line)
+        (line->prev_line)->next_line = line->next_line;
+    if (line->next_line)
+        (line->next_line)->prev_line = line->prev_line;
+    if (lines->first_line == line)
+        lines->first_line = line->next_line;
+    if (lines->last_line == line)
+        lines->last_line = line->prev_line;
+
+    lines->lines_count--;
+    lines->lines_count_total = lines->lines_count + lines->lines_compressed;
+
+    /* free data */
+    if (free_data)
+        gui_line_free_data (lines, line);
+    else
+        free (line);
+}
+
+/*
+ * Adds line to mixed lines for a buffer.
+ */
+
+void
+gui_line_mixed_add (struct t_gui_lines *lines,
+                    struct t_gui_line_data *line_data)
+{
+    struct t_gui_line *new_line;
+
+    new_line = malloc (sizeof (*new_line));
+    if (new_line)
+    {
+        new_line->data = line_data;
+        gui_line_add_to_list (lines, new_line);
+    }
+}
+
+/*
+ * Frees all mixed lines matching a buffer.
+ */
+
+void
+gui_line_mixed_free_buffer (struct t_gui_buffer *buffer)
+{
+    struct t_gui_line *ptr_line, *ptr_next_line;
+
+    if (buffer->mixed_lines)
+    {
+        ptr_line = buffer->mixed_lines->first_line;
+        while (ptr_line)
+        {
+            ptr_next_line = ptr_line->next_line;
+
+            if (ptr_line->data->buffer == buffer)
+            {
+                gui_line_remove_from_list (buffer,
+                                           buffer->mixed_lines,
+                                           ptr_line,
+                                           0);
+            }
+
+            ptr_line = ptr_next_line;
+        }
+    }
+}
+
+/*
+ * Frees all mixed lines in a buffer.
+ */
+
+void
+gui_line_mixed_free_all (struct t_gui_buffer *buffer)
+{
+    if (buffer->mixed_lines)
+    {
+        while (buffer->mixed_lines->first_line)
+        {
+            gui_line_remove_from_list (buffer,
+                                       buffer->mixed_lines,
+                                       buffer->mixed_lines->first_line,
+                                       0);
+        }
+    }
+}
+
+/*
+ * Deletes a line from a buffer.
+ */
+
+void
+gui_line_free (struct t_gui_buffer *buffer, struct t_gui_line *line)
+{
+    struct t_gui_line *ptr_line;
+
+    if (!buffer || !line)
+        return;
+
+    /* first remove mixed line if it exists */
+    if (buffer->mixed_lines)
+    {
+        for (ptr_line = buffer->mixed_lines->first_line; ptr_line;
+             ptr_line = ptr_line->next_line)
+        {
+            if (ptr_line->data == line->data)
+            {
+                gui_line_remove_from_list (buffer,
+                                           buffer->mixed_lines,
+                                           ptr_line,
+                                           0);
+                break;
+            }
+        }
+    }
+
+    /* remove line from lines list */
+    gui_line_remove_from_list (buffer, buffer->own_lines, line, 1);
+}
+
+/*
+ * Deletes all formatted lines from a buffer.
+ */
+
+void
+gui_line_free_all (struct t_gui_buffer *buffer)
+{
+    while (buffer->own_lines->first_line)
+    {
+        gui_line_free (buffer, buffer->own_lines->first_line);
+    }
+    gui_lines_free_blocks (buffer->own_lines);
+}
+
+/*
+ * Frees a block of compressed lines.
+ */
+
+void
+gui_line_block_free (struct t_gui_lines *lines,
+                     struct t_gui_line_block *block)
+{
+    if (block->prev_block)
+        (block->prev_block)->next_block = block->next_block;
+    if (block->next_block)
+        (block->next_block)->prev_block = block->prev_block;
+    if (lines->first_block == block)
+        lines->first_block = block->next_block;
+    if (lines->last_block == block)
+        lines->last_block = block->prev_block;
+
+    free (block);
+}
+
+/*
+ * Compresses the first lines of a buffer in a new block (added after the
+ * last block of compressed lines), then frees these lines.
+ *
+ * Lines are stored one after the other in the block, each line being:
+ * date, date printed, flags (prefix/highlight), tags (separated by commas),
+ * prefix and message (strings ending with '\0').
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+gui_line_compress_lines (struct t_gui_buffer *buffer, int count)
+{
+    struct t_gui_line *ptr_line;
+    struct t_gui_line_block *new_block, *ptr_block;
+    char *lines_data, *ptr_data;
+    uLongf size_compressed;
+    int i, j, rc, size, length, read_marker;
+    time_t date_printed_last;
+
+    /* compute size of lines (uncompressed) */
+    size = 0;
+    ptr_line = buffer->own_lines->first_line;
+    for (i = 0; (i < count) && ptr_line; i++)
+    {
+        size += (2 * sizeof (time_t)) + 1;
+        if (ptr_line->data->tags_count > 0)
+        {
+            for (j = 0; j < ptr_line->data->tags_count; j++)
+            {
+                size += strlen (ptr_line->data->tags_array[j]) + 1;
+            }
+        }
+        else
+            size++;
+        size += ((ptr_line->data->prefix) ?
+                 strlen (ptr_line->data->prefix) : 0) + 1;
+        size += ((ptr_line->data->message) ?
+                 strlen (ptr_line->data->message) : 0) + 1;
+        ptr_line = ptr_line->next_line;
+    }
+    count = i;
+    if (count == 0)
+        return 0;
+
+    lines_data = malloc (size);
+    if (!lines_data)
+        return 0;
+
+    /* write lines */
+    read_marker = -1;
+    date_printed_last = 0;
+    ptr_data = lines_data;
+    ptr_line = buffer->own_lines->first_line;
+    for (i = 0; i < count; i++)
+    {
+        memcpy (ptr_data, &(ptr_line->data->date), sizeof (time_t));
+        ptr_data += sizeof (time_t);
+        memcpy (ptr_data, &(ptr_line->data->date_printed), sizeof (time_t));
+        ptr_data += sizeof (time_t);
+        ptr_data[0] = ((ptr_line->data->prefix) ?
+                       GUI_LINE_BLOCK_FLAG_PREFIX : 0)
+            | ((ptr_line->data->highlight) ?
+               GUI_LINE_BLOCK_FLAG_HIGHLIGHT : 0);
+        ptr_data++;
+        for (j = 0; j < ptr_line->data->tags_count; j++)
+        {
+            if (j > 0)
+            {
+                ptr_data[0] = ',';
+                ptr_data++;
+            }
+            length = strlen (ptr_line->data->tags_array[j]);
+            memcpy (ptr_data, ptr_line->data->tags_array[j], length);
+            ptr_data += length;
+        }
+        ptr_data[0] = '\0';
+        ptr_data++;
+        length = (ptr_line->data->prefix) ?
+            strlen (ptr_line->data->prefix) : 0;
+        memcpy (ptr_data, (length > 0) ? ptr_line->data->prefix : "", length);
+        ptr_data[length] = '\0';
+        ptr_data += length + 1;
+        length = (ptr_line->data->message) ?
+            strlen (ptr_line->data->message) : 0;
+        memcpy (ptr_data, (length > 0) ? ptr_line->data->message : "", length);
+        ptr_data[length] = '\0';
+        ptr_data += length + 1;
+        if (ptr_line == buffer->own_lines->last_read_line)
+            read_marker = i;
+        date_printed_last = ptr_line->data->date_printed;
+        ptr_line = ptr_line->next_line;
+    }
+
+    /* compress lines */
+    size_compressed = compressBound (size);
+    new_block = malloc (sizeof (*new_block) + size_compressed);
+    if (!new_block)
+    {
+        free (lines_data);
+        return 0;
+    }
+    rc = compress2 ((Bytef *)new_block + sizeof (*new_block), &size_compressed,
+                    (Bytef *)lines_data, size, Z_DEFAULT_COMPRESSION);
+    free (lines_data);
+    if (rc != Z_OK)
+    {
+        free (new_block);
+        return 0;
+    }
+    ptr_block = realloc (new_block, sizeof (*new_block) + size_compressed);
+    if (ptr_block)
+        new_block = ptr_block;
+    new_block->data = (char *)new_block + sizeof (*new_block);
+    new_block->lines_count = count;
+    new_block->lines_removed = 0;
+    new_block->read_marker = read_marker;
+    new_block->date_printed_last = date_printed_last;
+    new_block->size = size;
+    new_block->size_compressed = size_compressed;
+
+    /* add block after last block */
+    new_block->prev_block = buffer->own_lines->last_block;
+    new_block->next_block = NULL;
+    if (buffer->own_lines->last_block)
+        (buffer->own_lines->last_block)->next_block = new_block;
+    else
+        buffer->own_lines->first_block = new_block;
+    buffer->own_lines->last_block = new_block;
+    buffer->own_lines->lines_compressed += count;
+
+    /* free lines (now in block) */
+    for (i = 0; i < count; i++)
+    {
+        gui_line_free (buffer, buffer->own_lines->first_line);
+    }
+
+    return 1;
+}
+
+/*
+ * Compresses oldest lines of a buffer if needed, according to options
+ * weechat.history.compress_buffer_lines_number and
+ * weechat.history.compress_buffer_lines_minutes (lines are compressed by
+ * blocks of GUI_LINE_BLOCK_LINES lines).
+ *
+ * Lines are not compressed if the buffer is merged, if it is scrolled or
+ * searched in a window, or if the remaining lines could not fill a window
+ * displaying the buffer.
+ */
+
+void
+gui_line_compress (struct t_gui_buffer *buffer)
+{
+    struct t_gui_window *ptr_win;
+    struct t_gui_window_scroll *ptr_scroll;
+    struct t_gui_line *ptr_line;
+    int max_lines, max_minutes, count;
+    time_t current_time;
+
+    max_lines = CONFIG_INTEGER(config_history_compress_buffer_lines_number);
+    max_minutes = CONFIG_INTEGER(config_history_compress_buffer_lines_minutes);
+    if ((max_lines == 0) && (max_minutes == 0))
+        return;
+
+    if ((buffer->type != GUI_BUFFER_TYPE_FORMATTED)
+        || buffer->mixed_lines
+        || (buffer->text_search != GUI_TEXT_SEARCH_DISABLED)
+        || (buffer->own_lines->lines_count < GUI_LINE_BLOCK_LINES))
+    {
+        return;
+    }
+
+    /* count lines to compress (at most one block) */
+    current_time = time (NULL);
+    count = 0;
+    ptr_line = buffer->own_lines->first_line;
+    while (ptr_line
+           && (count < GUI_LINE_BLOCK_LINES)
+           && (((max_lines > 0)
+                && (buffer->own_lines->lines_count - count > max_lines))
+               || ((max_minutes > 0)
+                   && (current_time - ptr_line->data->date_printed >
+                       max_minutes * 60))))
+    {
+        count++;
+        ptr_line = ptr_line->next_line;
+    }
+    if (count < GUI_LINE_BLOCK_LINES)
+        return;
+
+    for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
+    {
+        if ((ptr_win->buffer == buffer)
+            && (buffer->own_lines->lines_count
+                - buffer->own_lines->lines_hidden
+                - count < ptr_win->win_chat_height))
+        {
+            return;
+        }
+        for (ptr_scroll = ptr_win->scroll; ptr_scroll;
+             ptr_scroll = ptr_scroll->next_scroll)
+        {
+            if ((ptr_scroll->buffer == buffer)
+                && (ptr_scroll->start_line
+                    || ptr_scroll->text_search_start_line))
+            {
+                return;
+            }
+        }
+    }
+
+    gui_line_compress_lines (buffer, count);
+}
+
+/*
+ * Uncompresses a block of lines: lines are inserted before the first line of
+ * buffer, and the block is freed.
+ *
+ * If a line can not be created, the lines already created are freed and the
+ * block is kept.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+gui_line_uncompress_block (struct t_gui_buffer *buffer,
+                           struct t_gui_line_block *block)
+{
+    struct t_gui_line **new_lines, *ptr_next_line;
+    struct t_gui_line_slab *ptr_slab;
+    char *lines_data, *ptr_data, *ptr_tags, *ptr_prefix, *ptr_message;
+    uLongf size;
+    time_t date, date_printed;
+    int i, flags, count, read_marker;
+
+    lines_data = malloc (block->size);
+    if (!lines_data)
+        return 0;
+    size = block->size;
+    if ((uncompress ((Bytef *)lines_data, &size, (Bytef *)block->data,
+                     block->size_compressed) != Z_OK)
+        || ((int)size != block->size))
+    {
+        free (lines_data);
+        return 0;
+    }
+
+    new_lines = malloc (block->lines_count * sizeof (*new_lines));
+    if (!new_lines)
+    {
+        free (lines_data);
+        return 0;
+    }
+
+    /*
+     * create all lines, before adding them in buffer; they are allocated in
+     * new slabs before the first slab, because they are older than all lines
+     */
+    count = 0;
+    ptr_slab = NULL;
+    read_marker = -1;
+    ptr_data = lines_data;
+    for (i = 0; i < block->lines_count; i++)
+    {
+        memcpy (&date, ptr_data, sizeof (date));
+        ptr_data += sizeof (date);
+        memcpy (&date_printed, ptr_data, sizeof (date_printed));
+        ptr_data += sizeof (date_printed);
+        flags = (unsigned char)ptr_data[0];
+        ptr_data++;
+        ptr_tags = ptr_data;
+        ptr_data += strlen (ptr_data) + 1;
+        ptr_prefix = ptr_data;
+        ptr_data += strlen (ptr_data) + 1;
+        ptr_message = ptr_data;
+        ptr_data += strlen (ptr_data) + 1;
+        if (i < block->lines_removed)
+            continue;
+        new_lines[count] = gui_line_new (
+            buffer, date, date_printed, ptr_tags,
+            (flags & GUI_LINE_BLOCK_FLAG_PREFIX) ? ptr_prefix : NULL,
+            ptr_message, &ptr_slab);
+        if (!new_lines[count])
+            break;
+        new_lines[count]->data->highlight =
+            (flags & GUI_LINE_BLOCK_FLAG_HIGHLIGHT) ? 1 : 0;
+        if (i == block->read_marker)
+            read_marker = count;
+        count++;
+    }
+
+    free (lines_data);
+
+    if (count < block->lines_count - block->lines_removed)
     {
-        /* reset scroll for any window scroll starting with this line */
-        for (ptr_scroll = ptr_win->scroll; ptr_scroll;
-             ptr_scroll = ptr_scroll->next_scroll)
+        /* not enough memory: free lines created, keep the block */
+        for (i = 0; i < count; i++)
         {
-            if (ptr_scroll->start_line == line)
-            {
-                ptr_scroll->start_line = ptr_scroll->start_line->next_line;
-                ptr_scroll->start_line_pos = 0;
-                if (ptr_scroll->start_line)
-                {
-                    gui_buffer_ask_chat_refresh (buffer, 2);
-                }
-                else
-                {
-                    ptr_scroll->first_line_displayed = 1;
-                    ptr_scroll->scrolling = 0;
-                    ptr_scroll->lines_after = 0;
-                    gui_window_ask_refresh (1);
-                }
-            }
-
-            if (ptr_scroll->text_search_start_line == line)
-                ptr_scroll->text_search_start_line = NULL;
+            gui_line_free_data (buffer->own_lines, new_lines[i]);
         }
-        /* remove line from coords */
-        gui_window_coords_remove_line (ptr_win, line);
+        free (new_lines);
+        return 0;
     }
 
-    gui_line_get_prefix_for_display (line, NULL, &prefix_length, NULL,
-                                     &prefix_is_nick);
-    if (prefix_is_nick)
-        prefix_length += config_length_nick_prefix_suffix;
-    if (prefix_length == lines->prefix_max_length)
-        lines->prefix_max_length_refresh = 1;
-
-    /* move read marker if it was on line we are removing */
-    if (lines->last_read_line == line)
+    ptr_next_line = buffer->own_lines->first_line;
+    for (i = 0; i < count; i++)
     {
-        lines->last_read_line = lines->last_read_line->prev_line;
-        lines->first_line_not_read = (lines->last_read_line) ? 0 : 1;
-        gui_buffer_ask_chat_refresh (buffer, 1);
+        gui_filter_line (new_lines[i]->data);
+        gui_line_insert_in_list (buffer->own_lines, new_lines[i],
+                                 ptr_next_line);
     }
 
-    /* adjust "lines_hidden" if the line was hidden */
-    if (!line->data->displayed && (lines->lines_hidden > 0))
-        (lines->lines_hidden)--;
-
-    /* free data */
-    if (free_data)
+    /* restore read marker if it was moved when lines were compressed */
+    if ((read_marker >= 0)
+        && !buffer->own_lines->last_read_line
+        && buffer->own_lines->first_line_not_read)
     {
-        if (line->data->str_time)
-            free (line->data->str_time);
-        gui_line_tags_free (line->data);
-        if (line->data->prefix)
-            string_shared_free (line->data->prefix);
-        if (line->data->message)
-            free (line->data->message);
-        free (line->data);
+        buffer->own_lines->last_read_line = new_lines[read_marker];
+        buffer->own_lines->first_line_not_read = 0;
     }
 
-    /* remove line from list */
-    if (line->prev_line)
-        (line->prev_line)->next_line = line->next_line;
-    if (line->next_line)
-        (line->next_line)->prev_line = line->prev_line;
-    if (lines->first_line == line)
-        lines->first_line = line->next_line;
-    if (lines->last_line == line)
-        lines->last_line = line->prev_line;
+    free (new_lines);
 
-    lines->lines_count--;
+    buffer->own_lines->lines_compressed -=
+        block->lines_count - block->lines_removed;
+    buffer->own_lines->lines_count_total =
+        buffer->own_lines->lines_count + buffer->own_lines->lines_compressed;
+    gui_line_block_free (buffer->own_lines, block);
 
-    free (line);
+    return 1;
 }
 
 /*
- * Adds line to mixed lines for a buffer.
+ * Uncompresses blocks of lines of a buffer, starting with the last block
+ * (newest compressed lines); if count < 0, all blocks are uncompressed.
+ *
+ * Returns number of blocks uncompressed.
  */
 
-void
-gui_line_mixed_add (struct t_gui_lines *lines,
-                    struct t_gui_line_data *line_data)
+int
+gui_line_uncompress_blocks (struct t_gui_buffer *buffer, int count)
 {
-    struct t_gui_line *new_line;
+    struct t_gui_window *ptr_win;
+    struct t_gui_window_scroll *ptr_scroll;
+    int blocks;
 
-    new_line = malloc (sizeof (*new_line));
-    if (new_line)
+    if (!buffer || !buffer->own_lines || !buffer->own_lines->last_block)
+        return 0;
+
+    blocks = 0;
+    while (buffer->own_lines->last_block && (count != 0))
     {
-        new_line->data = line_data;
-        gui_line_add_to_list (lines, new_line);
+        if (!gui_line_uncompress_block (buffer, buffer->own_lines->last_block))
+            break;
+        blocks++;
+        if (count > 0)
+            count--;
     }
-}
-
-/*
- * Frees all mixed lines matching a buffer.
- */
 
-void
-gui_line_mixed_free_buffer (struct t_gui_buffer *buffer)
-{
-    struct t_gui_line *ptr_line, *ptr_next_line;
+    if (blocks == 0)
+        return 0;
 
-    if (buffer->mixed_lines)
+    /* lines have been added before first line displayed in windows */
+    for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
     {
-        ptr_line = buffer->mixed_lines->first_line;
-        while (ptr_line)
+        for (ptr_scroll = ptr_win->scroll; ptr_scroll;
+             ptr_scroll = ptr_scroll->next_scroll)
         {
-            ptr_next_line = ptr_line->next_line;
-
-            if (ptr_line->data->buffer == buffer)
-            {
-                gui_line_remove_from_list (buffer,
-                                           buffer->mixed_lines,
-                                           ptr_line,
-                                           0);
-            }
-
-            ptr_line = ptr_next_line;
+            if (ptr_scroll->buffer == buffer)
+                ptr_scroll->first_line_displayed = 0;
         }
     }
+
+    gui_buffer_ask_chat_refresh (buffer, 2);
+
+    return blocks;
 }
 
 /*
- * Frees all mixed lines in a buffer.
+ * Uncompresses all lines of a buffer.
  */
 
 void
-gui_line_mixed_free_all (struct t_gui_buffer *buffer)
+gui_line_uncompress (struct t_gui_buffer *buffer)
 {
-    if (buffer->mixed_lines)
-    {
-        while (buffer->mixed_lines->first_line)
-        {
-            gui_line_remove_from_list (buffer,
-                                       buffer->mixed_lines,
-                                       buffer->mixed_lines->first_line,
-                                       0);
-        }
-    }
+    gui_line_uncompress_blocks (buffer, -1);
 }
 
 /*
- * Deletes a line from a buffer.
+ * Uncompresses the newest block of compressed lines of the buffer of a line,
+ * so that lines are added before the line; it is used when the first line
+ * of buffer is reached while walking lines backward (scroll, search), so
+ * that compressed lines are uncompressed only when they are needed.
+ *
+ * Returns:
+ *   1: lines have been added before the first line of buffer
+ *   0: no lines added (no compressed lines, or error)
  */
 
-void
-gui_line_free (struct t_gui_buffer *buffer, struct t_gui_line *line)
+int
+gui_line_uncompress_prev (struct t_gui_line *line)
 {
-    struct t_gui_line *ptr_line;
+    struct t_gui_buffer *buffer;
 
-    if (!buffer || !line)
-        return;
+    if (!line)
+        return 0;
 
-    /* first remove mixed line if it exists */
-    if (buffer->mixed_lines)
+    buffer = line->data->buffer;
+    if (!buffer || buffer->mixed_lines || !buffer->own_lines->last_block)
+        return 0;
+
+    return (gui_line_uncompress_blocks (buffer, 1) > 0) ? 1 : 0;
+}
+
+/*
+ * Gets previous line displayed; if the first line of buffer is reached,
+ * blocks of compressed lines are uncompressed one by one, until a line
+ * displayed is found.
+ *
+ * Returns pointer to previous line displayed, NULL if not found.
+ */
+
+struct t_gui_line *
+gui_line_get_prev_displayed_uncompress (struct t_gui_line *line)
+{
+    struct t_gui_line *ptr_line;
+
+    ptr_line = gui_line_get_prev_displayed (line);
+    while (!ptr_line && gui_line_uncompress_prev (line))
     {
-        for (ptr_line = buffer->mixed_lines->first_line; ptr_line;
-             ptr_line = ptr_line->next_line)
-        {
-            if (ptr_line->data == line->data)
-            {
-                gui_line_remove_from_list (buffer,
-                                           buffer->mixed_lines,
-                                           ptr_line,
-                                           0);
-                break;
-            }
-        }
+        ptr_line = gui_line_get_prev_displayed (line);
     }
 
-    /* remove line from lines list */
-    gui_line_remove_from_list (buffer, buffer->own_lines, line, 1);
+    return ptr_line;
 }
 
 /*
- * Deletes all formatted lines from a buffer.
+ * Uncompresses lines of the buffer displayed in a window if lines are missing
+ * to fill the window: blocks are uncompressed one by one, until there are
+ * enough lines.
+ *
+ * Lines before the first line are uncompressed when the window is scrolled
+ * or searched (see function gui_line_get_prev_displayed_uncompress).
  */
 
 void
-gui_line_free_all (struct t_gui_buffer *buffer)
+gui_line_uncompress_for_window (struct t_gui_window *window)
 {
-    while (buffer->own_lines->first_line)
+    if (!window || window->buffer->mixed_lines)
+        return;
+
+    while (window->buffer->own_lines->last_block
+           && (window->buffer->own_lines->lines_count
+               - window->buffer->own_lines->lines_hidden
+               < window->win_chat_height))
     {
-        gui_line_free (buffer, buffer->own_lines->first_line);
+        if (!gui_line_uncompress_blocks (window->buffer, 1))
+            break;
     }
 }
 
@@ -1189,6 +2272,125 @@ gui_line_get_notify_level (struct t_gui_line *line)
     return GUI_HOTLIST_LOW;
 }
 
+
+/*
+ * Creates a new line for a buffer (the line is not added in lines of buffer).
+ *
+ * The line, its data, tags and message are allocated in a single block, in
+ * a slab of buffer (the prefix is a shared string).
+ *
+ * Argument "slab_old" is NULL for a new line, and not NULL for a line older
+ * than all lines of buffer (see function gui_line_slab_alloc).
+ *
+ * Note: fields "highlight" and "displayed" are not set by this function.
+ *
+ * Returns pointer to new line, NULL if error.
+ */
+
+struct t_gui_line *
+gui_line_new (struct t_gui_buffer *buffer, time_t date, time_t date_printed,
+              const char *tags, const char *prefix, const char *message,
+              struct t_gui_line_slab **slab_old)
+{
+    struct t_gui_line *new_line;
+    struct t_gui_line_data *new_line_data;
+    struct t_gui_line_slab *ptr_slab;
+    char *ptr_data, *message_no_color, *prefix_no_color;
+    int size, length_message, length_message_no_color, tags_count;
+    int length_tags;
+
+    length_message = (message) ? strlen (message) + 1 : 1;
+
+    /* message without colors is stored in slab only if it has colors */
+    message_no_color = (message) ? gui_color_decode (message, NULL) : NULL;
+    length_message_no_color = (message_no_color
+                               && (strcmp (message_no_color, message) != 0)) ?
+        strlen (message_no_color) + 1 : 0;
+
+    tags_count = gui_line_tags_split_slab (tags, NULL, NULL, &length_tags);
+    size = GUI_LINE_SLAB_ALIGN(sizeof (*new_line))
+        + GUI_LINE_SLAB_ALIGN(sizeof (*new_line_data))
+        + ((tags_count > 0) ? (tags_count + 1) * (int)sizeof (char *) : 0)
+        + length_message + length_message_no_color + length_tags;
+    ptr_slab = (slab_old) ? *slab_old : NULL;
+    ptr_data = gui_line_slab_alloc (buffer->own_lines, size,
+                                    (slab_old) ? 1 : 0, &ptr_slab);
+    if (!ptr_data)
+    {
+        if (message_no_color)
+            free (message_no_color);
+        return NULL;
+    }
+    new_line = (struct t_gui_line *)ptr_data;
+    ptr_data += GUI_LINE_SLAB_ALIGN(sizeof (*new_line));
+    new_line_data = (struct t_gui_line_data *)ptr_data;
+    ptr_data += GUI_LINE_SLAB_ALIGN(sizeof (*new_line_data));
+    new_line->data = new_line_data;
+    new_line->data->slab = ptr_slab;
+    if (slab_old)
+        *slab_old = ptr_slab;
+
+    /* fill data in new line */
+    new_line->data->buffer = buffer;
+    new_line->data->y = -1;
+    new_line->data->date = date;
+    new_line->data->date_printed = date_printed;
+    new_line->data->tags_count = tags_count;
+    new_line->data->tags_array = NULL;
+    if (tags_count > 0)
+    {
+        new_line->data->tags_array = (char **)ptr_data;
+        ptr_data += (tags_count + 1) * sizeof (char *);
+    }
+    if (message)
+        memcpy (ptr_data, message, length_message);
+    else
+        ptr_data[0] = '\0';
+    new_line->data->message = ptr_data;
+    ptr_data += length_message;
+    if (length_message_no_color > 0)
+    {
+        memcpy (ptr_data, message_no_color, length_message_no_color);
+        new_line->data->message_no_color = ptr_data;
+        ptr_data += length_message_no_color;
+    }
+    else
+    {
+        new_line->data->message_no_color = (message_no_color
+                                             || !message) ?
+            new_line->data->message : NULL;
+    }
+    if (message_no_color)
+        free (message_no_color);
+    if (tags_count > 0)
+    {
+        gui_line_tags_split_slab (tags, new_line->data->tags_array, ptr_data,
+                                  NULL);
+    }
+    new_line->data->refresh_needed = 0;
+    new_line->data->prefix = (prefix) ?
+        (char *)string_shared_get (prefix) : ((date != 0) ? (char *)string_shared_get ("") : NULL);
+    new_line->data->prefix_length = (prefix) ?
+        gui_chat_strlen_screen (prefix) : 0;
+    new_line->data->prefix_no_color = NULL;
+    if (new_line->data->prefix)
+    {
+        prefix_no_color = gui_color_decode (new_line->data->prefix, NULL);
+        if (prefix_no_color)
+        {
+            new_line->data->prefix_no_color =
+                (char *)string_shared_get (prefix_no_color);
+            free (prefix_no_color);
+        }
+    }
+    new_line->data->displayed = 1;
+    new_line->data->filter_id = 0;
+    new_line->data->highlight = 0;
+    gui_line_index_build (new_line->data);
+
+    return new_line;
+}
+
 /*
  * Adds a new line for a buffer.
  */
@@ -1199,7 +2401,7 @@ gui_line_add (struct t_gui_buffer *buffer, time_t date,
               const char *prefix, const char *message)
 {
     struct t_gui_line *new_line;
-    struct t_gui_line_data *new_line_data;
+    struct t_gui_line_block *ptr_block;
     struct t_gui_window *ptr_win;
     char *message_for_signal;
     const char *nick;
@@ -1210,9 +2412,39 @@ gui_line_add (struct t_gui_buffer *buffer, time_t date,
      * remove line(s) if necessary, according to history options:
      *   max_lines:   if > 0, keep only N lines in buffer
      *   max_minutes: if > 0, keep only lines from last N minutes
+     * oldest lines are first removed from blocks of compressed lines
+     * (with max_minutes, a block is removed when all its lines are too old)
      */
     lines_removed = 0;
     current_time = time (NULL);
+    while (buffer->own_lines->first_block)
+    {
+        ptr_block = buffer->own_lines->first_block;
+        if ((CONFIG_INTEGER(config_history_max_buffer_lines_minutes) > 0)
+            && (current_time - ptr_block->date_printed_last >
+                CONFIG_INTEGER(config_history_max_buffer_lines_minutes) * 60))
+        {
+            /* all lines in block are too old */
+            buffer->own_lines->lines_compressed -=
+                ptr_block->lines_count - ptr_block->lines_removed;
+            buffer->own_lines->lines_count_total -=
+                ptr_block->lines_count - ptr_block->lines_removed;
+        }
+        else if ((CONFIG_INTEGER(config_history_max_buffer_lines_number) > 0)
+                 && (buffer->own_lines->lines_count
+                     + buffer->own_lines->lines_compressed + 1 >
+                     CONFIG_INTEGER(config_history_max_buffer_lines_number)))
+        {
+            ptr_block->lines_removed++;
+            buffer->own_lines->lines_compressed--;
+            buffer->own_lines->lines_count_total--;
+            if (ptr_block->lines_removed < ptr_block->lines_count)
+                continue;
+        }
+        else
+            break;
+        gui_line_block_free (buffer->own_lines, ptr_block);
+    }
     while (buffer->own_lines->first_line
            && (((CONFIG_INTEGER(config_history_max_buffer_lines_number) > 0)
                 && (buffer->own_lines->lines_count + 1 >
@@ -1226,37 +2458,14 @@ gui_line_add (struct t_gui_buffer *buffer, time_t date,
     }
 
     /* create new line */
-    new_line = malloc (sizeof (*new_line));
+    new_line = gui_line_new (buffer, date, date_printed, tags, prefix,
+                             message, NULL);
     if (!new_line)
     {
         log_printf (_("Not enough memory for new line"));
         return NULL;
     }
 
-    /* create data for line */
-    new_line_data = malloc (sizeof (*new_line_data));
-    if (!new_line_data)
-    {
-        free (new_line);
-        log_printf (_("Not enough memory for new line"));
-        return NULL;
-    }
-    new_line->data = new_line_data;
-
-    /* fill data in new line */
-    new_line->data->buffer = buffer;
-    new_line->data->y = -1;
-    new_line->data->date = date;
-    new_line->data->date_printed = date_printed;
-    new_line->data->str_time = gui_chat_get_time_string (date);
-    gui_line_tags_alloc (new_line->data, tags);
-    new_line->data->refresh_needed = 0;
-    new_line->data->prefix = (prefix) ?
-        (char *)string_shared_get (prefix) : ((date != 0) ? (char *)string_shared_get ("") : NULL);
-    new_line->data->prefix_length = (prefix) ?
-        gui_chat_strlen_screen (prefix) : 0;
-    new_line->data->message = (message) ? strdup (message) : strdup ("");
-
     /* get notify level and max notify level for nick in buffer */
     notify_level = gui_line_get_notify_level (new_line);
     max_notify_level = NULL;
@@ -1275,7 +2484,7 @@ gui_line_add (struct t_gui_buffer *buffer, time_t date,
         new_line->data->highlight = gui_line_has_highlight (new_line);
 
     /* check if line is filtered or not */
-    new_line->data->displayed = gui_filter_check_line (new_line->data);
+    gui_filter_line (new_line->data);
 
     /* add line to lines list */
     gui_line_add_to_list (buffer->own_lines, new_line);
@@ -1345,6 +2554,9 @@ gui_line_add (struct t_gui_buffer *buffer, time_t date,
         }
     }
 
+    /* compress oldest lines of buffer if needed */
+    gui_line_compress (buffer);
+
     (void) hook_signal_send ("buffer_line_added",
                              WEECHAT_HOOK_SIGNAL_POINTER, new_line);
 
@@ -1389,19 +2601,24 @@ gui_line_add_y (struct t_gui_buffer *buffer, int y, const char *message)
         new_line->data = new_line_data;
 
         buffer->own_lines->lines_count++;
+        buffer->own_lines->lines_count_total++;
 
         /* fill data in new line */
         new_line->data->buffer = buffer;
         new_line->data->y = y;
         new_line->data->date = 0;
         new_line->data->date_printed = 0;
-        new_line->data->str_time = NULL;
         new_line->data->tags_count = 0;
         new_line->data->tags_array = NULL;
         new_line->data->refresh_needed = 1;
         new_line->data->prefix = NULL;
         new_line->data->prefix_length = 0;
         new_line->data->message = NULL;
+        new_line->data->prefix_no_color = NULL;
+        new_line->data->message_no_color = NULL;
+        new_line->data->slab = NULL;
+        new_line->data->displayed = 1;
+        new_line->data->filter_id = 0;
         new_line->data->highlight = 0;
 
         /* add line to lines list */
@@ -1432,6 +2649,7 @@ gui_line_add_y (struct t_gui_buffer *buffer, int y, const char *message)
     }
 
     /* set message for line */
+    gui_line_no_color_free (ptr_line->data);
     if (ptr_line->data->message)
     {
         /* remove line from coords if the content is changing */
@@ -1444,9 +2662,11 @@ gui_line_add_y (struct t_gui_buffer *buffer, int y, const char *message)
         free (ptr_line->data->message);
     }
     ptr_line->data->message = (message) ? strdup (message) : strdup ("");
+    gui_line_no_color_build (ptr_line->data);
+    gui_line_index_build (ptr_line->data);
 
     /* check if line is filtered or not */
-    ptr_line->data->displayed = gui_filter_check_line (ptr_line->data);
+    gui_filter_line (ptr_line->data);
     if (!ptr_line->data->displayed)
     {
         buffer->own_lines->lines_hidden++;
@@ -1464,6 +2684,8 @@ gui_line_add_y (struct t_gui_buffer *buffer, int y, const char *message)
 void
 gui_line_clear (struct t_gui_line *line)
 {
+    gui_line_no_color_free (line->data);
+
     if (line->data->prefix)
         string_shared_free (line->data->prefix);
     line->data->prefix = (char *)string_shared_get ("");
@@ -1471,6 +2693,9 @@ gui_line_clear (struct t_gui_line *line)
     if (line->data->message)
         free (line->data->message);
     line->data->message = strdup ("");
+
+    gui_line_no_color_build (line->data);
+    gui_line_index_build (line->data);
 }
 
 /*
@@ -1498,6 +2723,10 @@ gui_line_mix_buffers (struct t_gui_buffer *buffer)
     if (!ptr_buffer_found)
         return;
 
+    /* lines of merged buffers are never compressed */
+    gui_line_uncompress (buffer);
+    gui_line_uncompress (ptr_buffer_found);
+
     /* mix all lines (sorting by date) to a new structure "new_lines" */
     new_lines = gui_lines_alloc ();
     if (!new_lines)
@@ -1593,10 +2822,39 @@ gui_line_hdata_lines_cb (const void *pointer, void *data,
         HDATA_VAR(struct t_gui_lines, buffer_max_length_refresh, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_lines, prefix_max_length, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_lines, prefix_max_length_refresh, INTEGER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_lines, lines_count_total, INTEGER, 0, NULL, NULL);
     }
     return hdata;
 }
 
+/*
+ * Callback called before a pointer is read in hdata "line": the last block of
+ * compressed lines is uncompressed when the line before the first line of
+ * buffer is read.
+ */
+
+void
+gui_line_hdata_line_read_cb (struct t_hdata *hdata, void *pointer,
+                             const char *name)
+{
+    struct t_gui_line *line;
+
+    /* make C compiler happy */
+    (void) hdata;
+
+    line = (struct t_gui_line *)pointer;
+
+    if (line->prev_line || (strcmp (name, "prev_line") != 0))
+        return;
+
+    if (line->data->buffer->own_lines
+        && (line->data->buffer->own_lines->first_line == line)
+        && line->data->buffer->own_lines->last_block)
+    {
+        gui_line_uncompress_blocks (line->data->buffer, 1);
+    }
+}
+
 /*
  * Returns hdata for line.
  */
@@ -1618,6 +2876,7 @@ gui_line_hdata_line_cb (const void *pointer, void *data,
         HDATA_VAR(struct t_gui_line, data, POINTER, 0, NULL, "line_data");
         HDATA_VAR(struct t_gui_line, prev_line, POINTER, 0, NULL, hdata_name);
         HDATA_VAR(struct t_gui_line, next_line, POINTER, 0, NULL, hdata_name);
+        hdata->callback_read = &gui_line_hdata_line_read_cb;
     }
     return hdata;
 }
@@ -1635,7 +2894,7 @@ gui_line_hdata_line_data_update_cb (void *data,
     const char *value;
     struct t_gui_line_data *line_data;
     struct t_gui_window *ptr_win;
-    int rc, update_coords;
+    int rc, update_coords, update_no_color;
 
     /* make C compiler happy */
     (void) data;
@@ -1645,15 +2904,18 @@ gui_line_hdata_line_data_update_cb (void *data,
     rc = 0;
     update_coords = 0;
 
+    /* prefix/message without colors are rebuilt if prefix/message change */
+    update_no_color = (hashtable_has_key (hashtable, "prefix")
+                       || hashtable_has_key (hashtable, "message"));
+    if (update_no_color)
+        gui_line_no_color_free (line_data);
+
     if (hashtable_has_key (hashtable, "date"))
     {
         value = hashtable_get (hashtable, "date");
         if (value)
         {
             hdata_set (hdata, pointer, "date", value);
-            if (line_data->str_time)
-                free (line_data->str_time);
-            line_data->str_time = gui_chat_get_time_string (line_data->date);
             rc++;
             update_coords = 1;
         }
@@ -1691,11 +2953,20 @@ gui_line_hdata_line_data_update_cb (void *data,
     if (hashtable_has_key (hashtable, "message"))
     {
         value = hashtable_get (hashtable, "message");
+        /* message in slab is not freed, the new one is allocated */
+        if (gui_line_slab_contains (line_data, line_data->message))
+            line_data->message = NULL;
         hdata_set (hdata, pointer, "message", value);
         rc++;
         update_coords = 1;
     }
 
+    if (update_no_color)
+    {
+        gui_line_no_color_build (line_data);
+        gui_line_index_build (line_data);
+    }
+
     if (rc > 0)
     {
         if (update_coords)
@@ -1705,6 +2976,11 @@ gui_line_hdata_line_data_update_cb (void *data,
                 gui_window_coords_remove_line_data (ptr_win, line_data);
             }
         }
+        /*
+         * the line data may be shared by two lines (own and mixed lines):
+         * clear the cache of line heights in all windows
+         */
+        gui_window_line_heights_clear_all ();
         gui_filter_buffer (line_data->buffer, line_data);
         gui_buffer_ask_chat_refresh (line_data->buffer, 1);
     }
@@ -1734,7 +3010,6 @@ gui_line_hdata_line_data_cb (const void *pointer, void *data,
         HDATA_VAR(struct t_gui_line_data, y, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_line_data, date, TIME, 1, NULL, NULL);
         HDATA_VAR(struct t_gui_line_data, date_printed, TIME, 1, NULL, NULL);
-        HDATA_VAR(struct t_gui_line_data, str_time, STRING, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_line_data, tags_count, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_line_data, tags_array, SHARED_STRING, 1, "tags_count", NULL);
         HDATA_VAR(struct t_gui_line_data, displayed, CHAR, 0, NULL, NULL);
@@ -1743,6 +3018,8 @@ gui_line_hdata_line_data_cb (const void *pointer, void *data,
         HDATA_VAR(struct t_gui_line_data, prefix, SHARED_STRING, 1, NULL, NULL);
         HDATA_VAR(struct t_gui_line_data, prefix_length, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_line_data, message, STRING, 1, NULL, NULL);
+        HDATA_VAR(struct t_gui_line_data, prefix_no_color, SHARED_STRING, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_line_data, message_no_color, STRING, 0, NULL, NULL);
     }
     return hdata;
 }
@@ -1777,7 +3054,8 @@ gui_line_add_to_infolist (struct t_infolist *infolist,
         return 0;
     if (!infolist_new_var_time (ptr_item, "date_printed", line->data->date_printed))
         return 0;
-    if (!infolist_new_var_string (ptr_item, "str_time", line->data->str_time))
+    if (!infolist_new_var_string (ptr_item, "str_time",
+                                  gui_chat_get_time_string_cached (line->data->date)))
         return 0;
 
     /* write tags */
@@ -1843,5 +3121,11 @@ gui_lines_print_log (struct t_gui_lines *lines)
         log_printf ("    buffer_max_length_refresh: %d",    lines->buffer_max_length_refresh);
         log_printf ("    prefix_max_length. . . . : %d",    lines->prefix_max_length);
         log_printf ("    prefix_max_length_refresh: %d",    lines->prefix_max_length_refresh);
+        log_printf ("    first_slab . . . . . . . : 0x%lx", lines->first_slab);
+        log_printf ("    last_slab. . . . . . . . : 0x%lx", lines->last_slab);
+        log_printf ("    first_block. . . . . . . : 0x%lx", lines->first_block);
+        log_printf ("    last_block . . . . . . . : 0x%lx", lines->last_block);
+        log_printf ("    lines_compressed . . . . : %d",    lines->lines_compressed);
+        log_printf ("    lines_count_total. . . . : %d",    lines->lines_count_total);
     }
 }
@@ -24,24 +24,93 @@
 #include <regex.h>
 
 struct t_infolist;
+struct t_gui_window;
+
+/*
+ * size of slabs with lines: first slab of a buffer has min size, then size
+ * is doubled for each new slab, up to max size (a line larger than a slab
+ * has its own slab)
+ */
+#define GUI_LINE_SLAB_MIN_SIZE (4 * 1024)
+#define GUI_LINE_SLAB_MAX_SIZE (64 * 1024)
+
+/* alignment of lines in a slab (structures contain pointers and time_t) */
+#define GUI_LINE_SLAB_ALIGN(size) (((size) + 7) & ~7)
+
+/* number of lines compressed in a block (oldest lines of a buffer) */
+#define GUI_LINE_BLOCK_LINES 256
+
+/* flags for lines in a block of compressed lines */
+#define GUI_LINE_BLOCK_FLAG_PREFIX    1
+#define GUI_LINE_BLOCK_FLAG_HIGHLIGHT 2
+
+/*
+ * per-line bloom filter used by searches: trigrams of prefix and message
+ * (without colors, in lower case) are hashed in bit fields; a line can
+ * contain a text only if all bits of the text trigrams are set in the bloom
+ * filter of line (false positives are possible, not false negatives)
+ */
+#define GUI_LINE_INDEX_PREFIX_SIZE  1  /* 32 bits for prefix                */
+#define GUI_LINE_INDEX_MESSAGE_SIZE 4  /* 128 bits for message              */
 
 /* line structures */
 
+struct t_gui_line_index
+{
+    unsigned int prefix[GUI_LINE_INDEX_PREFIX_SIZE];   /* prefix trigrams   */
+    unsigned int message[GUI_LINE_INDEX_MESSAGE_SIZE]; /* message trigrams  */
+};
+
+struct t_gui_line_slab
+{
+    char *data;                        /* lines (structures and content)    */
+    int size;                          /* size of data (in bytes)           */
+    int used;                          /* number of bytes used in data      */
+    int lines_count;                   /* number of lines (not freed) in    */
+                                       /* slab: slab is freed when it is 0  */
+    struct t_gui_line_slab *prev_slab; /* link to previous slab             */
+    struct t_gui_line_slab *next_slab; /* link to next slab                 */
+};
+
+struct t_gui_line_block
+{
+    int lines_count;                   /* number of lines in block          */
+    int lines_removed;                 /* number of lines removed at the    */
+                                       /* beginning of block (history max)  */
+    int read_marker;                   /* index of last read line in block  */
+                                       /* (-1 if not in block)              */
+    time_t date_printed_last;          /* date printed of last line         */
+    int size;                          /* size of lines (uncompressed)      */
+    int size_compressed;               /* size of data (compressed lines)   */
+    char *data;                        /* compressed lines (zlib)           */
+    struct t_gui_line_block *prev_block; /* link to previous block          */
+    struct t_gui_line_block *next_block; /* link to next block              */
+};
+
 struct t_gui_line_data
 {
     struct t_gui_buffer *buffer;       /* pointer to buffer                 */
     int y;                             /* line position (for free buffer)   */
     time_t date;                       /* date/time of line (may be past)   */
     time_t date_printed;               /* date/time when weechat print it   */
-    char *str_time;                    /* time string (for display)         */
     int tags_count;                    /* number of tags for line           */
     char **tags_array;                 /* tags for line                     */
     char displayed;                    /* 1 if line is displayed            */
     char highlight;                    /* 1 if line has highlight           */
     char refresh_needed;               /* 1 if refresh asked (free buffer)  */
+    int filter_id;                     /* id of filter hiding line (0 if    */
+                                       /* line is displayed)                */
     char *prefix;                      /* prefix for line (may be NULL)     */
     int prefix_length;                 /* prefix length (on screen)         */
     char *message;                     /* line content (after prefix)       */
+    char *prefix_no_color;             /* prefix without colors (may be     */
+                                       /* NULL)                             */
+    char *message_no_color;            /* message without colors (same      */
+                                       /* pointer as message if no colors)  */
+    struct t_gui_line_index index;     /* bloom filter for search (all bits */
+                                       /* set if line is not indexed)       */
+    struct t_gui_line_slab *slab;      /* slab with line (NULL if line is   */
+                                       /* allocated with malloc)            */
 };
 
 struct t_gui_line
@@ -64,12 +133,21 @@ struct t_gui_lines
     int buffer_max_length_refresh;     /* refresh asked for buffer max len. */
     int prefix_max_length;             /* max length for prefix align       */
     int prefix_max_length_refresh;     /* refresh asked for prefix max len. */
+    struct t_gui_line_slab *first_slab; /* slabs with lines (own lines only)*/
+    struct t_gui_line_slab *last_slab; /* last slab (new lines added here)  */
+    struct t_gui_line_block *first_block; /* compressed lines (oldest lines */
+                                       /* of buffer, own lines only)        */
+    struct t_gui_line_block *last_block; /* last block of compressed lines  */
+    int lines_compressed;              /* number of lines in blocks         */
+    int lines_count_total;             /* lines + compressed lines          */
 };
 
 /* line functions */
 
 extern struct t_gui_lines *gui_lines_alloc ();
 extern void gui_lines_free (struct t_gui_lines *lines);
+extern int gui_line_slab_contains (struct t_gui_line_data *line_data,
+                                   const void *pointer);
 extern void gui_line_get_prefix_for_display (struct t_gui_line *line,
                                              char **prefix, int *length,
                                              char **color, int *prefix_is_nick);
@@ -81,8 +159,26 @@ extern struct t_gui_line *gui_line_get_first_displayed (struct t_gui_buffer *buf
 extern struct t_gui_line *gui_line_get_last_displayed (struct t_gui_buffer *buffer);
 extern struct t_gui_line *gui_line_get_prev_displayed (struct t_gui_line *line);
 extern struct t_gui_line *gui_line_get_next_displayed (struct t_gui_line *line);
+extern void gui_line_no_color_free (struct t_gui_line_data *line_data);
+extern void gui_line_no_color_build (struct t_gui_line_data *line_data);
+extern int gui_line_index_is_literal (const char *regex);
+extern void gui_line_index_compute (struct t_gui_line_index *index,
+                                    const char *prefix, const char *message,
+                                    int regex_icase);
+extern void gui_line_index_build (struct t_gui_line_data *line_data);
+extern void gui_line_index_build_all ();
+extern int gui_line_index_match_prefix (struct t_gui_line_data *line_data,
+                                        struct t_gui_line_index *index);
+extern int gui_line_index_match_message (struct t_gui_line_data *line_data,
+                                         struct t_gui_line_index *index);
+extern struct t_gui_line_index *gui_line_search_text_index (struct t_gui_buffer *buffer,
+                                                            struct t_gui_line_index *index);
 extern int gui_line_search_text (struct t_gui_buffer *buffer,
-                                 struct t_gui_line *line);
+                                 struct t_gui_line *line,
+                                 struct t_gui_line_index *index);
+extern int gui_line_has_text (struct t_gui_line_data *line_data,
+                              struct t_gui_line_index *index,
+                              const char *text);
 extern int gui_line_match_regex (struct t_gui_line_data *line_data,
                                  regex_t *regex_prefix,
                                  regex_t *regex_message);
@@ -103,7 +199,21 @@ extern void gui_line_mixed_free_all (struct t_gui_buffer *buffer);
 extern void gui_line_free (struct t_gui_buffer *buffer,
                            struct t_gui_line *line);
 extern void gui_line_free_all (struct t_gui_buffer *buffer);
+extern void gui_line_compress (struct t_gui_buffer *buffer);
+extern int gui_line_uncompress_blocks (struct t_gui_buffer *buffer,
+                                       int count);
+extern void gui_line_uncompress (struct t_gui_buffer *buffer);
+extern int gui_line_uncompress_prev (struct t_gui_line *line);
+extern struct t_gui_line *gui_line_get_prev_displayed_uncompress (struct t_gui_line *line);
+extern void gui_line_uncompress_for_window (struct t_gui_window *window);
 extern int gui_line_get_notify_level (struct t_gui_line *line);
+extern struct t_gui_line *gui_line_new (struct t_gui_buffer *buffer,
+                                        time_t date,
+                                        time_t date_printed,
+                                        const char *tags,
+                                        const char *prefix,
+                                        const char *message,
+                                        struct t_gui_line_slab **slab_old);
 extern struct t_gui_line *gui_line_add (struct t_gui_buffer *buffer,
                                         time_t date,
                                         time_t date_printed,
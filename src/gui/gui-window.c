@@ -35,6 +35,7 @@
 
 #include "../core/weechat.h"
 #include "../core/wee-config.h"
+#include "../core/wee-hashtable.h"
 #include "../core/wee-hdata.h"
 #include "../core/wee-hook.h"
 #include "../core/wee-infolist.h"
@@ -189,7 +190,9 @@ gui_window_get_context_at_xy (struct t_gui_window *window,
         if ((win_x >= window->coords[win_y].time_x1)
             && (win_x <= window->coords[win_y].time_x2))
         {
-            *word = gui_color_decode ((*line)->data->str_time, NULL);
+            *word = gui_color_decode (
+                gui_chat_get_time_string_cached ((*line)->data->date),
+                NULL);
         }
         else if ((win_x >= window->coords[win_y].buffer_x1)
                  && (win_x <= window->coords[win_y].buffer_x2))
@@ -199,7 +202,8 @@ gui_window_get_context_at_xy (struct t_gui_window *window,
         else if ((win_x >= window->coords[win_y].prefix_x1)
                  && (win_x <= window->coords[win_y].prefix_x2))
         {
-            *word = gui_color_decode ((*line)->data->prefix, NULL);
+            *word = ((*line)->data->prefix_no_color) ?
+                strdup ((*line)->data->prefix_no_color) : NULL;
         }
     }
     else
@@ -625,9 +629,30 @@ gui_window_new (struct t_gui_window *parent_window, struct t_gui_buffer *buffer,
         return NULL;
     }
 
+    /* create cache of line heights */
+    new_window->line_heights = malloc (sizeof (*new_window->line_heights));
+    if (!new_window->line_heights)
+    {
+        free (new_window->scroll);
+        free (new_window);
+        return NULL;
+    }
+
+    /* create info on last line displayed at bottom of chat area */
+    new_window->chat_bottom = malloc (sizeof (*new_window->chat_bottom));
+    if (!new_window->chat_bottom)
+    {
+        free (new_window->line_heights);
+        free (new_window->scroll);
+        free (new_window);
+        return NULL;
+    }
+
     /* create window objects */
     if (!gui_window_objects_init (new_window))
     {
+        free (new_window->chat_bottom);
+        free (new_window->line_heights);
         free (new_window->scroll);
         free (new_window);
         return NULL;
@@ -672,6 +697,19 @@ gui_window_new (struct t_gui_window *parent_window, struct t_gui_buffer *buffer,
     new_window->coords = NULL;
     new_window->coords_x_message = 0;
 
+    /* cache of line heights */
+    new_window->line_heights->heights = NULL;
+    new_window->line_heights->lines = NULL;
+    new_window->line_heights->chat_width = 0;
+    new_window->line_heights->chat_real_width = 0;
+    new_window->line_heights->prefix_max_length = 0;
+    new_window->line_heights->buffer_max_length = 0;
+    new_window->line_heights->time_for_each_line = 0;
+    new_window->line_heights->display_tags = 0;
+
+    /* last line displayed at bottom of chat area */
+    gui_window_chat_bottom_reset (new_window);
+
     /* tree */
     new_window->ptr_tree = ptr_leaf;
     ptr_leaf->window = new_window;
@@ -915,8 +953,14 @@ gui_window_coords_remove_line (struct t_gui_window *window,
     for (i = 0; i < window->coords_size; i++)
     {
         if (window->coords[i].line == line)
+        {
             gui_window_coords_init_line (window, i);
+            gui_window_chat_bottom_reset (window);
+        }
     }
+
+    if (window->chat_bottom && (window->chat_bottom->line == line))
+        gui_window_chat_bottom_reset (window);
 }
 
 /*
@@ -939,6 +983,7 @@ gui_window_coords_remove_line_data (struct t_gui_window *window,
             && (window->coords[i].line->data == line_data))
         {
             gui_window_coords_init_line (window, i);
+            gui_window_chat_bottom_reset (window);
         }
     }
 }
@@ -973,6 +1018,158 @@ gui_window_coords_alloc (struct t_gui_window *window)
     window->coords_x_message = 0;
 }
 
+/*
+ * Resets info on last line displayed at bottom of chat area: the chat area
+ * will be fully drawn on next refresh.
+ */
+
+void
+gui_window_chat_bottom_reset (struct t_gui_window *window)
+{
+    if (!window || !window->chat_bottom)
+        return;
+
+    window->chat_bottom->line = NULL;
+    window->chat_bottom->line_rows = 0;
+    window->chat_bottom->lines = NULL;
+    window->chat_bottom->chat_width = 0;
+    window->chat_bottom->chat_height = 0;
+    window->chat_bottom->prefix_max_length = 0;
+    window->chat_bottom->buffer_max_length = 0;
+    window->chat_bottom->last_read_line = NULL;
+    window->chat_bottom->first_line_not_read = 0;
+    window->chat_bottom->time_for_each_line = 0;
+    window->chat_bottom->display_tags = 0;
+    window->chat_bottom->current_window = 0;
+}
+
+/*
+ * Gets height of a line (number of lines on screen) from cache of window.
+ *
+ * Returns height of line, -1 if the line is not in cache.
+ */
+
+int
+gui_window_line_heights_get (struct t_gui_window *window,
+                             struct t_gui_line *line)
+{
+    int *ptr_height;
+
+    if (!window || !line || !window->line_heights
+        || !window->line_heights->heights)
+    {
+        return -1;
+    }
+
+    ptr_height = hashtable_get (window->line_heights->heights, line);
+
+    return (ptr_height) ? *ptr_height : -1;
+}
+
+/*
+ * Sets height of a line (number of lines on screen) in cache of window.
+ */
+
+void
+gui_window_line_heights_set (struct t_gui_window *window,
+                             struct t_gui_line *line, int height)
+{
+    if (!window || !line || !window->line_heights)
+        return;
+
+    if (!window->line_heights->heights)
+    {
+        /*
+         * keys are hashed with the line pointer, so a prime number is used
+         * for the size of hashtable
+         */
+        window->line_heights->heights = hashtable_new (
+            GUI_WINDOW_LINE_HEIGHTS_HASHTABLE_SIZE,
+            WEECHAT_HASHTABLE_POINTER,
+            WEECHAT_HASHTABLE_INTEGER,
+            NULL, NULL);
+        if (!window->line_heights->heights)
+            return;
+    }
+
+    hashtable_set (window->line_heights->heights, line, &height);
+}
+
+/*
+ * Removes a line from cache of line heights (called when a line is removed
+ * or when its content is changed).
+ */
+
+void
+gui_window_line_heights_remove_line (struct t_gui_window *window,
+                                     struct t_gui_line *line)
+{
+    if (!window || !line || !window->line_heights
+        || !window->line_heights->heights)
+    {
+        return;
+    }
+
+    hashtable_remove (window->line_heights->heights, line);
+}
+
+/*
+ * Clears cache of line heights in a window.
+ */
+
+void
+gui_window_line_heights_clear (struct t_gui_window *window)
+{
+    if (!window || !window->line_heights
+        || !window->line_heights->heights)
+    {
+        return;
+    }
+
+    hashtable_remove_all (window->line_heights->heights);
+}
+
+/*
+ * Clears cache of line heights in all windows.
+ */
+
+void
+gui_window_line_heights_clear_all ()
+{
+    struct t_gui_window *ptr_window;
+
+    for (ptr_window = gui_windows; ptr_window;
+         ptr_window = ptr_window->next_window)
+    {
+        gui_window_line_heights_clear (ptr_window);
+    }
+}
+
+/*
+ * Clears cache of line heights in windows displaying lines of a merged
+ * buffer (called when the name of buffer is changed: it is displayed before
+ * each line of merged buffers).
+ */
+
+void
+gui_window_line_heights_clear_buffer (struct t_gui_buffer *buffer)
+{
+    struct t_gui_window *ptr_window;
+
+    if (!buffer || !buffer->mixed_lines)
+        return;
+
+    for (ptr_window = gui_windows; ptr_window;
+         ptr_window = ptr_window->next_window)
+    {
+        if (ptr_window->buffer
+            && (ptr_window->buffer->lines == buffer->mixed_lines))
+        {
+            gui_window_line_heights_clear (ptr_window);
+        }
+    }
+}
+
 /*
  * Deletes a window.
  */
@@ -1020,6 +1217,18 @@ gui_window_free (struct t_gui_window *window)
     if (window->coords)
         free (window->coords);
 
+    /* free cache of line heights */
+    if (window->line_heights)
+    {
+        if (window->line_heights->heights)
+            hashtable_free (window->line_heights->heights);
+        free (window->line_heights);
+    }
+
+    /* free info on last line displayed at bottom of chat area */
+    if (window->chat_bottom)
+        free (window->chat_bottom);
+
     /* remove window from windows list */
     if (window->prev_window)
         (window->prev_window)->next_window = window->next_window;
@@ -1240,7 +1449,8 @@ gui_window_scroll (struct t_gui_window *window, char *scroll)
     while (ptr_line)
     {
         ptr_line = (direction < 0) ?
-            gui_line_get_prev_displayed (ptr_line) : gui_line_get_next_displayed (ptr_line);
+            gui_line_get_prev_displayed_uncompress (ptr_line) :
+            gui_line_get_next_displayed (ptr_line);
 
         if (ptr_line
             && ((window->buffer->type != GUI_BUFFER_TYPE_FORMATTED)
@@ -1459,6 +1669,11 @@ gui_window_scroll_previous_highlight (struct t_gui_window *window)
     {
         if (window->buffer->lines->first_line)
         {
+            if (window->scroll->start_line
+                && !window->scroll->start_line->prev_line)
+            {
+                gui_line_uncompress_prev (window->scroll->start_line);
+            }
             ptr_line = (window->scroll->start_line) ?
                 window->scroll->start_line->prev_line : window->buffer->lines->last_line;
             while (ptr_line)
@@ -1472,6 +1687,8 @@ gui_window_scroll_previous_highlight (struct t_gui_window *window)
                     gui_buffer_ask_chat_refresh (window->buffer, 2);
                     return;
                 }
+                if (!ptr_line->prev_line)
+                    gui_line_uncompress_prev (ptr_line);
                 ptr_line = ptr_line->prev_line;
             }
             /* no previous highlight, scroll to bottom */
@@ -1530,6 +1747,15 @@ gui_window_scroll_unread (struct t_gui_window *window)
 
     if (window->buffer->text_search == GUI_TEXT_SEARCH_DISABLED)
     {
+        /*
+         * the read marker may be in compressed lines: uncompress blocks until
+         * the block with the read marker is found
+         */
+        while (window->buffer->lines->first_line_not_read)
+        {
+            if (!gui_line_uncompress_blocks (window->buffer, 1))
+                break;
+        }
         if (CONFIG_STRING(config_look_read_marker) &&
             CONFIG_STRING(config_look_read_marker)[0] &&
             (window->buffer->type == GUI_BUFFER_TYPE_FORMATTED) &&
@@ -1566,21 +1792,26 @@ int
 gui_window_search_text (struct t_gui_window *window)
 {
     struct t_gui_line *ptr_line;
+    struct t_gui_line_index index, *ptr_index;
 
     if (!window)
         return 0;
 
+    /* index of text searched, computed once for all lines */
+    ptr_index = gui_line_search_text_index (window->buffer, &index);
+
     if (window->buffer->text_search == GUI_TEXT_SEARCH_BACKWARD)
     {
         if (window->buffer->lines->first_line
             && window->buffer->input_buffer && window->buffer->input_buffer[0])
         {
             ptr_line = (window->scroll->start_line) ?
-                gui_line_get_prev_displayed (window->scroll->start_line) :
+                gui_line_get_prev_displayed_uncompress (window->scroll->start_line) :
                 gui_line_get_last_displayed (window->buffer);
             while (ptr_line)
             {
-                if (gui_line_search_text (window->buffer, ptr_line))
+                if (gui_line_search_text (window->buffer, ptr_line,
+                                          ptr_index))
                 {
                     window->scroll->start_line = ptr_line;
                     window->scroll->start_line_pos = 0;
@@ -1589,7 +1820,7 @@ gui_window_search_text (struct t_gui_window *window)
                     gui_buffer_ask_chat_refresh (window->buffer, 2);
                     return 1;
                 }
-                ptr_line = gui_line_get_prev_displayed (ptr_line);
+                ptr_line = gui_line_get_prev_displayed_uncompress (ptr_line);
             }
         }
     }
@@ -1603,7 +1834,8 @@ gui_window_search_text (struct t_gui_window *window)
                 gui_line_get_first_displayed (window->buffer);
             while (ptr_line)
             {
-                if (gui_line_search_text (window->buffer, ptr_line))
+                if (gui_line_search_text (window->buffer, ptr_line,
+                                          ptr_index))
                 {
                     window->scroll->start_line = ptr_line;
                     window->scroll->start_line_pos = 0;
@@ -2029,6 +2261,37 @@ gui_window_print_log ()
         log_printf ("  coords_size . . . . : %d",    ptr_window->coords_size);
         log_printf ("  coords. . . . . . . : 0x%lx", ptr_window->coords);
         log_printf ("  coords_x_message. . : %d",    ptr_window->coords_x_message);
+        log_printf ("  line_heights. . . . : 0x%lx", ptr_window->line_heights);
+        if (ptr_window->line_heights)
+        {
+            log_printf ("    heights . . . . . : 0x%lx (items: %d)",
+                        ptr_window->line_heights->heights,
+                        (ptr_window->line_heights->heights) ?
+                        ptr_window->line_heights->heights->items_count : 0);
+            log_printf ("    lines . . . . . . : 0x%lx", ptr_window->line_heights->lines);
+            log_printf ("    chat_width. . . . : %d",    ptr_window->line_heights->chat_width);
+            log_printf ("    chat_real_width . : %d",    ptr_window->line_heights->chat_real_width);
+            log_printf ("    prefix_max_length : %d",    ptr_window->line_heights->prefix_max_length);
+            log_printf ("    buffer_max_length : %d",    ptr_window->line_heights->buffer_max_length);
+            log_printf ("    time_for_each_line: %d",    ptr_window->line_heights->time_for_each_line);
+            log_printf ("    display_tags. . . : %d",    ptr_window->line_heights->display_tags);
+        }
+        log_printf ("  chat_bottom . . . . : 0x%lx", ptr_window->chat_bottom);
+        if (ptr_window->chat_bottom)
+        {
+            log_printf ("    line. . . . . . . : 0x%lx", ptr_window->chat_bottom->line);
+            log_printf ("    line_rows . . . . : %d",    ptr_window->chat_bottom->line_rows);
+            log_printf ("    lines . . . . . . : 0x%lx", ptr_window->chat_bottom->lines);
+            log_printf ("    chat_width. . . . : %d",    ptr_window->chat_bottom->chat_width);
+            log_printf ("    chat_height . . . : %d",    ptr_window->chat_bottom->chat_height);
+            log_printf ("    prefix_max_length : %d",    ptr_window->chat_bottom->prefix_max_length);
+            log_printf ("    buffer_max_length : %d",    ptr_window->chat_bottom->buffer_max_length);
+            log_printf ("    last_read_line. . : 0x%lx", ptr_window->chat_bottom->last_read_line);
+            log_printf ("    first_line_not_read: %d",   ptr_window->chat_bottom->first_line_not_read);
+            log_printf ("    time_for_each_line: %d",    ptr_window->chat_bottom->time_for_each_line);
+            log_printf ("    display_tags. . . : %d",    ptr_window->chat_bottom->display_tags);
+            log_printf ("    current_window. . : %d",    ptr_window->chat_bottom->current_window);
+        }
         log_printf ("  ptr_tree. . . . . . : 0x%lx", ptr_window->ptr_tree);
         log_printf ("  prev_window . . . . : 0x%lx", ptr_window->prev_window);
         log_printf ("  next_window . . . . : 0x%lx", ptr_window->next_window);
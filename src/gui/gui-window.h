@@ -21,8 +21,12 @@
 #define WEECHAT_GUI_WINDOW_H 1
 
 struct t_infolist;
+struct t_hashtable;
 struct t_gui_bar_window;
 struct t_gui_line_data;
+struct t_gui_lines;
+
+#define GUI_WINDOW_LINE_HEIGHTS_HASHTABLE_SIZE 4099
 
 /* window structures */
 
@@ -78,6 +82,12 @@ struct t_gui_window
     struct t_gui_window_coords *coords;/* coords for window                 */
     int coords_x_message;              /* start X for messages              */
 
+    /* cache of line heights (formatted buffers) */
+    struct t_gui_window_line_heights *line_heights;
+
+    /* last line displayed at bottom of chat area (formatted buffers) */
+    struct t_gui_window_chat_bottom *chat_bottom;
+
     /* tree */
     struct t_gui_window_tree *ptr_tree;/* pointer to leaf in windows tree   */
 
@@ -102,6 +112,39 @@ struct t_gui_window_scroll
     struct t_gui_window_scroll *next_scroll; /* link to next buf. scrolled  */
 };
 
+struct t_gui_window_line_heights
+{
+    struct t_hashtable *heights;       /* number of lines on screen for     */
+                                       /* each line (key: line pointer)     */
+    /* context of heights: cache is cleared if one of them changes */
+    struct t_gui_lines *lines;         /* lines displayed in window         */
+    int chat_width;                    /* width of chat area                */
+    int chat_real_width;               /* real width of chat area           */
+    int prefix_max_length;             /* max length of prefix (alignment)  */
+    int buffer_max_length;             /* max length of buffer (merged)     */
+    int time_for_each_line;            /* time displayed for each line?     */
+    int display_tags;                  /* tags displayed (/debug tags)?     */
+};
+
+struct t_gui_window_chat_bottom
+{
+    struct t_gui_line *line;           /* last line displayed at bottom of  */
+                                       /* chat area (NULL if chat area must */
+                                       /* be fully drawn on next refresh)   */
+    int line_rows;                     /* number of rows used by this line  */
+    /* context of line: chat area is fully drawn if one of them changes */
+    struct t_gui_lines *lines;         /* lines displayed in window         */
+    int chat_width;                    /* width of chat area                */
+    int chat_height;                   /* height of chat area               */
+    int prefix_max_length;             /* max length of prefix (alignment)  */
+    int buffer_max_length;             /* max length of buffer (merged)     */
+    struct t_gui_line *last_read_line; /* last read line (read marker)      */
+    int first_line_not_read;           /* marker is before first line?      */
+    int time_for_each_line;            /* time displayed for each line?     */
+    int display_tags;                  /* tags displayed (/debug tags)?     */
+    int current_window;                /* window was the current window?    */
+};
+
 struct t_gui_window_tree
 {
     struct t_gui_window_tree *parent_node; /* pointer to parent node        */
@@ -174,6 +217,17 @@ extern void gui_window_coords_remove_line (struct t_gui_window *window,
 extern void gui_window_coords_remove_line_data (struct t_gui_window *window,
                                                 struct t_gui_line_data *line_data);
 extern void gui_window_coords_alloc (struct t_gui_window *window);
+extern int gui_window_line_heights_get (struct t_gui_window *window,
+                                        struct t_gui_line *line);
+extern void gui_window_line_heights_set (struct t_gui_window *window,
+                                         struct t_gui_line *line,
+                                         int height);
+extern void gui_window_line_heights_remove_line (struct t_gui_window *window,
+                                                 struct t_gui_line *line);
+extern void gui_window_line_heights_clear (struct t_gui_window *window);
+extern void gui_window_line_heights_clear_all ();
+extern void gui_window_line_heights_clear_buffer (struct t_gui_buffer *buffer);
+extern void gui_window_chat_bottom_reset (struct t_gui_window *window);
 extern void gui_window_free (struct t_gui_window *window);
 extern void gui_window_switch_previous (struct t_gui_window *window);
 extern void gui_window_switch_next (struct t_gui_window *window);
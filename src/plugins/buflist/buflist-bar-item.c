@@ -37,8 +37,228 @@ struct t_hashtable *buflist_hashtable_options_conditions = NULL;
 struct t_arraylist *buflist_list_buffers = NULL;
 
 
+/*
+ * Sets pointers to buffer, IRC server and channel in hashtable
+ * buflist_hashtable_pointers (used to evaluate conditions and line of a
+ * buffer).
+ */
+
+void
+buflist_bar_item_set_pointers (struct t_gui_buffer *buffer,
+                               struct t_irc_server **server,
+                               struct t_irc_channel **channel)
+{
+    weechat_hashtable_set (buflist_hashtable_pointers, "buffer", buffer);
+
+    buflist_buffer_get_irc_pointers (buffer, server, channel);
+    weechat_hashtable_set (buflist_hashtable_pointers,
+                           "irc_server", *server);
+    weechat_hashtable_set (buflist_hashtable_pointers,
+                           "irc_channel", *channel);
+}
+
+/*
+ * Evaluates the line displayed for a buffer.
+ *
+ * The hashtable buflist_hashtable_pointers must already contain the pointers
+ * to buffer, IRC server and channel.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+buflist_bar_item_eval_line (struct t_gui_buffer *ptr_buffer,
+                            int current_buffer, const char *str_number,
+                            int number_displayed,
+                            struct t_gui_hotlist *ptr_hotlist)
+{
+    struct t_gui_nick *ptr_gui_nick;
+    char str_nick_prefix[32], str_color_nick_prefix[32];
+    char **hotlist, *str_hotlist, str_hotlist_count[32];
+    const char *ptr_format, *ptr_format_current, *ptr_format_indent;
+    const char *ptr_name, *ptr_type, *ptr_nick, *ptr_nick_prefix;
+    const char *ptr_hotlist_format, *ptr_hotlist_priority;
+    const char *hotlist_priority_none = "none";
+    const char *hotlist_priority[4] = { "low", "message", "private",
+                                        "highlight" };
+    const char indent_empty[1] = { '\0' };
+    const char *ptr_lag;
+    int is_channel, is_private, j, priority, count;
+
+    ptr_format = weechat_config_string (buflist_config_format_buffer);
+    ptr_format_current = weechat_config_string (buflist_config_format_buffer_current);
+
+    ptr_name = weechat_hdata_string (buflist_hdata_buffer,
+                                     ptr_buffer, "short_name");
+    if (!ptr_name)
+        ptr_name = weechat_hdata_string (buflist_hdata_buffer,
+                                         ptr_buffer, "name");
+
+    /* buffer number */
+    weechat_hashtable_set (buflist_hashtable_extra_vars,
+                           "number_displayed",
+                           (number_displayed) ? "1" : "0");
+
+    /* buffer name */
+    ptr_type = weechat_buffer_get_string (ptr_buffer, "localvar_type");
+    is_channel = (ptr_type && (strcmp (ptr_type, "channel") == 0));
+    is_private = (ptr_type && (strcmp (ptr_type, "private") == 0));
+    ptr_format_indent = (is_channel || is_private) ?
+        weechat_config_string (buflist_config_format_indent) : indent_empty;
+
+    /* nick prefix */
+    str_nick_prefix[0] = '\0';
+    str_color_nick_prefix[0] = '\0';
+    if (is_channel
+        && weechat_config_boolean (buflist_config_look_nick_prefix))
+    {
+        snprintf (str_nick_prefix, sizeof (str_nick_prefix),
+                  "%s",
+                  (weechat_config_boolean (buflist_config_look_nick_prefix_empty)) ?
+                  " " : "");
+        ptr_nick = weechat_buffer_get_string (ptr_buffer, "localvar_nick");
+        if (ptr_nick)
+        {
+            ptr_gui_nick = weechat_nicklist_search_nick (ptr_buffer, NULL,
+                                                         ptr_nick);
+            if (ptr_gui_nick)
+            {
+                ptr_nick_prefix = weechat_nicklist_nick_get_string (
+                    ptr_buffer, ptr_gui_nick, "prefix");
+                if (ptr_nick_prefix && (ptr_nick_prefix[0] != ' '))
+                {
+                    snprintf (str_color_nick_prefix,
+                              sizeof (str_color_nick_prefix),
+                              "%s",
+                              weechat_color (
+                                  weechat_nicklist_nick_get_string (
+                                      ptr_buffer, ptr_gui_nick,
+                                      "prefix_color")));
+                    snprintf (str_nick_prefix, sizeof (str_nick_prefix),
+                              "%s",
+                              ptr_nick_prefix);
+                }
+            }
+        }
+    }
+    weechat_hashtable_set (buflist_hashtable_extra_vars,
+                           "nick_prefix", str_nick_prefix);
+    weechat_hashtable_set (buflist_hashtable_extra_vars,
+                           "color_nick_prefix", str_color_nick_prefix);
+    weechat_hashtable_set (buflist_hashtable_extra_vars,
+                           "format_nick_prefix",
+                           weechat_config_string (
+                               buflist_config_format_nick_prefix));
+
+    /* set extra variables */
+    weechat_hashtable_set (buflist_hashtable_extra_vars,
+                           "format_buffer",
+                           weechat_config_string (
+                               buflist_config_format_buffer));
+    weechat_hashtable_set (buflist_hashtable_extra_vars,
+                           "number", str_number);
+    weechat_hashtable_set (buflist_hashtable_extra_vars,
+                           "format_number",
+                           weechat_config_string (
+                               buflist_config_format_number));
+    weechat_hashtable_set (buflist_hashtable_extra_vars,
+                           "indent", ptr_format_indent);
+    weechat_hashtable_set (buflist_hashtable_extra_vars,
+                           "name", ptr_name);
+
+    /* hotlist */
+    ptr_hotlist_format = weechat_config_string (
+        buflist_config_format_hotlist_level_none);
+    ptr_hotlist_priority = hotlist_priority_none;
+    if (ptr_hotlist)
+    {
+        priority = weechat_hdata_integer (buflist_hdata_hotlist,
+                                          ptr_hotlist, "priority");
+        if ((priority >= 0) && (priority < 4))
+        {
+            ptr_hotlist_format = weechat_config_string (
+                buflist_config_format_hotlist_level[priority]);
+            ptr_hotlist_priority = hotlist_priority[priority];
+        }
+    }
+    weechat_hashtable_set (buflist_hashtable_extra_vars,
+                           "color_hotlist", ptr_hotlist_format);
+    weechat_hashtable_set (buflist_hashtable_extra_vars,
+                           "hotlist_priority", ptr_hotlist_priority);
+    str_hotlist = NULL;
+    if (ptr_hotlist)
+    {
+        hotlist = weechat_string_dyn_alloc (64);
+        if (hotlist)
+        {
+            for (j = 3; j >= 0; j--)
+            {
+                snprintf (str_hotlist_count, sizeof (str_hotlist_count),
+                          "%02d|count", j);
+                count = weechat_hdata_integer (buflist_hdata_hotlist,
+                                               ptr_hotlist,
+                                               str_hotlist_count);
+                if (count > 0)
+                {
+                    if (*hotlist[0])
+                    {
+                        weechat_string_dyn_concat (
+                            hotlist,
+                            weechat_config_string (
+                                buflist_config_format_hotlist_separator));
+                    }
+                    weechat_string_dyn_concat (
+                        hotlist,
+                        weechat_config_string (
+                            buflist_config_format_hotlist_level[j]));
+                    snprintf (str_hotlist_count, sizeof (str_hotlist_count),
+                              "%d", count);
+                    weechat_string_dyn_concat (hotlist, str_hotlist_count);
+                }
+            }
+            str_hotlist = *hotlist;
+            weechat_string_dyn_free (hotlist, 0);
+        }
+    }
+    weechat_hashtable_set (
+        buflist_hashtable_extra_vars,
+        "format_hotlist",
+        (str_hotlist) ? weechat_config_string (buflist_config_format_hotlist) : "");
+    weechat_hashtable_set (buflist_hashtable_extra_vars,
+                           "hotlist",
+                           (str_hotlist) ? str_hotlist : "");
+    if (str_hotlist)
+        free (str_hotlist);
+
+    /* lag */
+    ptr_lag = weechat_buffer_get_string (ptr_buffer, "localvar_lag");
+    if (ptr_lag && ptr_lag[0])
+    {
+        weechat_hashtable_set (
+            buflist_hashtable_extra_vars,
+            "format_lag",
+            weechat_config_string (buflist_config_format_lag));
+    }
+    else
+    {
+        weechat_hashtable_set (buflist_hashtable_extra_vars,
+                               "format_lag", "");
+    }
+
+    /* build string */
+    return weechat_string_eval_expression (
+        (current_buffer) ? ptr_format_current : ptr_format,
+        buflist_hashtable_pointers,
+        buflist_hashtable_extra_vars,
+        buflist_hashtable_options);
+}
+
 /*
  * Returns content of bar item "buffer_plugin": bar item with buffer plugin.
+ *
+ * The line of a buffer is evaluated only if the buffer has changed (asked by
+ * a signal), or if a variable computed here has changed (number, current
+ * buffer, hotlist); otherwise the last line evaluated is used.
  */
 
 char *
@@ -49,27 +269,16 @@ buflist_bar_item_buflist_cb (const void *pointer, void *data,
                              struct t_hashtable *extra_info)
 {
     struct t_arraylist *buffers;
+    struct t_buflist_buffer *ptr_buflist_buffer;
     struct t_gui_buffer *ptr_buffer, *ptr_current_buffer;
-    struct t_gui_nick *ptr_gui_nick;
     struct t_gui_hotlist *ptr_hotlist;
     struct t_irc_server *ptr_server;
     struct t_irc_channel *ptr_channel;
     char **buflist, *str_buflist, *condition;
     char str_format_number[32], str_format_number_empty[32];
-    char str_nick_prefix[32], str_color_nick_prefix[32];
-    char str_number[32], *line, **hotlist, *str_hotlist;
-    char str_hotlist_count[32];
-    const char *ptr_format, *ptr_format_current, *ptr_format_indent;
-    const char *ptr_name, *ptr_type, *ptr_nick, *ptr_nick_prefix;
-    const char *ptr_hotlist_format, *ptr_hotlist_priority;
-    const char *hotlist_priority_none = "none";
-    const char *hotlist_priority[4] = { "low", "message", "private",
-                                        "highlight" };
-    const char indent_empty[1] = { '\0' };
-    const char *ptr_lag;
-    int is_channel, is_private;
-    int i, j, length_max_number, current_buffer, number, prev_number, priority;
-    int rc, count;
+    char str_number[32], str_vars[128], str_vars_line[256];
+    int i, length_max_number, current_buffer, number, prev_number, priority;
+    int number_displayed, pointers_set;
 
     /* make C compiler happy */
     (void) pointer;
@@ -82,9 +291,8 @@ buflist_bar_item_buflist_cb (const void *pointer, void *data,
     prev_number = -1;
 
     buflist = weechat_string_dyn_alloc (256);
-
-    ptr_format = weechat_config_string (buflist_config_format_buffer);
-    ptr_format_current = weechat_config_string (buflist_config_format_buffer_current);
+    if (!buflist)
+        return NULL;
 
     ptr_current_buffer = weechat_current_buffer ();
 
@@ -106,47 +314,82 @@ buflist_bar_item_buflist_cb (const void *pointer, void *data,
                                                   NULL, NULL, NULL, NULL);
 
     buffers = buflist_sort_buffers ();
+    if (!buffers)
+        goto error;
 
     for (i = 0; i < weechat_arraylist_size (buffers); i++)
     {
-        ptr_buffer = weechat_arraylist_get (buffers, i);
+        ptr_buflist_buffer = weechat_arraylist_get (buffers, i);
+        ptr_buffer = ptr_buflist_buffer->buffer;
+        pointers_set = 0;
+
+        current_buffer = (ptr_buffer == ptr_current_buffer);
 
-        /* set pointers */
-        weechat_hashtable_set (buflist_hashtable_pointers,
-                               "buffer", ptr_buffer);
+        number = weechat_hdata_integer (buflist_hdata_buffer,
+                                        ptr_buffer, "number");
 
-        /* set IRC server/channel pointers */
-        buflist_buffer_get_irc_pointers (ptr_buffer, &ptr_server, &ptr_channel);
-        weechat_hashtable_set (buflist_hashtable_pointers,
-                               "irc_server", ptr_server);
-        weechat_hashtable_set (buflist_hashtable_pointers,
-                               "irc_channel", ptr_channel);
+        ptr_hotlist = weechat_hdata_pointer (buflist_hdata_buffer,
+                                             ptr_buffer, "hotlist");
+        priority = (ptr_hotlist) ?
+            weechat_hdata_integer (buflist_hdata_hotlist,
+                                   ptr_hotlist, "priority") : -1;
+
+        /*
+         * variables which can change without a signal for this buffer
+         * (if one of them has changed, the line is evaluated again)
+         */
+        snprintf (str_vars, sizeof (str_vars),
+                  "%d|%d|%d|%d|%d,%d,%d,%d",
+                  current_buffer,
+                  number,
+                  weechat_hdata_integer (buflist_hdata_buffer,
+                                         ptr_buffer, "active"),
+                  priority,
+                  (ptr_hotlist) ? weechat_hdata_integer (
+                      buflist_hdata_hotlist, ptr_hotlist, "00|count") : 0,
+                  (ptr_hotlist) ? weechat_hdata_integer (
+                      buflist_hdata_hotlist, ptr_hotlist, "01|count") : 0,
+                  (ptr_hotlist) ? weechat_hdata_integer (
+                      buflist_hdata_hotlist, ptr_hotlist, "02|count") : 0,
+                  (ptr_hotlist) ? weechat_hdata_integer (
+                      buflist_hdata_hotlist, ptr_hotlist, "03|count") : 0);
 
         /* check condition: if false, the buffer is not displayed */
-        condition = weechat_string_eval_expression (
-            weechat_config_string (buflist_config_look_display_conditions),
-            buflist_hashtable_pointers,
-            NULL,  /* extra vars */
-            buflist_hashtable_options_conditions);
-        rc = (condition && (strcmp (condition, "1") == 0));
-        if (condition)
-            free (condition);
-        if (!rc)
+        if (ptr_buflist_buffer->refresh
+            || !ptr_buflist_buffer->vars_conditions
+            || (strcmp (ptr_buflist_buffer->vars_conditions, str_vars) != 0))
+        {
+            buflist_bar_item_set_pointers (ptr_buffer, &ptr_server,
+                                           &ptr_channel);
+            pointers_set = 1;
+            condition = weechat_string_eval_expression (
+                weechat_config_string (buflist_config_look_display_conditions),
+                buflist_hashtable_pointers,
+                NULL,  /* extra vars */
+                buflist_hashtable_options_conditions);
+            ptr_buflist_buffer->displayed = (condition
+                                             && (strcmp (condition, "1") == 0));
+            if (condition)
+                free (condition);
+            if (ptr_buflist_buffer->vars_conditions)
+                free (ptr_buflist_buffer->vars_conditions);
+            ptr_buflist_buffer->vars_conditions = strdup (str_vars);
+            if (ptr_buflist_buffer->refresh)
+            {
+                /* the line will be evaluated again */
+                if (ptr_buflist_buffer->line)
+                {
+                    free (ptr_buflist_buffer->line);
+                    ptr_buflist_buffer->line = NULL;
+                }
+                ptr_buflist_buffer->refresh = 0;
+            }
+        }
+        if (!ptr_buflist_buffer->displayed)
             continue;
 
         weechat_arraylist_add (buflist_list_buffers, ptr_buffer);
 
-        current_buffer = (ptr_buffer == ptr_current_buffer);
-
-        ptr_hotlist = weechat_hdata_pointer (buflist_hdata_buffer,
-                                             ptr_buffer, "hotlist");
-
-        ptr_name = weechat_hdata_string (buflist_hdata_buffer,
-                                         ptr_buffer, "short_name");
-        if (!ptr_name)
-            ptr_name = weechat_hdata_string (buflist_hdata_buffer,
-                                             ptr_buffer, "name");
-
         if (*buflist[0])
         {
             if (!weechat_string_dyn_concat (buflist, "\n"))
@@ -154,182 +397,47 @@ buflist_bar_item_buflist_cb (const void *pointer, void *data,
         }
 
         /* buffer number */
-        number = weechat_hdata_integer (buflist_hdata_buffer,
-                                        ptr_buffer, "number");
-        if (number != prev_number)
+        number_displayed = (number != prev_number);
+        if (number_displayed)
         {
             snprintf (str_number, sizeof (str_number),
                       str_format_number, number);
-            weechat_hashtable_set (buflist_hashtable_extra_vars,
-                                   "number_displayed", "1");
         }
         else
         {
             snprintf (str_number, sizeof (str_number),
                       str_format_number_empty, " ");
-            weechat_hashtable_set (buflist_hashtable_extra_vars,
-                                   "number_displayed", "0");
         }
         prev_number = number;
 
-        /* buffer name */
-        ptr_type = weechat_buffer_get_string (ptr_buffer, "localvar_type");
-        is_channel = (ptr_type && (strcmp (ptr_type, "channel") == 0));
-        is_private = (ptr_type && (strcmp (ptr_type, "private") == 0));
-        ptr_format_indent = (is_channel || is_private) ?
-            weechat_config_string (buflist_config_format_indent) : indent_empty;
-
-        /* nick prefix */
-        str_nick_prefix[0] = '\0';
-        str_color_nick_prefix[0] = '\0';
-        if (is_channel
-            && weechat_config_boolean (buflist_config_look_nick_prefix))
+        /* evaluate line if needed */
+        snprintf (str_vars_line, sizeof (str_vars_line),
+                  "%s|%s", str_vars, str_number);
+        if (!ptr_buflist_buffer->line
+            || !ptr_buflist_buffer->vars_line
+            || (strcmp (ptr_buflist_buffer->vars_line, str_vars_line) != 0))
         {
-            snprintf (str_nick_prefix, sizeof (str_nick_prefix),
-                      "%s",
-                      (weechat_config_boolean (buflist_config_look_nick_prefix_empty)) ?
-                      " " : "");
-            ptr_nick = weechat_buffer_get_string (ptr_buffer, "localvar_nick");
-            if (ptr_nick)
+            if (!pointers_set)
             {
-                ptr_gui_nick = weechat_nicklist_search_nick (ptr_buffer, NULL,
-                                                             ptr_nick);
-                if (ptr_gui_nick)
-                {
-                    ptr_nick_prefix = weechat_nicklist_nick_get_string (
-                        ptr_buffer, ptr_gui_nick, "prefix");
-                    if (ptr_nick_prefix && (ptr_nick_prefix[0] != ' '))
-                    {
-                        snprintf (str_color_nick_prefix,
-                                  sizeof (str_color_nick_prefix),
-                                  "%s",
-                                  weechat_color (
-                                      weechat_nicklist_nick_get_string (
-                                          ptr_buffer, ptr_gui_nick,
-                                          "prefix_color")));
-                        snprintf (str_nick_prefix, sizeof (str_nick_prefix),
-                                  "%s",
-                                  ptr_nick_prefix);
-                    }
-                }
+                buflist_bar_item_set_pointers (ptr_buffer, &ptr_server,
+                                               &ptr_channel);
             }
+            if (ptr_buflist_buffer->line)
+                free (ptr_buflist_buffer->line);
+            ptr_buflist_buffer->line = buflist_bar_item_eval_line (
+                ptr_buffer, current_buffer, str_number, number_displayed,
+                ptr_hotlist);
+            if (ptr_buflist_buffer->vars_line)
+                free (ptr_buflist_buffer->vars_line);
+            ptr_buflist_buffer->vars_line = strdup (str_vars_line);
         }
-        weechat_hashtable_set (buflist_hashtable_extra_vars,
-                               "nick_prefix", str_nick_prefix);
-        weechat_hashtable_set (buflist_hashtable_extra_vars,
-                               "color_nick_prefix", str_color_nick_prefix);
-        weechat_hashtable_set (buflist_hashtable_extra_vars,
-                               "format_nick_prefix",
-                               weechat_config_string (
-                                   buflist_config_format_nick_prefix));
 
-        /* set extra variables */
-        weechat_hashtable_set (buflist_hashtable_extra_vars,
-                               "format_buffer",
-                               weechat_config_string (
-                                   buflist_config_format_buffer));
-        weechat_hashtable_set (buflist_hashtable_extra_vars,
-                               "number", str_number);
-        weechat_hashtable_set (buflist_hashtable_extra_vars,
-                               "format_number",
-                               weechat_config_string (
-                                   buflist_config_format_number));
-        weechat_hashtable_set (buflist_hashtable_extra_vars,
-                               "indent", ptr_format_indent);
-        weechat_hashtable_set (buflist_hashtable_extra_vars,
-                               "name", ptr_name);
-
-        /* hotlist */
-        ptr_hotlist_format = weechat_config_string (
-            buflist_config_format_hotlist_level_none);
-        ptr_hotlist_priority = hotlist_priority_none;
-        if (ptr_hotlist)
-        {
-            priority = weechat_hdata_integer (buflist_hdata_hotlist,
-                                              ptr_hotlist, "priority");
-            if ((priority >= 0) && (priority < 4))
-            {
-                ptr_hotlist_format = weechat_config_string (
-                    buflist_config_format_hotlist_level[priority]);
-                ptr_hotlist_priority = hotlist_priority[priority];
-            }
-        }
-        weechat_hashtable_set (buflist_hashtable_extra_vars,
-                               "color_hotlist", ptr_hotlist_format);
-        weechat_hashtable_set (buflist_hashtable_extra_vars,
-                               "hotlist_priority", ptr_hotlist_priority);
-        str_hotlist = NULL;
-        if (ptr_hotlist)
-        {
-            hotlist = weechat_string_dyn_alloc (64);
-            if (hotlist)
-            {
-                for (j = 3; j >= 0; j--)
-                {
-                    snprintf (str_hotlist_count, sizeof (str_hotlist_count),
-                              "%02d|count", j);
-                    count = weechat_hdata_integer (buflist_hdata_hotlist,
-                                                   ptr_hotlist,
-                                                   str_hotlist_count);
-                    if (count > 0)
-                    {
-                        if (*hotlist[0])
-                        {
-                            weechat_string_dyn_concat (
-                                hotlist,
-                                weechat_config_string (
-                                    buflist_config_format_hotlist_separator));
-                        }
-                        weechat_string_dyn_concat (
-                            hotlist,
-                            weechat_config_string (
-                                buflist_config_format_hotlist_level[j]));
-                        snprintf (str_hotlist_count, sizeof (str_hotlist_count),
-                                  "%d", count);
-                        weechat_string_dyn_concat (hotlist, str_hotlist_count);
-                    }
-                }
-                str_hotlist = *hotlist;
-                weechat_string_dyn_free (hotlist, 0);
-            }
-        }
-        weechat_hashtable_set (
-            buflist_hashtable_extra_vars,
-            "format_hotlist",
-            (str_hotlist) ? weechat_config_string (buflist_config_format_hotlist) : "");
-        weechat_hashtable_set (buflist_hashtable_extra_vars,
-                               "hotlist",
-                               (str_hotlist) ? str_hotlist : "");
-        if (str_hotlist)
-            free (str_hotlist);
-
-        /* lag */
-        ptr_lag = weechat_buffer_get_string (ptr_buffer, "localvar_lag");
-        if (ptr_lag && ptr_lag[0])
-        {
-            weechat_hashtable_set (
-                buflist_hashtable_extra_vars,
-                "format_lag",
-                weechat_config_string (buflist_config_format_lag));
-        }
-        else
+        /* concatenate string */
+        if (ptr_buflist_buffer->line)
         {
-            weechat_hashtable_set (buflist_hashtable_extra_vars,
-                                   "format_lag", "");
+            if (!weechat_string_dyn_concat (buflist, ptr_buflist_buffer->line))
+                goto error;
         }
-
-        /* build string */
-        line = weechat_string_eval_expression (
-            (current_buffer) ? ptr_format_current : ptr_format,
-            buflist_hashtable_pointers,
-            buflist_hashtable_extra_vars,
-            buflist_hashtable_options);
-
-        /* concatenate string */
-        rc = weechat_string_dyn_concat (buflist, line);
-        free (line);
-        if (!rc)
-            goto error;
     }
 
     str_buflist = *buflist;
@@ -340,8 +448,7 @@ error:
     str_buflist = NULL;
 
 end:
-    weechat_string_dyn_free (buflist, 0);
-    weechat_arraylist_free (buffers);
+    weechat_string_dyn_free (buflist, (str_buflist) ? 0 : 1);
 
     return str_buflist;
 }
@@ -19,6 +19,7 @@
  * along with WeeChat.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -80,6 +81,8 @@ buflist_config_change_sort (const void *pointer, void *data,
         weechat_config_string (buflist_config_look_sort),
         ",", 0, 0, &buflist_config_sort_fields_count);
 
+    buflist_buffer_refresh_all ();
+
     weechat_bar_item_update (BUFLIST_BAR_ITEM_NAME);
 }
 
@@ -106,8 +109,78 @@ buflist_config_free_signals_refresh ()
     buflist_config_num_signals_refresh = 0;
 }
 
+/*
+ * Checks if a field starting with a prefix is used in option
+ * "buflist.look.sort".
+ *
+ * Returns:
+ *   1: field is used to sort buffers
+ *   0: field is not used
+ */
+
+int
+buflist_config_sort_has_field (const char *prefix)
+{
+    int i, length;
+    const char *ptr_field;
+
+    length = strlen (prefix);
+
+    for (i = 0; i < buflist_config_sort_fields_count; i++)
+    {
+        ptr_field = buflist_config_sort_fields[i];
+        if (ptr_field[0] == '-')
+            ptr_field++;
+        if (strncmp (ptr_field, prefix, length) == 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Checks if a signal is one of the signals always hooked by buflist
+ * (BUFLIST_CONFIG_SIGNALS_REFRESH).
+ *
+ * Returns:
+ *   1: signal is a default signal
+ *   0: signal is not a default signal (added by user in option
+ *      "buflist.look.signals_refresh")
+ */
+
+int
+buflist_config_signal_is_default (const char *signal)
+{
+    const char *ptr_signal, *pos;
+    int length, length_signal;
+
+    length = strlen (signal);
+
+    ptr_signal = BUFLIST_CONFIG_SIGNALS_REFRESH;
+    while (ptr_signal && ptr_signal[0])
+    {
+        pos = strchr (ptr_signal, ',');
+        length_signal = (pos) ? pos - ptr_signal : (int)strlen (ptr_signal);
+        if ((length_signal == length)
+            && (strncmp (ptr_signal, signal, length) == 0))
+        {
+            return 1;
+        }
+        ptr_signal = (pos) ? pos + 1 : NULL;
+    }
+
+    return 0;
+}
+
 /*
  * Callback for a signal on a buffer.
+ *
+ * When possible, only the buffer sent in the signal is evaluated again,
+ * otherwise all buffers are evaluated and sorted again.
+ *
+ * The signal data is used as a buffer pointer only for the default signals
+ * and nicklist signals hooked by buflist: other signals (added by user in
+ * option "buflist.look.signals_refresh") always refresh all buffers.
  */
 
 int
@@ -115,12 +188,64 @@ buflist_config_signal_buffer_cb (const void *pointer, void *data,
                                  const char *signal, const char *type_data,
                                  void *signal_data)
 {
+    struct t_gui_buffer *ptr_buffer;
+    const char *ptr_type;
+    unsigned long value;
+
     /* make C compiler happy */
     (void) pointer;
     (void) data;
-    (void) signal;
-    (void) type_data;
-    (void) signal_data;
+
+    if ((strcmp (type_data, WEECHAT_HOOK_SIGNAL_POINTER) == 0)
+        && (strncmp (signal, "buffer_", 7) == 0)
+        && buflist_config_signal_is_default (signal))
+    {
+        ptr_buffer = (struct t_gui_buffer *)signal_data;
+        if ((strcmp (signal, "buffer_opened") == 0)
+            || (strcmp (signal, "buffer_closed") == 0)
+            || (strcmp (signal, "buffer_merged") == 0)
+            || (strcmp (signal, "buffer_unmerged") == 0)
+            || (strcmp (signal, "buffer_moved") == 0)
+            || (strcmp (signal, "buffer_switch") == 0))
+        {
+            /* numbers or active buffer have changed: check all buffers */
+            buflist_buffer_refresh (ptr_buffer, 1);
+            buflist_sort_refresh_keys = 1;
+        }
+        else if (strncmp (signal, "buffer_localvar_", 16) == 0)
+        {
+            /* a change on IRC server buffer can change IRC channels */
+            ptr_type = weechat_buffer_get_string (ptr_buffer,
+                                                  "localvar_type");
+            if (ptr_type && (strcmp (ptr_type, "server") == 0))
+                buflist_buffer_refresh_all ();
+            else
+                buflist_buffer_refresh (ptr_buffer, 1);
+        }
+        else
+        {
+            buflist_buffer_refresh (ptr_buffer, 1);
+        }
+    }
+    else if (strcmp (signal, "hotlist_changed") == 0)
+    {
+        /* lines with a hotlist changed are evaluated in bar item callback */
+        if (buflist_config_sort_has_field ("hotlist."))
+            buflist_sort_refresh_keys = 1;
+    }
+    else if ((strcmp (type_data, WEECHAT_HOOK_SIGNAL_STRING) == 0)
+             && weechat_string_match (
+                 signal, BUFLIST_CONFIG_SIGNALS_REFRESH_NICK_PREFIX, 1)
+             && signal_data
+             && (sscanf ((const char *)signal_data, "%lx", &value) == 1))
+    {
+        /* signal data is: "0x123456,name" (pointer to buffer, then name) */
+        buflist_buffer_refresh ((struct t_gui_buffer *)value, 1);
+    }
+    else
+    {
+        buflist_buffer_refresh_all ();
+    }
 
     weechat_bar_item_update (BUFLIST_BAR_ITEM_NAME);
 
@@ -246,6 +371,7 @@ buflist_config_change_nick_prefix (const void *pointer, void *data,
     (void) option;
 
     buflist_config_change_signals_refresh (NULL, NULL, NULL);
+    buflist_buffer_refresh_all ();
     weechat_bar_item_update (BUFLIST_BAR_ITEM_NAME);
 }
 
@@ -262,6 +388,7 @@ buflist_config_change_buflist (const void *pointer, void *data,
     (void) data;
     (void) option;
 
+    buflist_buffer_refresh_all ();
     weechat_bar_item_update (BUFLIST_BAR_ITEM_NAME);
 }
 
@@ -43,6 +43,13 @@ struct t_weechat_plugin *weechat_buflist_plugin = NULL;
 struct t_hdata *buflist_hdata_buffer = NULL;
 struct t_hdata *buflist_hdata_hotlist = NULL;
 
+struct t_hashtable *buflist_buffers = NULL; /* buffers (pointer -> buflist  */
+                                            /* buffer)                      */
+struct t_arraylist *buflist_buffers_sorted = NULL; /* sorted buflist buffers*/
+int buflist_sort_refresh = 1;          /* 1 if all buffers must be sorted   */
+int buflist_sort_refresh_keys = 0;     /* 1 if sort keys of all buffers     */
+                                       /* must be checked                   */
+
 
 /*
  * Get IRC server and channel pointers for a buffer.
@@ -58,8 +65,7 @@ buflist_buffer_get_irc_pointers(struct t_gui_buffer *buffer,
                                 struct t_irc_server **server,
                                 struct t_irc_channel **channel)
 {
-    const char *ptr_server_name, *ptr_channel_name;
-    char str_condition[512];
+    const char *ptr_server_name, *ptr_channel_name, *ptr_name;
     struct t_hdata *hdata_irc_server, *hdata_irc_channel;
 
     *server = NULL;
@@ -80,15 +86,14 @@ buflist_buffer_get_irc_pointers(struct t_gui_buffer *buffer,
         return;
 
     /* search the server by name in list of servers */
-    snprintf (str_condition, sizeof (str_condition),
-              "${irc_server.name} == %s",
-              ptr_server_name);
-    *server = weechat_hdata_get_list (hdata_irc_server,
-                                      "irc_servers");
-    *server = weechat_hdata_search (hdata_irc_server,
-                                    *server,
-                                    str_condition,
-                                    1);
+    *server = weechat_hdata_get_list (hdata_irc_server, "irc_servers");
+    while (*server)
+    {
+        ptr_name = weechat_hdata_string (hdata_irc_server, *server, "name");
+        if (ptr_name && (strcmp (ptr_name, ptr_server_name) == 0))
+            break;
+        *server = weechat_hdata_move (hdata_irc_server, *server, 1);
+    }
     if (!*server)
         return;
 
@@ -104,76 +109,145 @@ buflist_buffer_get_irc_pointers(struct t_gui_buffer *buffer,
         return;
 
     /* search the channel by name in list of channels on the server */
-    snprintf (str_condition, sizeof (str_condition),
-              "${irc_channel.name} == %s",
-              ptr_channel_name);
-    *channel = weechat_hdata_pointer (hdata_irc_server,
-                                      *server,
-                                      "channels");
-    *channel = weechat_hdata_search (hdata_irc_channel,
-                                     *channel,
-                                     str_condition,
-                                     1);
+    *channel = weechat_hdata_pointer (hdata_irc_server, *server, "channels");
+    while (*channel)
+    {
+        ptr_name = weechat_hdata_string (hdata_irc_channel, *channel, "name");
+        if (ptr_name && (strcmp (ptr_name, ptr_channel_name) == 0))
+            break;
+        *channel = weechat_hdata_move (hdata_irc_channel, *channel, 1);
+    }
 }
 
 /*
- * Compares a hdata variable of two objects.
+ * Frees the value of a sort key.
+ */
+
+void
+buflist_sort_key_free_value (struct t_buflist_sort_key *sort_key)
+{
+    if (sort_key->set
+        && ((sort_key->type == WEECHAT_HDATA_STRING)
+            || (sort_key->type == WEECHAT_HDATA_SHARED_STRING))
+        && sort_key->value.string_value)
+    {
+        free (sort_key->value.string_value);
+    }
+    sort_key->set = 0;
+    sort_key->type = -1;
+}
+
+/*
+ * Sets a sort key with the value of a hdata variable.
+ */
+
+void
+buflist_sort_key_set (struct t_buflist_sort_key *sort_key,
+                      struct t_hdata *hdata, void *pointer,
+                      const char *variable)
+{
+    const char *pos, *ptr_string;
+
+    sort_key->set = 1;
+
+    pos = strchr (variable, '|');
+    sort_key->type = weechat_hdata_get_var_type (hdata,
+                                                 (pos) ? pos + 1 : variable);
+    switch (sort_key->type)
+    {
+        case WEECHAT_HDATA_CHAR:
+            sort_key->value.char_value = weechat_hdata_char (hdata, pointer,
+                                                             variable);
+            break;
+        case WEECHAT_HDATA_INTEGER:
+            sort_key->value.int_value = weechat_hdata_integer (hdata, pointer,
+                                                               variable);
+            break;
+        case WEECHAT_HDATA_LONG:
+            sort_key->value.long_value = weechat_hdata_long (hdata, pointer,
+                                                             variable);
+            break;
+        case WEECHAT_HDATA_STRING:
+        case WEECHAT_HDATA_SHARED_STRING:
+            ptr_string = weechat_hdata_string (hdata, pointer, variable);
+            sort_key->value.string_value = (ptr_string) ?
+                strdup (ptr_string) : NULL;
+            break;
+        case WEECHAT_HDATA_POINTER:
+            sort_key->value.pointer_value = weechat_hdata_pointer (hdata,
+                                                                   pointer,
+                                                                   variable);
+            break;
+        case WEECHAT_HDATA_TIME:
+            sort_key->value.time_value = weechat_hdata_time (hdata, pointer,
+                                                             variable);
+            break;
+        default:
+            /* unknown variable: field is ignored */
+            sort_key->type = -1;
+            break;
+    }
+}
+
+/*
+ * Compares two sort keys.
  *
  * Returns:
- *   -1: variable1 < variable2
- *    0: variable1 == variable2
- *    1: variable1 > variable2
+ *   -1: key1 < key2
+ *    0: key1 == key2
+ *    1: key1 > key2
  */
 
 int
-buflist_compare_hdata_var (struct t_hdata *hdata,
-                           void *pointer1, void *pointer2,
-                           const char *variable)
+buflist_sort_key_compare (struct t_buflist_sort_key *sort_key1,
+                          struct t_buflist_sort_key *sort_key2)
 {
-    int type, rc, int_value1, int_value2;
-    long long_value1, long_value2;
-    char char_value1, char_value2;
-    const char *pos, *str_value1, *str_value2;
-    void *ptr_value1, *ptr_value2;
-    time_t time_value1, time_value2;
+    int rc;
+
+    if (!sort_key1->set && !sort_key2->set)
+        return 0;
+    if (sort_key1->set && !sort_key2->set)
+        return 1;
+    if (!sort_key1->set && sort_key2->set)
+        return -1;
+
+    if ((sort_key1->type < 0) || (sort_key1->type != sort_key2->type))
+        return 0;
 
     rc = 0;
 
-    pos = strchr (variable, '|');
-    type = weechat_hdata_get_var_type (hdata, (pos) ? pos + 1 : variable);
-    switch (type)
+    switch (sort_key1->type)
     {
         case WEECHAT_HDATA_CHAR:
-            char_value1 = weechat_hdata_char (hdata, pointer1, variable);
-            char_value2 = weechat_hdata_char (hdata, pointer2, variable);
-            rc = (char_value1 < char_value2) ?
-                -1 : ((char_value1 > char_value2) ? 1 : 0);
+            rc = (sort_key1->value.char_value < sort_key2->value.char_value) ?
+                -1 : ((sort_key1->value.char_value > sort_key2->value.char_value) ?
+                      1 : 0);
             break;
         case WEECHAT_HDATA_INTEGER:
-            int_value1 = weechat_hdata_integer (hdata, pointer1, variable);
-            int_value2 = weechat_hdata_integer (hdata, pointer2, variable);
-            rc = (int_value1 < int_value2) ?
-                -1 : ((int_value1 > int_value2) ? 1 : 0);
+            rc = (sort_key1->value.int_value < sort_key2->value.int_value) ?
+                -1 : ((sort_key1->value.int_value > sort_key2->value.int_value) ?
+                      1 : 0);
             break;
         case WEECHAT_HDATA_LONG:
-            long_value1 = weechat_hdata_long (hdata, pointer1, variable);
-            long_value2 = weechat_hdata_long (hdata, pointer2, variable);
-            rc = (long_value1 < long_value2) ?
-                -1 : ((long_value1 > long_value2) ? 1 : 0);
+            rc = (sort_key1->value.long_value < sort_key2->value.long_value) ?
+                -1 : ((sort_key1->value.long_value > sort_key2->value.long_value) ?
+                      1 : 0);
             break;
         case WEECHAT_HDATA_STRING:
         case WEECHAT_HDATA_SHARED_STRING:
-            str_value1 = weechat_hdata_string (hdata, pointer1, variable);
-            str_value2 = weechat_hdata_string (hdata, pointer2, variable);
-            if (!str_value1 && !str_value2)
+            if (!sort_key1->value.string_value
+                && !sort_key2->value.string_value)
                 rc = 0;
-            else if (str_value1 && !str_value2)
+            else if (sort_key1->value.string_value
+                     && !sort_key2->value.string_value)
                 rc = 1;
-            else if (!str_value1 && str_value2)
+            else if (!sort_key1->value.string_value
+                     && sort_key2->value.string_value)
                 rc = -1;
             else
             {
-                rc = strcmp (str_value1, str_value2);
+                rc = strcmp (sort_key1->value.string_value,
+                             sort_key2->value.string_value);
                 if (rc < 0)
                     rc = -1;
                 else if (rc > 0)
@@ -181,16 +255,14 @@ buflist_compare_hdata_var (struct t_hdata *hdata,
             }
             break;
         case WEECHAT_HDATA_POINTER:
-            ptr_value1 = weechat_hdata_pointer (hdata, pointer1, variable);
-            ptr_value2 = weechat_hdata_pointer (hdata, pointer2, variable);
-            rc = (ptr_value1 < ptr_value2) ?
-                -1 : ((ptr_value1 > ptr_value2) ? 1 : 0);
+            rc = (sort_key1->value.pointer_value < sort_key2->value.pointer_value) ?
+                -1 : ((sort_key1->value.pointer_value > sort_key2->value.pointer_value) ?
+                      1 : 0);
             break;
         case WEECHAT_HDATA_TIME:
-            time_value1 = weechat_hdata_time (hdata, pointer1, variable);
-            time_value2 = weechat_hdata_time (hdata, pointer2, variable);
-            rc = (time_value1 < time_value2) ?
-                -1 : ((time_value1 > time_value2) ? 1 : 0);
+            rc = (sort_key1->value.time_value < sort_key2->value.time_value) ?
+                -1 : ((sort_key1->value.time_value > sort_key2->value.time_value) ?
+                      1 : 0);
             break;
     }
 
@@ -198,132 +270,457 @@ buflist_compare_hdata_var (struct t_hdata *hdata,
 }
 
 /*
- * Compares two buffers in order to add them in the sorted arraylist.
+ * Frees sort keys of a buflist buffer.
+ */
+
+void
+buflist_sort_keys_free (struct t_buflist_buffer *buflist_buffer)
+{
+    int i;
+
+    if (buflist_buffer->sort_keys)
+    {
+        for (i = 0; i < buflist_buffer->sort_keys_count; i++)
+        {
+            buflist_sort_key_free_value (&buflist_buffer->sort_keys[i]);
+        }
+        free (buflist_buffer->sort_keys);
+        buflist_buffer->sort_keys = NULL;
+    }
+    buflist_buffer->sort_keys_count = 0;
+}
+
+/*
+ * Gets values of sort fields (option "buflist.look.sort") for a buffer.
  *
- * The comparison is made using the list of fields defined in the option
- * "buflist.look.sort".
+ * Values are read once here, so that buffers are sorted without reading
+ * hdata variables for each comparison.
  *
  * Returns:
- *   -1: buffer1 < buffer2
- *    0: buffer1 == buffer2
- *    1: buffer1 > buffer2
+ *   1: sort keys have changed (or are new)
+ *   0: sort keys are the same as before
  */
 
 int
-buflist_compare_buffers (void *data, struct t_arraylist *arraylist,
-                         void *pointer1, void *pointer2)
+buflist_sort_keys_get (struct t_buflist_buffer *buflist_buffer)
 {
-    int i, reverse, rc;
-    const char *ptr_field;
-    struct t_gui_hotlist *ptr_hotlist1, *ptr_hotlist2;
-    struct t_irc_server *ptr_server1, *ptr_server2;
-    struct t_irc_channel *ptr_channel1, *ptr_channel2;
+    struct t_buflist_sort_key *new_sort_keys;
+    struct t_gui_hotlist *ptr_hotlist;
+    struct t_irc_server *ptr_server;
+    struct t_irc_channel *ptr_channel;
     struct t_hdata *hdata_irc_server, *hdata_irc_channel;
+    const char *ptr_field;
+    int i, irc_pointers, changed;
 
-    /* make C compiler happy */
-    (void) data;
-    (void) arraylist;
+    new_sort_keys = NULL;
+    if (buflist_config_sort_fields_count > 0)
+    {
+        new_sort_keys = malloc (buflist_config_sort_fields_count *
+                                sizeof (*new_sort_keys));
+        if (!new_sort_keys)
+        {
+            buflist_sort_keys_free (buflist_buffer);
+            return 1;
+        }
+    }
 
-    hdata_irc_server = weechat_hdata_get ("irc_server");
-    hdata_irc_channel = weechat_hdata_get ("irc_channel");
+    hdata_irc_server = NULL;
+    hdata_irc_channel = NULL;
+    ptr_server = NULL;
+    ptr_channel = NULL;
+    irc_pointers = 0;
 
     for (i = 0; i < buflist_config_sort_fields_count; i++)
     {
-        rc = 0;
-        reverse = 1;
-        if (buflist_config_sort_fields[i][0] == '-')
-        {
-            ptr_field = buflist_config_sort_fields[i] + 1;
-            reverse = -1;
-        }
-        else
-        {
-            ptr_field = buflist_config_sort_fields[i];
-        }
+        new_sort_keys[i].set = 1;
+        new_sort_keys[i].type = -1;
+        ptr_field = buflist_config_sort_fields[i];
+        if (ptr_field[0] == '-')
+            ptr_field++;
         if (strncmp (ptr_field, "hotlist.", 8) == 0)
         {
-            ptr_hotlist1 = weechat_hdata_pointer (buflist_hdata_buffer,
-                                                  pointer1, "hotlist");
-            ptr_hotlist2 = weechat_hdata_pointer (buflist_hdata_buffer,
-                                                  pointer2, "hotlist");
-            if (!ptr_hotlist1 && !ptr_hotlist2)
-                rc = 0;
-            else if (ptr_hotlist1 && !ptr_hotlist2)
-                rc = 1;
-            else if (!ptr_hotlist1 && ptr_hotlist2)
-                rc = -1;
+            ptr_hotlist = weechat_hdata_pointer (buflist_hdata_buffer,
+                                                 buflist_buffer->buffer,
+                                                 "hotlist");
+            if (ptr_hotlist)
+            {
+                buflist_sort_key_set (&new_sort_keys[i],
+                                      buflist_hdata_hotlist, ptr_hotlist,
+                                      ptr_field + 8);
+            }
             else
             {
-                rc = buflist_compare_hdata_var (buflist_hdata_hotlist,
-                                                pointer1, pointer2,
-                                                ptr_field + 8);
+                new_sort_keys[i].set = 0;
             }
         }
-        else if (strncmp (ptr_field, "irc_server.", 11) == 0)
+        else if ((strncmp (ptr_field, "irc_server.", 11) == 0)
+                 || (strncmp (ptr_field, "irc_channel.", 12) == 0))
         {
-            if (hdata_irc_server)
+            if (!irc_pointers)
             {
-                buflist_buffer_get_irc_pointers (pointer1,
-                                                 &ptr_server1, &ptr_channel1);
-                buflist_buffer_get_irc_pointers (pointer2,
-                                                 &ptr_server2, &ptr_channel2);
-                rc = buflist_compare_hdata_var (hdata_irc_server,
-                                                ptr_server1, ptr_server2,
-                                                ptr_field + 11);
+                hdata_irc_server = weechat_hdata_get ("irc_server");
+                hdata_irc_channel = weechat_hdata_get ("irc_channel");
+                buflist_buffer_get_irc_pointers (buflist_buffer->buffer,
+                                                 &ptr_server, &ptr_channel);
+                irc_pointers = 1;
             }
-        }
-        else if (strncmp (ptr_field, "irc_channel.", 12) == 0)
-        {
-            if (hdata_irc_channel)
+            if (ptr_field[4] == 's')
+            {
+                if (hdata_irc_server)
+                {
+                    buflist_sort_key_set (&new_sort_keys[i],
+                                          hdata_irc_server, ptr_server,
+                                          ptr_field + 11);
+                }
+            }
+            else
             {
-                buflist_buffer_get_irc_pointers (pointer1,
-                                                 &ptr_server1, &ptr_channel1);
-                buflist_buffer_get_irc_pointers (pointer2,
-                                                 &ptr_server2, &ptr_channel2);
-                rc = buflist_compare_hdata_var (hdata_irc_channel,
-                                                ptr_channel1, ptr_channel2,
-                                                ptr_field + 12);
+                if (hdata_irc_channel)
+                {
+                    buflist_sort_key_set (&new_sort_keys[i],
+                                          hdata_irc_channel, ptr_channel,
+                                          ptr_field + 12);
+                }
             }
         }
         else
         {
-            rc = buflist_compare_hdata_var (buflist_hdata_buffer,
-                                            pointer1, pointer2,
-                                            ptr_field);
+            buflist_sort_key_set (&new_sort_keys[i],
+                                  buflist_hdata_buffer, buflist_buffer->buffer,
+                                  ptr_field);
+        }
+    }
+
+    /* compare with old keys */
+    changed = 0;
+    if (!buflist_buffer->sort_keys
+        || (buflist_buffer->sort_keys_count != buflist_config_sort_fields_count))
+    {
+        changed = 1;
+    }
+    else
+    {
+        for (i = 0; i < buflist_config_sort_fields_count; i++)
+        {
+            if ((buflist_buffer->sort_keys[i].set != new_sort_keys[i].set)
+                || (buflist_buffer->sort_keys[i].type != new_sort_keys[i].type)
+                || (buflist_sort_key_compare (&buflist_buffer->sort_keys[i],
+                                              &new_sort_keys[i]) != 0))
+            {
+                changed = 1;
+                break;
+            }
         }
-        rc *= reverse;
+    }
+
+    buflist_sort_keys_free (buflist_buffer);
+    buflist_buffer->sort_keys = new_sort_keys;
+    buflist_buffer->sort_keys_count = buflist_config_sort_fields_count;
+
+    return changed;
+}
+
+/*
+ * Compares two buflist buffers in order to add them in the sorted arraylist.
+ *
+ * The comparison is made using the sort keys of buffers (values of fields
+ * defined in the option "buflist.look.sort").
+ *
+ * Buffers with same values for all sort fields are sorted by their index in
+ * list of buffers, so that the result is the same when only some buffers
+ * are moved in the sorted arraylist.
+ *
+ * Returns:
+ *   -1: buffer1 < buffer2
+ *    0: buffer1 == buffer2
+ *    1: buffer1 > buffer2
+ */
+
+int
+buflist_compare_buflist_buffers (void *data, struct t_arraylist *arraylist,
+                                 void *pointer1, void *pointer2)
+{
+    struct t_buflist_buffer *ptr_buflist_buffer1, *ptr_buflist_buffer2;
+    int i, count, rc;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) arraylist;
+
+    ptr_buflist_buffer1 = (struct t_buflist_buffer *)pointer1;
+    ptr_buflist_buffer2 = (struct t_buflist_buffer *)pointer2;
+
+    count = (ptr_buflist_buffer1->sort_keys_count < ptr_buflist_buffer2->sort_keys_count) ?
+        ptr_buflist_buffer1->sort_keys_count : ptr_buflist_buffer2->sort_keys_count;
+    if (count > buflist_config_sort_fields_count)
+        count = buflist_config_sort_fields_count;
+
+    for (i = 0; i < count; i++)
+    {
+        rc = buflist_sort_key_compare (&ptr_buflist_buffer1->sort_keys[i],
+                                       &ptr_buflist_buffer2->sort_keys[i]);
+        if (buflist_config_sort_fields[i][0] == '-')
+            rc *= -1;
         if (rc != 0)
             return rc;
     }
 
-    return rc;
+    return (ptr_buflist_buffer1->index < ptr_buflist_buffer2->index) ?
+        -1 : ((ptr_buflist_buffer1->index > ptr_buflist_buffer2->index) ?
+              1 : 0);
 }
 
 /*
- * Builds a list of pointers to buffers, sorted according to option
- * "buflist.look.sort".
+ * Frees a buflist buffer.
+ */
+
+void
+buflist_buffer_free_value_cb (struct t_hashtable *hashtable,
+                              const void *key, void *value)
+{
+    struct t_buflist_buffer *ptr_buflist_buffer;
+
+    /* make C compiler happy */
+    (void) hashtable;
+    (void) key;
+
+    ptr_buflist_buffer = (struct t_buflist_buffer *)value;
+    if (!ptr_buflist_buffer)
+        return;
+
+    if (ptr_buflist_buffer->vars_conditions)
+        free (ptr_buflist_buffer->vars_conditions);
+    if (ptr_buflist_buffer->vars_line)
+        free (ptr_buflist_buffer->vars_line);
+    if (ptr_buflist_buffer->line)
+        free (ptr_buflist_buffer->line);
+    buflist_sort_keys_free (ptr_buflist_buffer);
+
+    free (ptr_buflist_buffer);
+}
+
+/*
+ * Asks for evaluation of the line of a buffer on next refresh of buflist.
  *
- * Returns an arraylist that must be freed by weechat_arraylist_free after use.
+ * If sort == 1, the position of buffer in sorted list is checked again.
+ */
+
+void
+buflist_buffer_refresh (struct t_gui_buffer *buffer, int sort)
+{
+    struct t_buflist_buffer *ptr_buflist_buffer;
+
+    if (!buflist_buffers || !buffer)
+        return;
+
+    ptr_buflist_buffer = weechat_hashtable_get (buflist_buffers, buffer);
+    if (ptr_buflist_buffer)
+    {
+        ptr_buflist_buffer->refresh = 1;
+        if (sort)
+            ptr_buflist_buffer->sort_refresh = 1;
+    }
+}
+
+/*
+ * Asks for evaluation of the lines of all buffers and sort of all buffers on
+ * next refresh of buflist.
+ */
+
+void
+buflist_buffer_refresh_all ()
+{
+    struct t_buflist_buffer *ptr_buflist_buffer;
+    int i;
+
+    buflist_sort_refresh = 1;
+
+    if (!buflist_buffers_sorted)
+        return;
+
+    for (i = 0; i < weechat_arraylist_size (buflist_buffers_sorted); i++)
+    {
+        ptr_buflist_buffer = weechat_arraylist_get (buflist_buffers_sorted, i);
+        ptr_buflist_buffer->refresh = 1;
+    }
+}
+
+/*
+ * Returns the sorted list of buflist buffers (struct t_buflist_buffer),
+ * according to option "buflist.look.sort".
+ *
+ * The list is kept between two calls: all buffers are sorted again only if
+ * asked (by buflist_buffer_refresh_all), otherwise sort keys are read again
+ * for buffers with sort_refresh == 1 (or all buffers if
+ * buflist_sort_refresh_keys == 1), and only buffers with new sort keys are
+ * moved in the list.
+ *
+ * Note: the arraylist returned must NOT be freed.
  */
 
 struct t_arraylist *
 buflist_sort_buffers ()
 {
-    struct t_arraylist *buffers;
     struct t_gui_buffer *ptr_buffer;
+    struct t_buflist_buffer *ptr_buflist_buffer;
+    struct t_arraylist *list_moved;
+    int i, index, sort_all;
 
-    buffers = weechat_arraylist_new (128, 1, 1,
-                                     &buflist_compare_buffers, NULL,
-                                     NULL, NULL);
+    if (!buflist_buffers)
+    {
+        buflist_buffers = weechat_hashtable_new (128,
+                                                 WEECHAT_HASHTABLE_POINTER,
+                                                 WEECHAT_HASHTABLE_POINTER,
+                                                 NULL, NULL);
+        if (!buflist_buffers)
+            return NULL;
+        weechat_hashtable_set_pointer (buflist_buffers,
+                                       "callback_free_value",
+                                       &buflist_buffer_free_value_cb);
+        buflist_sort_refresh = 1;
+    }
+    if (!buflist_buffers_sorted)
+    {
+        buflist_buffers_sorted = weechat_arraylist_new (
+            128, 1, 1,
+            &buflist_compare_buflist_buffers, NULL,
+            NULL, NULL);
+        if (!buflist_buffers_sorted)
+            return NULL;
+        buflist_sort_refresh = 1;
+    }
+
+    list_moved = weechat_arraylist_new (16, 0, 1, NULL, NULL, NULL, NULL);
+    if (!list_moved)
+        return NULL;
 
+    /* add new buffers and update index of buffers */
+    index = 0;
     ptr_buffer = weechat_hdata_get_list (buflist_hdata_buffer, "gui_buffers");
     while (ptr_buffer)
     {
-        weechat_arraylist_add (buffers, ptr_buffer);
+        ptr_buflist_buffer = weechat_hashtable_get (buflist_buffers,
+                                                    ptr_buffer);
+        if (!ptr_buflist_buffer)
+        {
+            ptr_buflist_buffer = malloc (sizeof (*ptr_buflist_buffer));
+            if (ptr_buflist_buffer)
+            {
+                ptr_buflist_buffer->buffer = ptr_buffer;
+                ptr_buflist_buffer->index = index;
+                ptr_buflist_buffer->found = 0;
+                ptr_buflist_buffer->refresh = 1;
+                ptr_buflist_buffer->sort_refresh = 0;
+                ptr_buflist_buffer->displayed = 0;
+                ptr_buflist_buffer->vars_conditions = NULL;
+                ptr_buflist_buffer->vars_line = NULL;
+                ptr_buflist_buffer->line = NULL;
+                ptr_buflist_buffer->sort_keys = NULL;
+                ptr_buflist_buffer->sort_keys_count = 0;
+                weechat_hashtable_set (buflist_buffers,
+                                       ptr_buffer, ptr_buflist_buffer);
+                weechat_arraylist_add (list_moved, ptr_buflist_buffer);
+            }
+        }
+        if (ptr_buflist_buffer)
+        {
+            if (ptr_buflist_buffer->index != index)
+            {
+                /* buffer must be moved, even if sort keys are the same */
+                ptr_buflist_buffer->index = index;
+                ptr_buflist_buffer->sort_refresh = 1;
+                buflist_sort_keys_free (ptr_buflist_buffer);
+            }
+            ptr_buflist_buffer->found = 1;
+        }
+        index++;
         ptr_buffer = weechat_hdata_move (buflist_hdata_buffer, ptr_buffer, 1);
     }
 
-    return buffers;
+    /*
+     * remove closed buffers, and buffers with new sort keys (they are added
+     * again below, if all buffers are not sorted again)
+     */
+    i = 0;
+    while (i < weechat_arraylist_size (buflist_buffers_sorted))
+    {
+        ptr_buflist_buffer = weechat_arraylist_get (buflist_buffers_sorted, i);
+        if (!ptr_buflist_buffer->found)
+        {
+            weechat_arraylist_remove (buflist_buffers_sorted, i);
+            weechat_hashtable_remove (buflist_buffers,
+                                      ptr_buflist_buffer->buffer);
+        }
+        else if (!buflist_sort_refresh
+                 && (ptr_buflist_buffer->sort_refresh
+                     || buflist_sort_refresh_keys)
+                 && buflist_sort_keys_get (ptr_buflist_buffer))
+        {
+            weechat_arraylist_remove (buflist_buffers_sorted, i);
+            weechat_arraylist_add (list_moved, ptr_buflist_buffer);
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    sort_all = buflist_sort_refresh;
+    if (sort_all)
+    {
+        /* sort all buffers */
+        for (i = 0; i < weechat_arraylist_size (buflist_buffers_sorted); i++)
+        {
+            weechat_arraylist_add (list_moved,
+                                   weechat_arraylist_get (
+                                       buflist_buffers_sorted, i));
+        }
+        weechat_arraylist_clear (buflist_buffers_sorted);
+        buflist_sort_refresh = 0;
+    }
+
+    /* add buffers in sorted list */
+    for (i = 0; i < weechat_arraylist_size (list_moved); i++)
+    {
+        ptr_buflist_buffer = weechat_arraylist_get (list_moved, i);
+        if (sort_all || !ptr_buflist_buffer->sort_keys)
+            (void) buflist_sort_keys_get (ptr_buflist_buffer);
+        weechat_arraylist_add (buflist_buffers_sorted, ptr_buflist_buffer);
+    }
+
+    buflist_sort_refresh_keys = 0;
+
+    /* reset flags for next sort */
+    for (i = 0; i < weechat_arraylist_size (buflist_buffers_sorted); i++)
+    {
+        ptr_buflist_buffer = weechat_arraylist_get (buflist_buffers_sorted, i);
+        ptr_buflist_buffer->found = 0;
+        ptr_buflist_buffer->sort_refresh = 0;
+    }
+
+    weechat_arraylist_free (list_moved);
+
+    return buflist_buffers_sorted;
+}
+
+/*
+ * Frees all buflist buffers.
+ */
+
+void
+buflist_buffer_free_all ()
+{
+    if (buflist_buffers_sorted)
+    {
+        weechat_arraylist_free (buflist_buffers_sorted);
+        buflist_buffers_sorted = NULL;
+    }
+    if (buflist_buffers)
+    {
+        weechat_hashtable_free (buflist_buffers);
+        buflist_buffers = NULL;
+    }
+    buflist_sort_refresh = 1;
 }
 
 /*
@@ -378,6 +775,8 @@ weechat_plugin_end (struct t_weechat_plugin *plugin)
 
     buflist_bar_item_end ();
 
+    buflist_buffer_free_all ();
+
     buflist_config_write ();
     buflist_config_free ();
 
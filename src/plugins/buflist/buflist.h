@@ -29,15 +29,59 @@
 struct t_irc_server;
 struct t_irc_channel;
 
+/* value of a sort field for a buffer (option buflist.look.sort) */
+
+struct t_buflist_sort_key
+{
+    int set;                           /* 0 if there is no object for field */
+                                       /* (buffer without hotlist)          */
+    int type;                          /* type of value (hdata type, -1 if  */
+                                       /* field is ignored)                 */
+    union
+    {
+        char char_value;               /* value for type "char"             */
+        int int_value;                 /* value for type "integer"          */
+        long long_value;               /* value for type "long"             */
+        char *string_value;            /* value for type "string"           */
+        void *pointer_value;           /* value for type "pointer"          */
+        time_t time_value;             /* value for type "time"             */
+    } value;
+};
+
+/* buffer in buflist (with last line displayed for this buffer) */
+
+struct t_buflist_buffer
+{
+    struct t_gui_buffer *buffer;       /* pointer to buffer                 */
+    int index;                         /* index in list of buffers          */
+    int found;                         /* 1 if buffer was found in list of  */
+                                       /* buffers (0 if buffer is closed)   */
+    int refresh;                       /* 1 if line must be evaluated again */
+    int sort_refresh;                  /* 1 if position in sorted list must */
+                                       /* be checked again                  */
+    int displayed;                     /* 1 if buffer is displayed          */
+                                       /* (result of display conditions)    */
+    struct t_buflist_sort_key *sort_keys; /* values of sort fields          */
+    int sort_keys_count;               /* number of sort keys               */
+    char *vars_conditions;             /* variables used for conditions     */
+    char *vars_line;                   /* variables used for line           */
+    char *line;                        /* line displayed for buffer         */
+};
+
 extern struct t_weechat_plugin *weechat_buflist_plugin;
 
 extern struct t_hdata *buflist_hdata_buffer;
 extern struct t_hdata *buflist_hdata_hotlist;
+extern int buflist_sort_refresh;
+extern int buflist_sort_refresh_keys;
 
 extern void buflist_buffer_get_irc_pointers(struct t_gui_buffer *buffer,
                                             struct t_irc_server **server,
                                             struct t_irc_channel **channel);
 extern struct t_gui_hotlist *buflist_search_hotlist_for_buffer (struct t_gui_buffer *buffer);
+extern void buflist_buffer_refresh (struct t_gui_buffer *buffer,
+                                    int sort);
+extern void buflist_buffer_refresh_all ();
 extern struct t_arraylist *buflist_sort_buffers ();
 
 #endif /* WEECHAT_BUFLIST_H */
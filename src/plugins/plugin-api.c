@@ -1140,6 +1140,9 @@ plugin_api_infolist_buffer_cb (const void *pointer, void *data,
 /*
  * Returns WeeChat infolist "buffer_lines".
  *
+ * If arguments are set, only lines with this text in prefix or message are
+ * returned (case insensitive search).
+ *
  * Note: result must be freed after use with function weechat_infolist_free().
  */
 
@@ -1150,12 +1153,12 @@ plugin_api_infolist_buffer_lines_cb (const void *pointer, void *data,
 {
     struct t_infolist *ptr_infolist;
     struct t_gui_line *ptr_line;
+    struct t_gui_line_index index;
 
     /* make C compiler happy */
     (void) pointer;
     (void) data;
     (void) infolist_name;
-    (void) arguments;
 
     if (!obj_pointer)
         obj_pointer = gui_buffers;
@@ -1170,9 +1173,19 @@ plugin_api_infolist_buffer_lines_cb (const void *pointer, void *data,
     if (!ptr_infolist)
         return NULL;
 
+    gui_line_uncompress (obj_pointer);
+
+    if (arguments && arguments[0])
+        gui_line_index_compute (&index, arguments, arguments, 0);
+
     for (ptr_line = ((struct t_gui_buffer *)obj_pointer)->own_lines->first_line;
          ptr_line; ptr_line = ptr_line->next_line)
     {
+        if (arguments && arguments[0]
+            && !gui_line_has_text (ptr_line->data, &index, arguments))
+        {
+            continue;
+        }
         if (!gui_line_add_to_infolist (ptr_infolist,
                                        ((struct t_gui_buffer *)obj_pointer)->own_lines,
                                        ptr_line))
@@ -1998,7 +2011,8 @@ plugin_api_init ()
     hook_infolist (NULL, "buffer_lines",
                    N_("lines of a buffer"),
                    N_("buffer pointer"),
-                   NULL,
+                   N_("text to search in prefix or message (case insensitive), "
+                      "to get only lines with this text (optional)"),
                    &plugin_api_infolist_buffer_lines_cb, NULL, NULL);
     hook_infolist (NULL, "filter",
                    N_("list of filters"),
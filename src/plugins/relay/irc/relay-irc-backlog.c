@@ -0,0 +1,1035 @@
+/*
+ * relay-irc-backlog.c - backlog of IRC channels for relay to client
+ *
+ * Copyright (C) 2003-2017 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The backlog of each channel buffer is built on first use (when a client
+ * joins the channel), with the lines of buffer, then it is updated each
+ * time a line is printed in buffer (until the buffer is cleared or closed).
+ *
+ * Each line is rendered only once as IRC message(s), so that sending the
+ * backlog to a client is just a copy of these messages in the socket.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../weechat-plugin.h"
+#include "../relay.h"
+#include "relay-irc.h"
+#include "relay-irc-backlog.h"
+#include "../relay-client.h"
+#include "../relay-config.h"
+#include "../relay-server.h"
+
+
+struct t_hashtable *relay_irc_backlog_hashtable = NULL; /* buffer -> backlog */
+struct t_hook *relay_irc_backlog_hook_print = NULL;
+struct t_hook *relay_irc_backlog_hook_signal_closing = NULL;
+struct t_hook *relay_irc_backlog_hook_signal_cleared = NULL;
+
+
+/*
+ * Gets info about a line using its tags.
+ *
+ * Arguments irc_command and irc_action must be non NULL, the other arguments
+ * can be NULL.
+ *
+ * Returns the IRC command (RELAY_IRC_CMD_XXX), -1 if the line must not be
+ * sent in backlog.
+ */
+
+int
+relay_irc_backlog_parse_tags (int tags_count, const char **tags,
+                              int *irc_action,
+                              const char **nick, const char **nick1,
+                              const char **nick2, const char **host)
+{
+    int i, command, all_tags;
+
+    command = -1;
+    *irc_action = 0;
+    if (nick)
+        *nick = NULL;
+    if (nick1)
+        *nick1 = NULL;
+    if (nick2)
+        *nick2 = NULL;
+    if (host)
+        *host = NULL;
+
+    all_tags = weechat_hashtable_has_key (relay_config_hashtable_irc_backlog_tags,
+                                          "*");
+    for (i = 0; i < tags_count; i++)
+    {
+        if (!tags[i])
+            continue;
+        if (strcmp (tags[i], "irc_action") == 0)
+            *irc_action = 1;
+        else if (strncmp (tags[i], "nick_", 5) == 0)
+        {
+            if (nick)
+                *nick = tags[i] + 5;
+        }
+        else if (strncmp (tags[i], "irc_nick1_", 10) == 0)
+        {
+            if (nick1)
+                *nick1 = tags[i] + 10;
+        }
+        else if (strncmp (tags[i], "irc_nick2_", 10) == 0)
+        {
+            if (nick2)
+                *nick2 = tags[i] + 10;
+        }
+        else if (strncmp (tags[i], "host_", 5) == 0)
+        {
+            if (host)
+                *host = tags[i] + 5;
+        }
+        else if ((command < 0)
+                 && (all_tags
+                     || (weechat_hashtable_has_key (relay_config_hashtable_irc_backlog_tags,
+                                                    tags[i]))))
+        {
+            command = relay_irc_search_backlog_commands_tags (tags[i]);
+        }
+    }
+
+    return command;
+}
+
+/*
+ * Splits an IRC message (if it is too long) and adds the message(s) in a
+ * dynamic string, each one followed by "\r\n".
+ */
+
+void
+relay_irc_backlog_split_message (char **irc_messages, const char *server,
+                                 const char *message)
+{
+    struct t_hashtable *hashtable_in, *hashtable_out;
+    const char *str_message;
+    char hash_key[32];
+    int number;
+
+    hashtable_out = NULL;
+
+    hashtable_in = weechat_hashtable_new (32,
+                                          WEECHAT_HASHTABLE_STRING,
+                                          WEECHAT_HASHTABLE_STRING,
+                                          NULL, NULL);
+    if (hashtable_in)
+    {
+        weechat_hashtable_set (hashtable_in, "server", server);
+        weechat_hashtable_set (hashtable_in, "message", message);
+        hashtable_out = weechat_info_get_hashtable ("irc_message_split",
+                                                    hashtable_in);
+        weechat_hashtable_free (hashtable_in);
+    }
+
+    if (!hashtable_out)
+    {
+        /* IRC plugin not available: keep message as-is */
+        weechat_string_dyn_concat (irc_messages, message);
+        weechat_string_dyn_concat (irc_messages, "\r\n");
+        return;
+    }
+
+    number = 1;
+    while (1)
+    {
+        snprintf (hash_key, sizeof (hash_key), "msg%d", number);
+        str_message = weechat_hashtable_get (hashtable_out, hash_key);
+        if (!str_message)
+            break;
+        weechat_string_dyn_concat (irc_messages, str_message);
+        weechat_string_dyn_concat (irc_messages, "\r\n");
+        number++;
+    }
+
+    weechat_hashtable_free (hashtable_out);
+}
+
+/*
+ * Renders a backlog line as IRC message(s) (without tags).
+ *
+ * Returns the IRC message(s), each one ending with "\r\n", NULL if the line
+ * can not be sent.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+relay_irc_backlog_render (struct t_relay_irc_backlog *backlog,
+                          struct t_relay_irc_backlog_line *line,
+                          const char *nick1, const char *nick2)
+{
+    char **message, **irc_messages, *result;
+    const char *server;
+
+    switch (line->irc_command)
+    {
+        case RELAY_IRC_CMD_NICK:
+            if (!nick1 || !nick2)
+                return NULL;
+            break;
+        case RELAY_IRC_CMD_PRIVMSG:
+            if (!line->nick || !line->message)
+                return NULL;
+            break;
+        default:
+            break;
+    }
+
+    message = weechat_string_dyn_alloc (256);
+    if (!message)
+        return NULL;
+
+    weechat_string_dyn_concat (message, ":");
+    if (line->irc_command == RELAY_IRC_CMD_NICK)
+    {
+        weechat_string_dyn_concat (message, nick1);
+        weechat_string_dyn_concat (message, " NICK :");
+        weechat_string_dyn_concat (message, nick2);
+    }
+    else
+    {
+        weechat_string_dyn_concat (message, line->nick);
+        if (line->host)
+        {
+            weechat_string_dyn_concat (message, "!");
+            weechat_string_dyn_concat (message, line->host);
+        }
+        switch (line->irc_command)
+        {
+            case RELAY_IRC_CMD_JOIN:
+                weechat_string_dyn_concat (message, " JOIN :");
+                weechat_string_dyn_concat (message, backlog->channel);
+                break;
+            case RELAY_IRC_CMD_PART:
+                weechat_string_dyn_concat (message, " PART ");
+                weechat_string_dyn_concat (message, backlog->channel);
+                break;
+            case RELAY_IRC_CMD_QUIT:
+                weechat_string_dyn_concat (message, " QUIT");
+                break;
+            case RELAY_IRC_CMD_PRIVMSG:
+                weechat_string_dyn_concat (message, " PRIVMSG ");
+                weechat_string_dyn_concat (message, backlog->channel);
+                weechat_string_dyn_concat (message, " :");
+                if (line->irc_action)
+                    weechat_string_dyn_concat (message, "\01ACTION ");
+                weechat_string_dyn_concat (message, line->message);
+                if (line->irc_action)
+                    weechat_string_dyn_concat (message, "\01");
+                break;
+        }
+    }
+
+    irc_messages = weechat_string_dyn_alloc (256);
+    if (!irc_messages)
+    {
+        weechat_string_dyn_free (message, 1);
+        return NULL;
+    }
+    server = weechat_buffer_get_string (backlog->buffer, "localvar_server");
+    relay_irc_backlog_split_message (irc_messages, server, *message);
+    weechat_string_dyn_free (message, 1);
+
+    result = weechat_string_dyn_free (irc_messages, 0);
+    if (result && !result[0])
+    {
+        free (result);
+        result = NULL;
+    }
+
+    return result;
+}
+
+/*
+ * Frees a backlog line.
+ */
+
+void
+relay_irc_backlog_line_free (struct t_relay_irc_backlog_line *line)
+{
+    if (line->nick)
+        free (line->nick);
+    if (line->host)
+        free (line->host);
+    if (line->message)
+        free (line->message);
+    if (line->tags)
+        free (line->tags);
+    if (line->irc_messages)
+        free (line->irc_messages);
+}
+
+/*
+ * Removes the oldest line in a backlog.
+ */
+
+void
+relay_irc_backlog_remove_first_line (struct t_relay_irc_backlog *backlog)
+{
+    if (backlog->lines_count == 0)
+        return;
+
+    relay_irc_backlog_line_free (&(backlog->lines[backlog->first_line]));
+    backlog->first_line = (backlog->first_line + 1) % backlog->lines_size;
+    backlog->lines_count--;
+}
+
+/*
+ * Returns a line in backlog (index 0 is the oldest line).
+ */
+
+struct t_relay_irc_backlog_line *
+relay_irc_backlog_get_line (struct t_relay_irc_backlog *backlog, int index)
+{
+    return &(backlog->lines[(backlog->first_line + index) % backlog->lines_size]);
+}
+
+/*
+ * Removes old lines in a backlog: lines older than the max minutes and lines
+ * exceeding the max number (options relay.irc.backlog_max_minutes and
+ * relay.irc.backlog_max_number), and lines which are not in buffer any more.
+ *
+ * Lines not in buffer any more are the lines printed before the first line
+ * of buffer (when there are compressed lines, the first line of buffer is not
+ * readable, so only the number of lines in buffer is checked).
+ *
+ * Argument "new_lines" is the number of lines that will be added in backlog.
+ */
+
+void
+relay_irc_backlog_remove_old_lines (struct t_relay_irc_backlog *backlog,
+                                    int new_lines)
+{
+    struct t_hdata *ptr_hdata_lines;
+    struct t_relay_irc_backlog_line *ptr_first_line;
+    int max_number, max_minutes, buffer_lines_count;
+    time_t date_min, date_printed_min;
+    void *ptr_own_lines, *ptr_line, *ptr_line_data;
+
+    max_number = weechat_config_integer (relay_config_irc_backlog_max_number);
+    max_minutes = weechat_config_integer (relay_config_irc_backlog_max_minutes);
+    date_min = (max_minutes > 0) ? time (NULL) - (max_minutes * 60) : 0;
+
+    buffer_lines_count = -1;
+    date_printed_min = 0;
+    ptr_hdata_lines = weechat_hdata_get ("lines");
+    ptr_own_lines = weechat_hdata_pointer (weechat_hdata_get ("buffer"),
+                                           backlog->buffer, "own_lines");
+    if (ptr_own_lines)
+    {
+        buffer_lines_count = weechat_hdata_integer (ptr_hdata_lines,
+                                                    ptr_own_lines,
+                                                    "lines_count_total");
+        if (buffer_lines_count == weechat_hdata_integer (ptr_hdata_lines,
+                                                         ptr_own_lines,
+                                                         "lines_count"))
+        {
+            ptr_line = weechat_hdata_pointer (ptr_hdata_lines, ptr_own_lines,
+                                              "first_line");
+            ptr_line_data = (ptr_line) ?
+                weechat_hdata_pointer (weechat_hdata_get ("line"),
+                                       ptr_line, "data") : NULL;
+            if (ptr_line_data)
+            {
+                date_printed_min = weechat_hdata_time (
+                    weechat_hdata_get ("line_data"),
+                    ptr_line_data, "date_printed");
+            }
+        }
+    }
+
+    while (backlog->lines_count > 0)
+    {
+        ptr_first_line = relay_irc_backlog_get_line (backlog, 0);
+        if (((max_number > 0)
+             && (backlog->lines_count + new_lines > max_number))
+            || ((date_min > 0) && (ptr_first_line->date < date_min))
+            || ((date_printed_min > 0)
+                && (ptr_first_line->date_printed < date_printed_min))
+            || ((buffer_lines_count >= 0)
+                && (backlog->lines_count + new_lines > buffer_lines_count)))
+        {
+            relay_irc_backlog_remove_first_line (backlog);
+        }
+        else
+            break;
+    }
+}
+
+/*
+ * Adds a line in backlog (only if it is an IRC message that can be sent to
+ * clients).
+ *
+ * Argument "message" must not contain color codes.
+ */
+
+void
+relay_irc_backlog_add_line (struct t_relay_irc_backlog *backlog,
+                            time_t date, time_t date_printed,
+                            int tags_count, const char **tags,
+                            const char *message,
+                            int remove_old_lines)
+{
+    struct t_relay_irc_backlog_line *new_lines, *line;
+    const char *ptr_nick, *ptr_nick1, *ptr_nick2, *ptr_host, *pos;
+    char str_time[128], str_tags[256];
+    int i, command, action, new_size, max_number;
+    struct tm *tm;
+
+    if ((tags_count <= 0) || !message)
+        return;
+
+    command = relay_irc_backlog_parse_tags (tags_count, tags, &action,
+                                            &ptr_nick, &ptr_nick1, &ptr_nick2,
+                                            &ptr_host);
+    if (command < 0)
+        return;
+
+    if (remove_old_lines)
+        relay_irc_backlog_remove_old_lines (backlog, 1);
+
+    /* grow the array if needed (up to max number of lines) */
+    if (backlog->lines_count == backlog->lines_size)
+    {
+        new_size = (backlog->lines_size > 0) ? backlog->lines_size * 2 : 16;
+        max_number = weechat_config_integer (relay_config_irc_backlog_max_number);
+        if ((max_number > 0) && (new_size > max_number))
+            new_size = max_number;
+        if (new_size <= backlog->lines_size)
+            return;
+        new_lines = malloc (new_size * sizeof (*new_lines));
+        if (!new_lines)
+            return;
+        for (i = 0; i < backlog->lines_count; i++)
+        {
+            memcpy (&new_lines[i], relay_irc_backlog_get_line (backlog, i),
+                    sizeof (*new_lines));
+        }
+        if (backlog->lines)
+            free (backlog->lines);
+        backlog->lines = new_lines;
+        backlog->lines_size = new_size;
+        backlog->first_line = 0;
+    }
+
+    line = relay_irc_backlog_get_line (backlog, backlog->lines_count);
+    line->date = date;
+    line->date_printed = date_printed;
+    line->irc_command = command;
+    line->irc_action = action;
+    line->nick = (ptr_nick) ? strdup (ptr_nick) : NULL;
+    line->host = (ptr_host) ? strdup (ptr_host) : NULL;
+    line->message = NULL;
+    if (command == RELAY_IRC_CMD_PRIVMSG)
+    {
+        pos = message;
+        if (action)
+        {
+            /* skip the nick in message */
+            pos = strchr (message, ' ');
+            if (pos)
+            {
+                while (pos[0] == ' ')
+                {
+                    pos++;
+                }
+            }
+            else
+                pos = message;
+        }
+        line->message = strdup (pos);
+    }
+    tm = gmtime (&date);
+    strftime (str_time, sizeof (str_time), "%Y-%m-%dT%H:%M:%S", tm);
+    snprintf (str_tags, sizeof (str_tags), "@time=%s.000Z ", str_time);
+    line->tags = strdup (str_tags);
+    line->irc_messages = relay_irc_backlog_render (backlog, line,
+                                                   ptr_nick1, ptr_nick2);
+
+    backlog->lines_count++;
+}
+
+/*
+ * Adds lines of a line data (read with hdata) in backlog.
+ */
+
+void
+relay_irc_backlog_add_line_data (struct t_relay_irc_backlog *backlog,
+                                 struct t_hdata *hdata_line_data,
+                                 void *line_data)
+{
+    int i, tags_count;
+    const char **tags;
+    char str_tag[64];
+
+    tags_count = weechat_hdata_get_var_array_size (hdata_line_data, line_data,
+                                                   "tags_array");
+    if (tags_count <= 0)
+        return;
+
+    tags = malloc (tags_count * sizeof (*tags));
+    if (!tags)
+        return;
+    for (i = 0; i < tags_count; i++)
+    {
+        snprintf (str_tag, sizeof (str_tag), "%d|tags_array", i);
+        tags[i] = weechat_hdata_string (hdata_line_data, line_data, str_tag);
+    }
+
+    relay_irc_backlog_add_line (backlog,
+                                weechat_hdata_time (hdata_line_data,
+                                                    line_data, "date"),
+                                weechat_hdata_time (hdata_line_data,
+                                                    line_data, "date_printed"),
+                                tags_count, tags,
+                                weechat_hdata_string (hdata_line_data,
+                                                      line_data,
+                                                      "message_no_color"),
+                                0);
+
+    free (tags);
+}
+
+/*
+ * Builds backlog with the lines of buffer (only the last lines, according to
+ * options relay.irc.backlog_max_minutes and relay.irc.backlog_max_number).
+ */
+
+void
+relay_irc_backlog_build (struct t_relay_irc_backlog *backlog)
+{
+    struct t_hdata *ptr_hdata_line, *ptr_hdata_line_data;
+    void *ptr_own_lines, *ptr_line, *ptr_line_data, *ptr_first_line;
+    const char **tags;
+    char str_tag[64];
+    int i, tags_count, action, count, max_number, max_minutes;
+    time_t date_min;
+
+    ptr_own_lines = weechat_hdata_pointer (weechat_hdata_get ("buffer"),
+                                           backlog->buffer, "own_lines");
+    if (!ptr_own_lines)
+        return;
+
+    ptr_hdata_line = weechat_hdata_get ("line");
+    ptr_hdata_line_data = weechat_hdata_get ("line_data");
+    if (!ptr_hdata_line || !ptr_hdata_line_data)
+        return;
+
+    max_number = weechat_config_integer (relay_config_irc_backlog_max_number);
+    max_minutes = weechat_config_integer (relay_config_irc_backlog_max_minutes);
+    date_min = (max_minutes > 0) ? time (NULL) - (max_minutes * 60) : 0;
+
+    /*
+     * loop on lines in buffer, from last to first, and stop when we have
+     * reached max number of lines (or max minutes)
+     */
+    ptr_first_line = NULL;
+    count = 0;
+    ptr_line = weechat_hdata_pointer (weechat_hdata_get ("lines"),
+                                      ptr_own_lines, "last_line");
+    while (ptr_line)
+    {
+        ptr_line_data = weechat_hdata_pointer (ptr_hdata_line,
+                                               ptr_line, "data");
+        if (ptr_line_data)
+        {
+            tags_count = weechat_hdata_get_var_array_size (ptr_hdata_line_data,
+                                                           ptr_line_data,
+                                                           "tags_array");
+            if (tags_count > 0)
+            {
+                tags = malloc (tags_count * sizeof (*tags));
+                if (!tags)
+                    break;
+                for (i = 0; i < tags_count; i++)
+                {
+                    snprintf (str_tag, sizeof (str_tag), "%d|tags_array", i);
+                    tags[i] = weechat_hdata_string (ptr_hdata_line_data,
+                                                    ptr_line_data, str_tag);
+                }
+                if (relay_irc_backlog_parse_tags (tags_count, tags, &action,
+                                                  NULL, NULL, NULL, NULL) >= 0)
+                {
+                    if ((date_min > 0)
+                        && (weechat_hdata_time (ptr_hdata_line_data,
+                                                ptr_line_data,
+                                                "date") < date_min))
+                    {
+                        free (tags);
+                        break;
+                    }
+                    count++;
+                }
+                free (tags);
+                if ((max_number > 0) && (count > max_number))
+                    break;
+            }
+        }
+        ptr_first_line = ptr_line;
+        ptr_line = weechat_hdata_move (ptr_hdata_line, ptr_line, -1);
+    }
+
+    /* add lines in backlog, from oldest to newest */
+    ptr_line = ptr_first_line;
+    while (ptr_line)
+    {
+        ptr_line_data = weechat_hdata_pointer (ptr_hdata_line,
+                                               ptr_line, "data");
+        if (ptr_line_data)
+        {
+            relay_irc_backlog_add_line_data (backlog, ptr_hdata_line_data,
+                                             ptr_line_data);
+        }
+        ptr_line = weechat_hdata_move (ptr_hdata_line, ptr_line, 1);
+    }
+}
+
+/*
+ * Frees a backlog.
+ */
+
+void
+relay_irc_backlog_free (struct t_relay_irc_backlog *backlog)
+{
+    int i;
+
+    if (!backlog)
+        return;
+
+    for (i = 0; i < backlog->lines_count; i++)
+    {
+        relay_irc_backlog_line_free (relay_irc_backlog_get_line (backlog, i));
+    }
+    if (backlog->lines)
+        free (backlog->lines);
+    if (backlog->channel)
+        free (backlog->channel);
+
+    free (backlog);
+}
+
+/*
+ * Callback called to free a backlog when it is removed from hashtable.
+ */
+
+void
+relay_irc_backlog_free_value_cb (struct t_hashtable *hashtable,
+                                 const void *key, void *value)
+{
+    /* make C compiler happy */
+    (void) hashtable;
+    (void) key;
+
+    relay_irc_backlog_free ((struct t_relay_irc_backlog *)value);
+}
+
+/*
+ * Callback for a line printed in a buffer: adds it in backlog of buffer (if
+ * there is a backlog for this buffer).
+ */
+
+int
+relay_irc_backlog_print_cb (const void *pointer, void *data,
+                            struct t_gui_buffer *buffer,
+                            time_t date, int tags_count, const char **tags,
+                            int displayed, int highlight,
+                            const char *prefix, const char *message)
+{
+    struct t_relay_irc_backlog *ptr_backlog;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) displayed;
+    (void) highlight;
+    (void) prefix;
+
+    ptr_backlog = weechat_hashtable_get (relay_irc_backlog_hashtable, buffer);
+    if (ptr_backlog)
+    {
+        relay_irc_backlog_add_line (ptr_backlog, date, time (NULL),
+                                    tags_count, tags, message, 1);
+    }
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Callback for signals "buffer_closing" and "buffer_cleared": removes the
+ * backlog of buffer.
+ */
+
+int
+relay_irc_backlog_signal_buffer_cb (const void *pointer, void *data,
+                                    const char *signal, const char *type_data,
+                                    void *signal_data)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) signal;
+    (void) type_data;
+
+    weechat_hashtable_remove (relay_irc_backlog_hashtable, signal_data);
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Gets the backlog of a buffer, builds it if it does not exist yet.
+ *
+ * Returns pointer to backlog, NULL if error.
+ */
+
+struct t_relay_irc_backlog *
+relay_irc_backlog_get (const char *channel, struct t_gui_buffer *buffer)
+{
+    struct t_relay_irc_backlog *ptr_backlog;
+
+    if (!relay_irc_backlog_hashtable)
+    {
+        relay_irc_backlog_hashtable = weechat_hashtable_new (
+            32,
+            WEECHAT_HASHTABLE_POINTER,
+            WEECHAT_HASHTABLE_POINTER,
+            NULL, NULL);
+        if (!relay_irc_backlog_hashtable)
+            return NULL;
+        weechat_hashtable_set_pointer (relay_irc_backlog_hashtable,
+                                       "callback_free_value",
+                                       &relay_irc_backlog_free_value_cb);
+        relay_irc_backlog_hook_print = weechat_hook_print (
+            NULL, NULL, NULL, 1,
+            &relay_irc_backlog_print_cb, NULL, NULL);
+        relay_irc_backlog_hook_signal_closing = weechat_hook_signal (
+            "buffer_closing",
+            &relay_irc_backlog_signal_buffer_cb, NULL, NULL);
+        relay_irc_backlog_hook_signal_cleared = weechat_hook_signal (
+            "buffer_cleared",
+            &relay_irc_backlog_signal_buffer_cb, NULL, NULL);
+    }
+
+    ptr_backlog = weechat_hashtable_get (relay_irc_backlog_hashtable, buffer);
+    if (ptr_backlog)
+    {
+        /* channel name has changed? then build the backlog again */
+        if (strcmp (ptr_backlog->channel, channel) == 0)
+            return ptr_backlog;
+        weechat_hashtable_remove (relay_irc_backlog_hashtable, buffer);
+    }
+
+    ptr_backlog = malloc (sizeof (*ptr_backlog));
+    if (!ptr_backlog)
+        return NULL;
+    ptr_backlog->buffer = buffer;
+    ptr_backlog->channel = strdup (channel);
+    ptr_backlog->lines_size = 0;
+    ptr_backlog->lines_count = 0;
+    ptr_backlog->first_line = 0;
+    ptr_backlog->lines = NULL;
+    if (!ptr_backlog->channel)
+    {
+        free (ptr_backlog);
+        return NULL;
+    }
+
+    relay_irc_backlog_build (ptr_backlog);
+
+    weechat_hashtable_set (relay_irc_backlog_hashtable, buffer, ptr_backlog);
+
+    return ptr_backlog;
+}
+
+/*
+ * Sends data buffered for a client.
+ */
+
+void
+relay_irc_backlog_send_data (struct t_relay_client *client, char **data)
+{
+    if (!(*data)[0])
+        return;
+
+    relay_client_send (client, RELAY_CLIENT_MSG_STANDARD,
+                       *data, strlen (*data), NULL);
+    weechat_string_dyn_copy (data, NULL);
+}
+
+/*
+ * Sends channel backlog to client.
+ *
+ * The IRC messages are sent in one time to the client (except for a
+ * websocket client, which receives one IRC message by frame).
+ */
+
+void
+relay_irc_backlog_send (struct t_relay_client *client,
+                        const char *channel,
+                        struct t_gui_buffer *buffer)
+{
+    struct t_relay_irc_backlog *ptr_backlog;
+    struct t_relay_irc_backlog_line *ptr_line;
+    struct t_relay_server *ptr_server;
+    const char *localvar_nick, *time_format;
+    char **data, str_time[256], *message;
+    const char *pos, *pos_end;
+    int i, start, count, max_number, max_minutes, server_time;
+    int since_last_message;
+    time_t date_min, date_min2;
+    struct tm *tm;
+
+    ptr_backlog = relay_irc_backlog_get (channel, buffer);
+    if (!ptr_backlog || (ptr_backlog->lines_count == 0))
+        return;
+
+    localvar_nick = weechat_buffer_get_string (buffer, "localvar_nick");
+    since_last_message = weechat_config_boolean (relay_config_irc_backlog_since_last_message);
+
+    max_number = weechat_config_integer (relay_config_irc_backlog_max_number);
+    max_minutes = weechat_config_integer (relay_config_irc_backlog_max_minutes);
+    date_min = (max_minutes > 0) ? time (NULL) - (max_minutes * 60) : 0;
+    if (weechat_config_boolean (relay_config_irc_backlog_since_last_disconnect))
+    {
+        ptr_server = relay_server_search (client->protocol_string);
+        if (ptr_server && (ptr_server->last_client_disconnect > 0))
+        {
+            date_min2 = ptr_server->last_client_disconnect;
+            if (date_min2 > date_min)
+                date_min = date_min2;
+        }
+    }
+
+    /*
+     * loop on lines in backlog, from last to first, and stop when we have
+     * reached max number of lines (or max minutes)
+     */
+    start = 0;
+    count = 0;
+    for (i = ptr_backlog->lines_count - 1; i >= 0; i--)
+    {
+        ptr_line = relay_irc_backlog_get_line (ptr_backlog, i);
+        /* if we have reached max minutes, exit loop */
+        if ((date_min > 0) && (ptr_line->date < date_min))
+        {
+            start = i + 1;
+            break;
+        }
+        count++;
+        /* if we have reached max number of messages, exit loop */
+        if ((max_number > 0) && (count > max_number))
+        {
+            start = i + 1;
+            break;
+        }
+        if (since_last_message
+            && localvar_nick && localvar_nick[0]
+            && ptr_line->nick && (strcmp (ptr_line->nick, localvar_nick) == 0))
+        {
+            /*
+             * stop when we find a line sent by the current nick
+             * (and include this line)
+             */
+            start = i;
+            break;
+        }
+    }
+
+    server_time = RELAY_IRC_DATA(client, server_capabilities) & (1 << RELAY_IRC_CAPAB_SERVER_TIME);
+    time_format = weechat_config_string (relay_config_irc_backlog_time_format);
+
+    data = weechat_string_dyn_alloc (4096);
+    if (!data)
+        return;
+
+    /* send IRC messages from the start line until the end of backlog */
+    for (i = start; i < ptr_backlog->lines_count; i++)
+    {
+        ptr_line = relay_irc_backlog_get_line (ptr_backlog, i);
+        if (!ptr_line->irc_messages)
+            continue;
+
+        /* ignore join/part/quit from self nick */
+        if (((ptr_line->irc_command == RELAY_IRC_CMD_JOIN)
+             || (ptr_line->irc_command == RELAY_IRC_CMD_PART)
+             || (ptr_line->irc_command == RELAY_IRC_CMD_QUIT))
+            && localvar_nick && localvar_nick[0]
+            && ptr_line->nick && (strcmp (ptr_line->nick, localvar_nick) == 0))
+        {
+            continue;
+        }
+
+        if ((ptr_line->irc_command == RELAY_IRC_CMD_PRIVMSG)
+            && !server_time && time_format && time_format[0])
+        {
+            /*
+             * if server capability "server-time" is NOT enabled, and if the
+             * time format is not empty, add time inside message (before
+             * message): the message is built for this client
+             */
+            relay_irc_backlog_send_data (client, data);
+            tm = localtime (&ptr_line->date);
+            strftime (str_time, sizeof (str_time), time_format, tm);
+            relay_irc_sendf (client,
+                             ":%s%s%s PRIVMSG %s :%s%s%s%s",
+                             ptr_line->nick,
+                             (ptr_line->host) ? "!" : "",
+                             (ptr_line->host) ? ptr_line->host : "",
+                             channel,
+                             (ptr_line->irc_action) ? "\01ACTION " : "",
+                             str_time,
+                             ptr_line->message,
+                             (ptr_line->irc_action) ? "\01": "");
+            continue;
+        }
+
+        if (!server_time && !client->websocket)
+        {
+            weechat_string_dyn_concat (data, ptr_line->irc_messages);
+            continue;
+        }
+
+        /*
+         * add each IRC message of line, with tags with time before message
+         * (if server capability "server-time" is enabled); a websocket
+         * client receives one IRC message by frame
+         */
+        pos = ptr_line->irc_messages;
+        while (pos && pos[0])
+        {
+            if (server_time)
+                weechat_string_dyn_concat (data, ptr_line->tags);
+            pos_end = strstr (pos, "\r\n");
+            if (!pos_end || !pos_end[2])
+            {
+                /* last message */
+                weechat_string_dyn_concat (data, pos);
+                pos = NULL;
+            }
+            else
+            {
+                message = weechat_strndup (pos, pos_end + 2 - pos);
+                if (message)
+                {
+                    weechat_string_dyn_concat (data, message);
+                    free (message);
+                }
+                pos = pos_end + 2;
+            }
+            if (client->websocket)
+                relay_irc_backlog_send_data (client, data);
+        }
+    }
+
+    relay_irc_backlog_send_data (client, data);
+
+    weechat_string_dyn_free (data, 1);
+}
+
+/*
+ * Removes all backlogs (they will be built again on next use).
+ *
+ * This is called when an option used to build the backlog is changed.
+ */
+
+void
+relay_irc_backlog_flush ()
+{
+    if (relay_irc_backlog_hashtable)
+        weechat_hashtable_remove_all (relay_irc_backlog_hashtable);
+}
+
+/*
+ * Frees all backlogs and removes hooks.
+ */
+
+void
+relay_irc_backlog_end ()
+{
+    if (relay_irc_backlog_hook_print)
+    {
+        weechat_unhook (relay_irc_backlog_hook_print);
+        relay_irc_backlog_hook_print = NULL;
+    }
+    if (relay_irc_backlog_hook_signal_closing)
+    {
+        weechat_unhook (relay_irc_backlog_hook_signal_closing);
+        relay_irc_backlog_hook_signal_closing = NULL;
+    }
+    if (relay_irc_backlog_hook_signal_cleared)
+    {
+        weechat_unhook (relay_irc_backlog_hook_signal_cleared);
+        relay_irc_backlog_hook_signal_cleared = NULL;
+    }
+    if (relay_irc_backlog_hashtable)
+    {
+        weechat_hashtable_free (relay_irc_backlog_hashtable);
+        relay_irc_backlog_hashtable = NULL;
+    }
+}
+
+/*
+ * Callback used to print a backlog in WeeChat log file.
+ */
+
+void
+relay_irc_backlog_print_log_map_cb (void *data,
+                                    struct t_hashtable *hashtable,
+                                    const void *key, const void *value)
+{
+    struct t_relay_irc_backlog *ptr_backlog;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) hashtable;
+    (void) key;
+
+    ptr_backlog = (struct t_relay_irc_backlog *)value;
+
+    weechat_log_printf ("");
+    weechat_log_printf ("[relay irc backlog (addr:0x%lx)]", ptr_backlog);
+    weechat_log_printf ("  buffer. . . . . . . . : 0x%lx", ptr_backlog->buffer);
+    weechat_log_printf ("  channel . . . . . . . : '%s'",  ptr_backlog->channel);
+    weechat_log_printf ("  lines_size. . . . . . : %d",    ptr_backlog->lines_size);
+    weechat_log_printf ("  lines_count . . . . . : %d",    ptr_backlog->lines_count);
+    weechat_log_printf ("  first_line. . . . . . : %d",    ptr_backlog->first_line);
+    weechat_log_printf ("  lines . . . . . . . . : 0x%lx", ptr_backlog->lines);
+}
+
+/*
+ * Prints backlogs in WeeChat log file (usually for crash dump).
+ */
+
+void
+relay_irc_backlog_print_log ()
+{
+    if (relay_irc_backlog_hashtable)
+    {
+        weechat_hashtable_map (relay_irc_backlog_hashtable,
+                               &relay_irc_backlog_print_log_map_cb, NULL);
+    }
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2003-2017 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WEECHAT_RELAY_IRC_BACKLOG_H
+#define WEECHAT_RELAY_IRC_BACKLOG_H 1
+
+#include <time.h>
+
+struct t_relay_client;
+
+struct t_relay_irc_backlog_line
+{
+    time_t date;                       /* date of line                      */
+    time_t date_printed;               /* date when line was displayed      */
+    int irc_command;                   /* IRC command (RELAY_IRC_CMD_XXX)   */
+    int irc_action;                    /* 1 if message is an action (/me)   */
+    char *nick;                        /* nick (from tag "nick_xxx")        */
+    char *host;                        /* host (from tag "host_xxx")        */
+    char *message;                     /* message (only for PRIVMSG)        */
+    char *tags;                        /* IRC tags with time ("@time=...")  */
+    char *irc_messages;                /* IRC message(s) ready to send,     */
+                                       /* each one ending with "\r\n"       */
+                                       /* (NULL if line is never sent)      */
+};
+
+struct t_relay_irc_backlog
+{
+    struct t_gui_buffer *buffer;       /* channel buffer                    */
+    char *channel;                     /* channel name (used in messages)   */
+    int lines_size;                    /* size of array "lines"             */
+    int lines_count;                   /* number of lines in backlog        */
+    int first_line;                    /* index of first (oldest) line      */
+    struct t_relay_irc_backlog_line *lines; /* lines (circular array)       */
+};
+
+extern void relay_irc_backlog_send (struct t_relay_client *client,
+                                    const char *channel,
+                                    struct t_gui_buffer *buffer);
+extern void relay_irc_backlog_flush ();
+extern void relay_irc_backlog_end ();
+extern void relay_irc_backlog_print_log ();
+
+#endif /* WEECHAT_RELAY_IRC_BACKLOG_H */
@@ -31,6 +31,7 @@
 #include "../../weechat-plugin.h"
 #include "../relay.h"
 #include "relay-irc.h"
+#include "relay-irc-backlog.h"
 #include "../relay-buffer.h"
 #include "../relay-client.h"
 #include "../relay-config.h"
@@ -574,384 +575,6 @@ relay_irc_hsignal_irc_redir_cb (const void *pointer, void *data,
     return WEECHAT_RC_OK;
 }
 
-/*
- * Gets info about a line in a buffer:
- *   - irc command
- *   - date
- *   - nick
- *   - nick1 and nick2 (old and new nick for irc "nick" command)
- *   - host
- *   - message (without colors).
- *
- * Arguments hdata_line_data and line_data must be non NULL, the other arguments
- * can be NULL.
- *
- * Note: tags and message (if given and filled) must be freed after use.
- */
-
-void
-relay_irc_get_line_info (struct t_relay_client *client,
-                         struct t_gui_buffer *buffer,
-                         struct t_hdata *hdata_line_data, void *line_data,
-                         int *irc_command, int *irc_action, time_t *date,
-                         const char **nick, const char **nick1,
-                         const char **nick2, const char **host,
-                         char **tags, char **message)
-{
-    int i, num_tags, command, action, all_tags, length;
-    char str_tag[256], *pos, *message_no_color, str_time[256];
-    const char *ptr_tag, *ptr_message, *ptr_nick, *ptr_nick1, *ptr_nick2;
-    const char *ptr_host, *localvar_nick, *time_format;
-    time_t msg_date;
-    struct tm *tm;
-
-    if (irc_command)
-        *irc_command = -1;
-    if (irc_action)
-        *irc_action = 0;
-    if (date)
-        *date = 0;
-    if (nick)
-        *nick = NULL;
-    if (nick1)
-        *nick1 = NULL;
-    if (nick2)
-        *nick2 = NULL;
-    if (host)
-        *host = NULL;
-    if (tags)
-        *tags = NULL;
-    if (message)
-        *message = NULL;
-
-    msg_date = weechat_hdata_time (hdata_line_data, line_data, "date");
-    num_tags = weechat_hdata_get_var_array_size (hdata_line_data, line_data,
-                                                 "tags_array");
-    ptr_message = weechat_hdata_pointer (hdata_line_data, line_data, "message");
-
-    /* no tag found, or no message? just exit */
-    if ((num_tags <= 0) || !ptr_message)
-        return;
-
-    command = -1;
-    action = 0;
-    ptr_nick = NULL;
-    ptr_nick1 = NULL;
-    ptr_nick2 = NULL;
-    ptr_host = NULL;
-    all_tags = weechat_hashtable_has_key (relay_config_hashtable_irc_backlog_tags,
-                                          "*");
-    for (i = 0; i < num_tags; i++)
-    {
-        snprintf (str_tag, sizeof (str_tag), "%d|tags_array", i);
-        ptr_tag = weechat_hdata_string (hdata_line_data, line_data, str_tag);
-        if (ptr_tag)
-        {
-            if (strcmp (ptr_tag, "irc_action") == 0)
-                action = 1;
-            else if (strncmp (ptr_tag, "nick_", 5) == 0)
-                ptr_nick = ptr_tag + 5;
-            else if (strncmp (ptr_tag, "irc_nick1_", 10) == 0)
-                ptr_nick1 = ptr_tag + 10;
-            else if (strncmp (ptr_tag, "irc_nick2_", 10) == 0)
-                ptr_nick2 = ptr_tag + 10;
-            else if (strncmp (ptr_tag, "host_", 5) == 0)
-                ptr_host = ptr_tag + 5;
-            else if ((command < 0)
-                     && (all_tags
-                         || (weechat_hashtable_has_key (relay_config_hashtable_irc_backlog_tags,
-                                                        ptr_tag))))
-            {
-                command = relay_irc_search_backlog_commands_tags (ptr_tag);
-            }
-        }
-    }
-
-    /* not a supported IRC command? */
-    if (command < 0)
-        return;
-
-    /* ignore join/part/quit from self nick */
-    if ((command == RELAY_IRC_CMD_JOIN) || (command == RELAY_IRC_CMD_PART)
-        || (command == RELAY_IRC_CMD_QUIT))
-    {
-        localvar_nick = weechat_buffer_get_string (buffer, "localvar_nick");
-        if (localvar_nick && localvar_nick[0]
-            && ptr_nick && (strcmp (ptr_nick, localvar_nick) == 0))
-        {
-            return;
-        }
-    }
-
-    /* fills variables with the line data */
-    if (irc_command)
-        *irc_command = command;
-    if (irc_action)
-        *irc_action = action;
-    if (date)
-        *date = msg_date;
-    if (nick)
-        *nick = ptr_nick;
-    if (nick1)
-        *nick1 = ptr_nick1;
-    if (nick2)
-        *nick2 = ptr_nick2;
-    if (host)
-        *host = ptr_host;
-    message_no_color = (ptr_message) ?
-        weechat_string_remove_color (ptr_message, NULL) : NULL;
-
-    if ((command == RELAY_IRC_CMD_PRIVMSG) && message && message_no_color)
-    {
-        pos = message_no_color;
-        if (action)
-        {
-            pos = strchr (message_no_color, ' ');
-            if (pos)
-            {
-                while (pos[0] == ' ')
-                {
-                    pos++;
-                }
-            }
-            else
-                pos = message_no_color;
-        }
-        /*
-         * if server capability "server-time" is NOT enabled, and if the time
-         * format is not empty, add time inside message (before message)
-         */
-        time_format = weechat_config_string (relay_config_irc_backlog_time_format);
-        if (!(RELAY_IRC_DATA(client, server_capabilities) & (1 << RELAY_IRC_CAPAB_SERVER_TIME))
-            && time_format && time_format[0])
-        {
-            tm = localtime (&msg_date);
-            strftime (str_time, sizeof (str_time), time_format, tm);
-            length = strlen (str_time) + strlen (pos) + 1;
-            *message = malloc (length);
-            if (*message)
-                snprintf (*message, length, "%s%s", str_time, pos);
-        }
-        else
-            *message = strdup (pos);
-    }
-
-    /* if server capability "server-time" is enabled, add an irc tag with time */
-    if (tags
-        && (RELAY_IRC_DATA(client, server_capabilities) & (1 << RELAY_IRC_CAPAB_SERVER_TIME)))
-    {
-        tm = gmtime (&msg_date);
-        strftime (str_time, sizeof (str_time), "%Y-%m-%dT%H:%M:%S", tm);
-        snprintf (str_tag, sizeof (str_tag), "@time=%s.000Z ", str_time);
-        *tags = strdup (str_tag);
-    }
-
-    if (message_no_color)
-        free (message_no_color);
-}
-
-/*
- * Sends channel backlog to client.
- */
-
-void
-relay_irc_send_channel_backlog (struct t_relay_client *client,
-                                const char *channel,
-                                struct t_gui_buffer *buffer)
-{
-    struct t_relay_server *ptr_server;
-    void *ptr_own_lines, *ptr_line, *ptr_line_data;
-    void *ptr_hdata_line, *ptr_hdata_line_data;
-    char *tags, *message;
-    const char *ptr_nick, *ptr_nick1, *ptr_nick2, *ptr_host, *localvar_nick;
-    int irc_command, irc_action, count, max_number, max_minutes;
-    time_t date_min, date_min2, date;
-
-    /* get pointer on "own_lines" in buffer */
-    ptr_own_lines = weechat_hdata_pointer (weechat_hdata_get ("buffer"),
-                                           buffer, "own_lines");
-    if (!ptr_own_lines)
-        return;
-
-    /* get pointer on "last_line" in lines */
-    ptr_line = weechat_hdata_pointer (weechat_hdata_get ("lines"),
-                                      ptr_own_lines, "last_line");
-    if (!ptr_line)
-        return;
-
-    /* get hdata "line" */
-    ptr_hdata_line = weechat_hdata_get ("line");
-    if (!ptr_hdata_line)
-        return;
-
-    /* get hdata "line_data" */
-    ptr_hdata_line_data = weechat_hdata_get ("line_data");
-    if (!ptr_hdata_line_data)
-        return;
-
-    localvar_nick = NULL;
-    if (weechat_config_boolean (relay_config_irc_backlog_since_last_message))
-        localvar_nick = weechat_buffer_get_string (buffer, "localvar_nick");
-
-    max_number = weechat_config_integer (relay_config_irc_backlog_max_number);
-    max_minutes = weechat_config_integer (relay_config_irc_backlog_max_minutes);
-    date_min = (max_minutes > 0) ? time (NULL) - (max_minutes * 60) : 0;
-    if (weechat_config_boolean (relay_config_irc_backlog_since_last_disconnect))
-    {
-        ptr_server = relay_server_search (client->protocol_string);
-        if (ptr_server && (ptr_server->last_client_disconnect > 0))
-        {
-            date_min2 = ptr_server->last_client_disconnect;
-            if (date_min2 > date_min)
-                date_min = date_min2;
-        }
-    }
-
-    /*
-     * loop on lines in buffer, from last to first, and stop when we have
-     * reached max number of lines (or max minutes)
-     */
-    count = 0;
-    while (ptr_line)
-    {
-        ptr_line_data = weechat_hdata_pointer (ptr_hdata_line,
-                                               ptr_line, "data");
-        if (ptr_line_data)
-        {
-            relay_irc_get_line_info (client, buffer,
-                                     ptr_hdata_line_data, ptr_line_data,
-                                     &irc_command,
-                                     NULL, /* irc_action */
-                                     &date,
-                                     &ptr_nick,
-                                     NULL, /* nick1 */
-                                     NULL, /* nick2 */
-                                     NULL, /* host */
-                                     NULL, /* tags */
-                                     NULL); /* message */
-            if (irc_command >= 0)
-            {
-                /* if we have reached max minutes, exit loop */
-                if ((date_min > 0) && (date < date_min))
-                    break;
-                count++;
-            }
-            /* if we have reached max number of messages, exit loop */
-            if ((max_number > 0) && (count > max_number))
-                break;
-
-            if (localvar_nick && localvar_nick[0]
-                && ptr_nick && (strcmp (ptr_nick, localvar_nick) == 0))
-            {
-                /*
-                 * stop when we find a line sent by the current nick
-                 * (and include this line)
-                 */
-                ptr_line = weechat_hdata_move (ptr_hdata_line, ptr_line, -1);
-                break;
-            }
-        }
-        ptr_line = weechat_hdata_move (ptr_hdata_line, ptr_line, -1);
-    }
-
-    if (!ptr_line)
-    {
-        /* if we have reached beginning of buffer, start from first line */
-        ptr_line = weechat_hdata_pointer (weechat_hdata_get ("lines"),
-                                          ptr_own_lines, "first_line");
-    }
-    else
-    {
-        /* start from line + 1 (the current line must not be sent) */
-        ptr_line = weechat_hdata_move (ptr_hdata_line, ptr_line, 1);
-    }
-
-    /*
-     * loop on lines from line pointer until last line of buffer, and for each
-     * irc message, sends it to client
-     */
-    while (ptr_line)
-    {
-        ptr_line_data = weechat_hdata_pointer (ptr_hdata_line,
-                                               ptr_line, "data");
-        if (ptr_line_data)
-        {
-            relay_irc_get_line_info (client, buffer,
-                                     ptr_hdata_line_data, ptr_line_data,
-                                     &irc_command,
-                                     &irc_action,
-                                     &date,
-                                     &ptr_nick,
-                                     &ptr_nick1,
-                                     &ptr_nick2,
-                                     &ptr_host,
-                                     &tags,
-                                     &message);
-            switch (irc_command)
-            {
-                case RELAY_IRC_CMD_JOIN:
-                    relay_irc_sendf (client,
-                                     "%s:%s%s%s JOIN :%s",
-                                     (tags) ? tags : "",
-                                     ptr_nick,
-                                     (ptr_host) ? "!" : "",
-                                     (ptr_host) ? ptr_host : "",
-                                     channel);
-                    break;
-                case RELAY_IRC_CMD_PART:
-                    relay_irc_sendf (client,
-                                     "%s:%s%s%s PART %s",
-                                     (tags) ? tags : "",
-                                     ptr_nick,
-                                     (ptr_host) ? "!" : "",
-                                     (ptr_host) ? ptr_host : "",
-                                     channel);
-                case RELAY_IRC_CMD_QUIT:
-                    relay_irc_sendf (client,
-                                     "%s:%s%s%s QUIT",
-                                     (tags) ? tags : "",
-                                     ptr_nick,
-                                     (ptr_host) ? "!" : "",
-                                     (ptr_host) ? ptr_host : "");
-                    break;
-                case RELAY_IRC_CMD_NICK:
-                    if (ptr_nick1 && ptr_nick2)
-                    {
-                        relay_irc_sendf (client,
-                                         "%s:%s NICK :%s",
-                                         (tags) ? tags : "",
-                                         ptr_nick1,
-                                         ptr_nick2);
-                    }
-                    break;
-                case RELAY_IRC_CMD_PRIVMSG:
-                    if (ptr_nick && message)
-                    {
-                        relay_irc_sendf (client,
-                                         "%s:%s%s%s PRIVMSG %s :%s%s%s",
-                                         (tags) ? tags : "",
-                                         ptr_nick,
-                                         (ptr_host) ? "!" : "",
-                                         (ptr_host) ? ptr_host : "",
-                                         channel,
-                                         (irc_action) ? "\01ACTION " : "",
-                                         message,
-                                         (irc_action) ? "\01": "");
-                    }
-                    break;
-                case RELAY_IRC_NUM_CMD:
-                    /* make C compiler happy */
-                    break;
-            }
-            if (tags)
-                free (tags);
-            if (message)
-                free (message);
-        }
-        ptr_line = weechat_hdata_move (ptr_hdata_line, ptr_line, 1);
-    }
-}
-
 /*
  * Sends IRC "JOIN" for a channel to client.
  */
@@ -1076,7 +699,7 @@ relay_irc_send_join (struct t_relay_client *client,
 
         /* send backlog to client */
         if (buffer)
-            relay_irc_send_channel_backlog (client, channel, buffer);
+            relay_irc_backlog_send (client, channel, buffer);
     }
 }
 
@@ -1113,7 +736,7 @@ relay_irc_send_join_channels (struct t_relay_client *client)
             else if (type == 1)
             {
                 /* private */
-                relay_irc_send_channel_backlog (client, name, buffer);
+                relay_irc_backlog_send (client, name, buffer);
             }
         }
         weechat_infolist_free (infolist_channels);
@@ -492,41 +492,62 @@ relay_client_recv_text_buffer (struct t_relay_client *client,
                                unsigned long long length_buffer)
 {
     unsigned long long index;
-    unsigned char msg_type;
 
     index = 0;
     while (index < length_buffer)
     {
-        msg_type = RELAY_CLIENT_MSG_STANDARD;
+        relay_client_recv_text (client, buffer + index);
+        index += strlen (buffer + index) + 1;
+    }
+}
 
-        /*
-         * in case of websocket, we can receive PING from client:
-         * trace this PING in raw buffer and answer with a PONG
-         */
-        if (client->websocket == 2)
-        {
-            msg_type = (unsigned char)buffer[index];
-            if (msg_type == RELAY_CLIENT_MSG_PING)
+/*
+ * Reads a complete websocket message from a client (payload of frame(s),
+ * unmasked and decompressed).
+ *
+ * Argument "message" is always terminated by '\0' (not counted in "length").
+ */
+
+void
+relay_client_recv_websocket_msg (struct t_relay_client *client,
+                                 int opcode,
+                                 const char *message,
+                                 unsigned long long length)
+{
+    switch (opcode)
+    {
+        case WEBSOCKET_FRAME_OPCODE_PING:
+            /*
+             * we can receive PING from client: trace this PING in raw buffer
+             * and answer with a PONG
+             */
+            relay_raw_print (client, RELAY_CLIENT_MSG_PING,
+                             RELAY_RAW_FLAG_RECV | RELAY_RAW_FLAG_BINARY,
+                             message, length);
+            relay_client_send (client, RELAY_CLIENT_MSG_PONG,
+                               message, length, NULL);
+            break;
+        case WEBSOCKET_FRAME_OPCODE_PONG:
+            /*
+             * RFC 6455 Section 5.5.3:
+             *
+             *   "A Pong frame MAY be sent unsolicited.  This serves as a
+             *   unidirectional heartbeat.  A response to an unsolicited
+             *   Pong frame is not expected."
+             */
+            break;
+        case WEBSOCKET_FRAME_OPCODE_CLOSE:
+            relay_client_set_status (client, RELAY_STATUS_DISCONNECTED);
+            break;
+        default:
+            if (client->recv_data_type == RELAY_CLIENT_DATA_TEXT)
+                relay_client_recv_text_buffer (client, message, length);
+            else
             {
-                /* print message in raw buffer */
-                relay_raw_print (client, RELAY_CLIENT_MSG_PING,
-                                 RELAY_RAW_FLAG_RECV | RELAY_RAW_FLAG_BINARY,
-                                 buffer + index + 1,
-                                 strlen (buffer + index + 1));
-                /* answer with a PONG */
-                relay_client_send (client,
-                                   RELAY_CLIENT_MSG_PONG,
-                                   buffer + index + 1,
-                                   strlen (buffer + index + 1),
-                                   NULL);
+                /* receive buffer as-is (binary data) */
+                /* currently, all supported protocols receive only text, no binary */
             }
-            index++;
-        }
-
-        if (msg_type == RELAY_CLIENT_MSG_STANDARD)
-            relay_client_recv_text (client, buffer + index);
-
-        index += strlen (buffer + index) + 1;
+            break;
     }
 }
 
@@ -538,10 +559,8 @@ int
 relay_client_recv_cb (const void *pointer, void *data, int fd)
 {
     struct t_relay_client *client;
-    static char buffer[4096], decoded[8192 + 1];
-    const char *ptr_buffer;
-    int num_read, rc;
-    unsigned long long decoded_length, length_buffer;
+    static char buffer[16384];
+    int num_read;
 
     /* make C compiler happy */
     (void) data;
@@ -563,8 +582,6 @@ relay_client_recv_cb (const void *pointer, void *data, int fd)
     if (num_read > 0)
     {
         buffer[num_read] = '\0';
-        ptr_buffer = buffer;
-        length_buffer = num_read;
 
         /*
          * if we are receiving the first message from client, check if it looks
@@ -592,25 +609,10 @@ relay_client_recv_cb (const void *pointer, void *data, int fd)
 
         if (client->websocket == 2)
         {
-            /* websocket used, decode message */
-            rc = relay_websocket_decode_frame ((unsigned char *)buffer,
-                                               (unsigned long long)num_read,
-                                               (unsigned char *)decoded,
-                                               &decoded_length);
-            if (decoded_length == 0)
-            {
-                /*
-                 * When decoded length is 0, assume client sent a PONG frame.
-                 *
-                 * RFC 6455 Section 5.5.3:
-                 *
-                 *   "A Pong frame MAY be sent unsolicited.  This serves as a
-                 *   unidirectional heartbeat.  A response to an unsolicited
-                 *   Pong frame is not expected."
-                 */
-                return WEECHAT_RC_OK;
-            }
-            if (!rc)
+            /* websocket used, decode frames */
+            if (!relay_websocket_decode_frame (client,
+                                               (unsigned char *)buffer,
+                                               (unsigned long long)num_read))
             {
                 /* error when decoding frame: close connection */
                 weechat_printf_date_tags (
@@ -624,15 +626,12 @@ relay_client_recv_cb (const void *pointer, void *data, int fd)
                 relay_client_set_status (client, RELAY_STATUS_DISCONNECTED);
                 return WEECHAT_RC_OK;
             }
-            ptr_buffer = decoded;
-            length_buffer = decoded_length;
         }
-
-        if ((client->websocket == 1)
-            || (client->recv_data_type == RELAY_CLIENT_DATA_TEXT))
+        else if ((client->websocket == 1)
+                 || (client->recv_data_type == RELAY_CLIENT_DATA_TEXT))
         {
             /* websocket initializing or text data for this client */
-            relay_client_recv_text_buffer (client, ptr_buffer, length_buffer);
+            relay_client_recv_text_buffer (client, buffer, num_read);
         }
         else
         {
@@ -895,8 +894,8 @@ relay_client_send (struct t_relay_client *client,
                     WEBSOCKET_FRAME_OPCODE_TEXT : WEBSOCKET_FRAME_OPCODE_BINARY;
                 break;
         }
-        websocket_frame = relay_websocket_encode_frame (opcode, data,
-                                                        data_size,
+        websocket_frame = relay_websocket_encode_frame (client, opcode,
+                                                        data, data_size,
                                                         &length_frame);
         if (websocket_frame)
         {
@@ -1213,6 +1212,17 @@ relay_client_new (int sock, const char *address, struct t_relay_server *server)
 #endif /* HAVE_GNUTLS */
         new_client->websocket = 0;
         new_client->http_headers = NULL;
+        new_client->ws_deflate = 0;
+        new_client->ws_deflate_window_bits = 15;
+        new_client->ws_strm_deflate = NULL;
+        new_client->ws_strm_inflate = NULL;
+        new_client->ws_partial_frame = NULL;
+        new_client->ws_partial_frame_size = 0;
+        new_client->ws_partial_frame_alloc = 0;
+        new_client->ws_msg_opcode = 0;
+        new_client->ws_msg_deflate = 0;
+        new_client->ws_msg = NULL;
+        new_client->ws_msg_size = 0;
         new_client->address = strdup ((address) ? address : "?");
         new_client->status = RELAY_STATUS_CONNECTED;
         new_client->protocol = server->protocol;
@@ -1367,6 +1377,8 @@ relay_client_new_with_infolist (struct t_infolist *infolist)
 {
     struct t_relay_client *new_client;
     const char *str;
+    void *buf;
+    int size;
 
     new_client = malloc (sizeof (*new_client));
     if (new_client)
@@ -1383,6 +1395,44 @@ relay_client_new_with_infolist (struct t_infolist *infolist)
 #endif /* HAVE_GNUTLS */
         new_client->websocket = weechat_infolist_integer (infolist, "websocket");
         new_client->http_headers = NULL;
+        new_client->ws_deflate = weechat_infolist_integer (infolist, "ws_deflate");
+        new_client->ws_deflate_window_bits = weechat_infolist_integer (infolist, "ws_deflate_window_bits");
+        if (new_client->ws_deflate_window_bits == 0)
+            new_client->ws_deflate_window_bits = 15;
+        /* compression streams are created on first use */
+        new_client->ws_strm_deflate = NULL;
+        new_client->ws_strm_inflate = NULL;
+        new_client->ws_partial_frame = NULL;
+        new_client->ws_partial_frame_size = 0;
+        new_client->ws_partial_frame_alloc = 0;
+        buf = weechat_infolist_buffer (infolist, "ws_partial_frame", &size);
+        if (buf && (size > 0))
+        {
+            new_client->ws_partial_frame = malloc (size + 1);
+            if (new_client->ws_partial_frame)
+            {
+                memcpy (new_client->ws_partial_frame, buf, size);
+                new_client->ws_partial_frame_size = size;
+                new_client->ws_partial_frame_alloc = size + 1;
+            }
+        }
+        new_client->ws_msg_opcode = weechat_infolist_integer (infolist, "ws_msg_opcode");
+        new_client->ws_msg_deflate = weechat_infolist_integer (infolist, "ws_msg_deflate");
+        new_client->ws_msg = NULL;
+        new_client->ws_msg_size = 0;
+        if (new_client->ws_msg_opcode)
+        {
+            buf = weechat_infolist_buffer (infolist, "ws_msg", &size);
+            new_client->ws_msg = malloc (((buf) ? size : 0) + 1);
+            if (new_client->ws_msg)
+            {
+                if (buf && (size > 0))
+                    memcpy (new_client->ws_msg, buf, size);
+                new_client->ws_msg_size = (buf) ? size : 0;
+            }
+            else
+                new_client->ws_msg_opcode = 0;
+        }
         new_client->address = strdup (weechat_infolist_string (infolist, "address"));
         new_client->status = weechat_infolist_integer (infolist, "status");
         new_client->protocol = weechat_infolist_integer (infolist, "protocol");
@@ -1581,6 +1631,7 @@ relay_client_free (struct t_relay_client *client)
 #endif /* HAVE_GNUTLS */
     if (client->http_headers)
         weechat_hashtable_free (client->http_headers);
+    relay_websocket_free (client);
     if (client->hook_fd)
         weechat_unhook (client->hook_fd);
     if (client->partial_message)
@@ -1695,6 +1746,28 @@ relay_client_add_to_infolist (struct t_infolist *infolist,
 #endif /* HAVE_GNUTLS */
     if (!weechat_infolist_new_var_integer (ptr_item, "websocket", client->websocket))
         return 0;
+    if (!weechat_infolist_new_var_integer (ptr_item, "ws_deflate", client->ws_deflate))
+        return 0;
+    if (!weechat_infolist_new_var_integer (ptr_item, "ws_deflate_window_bits", client->ws_deflate_window_bits))
+        return 0;
+    if (client->ws_partial_frame && (client->ws_partial_frame_size > 0))
+    {
+        if (!weechat_infolist_new_var_buffer (ptr_item, "ws_partial_frame",
+                                              client->ws_partial_frame,
+                                              client->ws_partial_frame_size))
+            return 0;
+    }
+    if (!weechat_infolist_new_var_integer (ptr_item, "ws_msg_opcode", client->ws_msg_opcode))
+        return 0;
+    if (!weechat_infolist_new_var_integer (ptr_item, "ws_msg_deflate", client->ws_msg_deflate))
+        return 0;
+    if (client->ws_msg && (client->ws_msg_size > 0))
+    {
+        if (!weechat_infolist_new_var_buffer (ptr_item, "ws_msg",
+                                              client->ws_msg,
+                                              client->ws_msg_size))
+            return 0;
+    }
     if (!weechat_infolist_new_var_string (ptr_item, "address", client->address))
         return 0;
     if (!weechat_infolist_new_var_integer (ptr_item, "status", client->status))
@@ -1775,6 +1848,17 @@ relay_client_print_log ()
         weechat_log_printf ("  http_headers. . . . . : 0x%lx (hashtable: '%s')",
                             ptr_client->http_headers,
                             weechat_hashtable_get_string (ptr_client->http_headers, "keys_values"));
+        weechat_log_printf ("  ws_deflate. . . . . . : %d",   ptr_client->ws_deflate);
+        weechat_log_printf ("  ws_deflate_window_bits: %d",   ptr_client->ws_deflate_window_bits);
+        weechat_log_printf ("  ws_strm_deflate . . . : 0x%lx", ptr_client->ws_strm_deflate);
+        weechat_log_printf ("  ws_strm_inflate . . . : 0x%lx", ptr_client->ws_strm_inflate);
+        weechat_log_printf ("  ws_partial_frame. . . : 0x%lx", ptr_client->ws_partial_frame);
+        weechat_log_printf ("  ws_partial_frame_size : %llu", ptr_client->ws_partial_frame_size);
+        weechat_log_printf ("  ws_partial_frame_alloc: %llu", ptr_client->ws_partial_frame_alloc);
+        weechat_log_printf ("  ws_msg_opcode . . . . : %d",   ptr_client->ws_msg_opcode);
+        weechat_log_printf ("  ws_msg_deflate. . . . : %d",   ptr_client->ws_msg_deflate);
+        weechat_log_printf ("  ws_msg. . . . . . . . : 0x%lx", ptr_client->ws_msg);
+        weechat_log_printf ("  ws_msg_size . . . . . : %llu", ptr_client->ws_msg_size);
         weechat_log_printf ("  address . . . . . . . : '%s'", ptr_client->address);
         weechat_log_printf ("  status. . . . . . . . : %d (%s)",
                             ptr_client->status,
@@ -21,6 +21,7 @@
 #define WEECHAT_RELAY_CLIENT_H 1
 
 #include <time.h>
+#include <zlib.h>
 
 #ifdef HAVE_GNUTLS
 #include <gnutls/gnutls.h>
@@ -98,6 +99,20 @@ struct t_relay_client
 #endif /* HAVE_GNUTLS */
     int websocket;                     /* 0=not a ws, 1=init ws, 2=ws ready */
     struct t_hashtable *http_headers;  /* HTTP headers for websocket        */
+    int ws_deflate;                    /* 1 if permessage-deflate is used   */
+    int ws_deflate_window_bits;        /* window bits for compression       */
+    z_stream *ws_strm_deflate;         /* stream for websocket compression  */
+    z_stream *ws_strm_inflate;         /* stream for ws decompression       */
+    char *ws_partial_frame;            /* incomplete websocket frame        */
+    unsigned long long ws_partial_frame_size; /* size of incomplete frame   */
+    unsigned long long ws_partial_frame_alloc; /* allocated size of the  */
+                                       /* incomplete frame                  */
+    int ws_msg_opcode;                 /* opcode of fragmented message      */
+                                       /* (0 if no fragmented message)      */
+    int ws_msg_deflate;                /* 1 if fragmented msg is compressed */
+    char *ws_msg;                      /* fragmented message (payload of    */
+                                       /* frames received so far)           */
+    unsigned long long ws_msg_size;    /* size of fragmented message        */
     char *address;                     /* string with IP address            */
     enum t_relay_status status;        /* status (connecting, active,..)    */
     enum t_relay_protocol protocol;    /* protocol (irc,..)                 */
@@ -133,6 +148,10 @@ extern struct t_relay_client *relay_client_search_by_id (int id);
 extern int relay_client_status_search (const char *name);
 extern int relay_client_count_active_by_port (int server_port);
 extern void relay_client_set_desc (struct t_relay_client *client);
+extern void relay_client_recv_websocket_msg (struct t_relay_client *client,
+                                             int opcode,
+                                             const char *message,
+                                             unsigned long long length);
 extern int relay_client_recv_cb (const void *pointer, void *data, int fd);
 extern int relay_client_send (struct t_relay_client *client,
                               enum t_relay_client_msg_type msg_type,
@@ -28,6 +28,7 @@
 #include "relay.h"
 #include "relay-config.h"
 #include "irc/relay-irc.h"
+#include "irc/relay-irc-backlog.h"
 #include "relay-client.h"
 #include "relay-buffer.h"
 #include "relay-network.h"
@@ -356,6 +357,23 @@ relay_config_check_irc_backlog_tags (const void *pointer, void *data,
     return rc;
 }
 
+/*
+ * Callback for changes on options "relay.irc.backlog_max_minutes" and
+ * "relay.irc.backlog_max_number".
+ */
+
+void
+relay_config_change_irc_backlog_max (const void *pointer, void *data,
+                                     struct t_config_option *option)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    relay_irc_backlog_flush ();
+}
+
 /*
  * Callback for changes on option "relay.irc.backlog_tags".
  */
@@ -395,6 +413,8 @@ relay_config_change_irc_backlog_tags (const void *pointer, void *data,
         }
         weechat_string_free_split (items);
     }
+
+    relay_irc_backlog_flush ();
 }
 
 /*
@@ -788,8 +808,9 @@ relay_config_init ()
         relay_config_file, ptr_section,
         "compression_level", "integer",
         N_("compression level for packets sent to client with WeeChat protocol "
-           "(0 = disable compression, 1 = low compression ... 9 = best "
-           "compression)"),
+           "and for text messages sent to websocket clients using extension "
+           "\"permessage-deflate\" (0 = disable compression, 1 = low "
+           "compression ... 9 = best compression)"),
         NULL, 0, 9, "6", NULL, 0,
         NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
     relay_config_network_ipv6 = weechat_config_new_option (
@@ -870,14 +891,18 @@ relay_config_init ()
            "(0 = unlimited, examples: 1440 = one day, 10080 = one week, "
            "43200 = one month, 525600 = one year)"),
         NULL, 0, INT_MAX, "1440", NULL, 0,
-        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+        NULL, NULL, NULL,
+        &relay_config_change_irc_backlog_max, NULL, NULL,
+        NULL, NULL, NULL);
     relay_config_irc_backlog_max_number = weechat_config_new_option (
         relay_config_file, ptr_section,
         "backlog_max_number", "integer",
         N_("maximum number of lines in backlog per IRC channel "
            "(0 = unlimited)"),
         NULL, 0, INT_MAX, "256", NULL, 0,
-        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+        NULL, NULL, NULL,
+        &relay_config_change_irc_backlog_max, NULL, NULL,
+        NULL, NULL, NULL);
     relay_config_irc_backlog_since_last_disconnect = weechat_config_new_option (
         relay_config_file, ptr_section,
         "backlog_since_last_disconnect", "boolean",
@@ -23,7 +23,9 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 #include <gcrypt.h>
+#include <zlib.h>
 
 #include "../weechat-plugin.h"
 #include "relay.h"
@@ -171,6 +173,143 @@ relay_websocket_client_handshake_valid (struct t_relay_client *client)
     return 0;
 }
 
+/*
+ * Checks an offer of extension "permessage-deflate" (RFC 7692) sent by client
+ * in HTTP header "Sec-WebSocket-Extensions", for example:
+ *   permessage-deflate; client_max_window_bits
+ *
+ * Returns:
+ *   > 0: offer accepted, value is the window bits to use for compression
+ *     0: offer not accepted
+ */
+
+int
+relay_websocket_deflate_check_offer (const char *offer)
+{
+    char **params, *pos, *error;
+    int i, num_params, window_bits;
+    long number;
+
+    params = weechat_string_split (offer, ";", 0, 0, &num_params);
+    if (!params)
+        return 0;
+
+    window_bits = 0;
+
+    for (i = 0; i < num_params; i++)
+    {
+        weechat_string_remove_quotes (params[i], "\"");
+        pos = params[i];
+        while (pos[0] == ' ')
+        {
+            pos++;
+        }
+        if (i == 0)
+        {
+            if (strcmp (pos, "permessage-deflate") != 0)
+                goto end;
+            window_bits = 15;
+        }
+        else if (strncmp (pos, "server_max_window_bits=", 23) == 0)
+        {
+            /*
+             * raw deflate with zlib does not support a window of 8 bits
+             * (it would use 9 bits), so the offer is declined in this case
+             */
+            error = NULL;
+            number = strtol (pos + 23, &error, 10);
+            if (!error || error[0] || (number < 9) || (number > 15))
+            {
+                window_bits = 0;
+                goto end;
+            }
+            window_bits = number;
+        }
+        else if ((strcmp (pos, "server_no_context_takeover") != 0)
+                 && (strcmp (pos, "client_no_context_takeover") != 0)
+                 && (strncmp (pos, "client_max_window_bits", 22) != 0))
+        {
+            /* unknown parameter: decline offer */
+            window_bits = 0;
+            goto end;
+        }
+    }
+
+end:
+    weechat_string_free_split (params);
+
+    return window_bits;
+}
+
+/*
+ * Negotiates extension "permessage-deflate" (RFC 7692) with client, using
+ * HTTP header "Sec-WebSocket-Extensions" (if the compression is enabled with
+ * option relay.network.compression_level).
+ *
+ * The context is never kept between messages (in both directions), so that
+ * each message can be decompressed alone.
+ *
+ * Returns the header to send in handshake (empty string if the extension is
+ * not used).
+ */
+
+const char *
+relay_websocket_deflate_negotiate (struct t_relay_client *client)
+{
+    static char header[256];
+    const char *extensions;
+    char **offers;
+    int i, num_offers, window_bits;
+
+    header[0] = '\0';
+
+    client->ws_deflate = 0;
+    client->ws_deflate_window_bits = 15;
+
+    if (weechat_config_integer (relay_config_network_compression_level) == 0)
+        return header;
+
+    extensions = weechat_hashtable_get (client->http_headers,
+                                        "sec-websocket-extensions");
+    if (!extensions)
+        return header;
+
+    offers = weechat_string_split (extensions, ",", 0, 0, &num_offers);
+    if (!offers)
+        return header;
+
+    for (i = 0; i < num_offers; i++)
+    {
+        window_bits = relay_websocket_deflate_check_offer (offers[i]);
+        if (window_bits > 0)
+        {
+            client->ws_deflate = 1;
+            client->ws_deflate_window_bits = window_bits;
+            if (window_bits < 15)
+            {
+                snprintf (header, sizeof (header),
+                          "Sec-WebSocket-Extensions: permessage-deflate; "
+                          "server_no_context_takeover; "
+                          "client_no_context_takeover; "
+                          "server_max_window_bits=%d\r\n",
+                          window_bits);
+            }
+            else
+            {
+                snprintf (header, sizeof (header),
+                          "Sec-WebSocket-Extensions: permessage-deflate; "
+                          "server_no_context_takeover; "
+                          "client_no_context_takeover\r\n");
+            }
+            break;
+        }
+    }
+
+    weechat_string_free_split (offers);
+
+    return header;
+}
+
 /*
  * Builds the handshake that will be returned to client, to initialize and use
  * the websocket.
@@ -226,8 +365,10 @@ relay_websocket_build_handshake (struct t_relay_client *client)
               "Connection: Upgrade\r\n"
               //"Sec-WebSocket-Protocol: chat\r\n"
               "Sec-WebSocket-Accept: %s\r\n"
+              "%s"
               "\r\n",
-              sec_websocket_accept);
+              sec_websocket_accept,
+              relay_websocket_deflate_negotiate (client));
 
     return strdup (handshake);
 }
@@ -258,86 +399,590 @@ relay_websocket_send_http (struct t_relay_client *client,
 }
 
 /*
- * Decodes a websocket frame.
+ * Unmasks data received from client (the 4 bytes of mask are applied on each
+ * group of 4 bytes), in place.
+ *
+ * The data is unmasked 8 bytes at a time, then the remaining bytes (if any)
+ * are unmasked one by one.
+ */
+
+void
+relay_websocket_unmask (unsigned char *data, unsigned long long length,
+                        const unsigned char *mask)
+{
+    unsigned char mask8[8];
+    uint64_t mask64, chunk;
+    unsigned long long i;
+
+    memcpy (mask8, mask, 4);
+    memcpy (mask8 + 4, mask, 4);
+    memcpy (&mask64, mask8, 8);
+
+    for (i = 0; i + 8 <= length; i += 8)
+    {
+        memcpy (&chunk, data + i, 8);
+        chunk ^= mask64;
+        memcpy (data + i, &chunk, 8);
+    }
+    for (; i < length; i++)
+    {
+        data[i] ^= mask[i % 4];
+    }
+}
+
+/*
+ * Decompresses data using an inflate stream, appending the result to
+ * "output" (which is reallocated if needed).
  *
  * Returns:
- *   1: frame decoded successfully
- *   0: error decoding frame (connection must be closed if it happens)
+ *   1: OK
+ *   0: error
  */
 
 int
-relay_websocket_decode_frame (const unsigned char *buffer,
-                              unsigned long long buffer_length,
-                              unsigned char *decoded,
-                              unsigned long long *decoded_length)
+relay_websocket_inflate_data (z_stream *strm,
+                              const unsigned char *data,
+                              unsigned long long length,
+                              char **output,
+                              unsigned long long *output_size,
+                              unsigned long long *output_alloc)
 {
-    unsigned long long i, index_buffer, length_frame_size, length_frame;
-    unsigned char opcode;
+    char *new_output;
+    unsigned long long new_alloc;
+    int rc;
 
-    *decoded_length = 0;
-    index_buffer = 0;
+    strm->next_in = (Bytef *)data;
+    strm->avail_in = length;
 
-    /* loop to decode all frames in message */
-    while (index_buffer + 2 <= buffer_length)
+    while (1)
     {
-        opcode = buffer[index_buffer] & 15;
-
-        /*
-         * check if frame is masked: client MUST send a masked frame; if frame is
-         * not masked, we MUST reject it and close the connection (see RFC 6455)
-         */
-        if (!(buffer[index_buffer + 1] & 128))
+        /* grow output buffer if it is full (keep 1 byte for final '\0') */
+        if (*output_size + 1 >= *output_alloc)
+        {
+            if (*output_alloc >= WEBSOCKET_MSG_MAX_SIZE)
+                return 0;
+            new_alloc = *output_alloc * 2;
+            if (new_alloc > WEBSOCKET_MSG_MAX_SIZE)
+                new_alloc = WEBSOCKET_MSG_MAX_SIZE;
+            new_output = realloc (*output, new_alloc);
+            if (!new_output)
+                return 0;
+            *output = new_output;
+            *output_alloc = new_alloc;
+        }
+        strm->next_out = (Bytef *)(*output + *output_size);
+        strm->avail_out = *output_alloc - *output_size - 1;
+        rc = inflate (strm, Z_SYNC_FLUSH);
+        *output_size = *output_alloc - 1 - strm->avail_out;
+        if ((rc != Z_OK) && (rc != Z_STREAM_END) && (rc != Z_BUF_ERROR))
             return 0;
+        if ((rc == Z_STREAM_END)
+            || ((strm->avail_in == 0) && (strm->avail_out > 0)))
+        {
+            break;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Decompresses a message received with extension "permessage-deflate"
+ * (RFC 7692).
+ *
+ * Returns the decompressed message (with a final '\0', not counted in
+ * "length_output"), NULL if error.
+ *
+ * Note: result must be freed after use.
+ */
 
-        /* decode frame */
-        length_frame_size = 1;
-        length_frame = buffer[index_buffer + 1] & 127;
-        index_buffer += 2;
-        if ((length_frame == 126) || (length_frame == 127))
+char *
+relay_websocket_inflate (struct t_relay_client *client,
+                         const unsigned char *data,
+                         unsigned long long length,
+                         unsigned long long *length_output)
+{
+    /* tail removed by client from the compressed data (RFC 7692 7.2.2) */
+    static const unsigned char tail[4] = { 0x00, 0x00, 0xFF, 0xFF };
+    char *output;
+    unsigned long long output_size, output_alloc;
+
+    *length_output = 0;
+
+    if (!client->ws_strm_inflate)
+    {
+        client->ws_strm_inflate = calloc (1, sizeof (*client->ws_strm_inflate));
+        if (!client->ws_strm_inflate)
+            return NULL;
+        if (inflateInit2 (client->ws_strm_inflate, -15) != Z_OK)
         {
-            length_frame_size = (length_frame == 126) ? 2 : 8;
-            if (buffer_length < 1 + length_frame_size)
-                return 0;
-            length_frame = 0;
-            for (i = 0; i < length_frame_size; i++)
-            {
-                length_frame += (unsigned long long)buffer[index_buffer + i] << ((length_frame_size - i - 1) * 8);
-            }
-            index_buffer += length_frame_size;
+            free (client->ws_strm_inflate);
+            client->ws_strm_inflate = NULL;
+            return NULL;
         }
+    }
+    else
+    {
+        /* no context takeover: each message is decompressed alone */
+        inflateReset (client->ws_strm_inflate);
+    }
+
+    output_alloc = (length < 1024) ? 4096 : length * 4;
+    if (output_alloc > WEBSOCKET_MSG_MAX_SIZE)
+        output_alloc = WEBSOCKET_MSG_MAX_SIZE;
+    output = malloc (output_alloc);
+    if (!output)
+        return NULL;
+    output_size = 0;
+
+    if (!relay_websocket_inflate_data (client->ws_strm_inflate, data, length,
+                                       &output, &output_size, &output_alloc)
+        || !relay_websocket_inflate_data (client->ws_strm_inflate, tail,
+                                          sizeof (tail), &output,
+                                          &output_size, &output_alloc))
+    {
+        free (output);
+        return NULL;
+    }
+
+    output[output_size] = '\0';
+    *length_output = output_size;
+
+    return output;
+}
+
+/*
+ * Compresses a message to send with extension "permessage-deflate"
+ * (RFC 7692).
+ *
+ * Returns the compressed message, NULL if error.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+relay_websocket_deflate (struct t_relay_client *client,
+                         const char *data,
+                         unsigned long long length,
+                         unsigned long long *length_output)
+{
+    unsigned char *output;
+    unsigned long long output_alloc, output_size;
+
+    *length_output = 0;
+
+    if (!client->ws_strm_deflate)
+    {
+        client->ws_strm_deflate = calloc (1, sizeof (*client->ws_strm_deflate));
+        if (!client->ws_strm_deflate)
+            return NULL;
+        if (deflateInit2 (
+                client->ws_strm_deflate,
+                weechat_config_integer (relay_config_network_compression_level),
+                Z_DEFLATED,
+                -1 * client->ws_deflate_window_bits,
+                8,
+                Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            free (client->ws_strm_deflate);
+            client->ws_strm_deflate = NULL;
+            return NULL;
+        }
+    }
+    else
+    {
+        /* no context takeover: each message is compressed alone */
+        deflateReset (client->ws_strm_deflate);
+    }
+
+    /* Z_SYNC_FLUSH adds a few bytes to the bound computed by zlib */
+    output_alloc = deflateBound (client->ws_strm_deflate, length) + 16;
+    output = malloc (output_alloc);
+    if (!output)
+        return NULL;
+
+    client->ws_strm_deflate->next_in = (Bytef *)data;
+    client->ws_strm_deflate->avail_in = length;
+    client->ws_strm_deflate->next_out = output;
+    client->ws_strm_deflate->avail_out = output_alloc;
+
+    if ((deflate (client->ws_strm_deflate, Z_SYNC_FLUSH) != Z_OK)
+        || (client->ws_strm_deflate->avail_in > 0))
+    {
+        free (output);
+        return NULL;
+    }
+
+    output_size = output_alloc - client->ws_strm_deflate->avail_out;
+
+    /* remove the tail "00 00 FF FF" added by the sync flush */
+    if ((output_size >= 4)
+        && (output[output_size - 4] == 0x00)
+        && (output[output_size - 3] == 0x00)
+        && (output[output_size - 2] == 0xFF)
+        && (output[output_size - 1] == 0xFF))
+    {
+        output_size -= 4;
+    }
+
+    *length_output = output_size;
+
+    return (char *)output;
+}
+
+/*
+ * Sends a complete message received from client (payload of frame(s), after
+ * decompression if needed).
+ *
+ * If the message is not compressed, it is sent without copy: the byte after
+ * the message is temporarily replaced by '\0' (there is always at least one
+ * byte available after the payload in buffer).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
 
-        if (buffer_length < 1 + length_frame_size + 4 + length_frame)
+int
+relay_websocket_recv_msg (struct t_relay_client *client, int opcode,
+                          int compressed, unsigned char *payload,
+                          unsigned long long length)
+{
+    char *message;
+    unsigned char saved_char;
+    unsigned long long length_message;
+
+    if (compressed)
+    {
+        message = relay_websocket_inflate (client, payload, length,
+                                           &length_message);
+        if (!message)
             return 0;
+        relay_client_recv_websocket_msg (client, opcode, message,
+                                         length_message);
+        free (message);
+    }
+    else
+    {
+        saved_char = payload[length];
+        payload[length] = '\0';
+        relay_client_recv_websocket_msg (client, opcode,
+                                         (const char *)payload, length);
+        payload[length] = saved_char;
+    }
+
+    return 1;
+}
+
+/*
+ * Handles a websocket frame received from client (payload is unmasked).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (protocol violation)
+ */
 
-        /* read masks (4 bytes) */
-        int masks[4];
-        for (i = 0; i < 4; i++)
+int
+relay_websocket_handle_frame (struct t_relay_client *client,
+                              unsigned char flags, int opcode,
+                              unsigned char *payload,
+                              unsigned long long length)
+{
+    char *new_msg, *message;
+    unsigned long long length_message;
+    int rc;
+
+    /* control frame: must not be fragmented nor compressed (RFC 6455 5.5) */
+    if (opcode & WEBSOCKET_FRAME_OPCODE_CONTROL)
+    {
+        if (!(flags & WEBSOCKET_FRAME_FIN)
+            || (flags & WEBSOCKET_FRAME_RSV1)
+            || (length > 125))
         {
-            masks[i] = (int)((unsigned char)buffer[index_buffer + i]);
+            return 0;
         }
-        index_buffer += 4;
+        if ((opcode != WEBSOCKET_FRAME_OPCODE_CLOSE)
+            && (opcode != WEBSOCKET_FRAME_OPCODE_PING)
+            && (opcode != WEBSOCKET_FRAME_OPCODE_PONG))
+        {
+            return 0;
+        }
+        return relay_websocket_recv_msg (client, opcode, 0, payload, length);
+    }
 
-        /* copy opcode in decoded data */
-        decoded[*decoded_length] = (opcode == WEBSOCKET_FRAME_OPCODE_PING) ?
-            RELAY_CLIENT_MSG_PING : RELAY_CLIENT_MSG_STANDARD;
-        *decoded_length += 1;
+    /* continuation of a fragmented message */
+    if (opcode == WEBSOCKET_FRAME_OPCODE_CONTINUATION)
+    {
+        if (!client->ws_msg_opcode || (flags & WEBSOCKET_FRAME_RSV1))
+            return 0;
+        if (client->ws_msg_size + length > WEBSOCKET_MSG_MAX_SIZE)
+            return 0;
+        new_msg = realloc (client->ws_msg, client->ws_msg_size + length + 1);
+        if (!new_msg)
+            return 0;
+        memcpy (new_msg + client->ws_msg_size, payload, length);
+        client->ws_msg = new_msg;
+        client->ws_msg_size += length;
+        if (!(flags & WEBSOCKET_FRAME_FIN))
+            return 1;
+        /* last frame: the message is complete */
+        message = client->ws_msg;
+        length_message = client->ws_msg_size;
+        client->ws_msg = NULL;
+        client->ws_msg_size = 0;
+        rc = relay_websocket_recv_msg (client, client->ws_msg_opcode,
+                                       client->ws_msg_deflate,
+                                       (unsigned char *)message,
+                                       length_message);
+        client->ws_msg_opcode = 0;
+        client->ws_msg_deflate = 0;
+        free (message);
+        return rc;
+    }
 
-        /* decode data using masks */
-        for (i = 0; i < length_frame; i++)
+    /* first frame of a message (text or binary) */
+    if ((opcode != WEBSOCKET_FRAME_OPCODE_TEXT)
+        && (opcode != WEBSOCKET_FRAME_OPCODE_BINARY))
+    {
+        return 0;
+    }
+    if (client->ws_msg_opcode)
+        return 0;
+    if (!(flags & WEBSOCKET_FRAME_FIN))
+    {
+        /* fragmented message: keep payload until the last frame */
+        client->ws_msg = malloc (length + 1);
+        if (!client->ws_msg)
+            return 0;
+        memcpy (client->ws_msg, payload, length);
+        client->ws_msg_size = length;
+        client->ws_msg_opcode = opcode;
+        client->ws_msg_deflate = (flags & WEBSOCKET_FRAME_RSV1) ? 1 : 0;
+        return 1;
+    }
+    return relay_websocket_recv_msg (client, opcode,
+                                     (flags & WEBSOCKET_FRAME_RSV1) ? 1 : 0,
+                                     payload, length);
+}
+
+/*
+ * Parses and handles one websocket frame at beginning of buffer.
+ *
+ * There must be at least one byte available after "length" bytes in buffer
+ * (used to send the payload as a string without copy).
+ *
+ * Returns:
+ *   1: frame handled, "frame_size" is set with the size of frame
+ *   0: incomplete frame (more data is needed)
+ *  -1: error (connection must be closed)
+ */
+
+int
+relay_websocket_parse_frame (struct t_relay_client *client,
+                             unsigned char *buffer,
+                             unsigned long long length,
+                             unsigned long long *frame_size)
+{
+    unsigned long long i, index, length_header, length_payload;
+    unsigned char *mask;
+
+    *frame_size = 0;
+
+    if (length < 2)
+        return 0;
+
+    /*
+     * check if frame is masked: client MUST send a masked frame; if frame is
+     * not masked, we MUST reject it and close the connection (see RFC 6455)
+     */
+    if (!(buffer[1] & WEBSOCKET_FRAME_MASK))
+        return -1;
+
+    /* RSV1 is allowed only if compression has been negotiated */
+    if ((buffer[0] & (WEBSOCKET_FRAME_RSV2 | WEBSOCKET_FRAME_RSV3))
+        || ((buffer[0] & WEBSOCKET_FRAME_RSV1) && !client->ws_deflate))
+    {
+        return -1;
+    }
+
+    length_payload = buffer[1] & 0x7F;
+    index = 2;
+    if ((length_payload == 126) || (length_payload == 127))
+    {
+        length_header = (length_payload == 126) ? 2 : 8;
+        if (length < index + length_header)
+            return 0;
+        length_payload = 0;
+        for (i = 0; i < length_header; i++)
         {
-            decoded[*decoded_length + i] = (int)((unsigned char)buffer[index_buffer + i]) ^ masks[i % 4];
+            length_payload = (length_payload << 8) | buffer[index + i];
         }
-        decoded[*decoded_length + length_frame] = '\0';
-        *decoded_length += length_frame + 1;
-        index_buffer += length_frame;
+        index += length_header;
+    }
+
+    if (length_payload > WEBSOCKET_MSG_MAX_SIZE)
+        return -1;
+
+    if (length < index + 4 + length_payload)
+        return 0;
+
+    /* unmask payload (in place) */
+    mask = buffer + index;
+    index += 4;
+    relay_websocket_unmask (buffer + index, length_payload, mask);
+
+    *frame_size = index + length_payload;
+
+    return (relay_websocket_handle_frame (client, buffer[0] & 0xF0,
+                                          buffer[0] & 0x0F,
+                                          buffer + index,
+                                          length_payload)) ? 1 : -1;
+}
+
+/*
+ * Grows buffer with incomplete websocket frame of client, so that it can
+ * contain at least "size" bytes (the allocated size is doubled if needed).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (not enough memory)
+ */
+
+int
+relay_websocket_partial_frame_grow (struct t_relay_client *client,
+                                    unsigned long long size)
+{
+    char *new_frame;
+    unsigned long long new_alloc;
+
+    if (size <= client->ws_partial_frame_alloc)
+        return 1;
+
+    new_alloc = (client->ws_partial_frame_alloc > 0) ?
+        client->ws_partial_frame_alloc : 4096;
+    while (new_alloc < size)
+    {
+        new_alloc *= 2;
     }
 
+    new_frame = realloc (client->ws_partial_frame, new_alloc);
+    if (!new_frame)
+        return 0;
+    client->ws_partial_frame = new_frame;
+    client->ws_partial_frame_alloc = new_alloc;
+
     return 1;
 }
 
+/*
+ * Decodes websocket frames received from client, and sends each complete
+ * message to the client (see function relay_client_recv_websocket_msg).
+ *
+ * Frames are decoded in place in buffer (there must be at least one byte
+ * available after "length" bytes in buffer); an incomplete frame at the end
+ * of buffer is saved in client and completed by next data received.
+ *
+ * The incomplete frame is kept in a growable buffer of client: data received
+ * is appended to it, and only the unparsed data is moved to the beginning of
+ * buffer once complete frames have been handled (so that a large frame
+ * received in many reads is not copied on each read).
+ *
+ * Returns:
+ *   1: frames decoded successfully
+ *   0: error decoding frame (connection must be closed if it happens)
+ */
+
+int
+relay_websocket_decode_frame (struct t_relay_client *client,
+                              unsigned char *buffer,
+                              unsigned long long length)
+{
+    unsigned long long index, frame_size;
+    int rc, partial;
+
+    partial = 0;
+
+    /* complete the partial frame received before */
+    if (client->ws_partial_frame_size > 0)
+    {
+        if (client->ws_partial_frame_size + length > WEBSOCKET_MSG_MAX_SIZE + 14)
+            return 0;
+        if (!relay_websocket_partial_frame_grow (
+                client, client->ws_partial_frame_size + length + 1))
+        {
+            return 0;
+        }
+        memcpy (client->ws_partial_frame + client->ws_partial_frame_size,
+                buffer, length);
+        client->ws_partial_frame_size += length;
+        buffer = (unsigned char *)client->ws_partial_frame;
+        length = client->ws_partial_frame_size;
+        partial = 1;
+    }
+
+    rc = 1;
+    index = 0;
+
+    while (index < length)
+    {
+        if (RELAY_CLIENT_HAS_ENDED(client))
+            break;
+        switch (relay_websocket_parse_frame (client, buffer + index,
+                                             length - index, &frame_size))
+        {
+            case 1:
+                index += frame_size;
+                break;
+            case 0:
+                /* incomplete frame: keep it for next data received */
+                if (partial)
+                {
+                    if (index > 0)
+                    {
+                        memmove (client->ws_partial_frame, buffer + index,
+                                 length - index);
+                    }
+                }
+                else if (relay_websocket_partial_frame_grow (
+                             client, length - index + 1))
+                {
+                    memcpy (client->ws_partial_frame, buffer + index,
+                            length - index);
+                }
+                else
+                {
+                    rc = 0;
+                    index = length;
+                    break;
+                }
+                client->ws_partial_frame_size = length - index;
+                return rc;
+            default:
+                rc = 0;
+                index = length;
+                break;
+        }
+    }
+
+    /* all data has been used (or error): no more incomplete frame */
+    client->ws_partial_frame_size = 0;
+    if (client->ws_partial_frame_alloc > WEBSOCKET_PARTIAL_FRAME_KEEP_SIZE)
+    {
+        /* do not keep a large buffer allocated for a next large frame */
+        free (client->ws_partial_frame);
+        client->ws_partial_frame = NULL;
+        client->ws_partial_frame_alloc = 0;
+    }
+
+    return rc;
+}
+
 /*
  * Encodes data in a websocket frame.
  *
+ * If the extension "permessage-deflate" is used, text messages are
+ * compressed (if they are not too short).
+ *
  * Returns websocket frame, NULL if error.
  * Argument "length_frame" is set with the length of frame built.
  *
@@ -345,21 +990,45 @@ relay_websocket_decode_frame (const unsigned char *buffer,
  */
 
 char *
-relay_websocket_encode_frame (int opcode,
+relay_websocket_encode_frame (struct t_relay_client *client,
+                              int opcode,
                               const char *buffer,
                               unsigned long long length,
                               unsigned long long *length_frame)
 {
     unsigned char *frame;
-    unsigned long long index;
+    char *deflated;
+    unsigned long long index, length_deflated;
 
     *length_frame = 0;
 
+    frame = NULL;
+    deflated = NULL;
+
+    /*
+     * compress only text frames: binary frames (WeeChat protocol) are
+     * already compressed with zlib (if compression is enabled)
+     */
+    if (client->ws_deflate
+        && (opcode == WEBSOCKET_FRAME_OPCODE_TEXT)
+        && (length >= WEBSOCKET_DEFLATE_MIN_SIZE)
+        && (weechat_config_integer (relay_config_network_compression_level) > 0))
+    {
+        deflated = relay_websocket_deflate (client, buffer, length,
+                                            &length_deflated);
+        if (deflated && (length_deflated < length))
+        {
+            buffer = deflated;
+            length = length_deflated;
+            opcode |= WEBSOCKET_FRAME_RSV1;
+        }
+    }
+
     frame = malloc (length + 10);
     if (!frame)
-        return NULL;
+        goto end;
 
-    frame[0] = 0x80;
+    frame[0] = WEBSOCKET_FRAME_FIN;
     frame[0] |= opcode;
 
     if (length <= 125)
@@ -396,5 +1065,46 @@ relay_websocket_encode_frame (int opcode,
 
     *length_frame = index + length;
 
+end:
+    if (deflated)
+        free (deflated);
+
     return (char *)frame;
 }
+
+/*
+ * Frees websocket data in a client (compression streams, partial frame and
+ * fragmented message).
+ */
+
+void
+relay_websocket_free (struct t_relay_client *client)
+{
+    if (client->ws_strm_deflate)
+    {
+        deflateEnd (client->ws_strm_deflate);
+        free (client->ws_strm_deflate);
+        client->ws_strm_deflate = NULL;
+    }
+    if (client->ws_strm_inflate)
+    {
+        inflateEnd (client->ws_strm_inflate);
+        free (client->ws_strm_inflate);
+        client->ws_strm_inflate = NULL;
+    }
+    if (client->ws_partial_frame)
+    {
+        free (client->ws_partial_frame);
+        client->ws_partial_frame = NULL;
+    }
+    client->ws_partial_frame_size = 0;
+    client->ws_partial_frame_alloc = 0;
+    if (client->ws_msg)
+    {
+        free (client->ws_msg);
+        client->ws_msg = NULL;
+    }
+    client->ws_msg_size = 0;
+    client->ws_msg_opcode = 0;
+    client->ws_msg_deflate = 0;
+}
@@ -20,12 +20,28 @@
 #ifndef WEECHAT_RELAY_WEBSOCKET_H
 #define WEECHAT_RELAY_WEBSOCKET_H 1
 
+#define WEBSOCKET_FRAME_FIN                 0x80
+#define WEBSOCKET_FRAME_RSV1                0x40
+#define WEBSOCKET_FRAME_RSV2                0x20
+#define WEBSOCKET_FRAME_RSV3                0x10
+#define WEBSOCKET_FRAME_MASK                0x80
+
 #define WEBSOCKET_FRAME_OPCODE_CONTINUATION 0x00
 #define WEBSOCKET_FRAME_OPCODE_TEXT         0x01
 #define WEBSOCKET_FRAME_OPCODE_BINARY       0x02
 #define WEBSOCKET_FRAME_OPCODE_CLOSE        0x08
 #define WEBSOCKET_FRAME_OPCODE_PING         0x09
 #define WEBSOCKET_FRAME_OPCODE_PONG         0x0A
+#define WEBSOCKET_FRAME_OPCODE_CONTROL      0x08
+
+/* permessage-deflate (RFC 7692) */
+#define WEBSOCKET_DEFLATE_MIN_SIZE          64   /* don't compress below  */
+
+/* max size of a message received (after decompression) */
+#define WEBSOCKET_MSG_MAX_SIZE              (16 * 1024 * 1024)
+
+/* max size of buffer kept for incomplete frames when it is empty */
+#define WEBSOCKET_PARTIAL_FRAME_KEEP_SIZE   (64 * 1024)
 
 extern int relay_websocket_is_http_get_weechat (const char *message);
 extern void relay_websocket_save_header (struct t_relay_client *client,
@@ -34,13 +50,17 @@ extern int relay_websocket_client_handshake_valid (struct t_relay_client *client
 extern char *relay_websocket_build_handshake (struct t_relay_client *client);
 extern void relay_websocket_send_http (struct t_relay_client *client,
                                        const char *http);
-extern int relay_websocket_decode_frame (const unsigned char *buffer,
-                                         unsigned long long length,
-                                         unsigned char *decoded,
-                                         unsigned long long *decoded_length);
-extern char *relay_websocket_encode_frame (int opcode,
+extern void relay_websocket_unmask (unsigned char *data,
+                                    unsigned long long length,
+                                    const unsigned char *mask);
+extern int relay_websocket_decode_frame (struct t_relay_client *client,
+                                         unsigned char *buffer,
+                                         unsigned long long length);
+extern char *relay_websocket_encode_frame (struct t_relay_client *client,
+                                           int opcode,
                                            const char *buffer,
                                            unsigned long long length,
                                            unsigned long long *length_frame);
+extern void relay_websocket_free (struct t_relay_client *client);
 
 #endif /* WEECHAT_RELAY_WEBSOCKET_H */
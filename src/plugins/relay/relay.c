@@ -34,6 +34,8 @@
 #include "relay-raw.h"
 #include "relay-server.h"
 #include "relay-upgrade.h"
+#include "irc/relay-irc-backlog.h"
+#include "weechat/relay-weechat-msg.h"
 
 
 WEECHAT_PLUGIN_NAME(RELAY_PLUGIN_NAME);
@@ -171,6 +173,7 @@ relay_debug_dump_cb (const void *pointer, void *data,
 
         relay_server_print_log ();
         relay_client_print_log ();
+        relay_irc_backlog_print_log ();
 
         weechat_log_printf ("");
         weechat_log_printf ("***** End of \"%s\" plugin dump *****",
@@ -209,6 +212,12 @@ weechat_plugin_init (struct t_weechat_plugin *plugin, int argc, char *argv[])
 
     weechat_hook_signal ("upgrade", &relay_signal_upgrade_cb, NULL, NULL);
     weechat_hook_signal ("debug_dump", &relay_debug_dump_cb, NULL, NULL);
+    weechat_hook_signal ("plugin_loaded",
+                         &relay_weechat_msg_hdata_cache_signal_plugin_cb,
+                         NULL, NULL);
+    weechat_hook_signal ("plugin_unloaded",
+                         &relay_weechat_msg_hdata_cache_signal_plugin_cb,
+                         NULL, NULL);
 
     relay_info_init ();
 
@@ -262,6 +271,10 @@ weechat_plugin_end (struct t_weechat_plugin *plugin)
         relay_client_free_all ();
     }
 
+    relay_irc_backlog_end ();
+
+    relay_weechat_msg_hdata_cache_free ();
+
     relay_network_end ();
 
     relay_config_free ();
@@ -41,6 +41,9 @@
 #include "../relay-raw.h"
 
 
+struct t_hashtable *relay_weechat_msg_hdata_cache = NULL; /* compiled paths */
+
+
 /*
  * Builds a new message (for sending to client).
  *
@@ -319,215 +322,696 @@ relay_weechat_msg_add_hashtable (struct t_relay_weechat_msg *msg,
                            &relay_weechat_msg_hashtable_map_cb, msg);
 }
 
+/*
+ * Returns object type (for binary message) of a hdata variable type.
+ *
+ * Returns NULL if the hdata type is not supported in message.
+ */
+
+const char *
+relay_weechat_msg_hdata_obj_type (int hdata_type)
+{
+    switch (hdata_type)
+    {
+        case WEECHAT_HDATA_CHAR:
+            return RELAY_WEECHAT_MSG_OBJ_CHAR;
+        case WEECHAT_HDATA_INTEGER:
+            return RELAY_WEECHAT_MSG_OBJ_INT;
+        case WEECHAT_HDATA_LONG:
+            return RELAY_WEECHAT_MSG_OBJ_LONG;
+        case WEECHAT_HDATA_STRING:
+        case WEECHAT_HDATA_SHARED_STRING:
+            return RELAY_WEECHAT_MSG_OBJ_STRING;
+        case WEECHAT_HDATA_POINTER:
+            return RELAY_WEECHAT_MSG_OBJ_POINTER;
+        case WEECHAT_HDATA_TIME:
+            return RELAY_WEECHAT_MSG_OBJ_TIME;
+        case WEECHAT_HDATA_HASHTABLE:
+            return RELAY_WEECHAT_MSG_OBJ_HASHTABLE;
+    }
+
+    return NULL;
+}
+
+/*
+ * Extracts the counter of an element in hdata path ("name(N)" or "name(*)").
+ *
+ * If counter is "*", count_all is set to 1, otherwise count is set to
+ * the number of objects to move after the first one (it can be negative).
+ */
+
+void
+relay_weechat_msg_hdata_parse_count (const char *element,
+                                     int *count_all, int *count)
+{
+    const char *pos, *pos2;
+    char *str_count, *error;
+
+    *count_all = 0;
+    *count = 0;
+
+    pos = strchr (element, '(');
+    if (!pos)
+        return;
+
+    pos2 = strchr (pos + 1, ')');
+    if (!pos2 || (pos2 <= pos + 1))
+        return;
+
+    str_count = weechat_strndup (pos + 1, pos2 - (pos + 1));
+    if (!str_count)
+        return;
+
+    if (strcmp (str_count, "*") == 0)
+    {
+        *count_all = 1;
+    }
+    else
+    {
+        error = NULL;
+        *count = (int)strtol (str_count, &error, 10);
+        if (error && !error[0])
+        {
+            if (*count > 0)
+                (*count)--;
+            else if (*count < 0)
+                (*count)++;
+        }
+        else
+            *count = 0;
+    }
+    free (str_count);
+}
+
+/*
+ * Returns offset of variable used to move in hdata list (property
+ * "var_prev" or "var_next"), -1 if not found.
+ */
+
+int
+relay_weechat_msg_hdata_move_offset (struct t_hdata *hdata,
+                                     const char *property)
+{
+    const char *var_name;
+
+    var_name = weechat_hdata_get_string (hdata, property);
+    if (!var_name)
+        return -1;
+
+    return weechat_hdata_get_var_offset (hdata, var_name);
+}
+
+/*
+ * Frees a compiled hdata path.
+ */
+
+void
+relay_weechat_msg_hdata_compiled_free (struct t_relay_weechat_msg_hdata *compiled)
+{
+    int i;
+
+    if (!compiled)
+        return;
+
+    if (compiled->path)
+    {
+        for (i = 0; i < compiled->num_path; i++)
+        {
+            if (compiled->path[i].name_sub)
+                free (compiled->path[i].name_sub);
+        }
+        free (compiled->path);
+    }
+    if (compiled->keys)
+    {
+        for (i = 0; i < compiled->num_keys; i++)
+        {
+            if (compiled->keys[i].name)
+                free (compiled->keys[i].name);
+        }
+        free (compiled->keys);
+    }
+    if (compiled->path_returned)
+        free (compiled->path_returned);
+    if (compiled->keys_types)
+        free (compiled->keys_types);
+
+    free (compiled);
+}
+
+/*
+ * Compiles a hdata path and a list of keys.
+ *
+ * The hdata, offsets and types of all variables are resolved once, so that
+ * objects can then be added to messages without any lookup by name.
+ *
+ * Argument list_path is the path split on "/" (the first element is the
+ * list or pointer, it is not used here except for its counter).
+ *
+ * Argument keys is optional: if NULL, all keys of last hdata are used.
+ *
+ * Returns pointer to compiled hdata path, NULL if error.
+ */
+
+struct t_relay_weechat_msg_hdata *
+relay_weechat_msg_hdata_compile (const char *hdata_head_name,
+                                 struct t_hdata *hdata_head,
+                                 char **list_path, int num_path,
+                                 const char *keys)
+{
+    struct t_relay_weechat_msg_hdata *compiled;
+    struct t_relay_weechat_msg_hdata_key *ptr_key;
+    struct t_hdata *ptr_hdata;
+    char **list_keys, *pos, *name, *path_returned;
+    const char *hdata_name, *obj_type;
+    int i, num_keys, type, length;
+
+    if (!hdata_head || !list_path || (num_path < 1))
+        return NULL;
+
+    list_keys = NULL;
+
+    compiled = malloc (sizeof (*compiled));
+    if (!compiled)
+        return NULL;
+
+    compiled->hdata_head = hdata_head;
+    compiled->num_path = num_path;
+    compiled->path = calloc (num_path, sizeof (*compiled->path));
+    compiled->num_keys = 0;
+    compiled->keys = NULL;
+    compiled->path_returned = strdup (hdata_head_name);
+    compiled->keys_types = NULL;
+    if (!compiled->path || !compiled->path_returned)
+        goto error;
+
+    /*
+     * resolve hdata of each element in path, and build string with path
+     * where counters are removed and variable names are replaced by hdata
+     * name
+     */
+    ptr_hdata = hdata_head;
+    for (i = 0; i < num_path; i++)
+    {
+        compiled->path[i].hdata = ptr_hdata;
+        relay_weechat_msg_hdata_parse_count (list_path[i],
+                                             &(compiled->path[i].count_all),
+                                             &(compiled->path[i].count));
+        compiled->path[i].offset_prev =
+            relay_weechat_msg_hdata_move_offset (ptr_hdata, "var_prev");
+        compiled->path[i].offset_next =
+            relay_weechat_msg_hdata_move_offset (ptr_hdata, "var_next");
+        compiled->path[i].offset_sub = -1;
+        if (i < num_path - 1)
+        {
+            pos = strchr (list_path[i + 1], '(');
+            name = (pos) ?
+                weechat_strndup (list_path[i + 1], pos - list_path[i + 1]) :
+                strdup (list_path[i + 1]);
+            if (!name)
+                goto error;
+            compiled->path[i].offset_sub = weechat_hdata_get_var_offset (
+                ptr_hdata, name);
+            hdata_name = weechat_hdata_get_var_hdata (ptr_hdata, name);
+            if ((compiled->path[i].offset_sub < 0) || !hdata_name)
+            {
+                free (name);
+                goto error;
+            }
+            ptr_hdata = weechat_hdata_get (hdata_name);
+            if (!ptr_hdata)
+            {
+                free (name);
+                goto error;
+            }
+            /*
+             * the start of a list is read with the hdata API, because it may
+             * be computed on access (for example compressed lines of buffer)
+             */
+            if (weechat_hdata_get_string (ptr_hdata, "var_prev")
+                || weechat_hdata_get_string (ptr_hdata, "var_next"))
+            {
+                compiled->path[i].name_sub = name;
+            }
+            else
+                free (name);
+            length = strlen (compiled->path_returned) + 1
+                + strlen (hdata_name) + 1;
+            path_returned = realloc (compiled->path_returned, length);
+            if (!path_returned)
+                goto error;
+            compiled->path_returned = path_returned;
+            strcat (compiled->path_returned, "/");
+            strcat (compiled->path_returned, hdata_name);
+        }
+    }
+
+    /* split keys */
+    if (!keys)
+        keys = weechat_hdata_get_string (ptr_hdata, "var_keys");
+    list_keys = weechat_string_split (keys, ",", 0, 0, &num_keys);
+    if (!list_keys)
+        goto error;
+    compiled->keys = calloc (num_keys, sizeof (*compiled->keys));
+    if (!compiled->keys)
+        goto error;
+
+    /* build string with list of keys with types: "key1:type1,key2:type2,..." */
+    compiled->keys_types = malloc (strlen (keys) + (num_keys * 8) + 1);
+    if (!compiled->keys_types)
+        goto error;
+    compiled->keys_types[0] = '\0';
+    for (i = 0; i < num_keys; i++)
+    {
+        type = weechat_hdata_get_var_type (ptr_hdata, list_keys[i]);
+        if ((type < 0) || (type == WEECHAT_HDATA_OTHER))
+            continue;
+        obj_type = relay_weechat_msg_hdata_obj_type (type);
+        if (!obj_type)
+            continue;
+        ptr_key = &(compiled->keys[compiled->num_keys]);
+        ptr_key->name = strdup (list_keys[i]);
+        if (!ptr_key->name)
+            goto error;
+        compiled->num_keys++;
+        ptr_key->type = type;
+        ptr_key->offset = weechat_hdata_get_var_offset (ptr_hdata,
+                                                        list_keys[i]);
+        ptr_key->array = (weechat_hdata_get_var_array_size_string (
+                              ptr_hdata, NULL, list_keys[i])) ? 1 : 0;
+        if (compiled->keys_types[0])
+            strcat (compiled->keys_types, ",");
+        strcat (compiled->keys_types, list_keys[i]);
+        strcat (compiled->keys_types, ":");
+        strcat (compiled->keys_types,
+                (ptr_key->array) ? RELAY_WEECHAT_MSG_OBJ_ARRAY : obj_type);
+    }
+    if (!compiled->keys_types[0])
+        goto error;
+
+    weechat_string_free_split (list_keys);
+
+    return compiled;
+
+error:
+    if (list_keys)
+        weechat_string_free_split (list_keys);
+    relay_weechat_msg_hdata_compiled_free (compiled);
+    return NULL;
+}
+
+/*
+ * Callback called to free a compiled hdata path in cache.
+ */
+
+void
+relay_weechat_msg_hdata_cache_free_value_cb (struct t_hashtable *hashtable,
+                                             const void *key, void *value)
+{
+    /* make C compiler happy */
+    (void) hashtable;
+    (void) key;
+
+    relay_weechat_msg_hdata_compiled_free (
+        (struct t_relay_weechat_msg_hdata *)value);
+}
+
+/*
+ * Gets a compiled hdata path from cache, compiles it and adds it in cache if
+ * not found.
+ *
+ * Argument path_counter is the path without the name of list (or the pointer)
+ * in first element, so that the same compiled path is used for any pointer.
+ *
+ * Returns pointer to compiled hdata path, NULL if error.
+ */
+
+struct t_relay_weechat_msg_hdata *
+relay_weechat_msg_hdata_cache_get (const char *hdata_head_name,
+                                   struct t_hdata *hdata_head,
+                                   const char *path, const char *path_counter,
+                                   const char *keys)
+{
+    struct t_relay_weechat_msg_hdata *compiled;
+    char *key, **list_path;
+    int length, num_path;
+
+    length = strlen (hdata_head_name) + 1 + strlen (path_counter) + 1
+        + ((keys) ? strlen (keys) : 0) + 1;
+    key = malloc (length);
+    if (!key)
+        return NULL;
+    snprintf (key, length, "%s:%s\n%s",
+              hdata_head_name, path_counter, (keys) ? keys : "");
+
+    if (!relay_weechat_msg_hdata_cache)
+    {
+        relay_weechat_msg_hdata_cache = weechat_hashtable_new (
+            32,
+            WEECHAT_HASHTABLE_STRING,
+            WEECHAT_HASHTABLE_POINTER,
+            NULL, NULL);
+        if (!relay_weechat_msg_hdata_cache)
+        {
+            free (key);
+            return NULL;
+        }
+        weechat_hashtable_set_pointer (
+            relay_weechat_msg_hdata_cache,
+            "callback_free_value",
+            &relay_weechat_msg_hdata_cache_free_value_cb);
+    }
+
+    compiled = weechat_hashtable_get (relay_weechat_msg_hdata_cache, key);
+    if (!compiled)
+    {
+        list_path = weechat_string_split (path, "/", 0, 0, &num_path);
+        if (list_path)
+        {
+            compiled = relay_weechat_msg_hdata_compile (hdata_head_name,
+                                                        hdata_head,
+                                                        list_path,
+                                                        num_path,
+                                                        keys);
+            weechat_string_free_split (list_path);
+        }
+        if (compiled)
+        {
+            if (weechat_hashtable_get_integer (relay_weechat_msg_hdata_cache,
+                                               "items_count") >= RELAY_WEECHAT_MSG_HDATA_CACHE_MAX)
+            {
+                weechat_hashtable_remove_all (relay_weechat_msg_hdata_cache);
+            }
+            if (!weechat_hashtable_set (relay_weechat_msg_hdata_cache,
+                                        key, compiled))
+            {
+                relay_weechat_msg_hdata_compiled_free (compiled);
+                compiled = NULL;
+            }
+        }
+    }
+
+    free (key);
+
+    return compiled;
+}
+
+/*
+ * Removes all compiled hdata paths from cache.
+ */
+
+void
+relay_weechat_msg_hdata_cache_flush ()
+{
+    if (relay_weechat_msg_hdata_cache)
+        weechat_hashtable_remove_all (relay_weechat_msg_hdata_cache);
+}
+
+/*
+ * Frees cache with compiled hdata paths.
+ */
+
+void
+relay_weechat_msg_hdata_cache_free ()
+{
+    if (relay_weechat_msg_hdata_cache)
+    {
+        weechat_hashtable_free (relay_weechat_msg_hdata_cache);
+        relay_weechat_msg_hdata_cache = NULL;
+    }
+}
+
+/*
+ * Callback for signals "plugin_loaded" and "plugin_unloaded".
+ *
+ * Hdata can be created or freed by plugins, so the compiled hdata paths
+ * (which have pointers to hdata) are removed from cache.
+ */
+
+int
+relay_weechat_msg_hdata_cache_signal_plugin_cb (const void *pointer,
+                                                void *data,
+                                                const char *signal,
+                                                const char *type_data,
+                                                void *signal_data)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) signal;
+    (void) type_data;
+    (void) signal_data;
+
+    relay_weechat_msg_hdata_cache_flush ();
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Adds value of a compiled hdata key to a message.
+ *
+ * If index is >= 0, the value is read in array at this index.
+ */
+
+void
+relay_weechat_msg_add_hdata_value (struct t_relay_weechat_msg *msg,
+                                   struct t_relay_weechat_msg_hdata_key *key,
+                                   void *pointer, int index)
+{
+    void *ptr_var;
+
+    ptr_var = pointer + key->offset;
+
+    switch (key->type)
+    {
+        case WEECHAT_HDATA_CHAR:
+            relay_weechat_msg_add_char (
+                msg,
+                (index >= 0) ?
+                (*((char **)ptr_var))[index] : *((char *)ptr_var));
+            break;
+        case WEECHAT_HDATA_INTEGER:
+            relay_weechat_msg_add_int (
+                msg, ((int *)ptr_var)[(index >= 0) ? index : 0]);
+            break;
+        case WEECHAT_HDATA_LONG:
+            relay_weechat_msg_add_long (
+                msg, ((long *)ptr_var)[(index >= 0) ? index : 0]);
+            break;
+        case WEECHAT_HDATA_STRING:
+        case WEECHAT_HDATA_SHARED_STRING:
+            relay_weechat_msg_add_string (
+                msg,
+                (index >= 0) ?
+                (*((char ***)ptr_var))[index] : *((char **)ptr_var));
+            break;
+        case WEECHAT_HDATA_POINTER:
+            relay_weechat_msg_add_pointer (
+                msg,
+                (index >= 0) ?
+                (*((void ***)ptr_var))[index] : *((void **)ptr_var));
+            break;
+        case WEECHAT_HDATA_TIME:
+            relay_weechat_msg_add_time (
+                msg, ((time_t *)ptr_var)[(index >= 0) ? index : 0]);
+            break;
+        case WEECHAT_HDATA_HASHTABLE:
+            relay_weechat_msg_add_hashtable (
+                msg,
+                (index >= 0) ?
+                (*((struct t_hashtable ***)ptr_var))[index] :
+                *((struct t_hashtable **)ptr_var));
+            break;
+    }
+}
+
+/*
+ * Checks if an object is still linked in its list: its previous object must
+ * point to it as next object and its next object must point to it as previous
+ * object.
+ *
+ * This check is used instead of weechat_hdata_check_pointer (which walks the
+ * whole list) when resuming an hdata sent by pages, so that each page costs
+ * only the objects it contains.
+ *
+ * Returns:
+ *   1: object is linked
+ *   0: object is not linked (removed from list)
+ */
+
+int
+relay_weechat_msg_hdata_path_linked (struct t_relay_weechat_msg_hdata_path *path,
+                                     void *pointer)
+{
+    void *ptr_prev, *ptr_next;
+
+    if (!pointer)
+        return 0;
+
+    if (path->offset_prev >= 0)
+    {
+        ptr_prev = *((void **)(pointer + path->offset_prev));
+        if (ptr_prev && (path->offset_next >= 0)
+            && (*((void **)(ptr_prev + path->offset_next)) != pointer))
+        {
+            return 0;
+        }
+    }
+
+    if (path->offset_next >= 0)
+    {
+        ptr_next = *((void **)(pointer + path->offset_next));
+        if (ptr_next && (path->offset_prev >= 0)
+            && (*((void **)(ptr_next + path->offset_prev)) != pointer))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
 /*
  * Adds recursively hdata for a path to a message.
  *
+ * Argument count is the number of moves for objects of this element in path
+ * (see counter in struct t_relay_weechat_msg_hdata_path).
+ *
+ * If page is not NULL, the objects of element page->index in path are added
+ * until the page has at least page->size objects; then the next object and
+ * remaining count are saved in page (the next page will start with this
+ * object, if it is still in the list).
+ *
  * Returns the number of hdata objects added to message.
  */
 
 int
 relay_weechat_msg_add_hdata_path (struct t_relay_weechat_msg *msg,
-                                  char **list_path,
+                                  struct t_relay_weechat_msg_hdata *compiled,
                                   int index_path,
                                   void **path_pointers,
-                                  struct t_hdata *hdata,
                                   void *pointer,
-                                  char **list_keys)
+                                  int count,
+                                  struct t_relay_weechat_msg_hdata_page *page)
 {
-    int num_added, i, j, count, count_all, var_type, array_size, max_array_size;
-    int length;
-    char *pos, *pos2, *str_count, *error, *name;
+    struct t_relay_weechat_msg_hdata_path *ptr_path;
+    struct t_relay_weechat_msg_hdata_key *ptr_key;
+    int num_added, i, j, array_size;
     void *sub_pointer;
-    struct t_hdata *sub_hdata;
-    const char *sub_hdata_name;
 
     num_added = 0;
 
-    count_all = 0;
-    count = 0;
-    pos = strchr (list_path[index_path], '(');
-    if (pos)
+    ptr_path = &(compiled->path[index_path]);
+
+    if (page && (index_path == page->index) && page->pointer)
     {
-        pos2 = strchr (pos + 1, ')');
-        if (pos2 && (pos2 > pos + 1))
+        /* resume after the last page (if the object is still linked) */
+        if (!relay_weechat_msg_hdata_path_linked (ptr_path, page->pointer))
         {
-            str_count = weechat_strndup (pos + 1, pos2 - (pos + 1));
-            if (str_count)
-            {
-                if (strcmp (str_count, "*") == 0)
-                    count_all = 1;
-                else
-                {
-                    error = NULL;
-                    count = (int)strtol (str_count, &error, 10);
-                    if (error && !error[0])
-                    {
-                        if (count > 0)
-                            count--;
-                        else if (count < 0)
-                            count++;
-                    }
-                    else
-                        count = 0;
-                }
-                free (str_count);
-            }
+            page->pointer = NULL;
+            return 0;
         }
+        pointer = page->pointer;
+        count = page->count;
+        page->pointer = NULL;
     }
 
     while (pointer)
     {
         path_pointers[index_path] = pointer;
 
-        if (list_path[index_path + 1])
+        if (index_path < compiled->num_path - 1)
         {
             /* recursive call with next path */
-            pos = strchr (list_path[index_path + 1], '(');
-            if (pos)
-                pos[0] = '\0';
-            sub_pointer = weechat_hdata_pointer (hdata, pointer, list_path[index_path + 1]);
-            sub_hdata_name = weechat_hdata_get_var_hdata (hdata, list_path[index_path + 1]);
-            if (pos)
-                pos[0] = '(';
-            if (sub_pointer && sub_hdata_name)
+            sub_pointer = (ptr_path->name_sub) ?
+                weechat_hdata_pointer (ptr_path->hdata, pointer,
+                                       ptr_path->name_sub) :
+                *((void **)(pointer + ptr_path->offset_sub));
+            if (sub_pointer)
             {
-                sub_hdata = weechat_hdata_get (sub_hdata_name);
-                if (sub_hdata)
-                {
-                    num_added += relay_weechat_msg_add_hdata_path (msg,
-                                                                   list_path,
-                                                                   index_path + 1,
-                                                                   path_pointers,
-                                                                   sub_hdata,
-                                                                   sub_pointer,
-                                                                   list_keys);
-                }
+                num_added += relay_weechat_msg_add_hdata_path (
+                    msg,
+                    compiled,
+                    index_path + 1,
+                    path_pointers,
+                    sub_pointer,
+                    compiled->path[index_path + 1].count,
+                    page);
+                if (page && page->pointer)
+                    return num_added;
             }
         }
         else
         {
             /* last path? then get pointer + values and fill message with them */
-            for (i = 0; list_path[i]; i++)
+            for (i = 0; i < compiled->num_path; i++)
             {
                 relay_weechat_msg_add_pointer (msg, path_pointers[i]);
             }
-            for (i = 0; list_keys[i]; i++)
+            for (i = 0; i < compiled->num_keys; i++)
             {
-                var_type = weechat_hdata_get_var_type (hdata, list_keys[i]);
-                if ((var_type >= 0) && (var_type != WEECHAT_HDATA_OTHER))
+                ptr_key = &(compiled->keys[i]);
+                if (ptr_key->array)
                 {
-                    max_array_size = 1;
-                    array_size = weechat_hdata_get_var_array_size (hdata,
-                                                                   pointer,
-                                                                   list_keys[i]);
+                    array_size = weechat_hdata_get_var_array_size (
+                        ptr_path->hdata, pointer, ptr_key->name);
                     if (array_size >= 0)
                     {
-                        switch (var_type)
+                        relay_weechat_msg_add_type (
+                            msg,
+                            relay_weechat_msg_hdata_obj_type (ptr_key->type));
+                        relay_weechat_msg_add_int (msg, array_size);
+                        for (j = 0; j < array_size; j++)
                         {
-                            case WEECHAT_HDATA_CHAR:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_CHAR);
-                                break;
-                            case WEECHAT_HDATA_INTEGER:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_INT);
-                                break;
-                            case WEECHAT_HDATA_LONG:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_LONG);
-                                break;
-                            case WEECHAT_HDATA_STRING:
-                            case WEECHAT_HDATA_SHARED_STRING:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_STRING);
-                                break;
-                            case WEECHAT_HDATA_POINTER:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_POINTER);
-                                break;
-                            case WEECHAT_HDATA_TIME:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_TIME);
-                                break;
-                            case WEECHAT_HDATA_HASHTABLE:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_HASHTABLE);
-                                break;
+                            relay_weechat_msg_add_hdata_value (msg, ptr_key,
+                                                               pointer, j);
                         }
-                        relay_weechat_msg_add_int (msg, array_size);
-                        max_array_size = array_size;
                     }
-                    length = 16 + strlen (list_keys[i]) + 1;
-                    name = malloc (length);
-                    if (name)
+                    else
                     {
-                        for (j = 0; j < max_array_size; j++)
-                        {
-                            snprintf (name, length, "%d|%s", j, list_keys[i]);
-                            switch (var_type)
-                            {
-                                case WEECHAT_HDATA_CHAR:
-                                    relay_weechat_msg_add_char (msg,
-                                                                weechat_hdata_char (hdata,
-                                                                                    pointer,
-                                                                                    name));
-                                    break;
-                                case WEECHAT_HDATA_INTEGER:
-                                    relay_weechat_msg_add_int (msg,
-                                                               weechat_hdata_integer (hdata,
-                                                                                      pointer,
-                                                                                      name));
-                                    break;
-                                case WEECHAT_HDATA_LONG:
-                                    relay_weechat_msg_add_long (msg,
-                                                                weechat_hdata_long (hdata,
-                                                                                    pointer,
-                                                                                    name));
-                                    break;
-                                case WEECHAT_HDATA_STRING:
-                                case WEECHAT_HDATA_SHARED_STRING:
-                                    relay_weechat_msg_add_string (msg,
-                                                                  weechat_hdata_string (hdata,
-                                                                                        pointer,
-                                                                                        name));
-                                    break;
-                                case WEECHAT_HDATA_POINTER:
-                                    relay_weechat_msg_add_pointer (msg,
-                                                                   weechat_hdata_pointer (hdata,
-                                                                                          pointer,
-                                                                                          name));
-                                    break;
-                                case WEECHAT_HDATA_TIME:
-                                    relay_weechat_msg_add_time (msg,
-                                                                weechat_hdata_time (hdata,
-                                                                                    pointer,
-                                                                                    name));
-                                    break;
-                                case WEECHAT_HDATA_HASHTABLE:
-                                    relay_weechat_msg_add_hashtable (msg,
-                                                                     weechat_hdata_hashtable (hdata,
-                                                                                              pointer,
-                                                                                              name));
-                                    break;
-                            }
-                        }
-                        free (name);
+                        relay_weechat_msg_add_hdata_value (msg, ptr_key,
+                                                           pointer, 0);
                     }
                 }
+                else
+                {
+                    relay_weechat_msg_add_hdata_value (msg, ptr_key,
+                                                       pointer, -1);
+                }
             }
             num_added++;
         }
-        if (count_all)
+        if (ptr_path->count_all || (count > 0))
         {
-            pointer = weechat_hdata_move (hdata, pointer, 1);
+            pointer = (ptr_path->offset_next >= 0) ?
+                *((void **)(pointer + ptr_path->offset_next)) : NULL;
+            if (count > 0)
+                count--;
         }
-        else if (count == 0)
-            pointer = NULL;
-        else if (count > 0)
+        else if (count < 0)
         {
-            pointer = weechat_hdata_move (hdata, pointer, 1);
-            count--;
+            if (ptr_path->offset_prev >= 0)
+            {
+                /* at start of list, let hdata API compute previous element */
+                pointer = (*((void **)(pointer + ptr_path->offset_prev))) ?
+                    *((void **)(pointer + ptr_path->offset_prev)) :
+                    weechat_hdata_move (ptr_path->hdata, pointer, -1);
+            }
+            else
+                pointer = NULL;
+            count++;
         }
         else
+            pointer = NULL;
+
+        if (page && (index_path == page->index) && pointer
+            && (num_added >= page->size))
         {
-            pointer = weechat_hdata_move (hdata, pointer, -1);
-            count++;
+            /* page is full: save position for next page */
+            page->pointer = pointer;
+            page->count = count;
+            return num_added;
         }
-        if (!pointer)
-            break;
     }
 
     return num_added;
@@ -543,6 +1027,10 @@ relay_weechat_msg_add_hdata_path (struct t_relay_weechat_msg *msg,
  * Argument keys is optional: if not NULL, comma-separated list of keys to
  * return for hdata.
  *
+ * The path (without the list name or pointer) and keys are compiled once and
+ * kept in a cache, so that the same request or event is then built without
+ * any parsing or lookup of variables by name.
+ *
  * Returns:
  *   1: hdata added to message
  *   0: error (hdata NOT added to message)
@@ -552,24 +1040,52 @@ int
 relay_weechat_msg_add_hdata (struct t_relay_weechat_msg *msg,
                              const char *path, const char *keys)
 {
-    struct t_hdata *ptr_hdata_head, *ptr_hdata;
-    char *hdata_head, *pos, **list_keys, *keys_types, **list_path;
-    char *path_returned;
-    const char *hdata_name, *array_size;
-    void *pointer, **path_pointers;
+    return relay_weechat_msg_add_hdata_page (msg, path, keys, NULL);
+}
+
+/*
+ * Adds a page of hdata to a message (see function relay_weechat_msg_add_hdata
+ * for the format of path and keys).
+ *
+ * If page is NULL, all objects are added to message.
+ *
+ * Otherwise, objects are added until the message contains at least
+ * page->size objects, and the position is saved in page: the function must
+ * be called again with the same path, keys and page to add the next page,
+ * until page->end is set to 1.
+ * The hdata is split only between objects of the first element in path with
+ * a counter, and only if it is iterated forward (for example "gui_buffers(*)"
+ * or "first_line(*)" in "buffer:0x123/own_lines/first_line(*)/data"), so a
+ * page can contain more than page->size objects. Before a page is added, the
+ * saved pointer is checked in the list: if it does not exist any more (for
+ * example buffer closed or line removed), the hdata ends.
+ *
+ * Returns:
+ *   1: hdata added to message
+ *   0: error (hdata NOT added to message)
+ */
+
+int
+relay_weechat_msg_add_hdata_page (struct t_relay_weechat_msg *msg,
+                                  const char *path, const char *keys,
+                                  struct t_relay_weechat_msg_hdata_page *page)
+{
+    struct t_relay_weechat_msg_hdata *compiled;
+    struct t_hdata *ptr_hdata_head;
+    char *hdata_head, *list_name;
+    const char *pos, *pos_counter, *pos_next;
+    void *pointer, **path_pointers, *resume_pointer;
     long unsigned int value;
-    int rc, num_keys, num_path, i, type, pos_count, count, rc_sscanf;
+    int rc, pos_count, rc_sscanf, i;
     uint32_t count32;
 
     rc = 0;
 
     hdata_head = NULL;
-    list_keys = NULL;
-    num_keys = 0;
-    keys_types = NULL;
-    list_path = NULL;
-    num_path = 0;
-    path_returned = NULL;
+    list_name = NULL;
+
+    if (page)
+        page->end = 1;
 
     /* extract hdata name (head) from path */
     pos = strchr (path, ':');
@@ -582,19 +1098,25 @@ relay_weechat_msg_add_hdata (struct t_relay_weechat_msg *msg,
     if (!ptr_hdata_head)
         goto end;
 
-    /* split path */
-    list_path = weechat_string_split (pos + 1, "/", 0, 0, &num_path);
-    if (!list_path)
+    /* extract list name or pointer from first element of path */
+    pos++;
+    pos_next = strchr (pos, '/');
+    if (!pos_next)
+        pos_next = pos + strlen (pos);
+    pos_counter = strchr (pos, '(');
+    if (!pos_counter || (pos_counter > pos_next))
+        pos_counter = pos_next;
+    if (pos_counter == pos)
+        goto end;
+    list_name = weechat_strndup (pos, pos_counter - pos);
+    if (!list_name)
         goto end;
 
-    /* extract pointer from first path (direct pointer or list name) */
+    /* get pointer (direct pointer or list name) */
     pointer = NULL;
-    pos = strchr (list_path[0], '(');
-    if (pos)
-        pos[0] = '\0';
-    if (strncmp (list_path[0], "0x", 2) == 0)
+    if (strncmp (list_name, "0x", 2) == 0)
     {
-        rc_sscanf = sscanf (list_path[0], "%lx", &value);
+        rc_sscanf = sscanf (list_name, "%lx", &value);
         if ((rc_sscanf != EOF) && (rc_sscanf != 0))
         {
             pointer = (void *)value;
@@ -613,133 +1135,75 @@ relay_weechat_msg_add_hdata (struct t_relay_weechat_msg *msg,
         }
     }
     else
-        pointer = weechat_hdata_get_list (ptr_hdata_head, list_path[0]);
-    if (pos)
-        pos[0] = '(';
+        pointer = weechat_hdata_get_list (ptr_hdata_head, list_name);
     if (!pointer)
         goto end;
 
-    /*
-     * build string with path where:
-     * - counters are removed
-     * - variable names are replaced by hdata name
-     */
-    path_returned = malloc (strlen (path) * 2);
-    if (!path_returned)
-        goto end;
-    ptr_hdata = ptr_hdata_head;
-    strcpy (path_returned, hdata_head);
-    for (i = 1; i < num_path; i++)
-    {
-        pos = strchr (list_path[i], '(');
-        if (pos)
-            pos[0] = '\0';
-        hdata_name = weechat_hdata_get_var_hdata (ptr_hdata, list_path[i]);
-        if (!hdata_name)
-            goto end;
-        ptr_hdata = weechat_hdata_get (hdata_name);
-        if (!ptr_hdata)
-            goto end;
-        strcat (path_returned, "/");
-        strcat (path_returned, hdata_name);
-        if (pos)
-            pos[0] = '(';
-    }
-
-    /* split keys */
-    if (!keys)
-        keys = weechat_hdata_get_string (ptr_hdata, "var_keys");
-    list_keys = weechat_string_split (keys, ",", 0, 0, &num_keys);
-    if (!list_keys)
+    /* get compiled path and keys */
+    compiled = relay_weechat_msg_hdata_cache_get (hdata_head, ptr_hdata_head,
+                                                  pos, pos_counter, keys);
+    if (!compiled)
         goto end;
 
-    /* build string with list of keys with types: "key1:type1,key2:type2,..." */
-    keys_types = malloc (strlen (keys) + (num_keys * 8) + 1);
-    if (!keys_types)
-        goto end;
-    keys_types[0] = '\0';
-    for (i = 0; i < num_keys; i++)
+    /*
+     * hdata can be split only on the first element with a counter, if it is
+     * iterated forward
+     */
+    if (page)
     {
-        type = weechat_hdata_get_var_type (ptr_hdata, list_keys[i]);
-        if ((type >= 0) && (type != WEECHAT_HDATA_OTHER))
+        for (i = 0; i < compiled->num_path; i++)
         {
-            if (keys_types[0])
-                strcat (keys_types, ",");
-            strcat (keys_types, list_keys[i]);
-            strcat (keys_types, ":");
-            array_size = weechat_hdata_get_var_array_size_string (ptr_hdata,
-                                                                  NULL,
-                                                                  list_keys[i]);
-            if (array_size)
-                strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_ARRAY);
-            else
-            {
-                switch (type)
-                {
-                    case WEECHAT_HDATA_CHAR:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_CHAR);
-                        break;
-                    case WEECHAT_HDATA_INTEGER:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_INT);
-                        break;
-                    case WEECHAT_HDATA_LONG:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_LONG);
-                        break;
-                    case WEECHAT_HDATA_STRING:
-                    case WEECHAT_HDATA_SHARED_STRING:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_STRING);
-                        break;
-                    case WEECHAT_HDATA_POINTER:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_POINTER);
-                        break;
-                    case WEECHAT_HDATA_TIME:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_TIME);
-                        break;
-                    case WEECHAT_HDATA_HASHTABLE:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_HASHTABLE);
-                        break;
-                }
-            }
+            if (compiled->path[i].count_all || compiled->path[i].count)
+                break;
+        }
+        if ((page->size <= 0) || (i >= compiled->num_path)
+            || (compiled->path[i].count < 0))
+        {
+            if (page->pointer)
+                goto end;
+            page = NULL;
         }
+        else
+            page->index = i;
     }
-    if (!keys_types[0])
-        goto end;
 
     /* start hdata in message */
     relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_HDATA);
-    relay_weechat_msg_add_string (msg, path_returned);
-    relay_weechat_msg_add_string (msg, keys_types);
+    relay_weechat_msg_add_string (msg, compiled->path_returned);
+    relay_weechat_msg_add_string (msg, compiled->keys_types);
 
     /* "count" will be set later, with number of objects in hdata */
     pos_count = msg->data_size;
-    count = 0;
+    count32 = 0;
     relay_weechat_msg_add_int (msg, 0);
-    path_pointers = malloc (sizeof (*path_pointers) * num_path);
+    resume_pointer = (page) ? page->pointer : NULL;
+    path_pointers = malloc (sizeof (*path_pointers) * compiled->num_path);
     if (path_pointers)
     {
-        count = relay_weechat_msg_add_hdata_path (msg,
-                                                  list_path,
-                                                  0,
-                                                  path_pointers,
-                                                  ptr_hdata_head,
-                                                  pointer,
-                                                  list_keys);
+        count32 = relay_weechat_msg_add_hdata_path (msg,
+                                                    compiled,
+                                                    0,
+                                                    path_pointers,
+                                                    pointer,
+                                                    compiled->path[0].count,
+                                                    page);
         free (path_pointers);
     }
-    count32 = htonl ((uint32_t)count);
+    count32 = htonl (count32);
     relay_weechat_msg_set_bytes (msg, pos_count, &count32, 4);
 
+    /*
+     * if the element where the hdata was split has not been reached (for
+     * example all lines of buffer have been removed), the hdata ends
+     */
+    if (page && page->pointer && (page->pointer != resume_pointer))
+        page->end = 0;
+
     rc = 1;
 
 end:
-    if (list_keys)
-        weechat_string_free_split (list_keys);
-    if (keys_types)
-        free (keys_types);
-    if (list_path)
-        weechat_string_free_split (list_path);
-    if (path_returned)
-        free (path_returned);
+    if (list_name)
+        free (list_name);
     if (hdata_head)
         free (hdata_head);
 
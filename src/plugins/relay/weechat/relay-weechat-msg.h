@@ -23,9 +23,13 @@
 #include <time.h>
 
 struct t_relay_weechat_nicklist;
+struct t_relay_weechat_msg_hdata_page;
 
 #define RELAY_WEECHAT_MSG_INITIAL_ALLOC 4096
 
+/* max number of compiled hdata paths kept in cache */
+#define RELAY_WEECHAT_MSG_HDATA_CACHE_MAX 256
+
 /* object ids in binary messages */
 #define RELAY_WEECHAT_MSG_OBJ_CHAR      "chr"
 #define RELAY_WEECHAT_MSG_OBJ_INT       "int"
@@ -48,6 +52,46 @@ struct t_relay_weechat_msg
     int data_size;                     /* current size of buffer            */
 };
 
+/* element of a compiled hdata path */
+
+struct t_relay_weechat_msg_hdata_path
+{
+    struct t_hdata *hdata;             /* hdata of objects in this element  */
+    int count_all;                     /* 1 if counter is "*"               */
+    int count;                         /* number of moves (< 0 = backward)  */
+    int offset_prev;                   /* offset of var_prev (-1 if none)   */
+    int offset_next;                   /* offset of var_next (-1 if none)   */
+    int offset_sub;                    /* offset of pointer to next element */
+                                       /* in path (-1 for last element)     */
+    char *name_sub;                    /* name of pointer to next element   */
+                                       /* if it is in a list (NULL if not)  */
+};
+
+/* key (variable) of a compiled hdata path */
+
+struct t_relay_weechat_msg_hdata_key
+{
+    char *name;                        /* variable name                     */
+    int type;                          /* hdata type (WEECHAT_HDATA_XXX)    */
+    int offset;                        /* offset of variable in object      */
+    int array;                         /* 1 if variable is an array         */
+};
+
+/* compiled hdata path with keys (cached by path and keys) */
+
+struct t_relay_weechat_msg_hdata
+{
+    struct t_hdata *hdata_head;        /* hdata of first element in path    */
+    int num_path;                      /* number of elements in path        */
+    struct t_relay_weechat_msg_hdata_path *path; /* elements of path        */
+    int num_keys;                      /* number of keys                    */
+    struct t_relay_weechat_msg_hdata_key *keys;  /* keys (of last hdata)    */
+    char *path_returned;               /* path with hdata names (sent)      */
+    char *keys_types;                  /* "key1:type1,key2:type2,..." (sent)*/
+};
+
+extern struct t_hashtable *relay_weechat_msg_hdata_cache;
+
 extern struct t_relay_weechat_msg *relay_weechat_msg_new (const char *id);
 extern void relay_weechat_msg_add_bytes (struct t_relay_weechat_msg *msg,
                                          const void *buffer, int size);
@@ -70,8 +114,19 @@ extern void relay_weechat_msg_add_pointer (struct t_relay_weechat_msg *msg,
                                            void *pointer);
 extern void relay_weechat_msg_add_time (struct t_relay_weechat_msg *msg,
                                         time_t time);
+extern void relay_weechat_msg_hdata_cache_flush ();
+extern void relay_weechat_msg_hdata_cache_free ();
+extern int relay_weechat_msg_hdata_cache_signal_plugin_cb (const void *pointer,
+                                                           void *data,
+                                                           const char *signal,
+                                                           const char *type_data,
+                                                           void *signal_data);
 extern int relay_weechat_msg_add_hdata (struct t_relay_weechat_msg *msg,
                                         const char *path, const char *keys);
+extern int relay_weechat_msg_add_hdata_page (struct t_relay_weechat_msg *msg,
+                                             const char *path,
+                                             const char *keys,
+                                             struct t_relay_weechat_msg_hdata_page *page);
 extern void relay_weechat_msg_add_infolist (struct t_relay_weechat_msg *msg,
                                             const char *name,
                                             void *pointer,
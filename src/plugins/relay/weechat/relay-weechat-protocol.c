@@ -165,12 +165,14 @@ relay_weechat_protocol_is_sync (struct t_relay_client *ptr_client,
  *   init password=mypass
  *   init password=mypass,compression=zlib
  *   init password=mypass,compression=off
+ *   init password=mypass,hdata_page_size=1000
  */
 
 RELAY_WEECHAT_PROTOCOL_CALLBACK(init)
 {
-    char **options, *pos, *password;
+    char **options, *pos, *password, *error;
     int i, compression;
+    long number;
 
     RELAY_WEECHAT_PROTOCOL_MIN_ARGS(1);
 
@@ -206,6 +208,14 @@ RELAY_WEECHAT_PROTOCOL_CALLBACK(init)
                     if (compression >= 0)
                         RELAY_WEECHAT_DATA(client, compression) = compression;
                 }
+                else if (strcmp (options[i], "hdata_page_size") == 0)
+                {
+                    error = NULL;
+                    number = strtol (pos, &error, 10);
+                    if (error && !error[0] && (number >= 0)
+                        && (number <= RELAY_WEECHAT_HDATA_PAGE_SIZE_MAX))
+                        RELAY_WEECHAT_DATA(client, hdata_page_size) = number;
+                }
             }
         }
         weechat_string_free_split_command (options);
@@ -217,20 +227,117 @@ RELAY_WEECHAT_PROTOCOL_CALLBACK(init)
     return WEECHAT_RC_OK;
 }
 
+/*
+ * Sends next page of a hdata stream to client.
+ *
+ * The message contains the hdata, followed by an info "hdata_continuation"
+ * with the stream number as value if more pages will be sent, or NULL if
+ * this is the last page.
+ *
+ * Returns:
+ *   1: more pages will be sent
+ *   0: last page sent
+ */
+
+int
+relay_weechat_protocol_hdata_stream_send_page (struct t_relay_client *client,
+                                               struct t_relay_weechat_hdata_stream *stream)
+{
+    struct t_relay_weechat_msg *msg;
+    char str_number[32];
+
+    msg = relay_weechat_msg_new (stream->id);
+    if (!msg)
+        return 0;
+
+    if (!relay_weechat_msg_add_hdata_page (msg, stream->path, stream->keys,
+                                           &(stream->page)))
+    {
+        relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_HDATA);
+        relay_weechat_msg_add_string (msg, NULL);  /* h-path */
+        relay_weechat_msg_add_string (msg, NULL);  /* keys */
+        relay_weechat_msg_add_int (msg, 0);  /* count */
+    }
+    snprintf (str_number, sizeof (str_number), "%d", stream->number);
+    relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_INFO);
+    relay_weechat_msg_add_string (msg, "hdata_continuation");
+    relay_weechat_msg_add_string (msg,
+                                  (stream->page.end) ? NULL : str_number);
+    relay_weechat_msg_send (client, msg);
+    relay_weechat_msg_free (msg);
+
+    return (stream->page.end) ? 0 : 1;
+}
+
+/*
+ * Callback for timer sending pages of hdata streams.
+ *
+ * One page is sent on each call, and only if all data previously sent to
+ * client has been written on the socket (no message in outqueue), so that a
+ * large hdata does not block WeeChat nor fill memory with a slow client.
+ */
+
+int
+relay_weechat_protocol_timer_hdata_cb (const void *pointer, void *data,
+                                       int remaining_calls)
+{
+    struct t_relay_client *ptr_client;
+    struct t_relay_weechat_hdata_stream *ptr_stream;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) remaining_calls;
+
+    ptr_client = (struct t_relay_client *)pointer;
+    if (!ptr_client || !relay_client_valid (ptr_client))
+        return WEECHAT_RC_OK;
+
+    if (ptr_client->outqueue)
+        return WEECHAT_RC_OK;
+
+    ptr_stream = RELAY_WEECHAT_DATA(ptr_client, hdata_streams);
+    if (ptr_stream
+        && !relay_weechat_protocol_hdata_stream_send_page (ptr_client,
+                                                           ptr_stream))
+    {
+        relay_weechat_hdata_stream_free (ptr_client, ptr_stream);
+    }
+
+    return WEECHAT_RC_OK;
+}
+
 /*
  * Callback for command "hdata" (from client).
  *
  * Message looks like:
  *   hdata buffer:gui_buffers(*) number,name,type,nicklist,title
  *   hdata buffer:gui_buffers(*)/own_lines/first_line(*)/data date,displayed,prefix,message
+ *
+ * If the client has set option "hdata_page_size" in command "init", the
+ * hdata is sent by pages: the first page is sent immediately and the next
+ * ones are sent by a timer.
  */
 
 RELAY_WEECHAT_PROTOCOL_CALLBACK(hdata)
 {
     struct t_relay_weechat_msg *msg;
+    struct t_relay_weechat_hdata_stream *ptr_stream;
 
     RELAY_WEECHAT_PROTOCOL_MIN_ARGS(1);
 
+    if (RELAY_WEECHAT_DATA(client, hdata_page_size) > 0)
+    {
+        ptr_stream = relay_weechat_hdata_stream_new (
+            client, id, argv[0], (argc > 1) ? argv_eol[1] : NULL);
+        if (ptr_stream
+            && !relay_weechat_protocol_hdata_stream_send_page (client,
+                                                               ptr_stream))
+        {
+            relay_weechat_hdata_stream_free (client, ptr_stream);
+        }
+        return WEECHAT_RC_OK;
+    }
+
     msg = relay_weechat_msg_new (id);
     if (msg)
     {
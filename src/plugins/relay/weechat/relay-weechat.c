@@ -124,6 +124,112 @@ relay_weechat_hook_timer_nicklist (struct t_relay_client *client)
                             client, NULL);
 }
 
+/*
+ * Creates a new hdata stream (hdata sent by pages) for a client.
+ *
+ * The timer sending the pages is hooked if needed.
+ *
+ * Returns pointer to new stream, NULL if error.
+ */
+
+struct t_relay_weechat_hdata_stream *
+relay_weechat_hdata_stream_new (struct t_relay_client *client,
+                                const char *id, const char *path,
+                                const char *keys)
+{
+    struct t_relay_weechat_hdata_stream *new_stream;
+
+    if (!client || !path)
+        return NULL;
+
+    new_stream = malloc (sizeof (*new_stream));
+    if (!new_stream)
+        return NULL;
+
+    new_stream->number = ++(RELAY_WEECHAT_DATA(client, hdata_stream_count));
+    new_stream->id = (id) ? strdup (id) : NULL;
+    new_stream->path = strdup (path);
+    new_stream->keys = (keys) ? strdup (keys) : NULL;
+    new_stream->page.size = RELAY_WEECHAT_DATA(client, hdata_page_size);
+    new_stream->page.index = 0;
+    new_stream->page.pointer = NULL;
+    new_stream->page.count = 0;
+    new_stream->page.end = 0;
+
+    new_stream->prev_stream = RELAY_WEECHAT_DATA(client, last_hdata_stream);
+    new_stream->next_stream = NULL;
+    if (RELAY_WEECHAT_DATA(client, last_hdata_stream))
+        (RELAY_WEECHAT_DATA(client, last_hdata_stream))->next_stream = new_stream;
+    else
+        RELAY_WEECHAT_DATA(client, hdata_streams) = new_stream;
+    RELAY_WEECHAT_DATA(client, last_hdata_stream) = new_stream;
+
+    if (!RELAY_WEECHAT_DATA(client, hook_timer_hdata))
+    {
+        RELAY_WEECHAT_DATA(client, hook_timer_hdata) =
+            weechat_hook_timer (RELAY_WEECHAT_HDATA_STREAM_DELAY, 0, 0,
+                                &relay_weechat_protocol_timer_hdata_cb,
+                                client, NULL);
+    }
+
+    return new_stream;
+}
+
+/*
+ * Frees a hdata stream of a client.
+ *
+ * The timer sending the pages is removed if there are no more streams.
+ */
+
+void
+relay_weechat_hdata_stream_free (struct t_relay_client *client,
+                                 struct t_relay_weechat_hdata_stream *stream)
+{
+    if (!client || !stream)
+        return;
+
+    /* remove stream from list */
+    if (stream->prev_stream)
+        (stream->prev_stream)->next_stream = stream->next_stream;
+    if (stream->next_stream)
+        (stream->next_stream)->prev_stream = stream->prev_stream;
+    if (RELAY_WEECHAT_DATA(client, hdata_streams) == stream)
+        RELAY_WEECHAT_DATA(client, hdata_streams) = stream->next_stream;
+    if (RELAY_WEECHAT_DATA(client, last_hdata_stream) == stream)
+        RELAY_WEECHAT_DATA(client, last_hdata_stream) = stream->prev_stream;
+
+    /* free data */
+    if (stream->id)
+        free (stream->id);
+    if (stream->path)
+        free (stream->path);
+    if (stream->keys)
+        free (stream->keys);
+
+    free (stream);
+
+    if (!RELAY_WEECHAT_DATA(client, hdata_streams)
+        && RELAY_WEECHAT_DATA(client, hook_timer_hdata))
+    {
+        weechat_unhook (RELAY_WEECHAT_DATA(client, hook_timer_hdata));
+        RELAY_WEECHAT_DATA(client, hook_timer_hdata) = NULL;
+    }
+}
+
+/*
+ * Frees all hdata streams of a client.
+ */
+
+void
+relay_weechat_hdata_stream_free_all (struct t_relay_client *client)
+{
+    while (RELAY_WEECHAT_DATA(client, hdata_streams))
+    {
+        relay_weechat_hdata_stream_free (client,
+                                         RELAY_WEECHAT_DATA(client, hdata_streams));
+    }
+}
+
 /*
  * Reads data from a client.
  */
@@ -142,6 +248,7 @@ void
 relay_weechat_close_connection (struct t_relay_client *client)
 {
     relay_weechat_unhook_signals (client);
+    relay_weechat_hdata_stream_free_all (client);
 }
 
 /*
@@ -177,6 +284,7 @@ relay_weechat_alloc (struct t_relay_client *client)
     {
         RELAY_WEECHAT_DATA(client, password_ok) = (password && password[0]) ? 0 : 1;
         RELAY_WEECHAT_DATA(client, compression) = RELAY_WEECHAT_COMPRESSION_ZLIB;
+        RELAY_WEECHAT_DATA(client, hdata_page_size) = 0;
         RELAY_WEECHAT_DATA(client, buffers_sync) =
             weechat_hashtable_new (32,
                                    WEECHAT_HASHTABLE_STRING,
@@ -194,6 +302,10 @@ relay_weechat_alloc (struct t_relay_client *client)
                                        "callback_free_value",
                                        &relay_weechat_free_buffers_nicklist);
         RELAY_WEECHAT_DATA(client, hook_timer_nicklist) = NULL;
+        RELAY_WEECHAT_DATA(client, hdata_stream_count) = 0;
+        RELAY_WEECHAT_DATA(client, hdata_streams) = NULL;
+        RELAY_WEECHAT_DATA(client, last_hdata_stream) = NULL;
+        RELAY_WEECHAT_DATA(client, hook_timer_hdata) = NULL;
 
         relay_weechat_hook_signals (client);
     }
@@ -225,6 +337,8 @@ relay_weechat_alloc_with_infolist (struct t_relay_client *client,
             infolist, "password_ok");
         RELAY_WEECHAT_DATA(client, compression) = weechat_infolist_integer (
             infolist, "compression");
+        RELAY_WEECHAT_DATA(client, hdata_page_size) = weechat_infolist_integer (
+            infolist, "hdata_page_size");
 
         /* sync of buffers */
         RELAY_WEECHAT_DATA(client, buffers_sync) = weechat_hashtable_new (
@@ -258,6 +372,10 @@ relay_weechat_alloc_with_infolist (struct t_relay_client *client,
                                        "callback_free_value",
                                        &relay_weechat_free_buffers_nicklist);
         RELAY_WEECHAT_DATA(client, hook_timer_nicklist) = NULL;
+        RELAY_WEECHAT_DATA(client, hdata_stream_count) = 0;
+        RELAY_WEECHAT_DATA(client, hdata_streams) = NULL;
+        RELAY_WEECHAT_DATA(client, last_hdata_stream) = NULL;
+        RELAY_WEECHAT_DATA(client, hook_timer_hdata) = NULL;
 
         if (RELAY_CLIENT_HAS_ENDED(client))
         {
@@ -292,6 +410,7 @@ relay_weechat_free (struct t_relay_client *client)
             weechat_unhook (RELAY_WEECHAT_DATA(client, hook_signal_upgrade));
         if (RELAY_WEECHAT_DATA(client, buffers_nicklist))
             weechat_hashtable_free (RELAY_WEECHAT_DATA(client, buffers_nicklist));
+        relay_weechat_hdata_stream_free_all (client);
 
         free (client->protocol_data);
 
@@ -318,6 +437,8 @@ relay_weechat_add_to_infolist (struct t_infolist_item *item,
         return 0;
     if (!weechat_infolist_new_var_integer (item, "compression", RELAY_WEECHAT_DATA(client, compression)))
         return 0;
+    if (!weechat_infolist_new_var_integer (item, "hdata_page_size", RELAY_WEECHAT_DATA(client, hdata_page_size)))
+        return 0;
     if (!weechat_hashtable_add_to_infolist (RELAY_WEECHAT_DATA(client, buffers_sync), item, "buffers_sync"))
         return 0;
 
@@ -335,6 +456,7 @@ relay_weechat_print_log (struct t_relay_client *client)
     {
         weechat_log_printf ("    password_ok. . . . . . : %d",   RELAY_WEECHAT_DATA(client, password_ok));
         weechat_log_printf ("    compression. . . . . . : %d",   RELAY_WEECHAT_DATA(client, compression));
+        weechat_log_printf ("    hdata_page_size. . . . : %d",   RELAY_WEECHAT_DATA(client, hdata_page_size));
         weechat_log_printf ("    buffers_sync . . . . . : 0x%lx (hashtable: '%s')",
                             RELAY_WEECHAT_DATA(client, buffers_sync),
                             weechat_hashtable_get_string (RELAY_WEECHAT_DATA(client, buffers_sync),
@@ -347,5 +469,9 @@ relay_weechat_print_log (struct t_relay_client *client)
                             weechat_hashtable_get_string (RELAY_WEECHAT_DATA(client, buffers_nicklist),
                                                           "keys_values"));
         weechat_log_printf ("    hook_timer_nicklist. . : 0x%lx", RELAY_WEECHAT_DATA(client, hook_timer_nicklist));
+        weechat_log_printf ("    hdata_stream_count . . : %d",   RELAY_WEECHAT_DATA(client, hdata_stream_count));
+        weechat_log_printf ("    hdata_streams. . . . . : 0x%lx", RELAY_WEECHAT_DATA(client, hdata_streams));
+        weechat_log_printf ("    last_hdata_stream. . . : 0x%lx", RELAY_WEECHAT_DATA(client, last_hdata_stream));
+        weechat_log_printf ("    hook_timer_hdata . . . : 0x%lx", RELAY_WEECHAT_DATA(client, hook_timer_hdata));
     }
 }
@@ -33,10 +33,40 @@ enum t_relay_weechat_compression
     RELAY_WEECHAT_NUM_COMPRESSIONS,
 };
 
+#define RELAY_WEECHAT_HDATA_STREAM_DELAY 10   /* ms between 2 hdata pages  */
+#define RELAY_WEECHAT_HDATA_PAGE_SIZE_MAX 1000000 /* max "hdata_page_size"  */
+
+/* position in hdata sent by pages (see relay_weechat_msg_add_hdata_page) */
+
+struct t_relay_weechat_msg_hdata_page
+{
+    int size;                          /* min number of objects in a page   */
+    int index;                         /* index of element split in path    */
+    void *pointer;                     /* next object of first element in   */
+                                       /* path (NULL for first page)        */
+    int count;                         /* remaining moves from this object  */
+    int end;                           /* 1 if last page has been added     */
+};
+
+/* hdata sent by pages to client (init option "hdata_page_size") */
+
+struct t_relay_weechat_hdata_stream
+{
+    int number;                        /* continuation id sent to client    */
+    char *id;                          /* message id (from client command)  */
+    char *path;                        /* hdata path                        */
+    char *keys;                        /* keys (NULL = all keys)            */
+    struct t_relay_weechat_msg_hdata_page page; /* position in hdata        */
+    struct t_relay_weechat_hdata_stream *prev_stream; /* previous stream    */
+    struct t_relay_weechat_hdata_stream *next_stream; /* next stream        */
+};
+
 struct t_relay_weechat_data
 {
     int password_ok;                   /* password received and OK?         */
     enum t_relay_weechat_compression compression; /* compression type       */
+    int hdata_page_size;               /* min objects by hdata message      */
+                                       /* (0 = send hdata in one message)   */
 
     /* sync of buffers */
     struct t_hashtable *buffers_sync;  /* buffers synchronized (events      */
@@ -46,12 +76,25 @@ struct t_relay_weechat_data
     struct t_hook *hook_signal_upgrade;   /* hook for signals "upgrade*"    */
     struct t_hashtable *buffers_nicklist; /* send nicklist for these buffers*/
     struct t_hook *hook_timer_nicklist;   /* timer for sending nicklist     */
+
+    /* hdata sent by pages */
+    int hdata_stream_count;            /* number of hdata streams created   */
+    struct t_relay_weechat_hdata_stream *hdata_streams;  /* pending hdata   */
+    struct t_relay_weechat_hdata_stream *last_hdata_stream; /* last stream  */
+    struct t_hook *hook_timer_hdata;   /* timer for sending hdata pages     */
 };
 
 extern int relay_weechat_compression_search (const char *compression);
 extern void relay_weechat_hook_signals (struct t_relay_client *client);
 extern void relay_weechat_unhook_signals (struct t_relay_client *client);
 extern void relay_weechat_hook_timer_nicklist (struct t_relay_client *client);
+extern struct t_relay_weechat_hdata_stream *relay_weechat_hdata_stream_new (struct t_relay_client *client,
+                                                                            const char *id,
+                                                                            const char *path,
+                                                                            const char *keys);
+extern void relay_weechat_hdata_stream_free (struct t_relay_client *client,
+                                             struct t_relay_weechat_hdata_stream *stream);
+extern void relay_weechat_hdata_stream_free_all (struct t_relay_client *client);
 extern void relay_weechat_recv (struct t_relay_client *client,
                                 const char *data);
 extern void relay_weechat_close_connection (struct t_relay_client *client);
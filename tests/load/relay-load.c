@@ -0,0 +1,1417 @@
+/*
+ * relay-load.c - load test of relay plugin with synthetic clients
+ *
+ * Copyright (C) 2017 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This program runs WeeChat (without interface) with the irc and relay
+ * plugins loaded, and:
+ *
+ *   1. starts a fake IRC server (child process), WeeChat connects to it and
+ *      joins the channel "#load";
+ *   2. starts synthetic relay clients (one child process per client), using
+ *      the weechat and/or irc protocol, optionally over websocket;
+ *   3. the fake IRC server sends messages to the channel at a given rate,
+ *      each message contains the time when it was sent;
+ *   4. at the end, statistics are displayed: end-to-end latency (from the
+ *      fake IRC server to the relay clients), bytes per line per client,
+ *      CPU used by WeeChat per client and memory growth of WeeChat.
+ *
+ * Optionally, messages are sent in the channel before clients connect, and
+ * clients with irc protocol check that they receive all these messages in
+ * backlog (oldest lines of the channel can be compressed in WeeChat).
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <limits.h>
+#include <getopt.h>
+#include <signal.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#ifndef HAVE_CONFIG_H
+#define HAVE_CONFIG_H
+#endif
+#include "src/core/weechat.h"
+#include "src/core/wee-hook.h"
+#include "src/core/wee-input.h"
+#include "src/core/wee-string.h"
+#include "src/plugins/plugin.h"
+#include "src/gui/gui-buffer.h"
+#include "src/gui/gui-line.h"
+#include "src/gui/gui-main.h"
+
+extern void gui_main_init ();
+
+#ifndef RELAY_LOAD_PLUGINS_DIR
+#define RELAY_LOAD_PLUGINS_DIR "."
+#endif
+
+#define RELAY_LOAD_DIR             "./tmp_weechat_relay_load"
+#define RELAY_LOAD_PASSWORD        "load"
+#define RELAY_LOAD_CHANNEL         "#load"
+#define RELAY_LOAD_MARKER          "LOAD:"
+#define RELAY_LOAD_MARKER_BACKLOG  "BACKLOG:"
+#define RELAY_LOAD_BACKLOG_MAX     4096
+#define RELAY_LOAD_READY_TIMEOUT   30
+#define RELAY_LOAD_DRAIN_DELAY     2
+
+/*
+ * latency histogram: 16 sub-buckets for each power of 2 (in microseconds),
+ * precision is about 6%
+ */
+#define RELAY_LOAD_HIST_SUB        16
+#define RELAY_LOAD_HIST_SIZE       (48 * RELAY_LOAD_HIST_SUB)
+
+enum t_relay_load_client_type
+{
+    RELAY_LOAD_CLIENT_WEECHAT = 0,
+    RELAY_LOAD_CLIENT_IRC,
+    /* number of client types */
+    RELAY_LOAD_NUM_CLIENT_TYPES,
+};
+
+struct t_relay_load_stats
+{
+    long long lines;                   /* number of lines received          */
+    long long bytes;                   /* number of bytes received          */
+    long long latency_max;             /* max latency (in microseconds)     */
+    long long hist[RELAY_LOAD_HIST_SIZE]; /* latency histogram              */
+    long long backlog_first;           /* first line received in backlog    */
+    long long backlog_last;            /* last line received in backlog     */
+};
+
+struct t_relay_load_options
+{
+    int clients[RELAY_LOAD_NUM_CLIENT_TYPES]; /* number of clients by type  */
+    int websocket;                     /* 1 if clients use websocket        */
+    int rate;                          /* messages per second               */
+    int duration;                      /* duration of test (in seconds)     */
+    int size;                          /* size of messages                  */
+    int backlog;                       /* messages sent before clients      */
+    int compress;                      /* lines kept uncompressed in buffer */
+    int port;                          /* first port used                   */
+    char *plugins_dir;                 /* directory with plugins            */
+};
+
+char *relay_load_client_type_string[RELAY_LOAD_NUM_CLIENT_TYPES] =
+{ "weechat", "irc" };
+
+struct t_relay_load_options relay_load_options;
+pid_t relay_load_pid_ircd = 0;
+pid_t *relay_load_pid_clients = NULL;
+int relay_load_num_clients = 0;
+int relay_load_pipe_ready[2] = { -1, -1 };
+int relay_load_clients_ready = 0;
+int relay_load_running = 0;
+int relay_load_error = 0;
+long long relay_load_backlog_min = -1;
+struct rusage relay_load_rusage_start, relay_load_rusage_end;
+long relay_load_rss_start = 0, relay_load_rss_end = 0;
+volatile sig_atomic_t relay_load_signal_start = 0;
+volatile sig_atomic_t relay_load_signal_stop = 0;
+
+
+/*
+ * Returns current time (monotonic clock) in microseconds.
+ */
+
+long long
+relay_load_time_usec ()
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ((long long)ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000);
+}
+
+/*
+ * Returns resident set size of current process (in KB).
+ */
+
+long
+relay_load_rss ()
+{
+    FILE *file;
+    long size, resident;
+    struct rusage usage;
+
+    file = fopen ("/proc/self/statm", "r");
+    if (file)
+    {
+        if (fscanf (file, "%ld %ld", &size, &resident) == 2)
+        {
+            fclose (file);
+            return resident * (sysconf (_SC_PAGESIZE) / 1024);
+        }
+        fclose (file);
+    }
+
+    /* fallback: max RSS */
+    getrusage (RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/*
+ * Callback for signals SIGUSR1 (start) and SIGTERM (stop) in child
+ * processes.
+ */
+
+void
+relay_load_signal_cb (int signo)
+{
+    if (signo == SIGUSR1)
+        relay_load_signal_start = 1;
+    else
+        relay_load_signal_stop = 1;
+}
+
+/*
+ * Closes all file descriptors inherited from parent (in a child process),
+ * except the one given.
+ */
+
+void
+relay_load_close_fds (int fd_keep)
+{
+    int fd, max_fd;
+
+    max_fd = sysconf (_SC_OPEN_MAX);
+    if ((max_fd < 0) || (max_fd > 65536))
+        max_fd = 65536;
+    for (fd = 3; fd < max_fd; fd++)
+    {
+        if (fd != fd_keep)
+            close (fd);
+    }
+}
+
+/*
+ * Searches a string in binary data (data may contain NUL chars).
+ *
+ * Returns pointer to string found, NULL if not found.
+ */
+
+char *
+relay_load_memsearch (const char *data, int length, const char *string,
+                      int length_string)
+{
+    const char *ptr_data, *end;
+
+    if ((length_string <= 0) || (length < length_string))
+        return NULL;
+
+    end = data + length - length_string;
+    for (ptr_data = data; ptr_data <= end; ptr_data++)
+    {
+        ptr_data = memchr (ptr_data, string[0], end - ptr_data + 1);
+        if (!ptr_data)
+            return NULL;
+        if (memcmp (ptr_data, string, length_string) == 0)
+            return (char *)ptr_data;
+    }
+
+    return NULL;
+}
+
+/*
+ * Sends a string on a socket (blocking).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+relay_load_send_all (int sock, const char *data, int length)
+{
+    int num_sent;
+
+    while (length > 0)
+    {
+        num_sent = send (sock, data, length, 0);
+        if (num_sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        data += num_sent;
+        length -= num_sent;
+    }
+
+    return 1;
+}
+
+/*
+ * Connects to a local port.
+ *
+ * Returns socket, -1 if error.
+ */
+
+int
+relay_load_connect (int port)
+{
+    struct sockaddr_in addr;
+    int sock;
+
+    sock = socket (AF_INET, SOCK_STREAM, 0);
+    if (sock < 0)
+        return -1;
+
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons (port);
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+    if (connect (sock, (struct sockaddr *)&addr, sizeof (addr)) < 0)
+    {
+        close (sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+/*
+ * Fake IRC server: sends a line to WeeChat.
+ */
+
+void
+relay_load_ircd_send (int sock, const char *format, ...)
+{
+    va_list args;
+    char buffer[4096];
+    int length;
+
+    va_start (args, format);
+    length = vsnprintf (buffer, sizeof (buffer) - 2, format, args);
+    va_end (args);
+
+    if ((length < 0) || (length > (int)sizeof (buffer) - 3))
+        return;
+    memcpy (buffer + length, "\r\n", 3);
+    relay_load_send_all (sock, buffer, length + 2);
+}
+
+/*
+ * Fake IRC server: reads lines received from WeeChat and answers some
+ * commands.
+ *
+ * Returns:
+ *   1: OK
+ *   0: connection closed
+ */
+
+int
+relay_load_ircd_read (int sock, char *buffer, int *length,
+                      int size, char *nick, int size_nick)
+{
+    char *pos, *line;
+    int num_read, i;
+
+    num_read = recv (sock, buffer + *length, size - *length - 1, 0);
+    if (num_read <= 0)
+        return ((num_read < 0) && (errno == EINTR)) ? 1 : 0;
+    *length += num_read;
+    buffer[*length] = '\0';
+
+    line = buffer;
+    while ((pos = strstr (line, "\r\n")) != NULL)
+    {
+        pos[0] = '\0';
+        if (strncmp (line, "NICK ", 5) == 0)
+        {
+            snprintf (nick, size_nick, "%s", line + 5);
+        }
+        else if (strncmp (line, "USER ", 5) == 0)
+        {
+            relay_load_ircd_send (sock, ":ircd 001 %s :Welcome", nick);
+            relay_load_ircd_send (sock, ":ircd 376 %s :End of MOTD", nick);
+            relay_load_ircd_send (sock, ":%s!load@localhost JOIN :%s",
+                                  nick, RELAY_LOAD_CHANNEL);
+            relay_load_ircd_send (sock, ":ircd 353 %s = %s :%s",
+                                  nick, RELAY_LOAD_CHANNEL, nick);
+            relay_load_ircd_send (sock, ":ircd 366 %s %s :End of /NAMES list.",
+                                  nick, RELAY_LOAD_CHANNEL);
+            for (i = 0; i < relay_load_options.backlog; i++)
+            {
+                relay_load_ircd_send (
+                    sock,
+                    ":user%d!load@localhost PRIVMSG %s :"
+                    RELAY_LOAD_MARKER_BACKLOG "%d: backlog message",
+                    i % 10,
+                    RELAY_LOAD_CHANNEL,
+                    i);
+            }
+        }
+        else if (strncmp (line, "PING ", 5) == 0)
+        {
+            relay_load_ircd_send (sock, "PONG %s", line + 5);
+        }
+        line = pos + 2;
+    }
+    *length -= line - buffer;
+    memmove (buffer, line, *length + 1);
+
+    return 1;
+}
+
+/*
+ * Fake IRC server (child process): accepts connection from WeeChat, then
+ * sends messages at the given rate when signal SIGUSR1 is received.
+ */
+
+void
+relay_load_ircd (int sock_listen)
+{
+    struct pollfd pfd;
+    char buffer[16384], nick[256], *padding;
+    long long start, now, seq, count;
+    int sock, length, timeout;
+
+    sock = accept (sock_listen, NULL, NULL);
+    close (sock_listen);
+    if (sock < 0)
+        _exit (EXIT_FAILURE);
+
+    padding = malloc (relay_load_options.size + 1);
+    if (!padding)
+        _exit (EXIT_FAILURE);
+    memset (padding, 'x', relay_load_options.size);
+    padding[relay_load_options.size] = '\0';
+
+    snprintf (nick, sizeof (nick), "weechat");
+    length = 0;
+    start = 0;
+    seq = 0;
+
+    while (!relay_load_signal_stop)
+    {
+        if (relay_load_signal_start && (start == 0))
+            start = relay_load_time_usec ();
+
+        timeout = 100;
+        if (start > 0)
+        {
+            now = relay_load_time_usec ();
+            if (now - start >= (long long)relay_load_options.duration * 1000000LL)
+            {
+                /* end of test: send the last messages */
+                count = (long long)relay_load_options.rate
+                    * relay_load_options.duration;
+                start = -1;
+            }
+            else
+            {
+                /* send all messages due at this time */
+                count = ((now - start) * relay_load_options.rate) / 1000000LL;
+                timeout = 1;
+            }
+            while (seq < count)
+            {
+                relay_load_ircd_send (
+                    sock,
+                    ":user%lld!load@localhost PRIVMSG %s :"
+                    RELAY_LOAD_MARKER "%lld:%lld: %s",
+                    seq % 10,
+                    RELAY_LOAD_CHANNEL,
+                    seq,
+                    relay_load_time_usec (),
+                    padding);
+                seq++;
+            }
+        }
+
+        pfd.fd = sock;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if ((poll (&pfd, 1, timeout) > 0) && (pfd.revents & POLLIN))
+        {
+            if (!relay_load_ircd_read (sock, buffer, &length, sizeof (buffer),
+                                       nick, sizeof (nick)))
+                break;
+        }
+    }
+
+    free (padding);
+    close (sock);
+    _exit (EXIT_SUCCESS);
+}
+
+/*
+ * Starts the fake IRC server (child process).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+relay_load_ircd_start ()
+{
+    struct sockaddr_in addr;
+    int sock, set;
+
+    sock = socket (AF_INET, SOCK_STREAM, 0);
+    if (sock < 0)
+        return 0;
+    set = 1;
+    setsockopt (sock, SOL_SOCKET, SO_REUSEADDR, &set, sizeof (set));
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons (relay_load_options.port + 2);
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    if ((bind (sock, (struct sockaddr *)&addr, sizeof (addr)) < 0)
+        || (listen (sock, 1) < 0))
+    {
+        fprintf (stderr, "Unable to listen on port %d: %s\n",
+                 relay_load_options.port + 2, strerror (errno));
+        close (sock);
+        return 0;
+    }
+
+    relay_load_pid_ircd = fork ();
+    if (relay_load_pid_ircd < 0)
+    {
+        close (sock);
+        return 0;
+    }
+    if (relay_load_pid_ircd == 0)
+        relay_load_ircd (sock);
+
+    close (sock);
+
+    return 1;
+}
+
+/*
+ * Sends data from a synthetic client to relay (in a websocket frame if
+ * websocket is used).
+ */
+
+void
+relay_load_client_send (int sock, const char *data)
+{
+    unsigned char frame[4096];
+    int length, index;
+
+    length = strlen (data);
+    if (!relay_load_options.websocket)
+    {
+        relay_load_send_all (sock, data, length);
+        return;
+    }
+
+    if (length > (int)sizeof (frame) - 8)
+        return;
+
+    /* text frame, masked with a null mask (so data is unchanged) */
+    frame[0] = 0x81;
+    if (length <= 125)
+    {
+        frame[1] = 0x80 | length;
+        index = 2;
+    }
+    else
+    {
+        frame[1] = 0x80 | 126;
+        frame[2] = (length >> 8) & 0xFF;
+        frame[3] = length & 0xFF;
+        index = 4;
+    }
+    memset (frame + index, 0, 4);
+    index += 4;
+    memcpy (frame + index, data, length);
+    relay_load_send_all (sock, (const char *)frame, index + length);
+}
+
+/*
+ * Adds a latency in statistics.
+ */
+
+void
+relay_load_stats_add_latency (struct t_relay_load_stats *stats,
+                              long long latency)
+{
+    int exponent, index;
+
+    if (latency < 0)
+        latency = 0;
+    if (latency > stats->latency_max)
+        stats->latency_max = latency;
+
+    if (latency < RELAY_LOAD_HIST_SUB)
+        index = latency;
+    else
+    {
+        exponent = 0;
+        while ((latency >> exponent) >= 2 * RELAY_LOAD_HIST_SUB)
+        {
+            exponent++;
+        }
+        index = ((exponent + 1) * RELAY_LOAD_HIST_SUB)
+            + (int)((latency >> exponent) - RELAY_LOAD_HIST_SUB);
+    }
+    if (index >= RELAY_LOAD_HIST_SIZE)
+        index = RELAY_LOAD_HIST_SIZE - 1;
+
+    stats->hist[index]++;
+}
+
+/*
+ * Returns the latency (lower bound, in microseconds) for an index in
+ * histogram.
+ */
+
+long long
+relay_load_stats_hist_value (int index)
+{
+    int exponent;
+
+    if (index < RELAY_LOAD_HIST_SUB)
+        return index;
+
+    exponent = (index / RELAY_LOAD_HIST_SUB) - 1;
+
+    return (long long)(RELAY_LOAD_HIST_SUB + (index % RELAY_LOAD_HIST_SUB))
+        << exponent;
+}
+
+/*
+ * Searches markers in data received by a client and adds latencies in
+ * statistics (and first/last line received in backlog).
+ *
+ * Returns the number of bytes that must be kept for next data received
+ * (incomplete marker at the end of data).
+ */
+
+int
+relay_load_client_parse (struct t_relay_load_stats *stats, char *data,
+                         int length, long long now)
+{
+    char *pos, *pos_end, *error;
+    long long sent, seq;
+
+    data[length] = '\0';
+
+    /* search backlog markers ("BACKLOG:seq:"), lines are sent in order */
+    pos = data;
+    while (1)
+    {
+        pos = relay_load_memsearch (pos, length - (pos - data),
+                                    RELAY_LOAD_MARKER_BACKLOG,
+                                    strlen (RELAY_LOAD_MARKER_BACKLOG));
+        if (!pos)
+            break;
+        pos += strlen (RELAY_LOAD_MARKER_BACKLOG);
+        error = NULL;
+        seq = strtoll (pos, &error, 10);
+        if (!error || (error[0] != ':'))
+            continue;
+        if (stats->backlog_first < 0)
+            stats->backlog_first = seq;
+        if (seq > stats->backlog_last)
+            stats->backlog_last = seq;
+        pos = error;
+    }
+
+    pos = data;
+    while (1)
+    {
+        pos = relay_load_memsearch (pos, length - (pos - data),
+                      RELAY_LOAD_MARKER, strlen (RELAY_LOAD_MARKER));
+        if (!pos)
+            break;
+        /* marker is "LOAD:seq:time:" */
+        pos_end = pos + strlen (RELAY_LOAD_MARKER);
+        pos_end = memchr (pos_end, ':', length - (pos_end - data));
+        if (!pos_end)
+            return length - (pos - data);
+        error = NULL;
+        sent = strtoll (pos_end + 1, &error, 10);
+        if (!error || (error[0] != ':'))
+        {
+            if (error && (error[0] == '\0'))
+                return length - (pos - data);
+            pos = pos_end;
+            continue;
+        }
+        stats->lines++;
+        relay_load_stats_add_latency (stats, now - sent);
+        pos = error;
+    }
+
+    /* keep the end of data (beginning of a marker may be there) */
+    return (length > 32) ? 32 : length;
+}
+
+/*
+ * Synthetic relay client (child process): connects to relay, receives data
+ * until signal SIGTERM is received, then writes statistics in a file.
+ */
+
+void
+relay_load_client (int type, int number)
+{
+    struct t_relay_load_stats stats;
+    struct pollfd pfd;
+    char buffer[65536 + 64], str_data[1024], *pos;
+    int sock, length, keep, num_read, ready, handshake_done;
+    FILE *file;
+
+    relay_load_close_fds (relay_load_pipe_ready[1]);
+
+    memset (&stats, 0, sizeof (stats));
+    stats.backlog_first = -1;
+    stats.backlog_last = -1;
+
+    sock = relay_load_connect (relay_load_options.port + type);
+    if (sock < 0)
+        _exit (EXIT_FAILURE);
+
+    handshake_done = !relay_load_options.websocket;
+    if (relay_load_options.websocket)
+    {
+        snprintf (str_data, sizeof (str_data),
+                  "GET /weechat HTTP/1.1\r\n"
+                  "Host: localhost\r\n"
+                  "Upgrade: websocket\r\n"
+                  "Connection: Upgrade\r\n"
+                  "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                  "Sec-WebSocket-Version: 13\r\n"
+                  "\r\n");
+        relay_load_send_all (sock, str_data, strlen (str_data));
+    }
+    else
+    {
+        if (type == RELAY_LOAD_CLIENT_WEECHAT)
+        {
+            relay_load_client_send (
+                sock,
+                "init password=" RELAY_LOAD_PASSWORD ",compression=off\n"
+                "sync\n"
+                "(ready) info version\n");
+        }
+        else
+        {
+            snprintf (str_data, sizeof (str_data),
+                      "PASS " RELAY_LOAD_PASSWORD "\r\n"
+                      "NICK load%d\r\n"
+                      "USER load%d 0 * :load\r\n",
+                      number, number);
+            relay_load_client_send (sock, str_data);
+        }
+    }
+
+    ready = 0;
+    length = 0;
+    while (!relay_load_signal_stop)
+    {
+        pfd.fd = sock;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll (&pfd, 1, 100) <= 0)
+            continue;
+        num_read = recv (sock, buffer + length,
+                         sizeof (buffer) - length - 1, 0);
+        if (num_read <= 0)
+        {
+            if ((num_read < 0) && (errno == EINTR))
+                continue;
+            break;
+        }
+        if (ready)
+            stats.bytes += num_read;
+        length += num_read;
+        buffer[length] = '\0';
+
+        if (!handshake_done)
+        {
+            pos = strstr (buffer, "\r\n\r\n");
+            if (!pos)
+                continue;
+            handshake_done = 1;
+            length -= pos + 4 - buffer;
+            memmove (buffer, pos + 4, length + 1);
+            if (type == RELAY_LOAD_CLIENT_WEECHAT)
+            {
+                relay_load_client_send (
+                    sock,
+                    "init password=" RELAY_LOAD_PASSWORD ",compression=off\n");
+                relay_load_client_send (sock, "sync\n");
+                relay_load_client_send (sock, "(ready) info version\n");
+            }
+            else
+            {
+                relay_load_client_send (sock,
+                                        "PASS " RELAY_LOAD_PASSWORD "\r\n");
+                snprintf (str_data, sizeof (str_data), "NICK load%d\r\n",
+                          number);
+                relay_load_client_send (sock, str_data);
+                snprintf (str_data, sizeof (str_data),
+                          "USER load%d 0 * :load\r\n", number);
+                relay_load_client_send (sock, str_data);
+            }
+        }
+
+        if (!ready)
+        {
+            pos = relay_load_memsearch (
+                buffer, length,
+                (type == RELAY_LOAD_CLIENT_WEECHAT) ? "ready" : " 366 ", 5);
+            if (pos)
+            {
+                /* keep data after the marker (backlog may be there) */
+                ready = 1;
+                length -= pos + 5 - buffer;
+                memmove (buffer, pos + 5, length + 1);
+                if (write (relay_load_pipe_ready[1], "R", 1) != 1)
+                    break;
+            }
+            else
+            {
+                if (length > 32)
+                {
+                    memmove (buffer, buffer + length - 32, 32);
+                    length = 32;
+                }
+                continue;
+            }
+        }
+
+        keep = relay_load_client_parse (&stats, buffer, length,
+                                        relay_load_time_usec ());
+        memmove (buffer, buffer + length - keep, keep);
+        length = keep;
+    }
+
+    close (sock);
+
+    snprintf (str_data, sizeof (str_data), "%s/client_%d.stats",
+              RELAY_LOAD_DIR, number);
+    file = fopen (str_data, "wb");
+    if (file)
+    {
+        if (fwrite (&stats, sizeof (stats), 1, file) != 1)
+            stats.lines = 0;
+        fclose (file);
+    }
+
+    _exit (EXIT_SUCCESS);
+}
+
+/*
+ * Starts synthetic clients (child processes).
+ */
+
+void
+relay_load_clients_start ()
+{
+    int i, type, number;
+    pid_t pid;
+
+    relay_load_num_clients = relay_load_options.clients[0]
+        + relay_load_options.clients[1];
+    relay_load_pid_clients = calloc (relay_load_num_clients,
+                                     sizeof (*relay_load_pid_clients));
+    if (!relay_load_pid_clients)
+        return;
+
+    number = 0;
+    for (type = 0; type < RELAY_LOAD_NUM_CLIENT_TYPES; type++)
+    {
+        for (i = 0; i < relay_load_options.clients[type]; i++)
+        {
+            pid = fork ();
+            if (pid == 0)
+                relay_load_client (type, number);
+            relay_load_pid_clients[number] = pid;
+            number++;
+        }
+    }
+}
+
+/*
+ * Stops synthetic clients and reads their statistics.
+ */
+
+void
+relay_load_clients_stop (struct t_relay_load_stats *stats)
+{
+    struct t_relay_load_stats client_stats;
+    char filename[PATH_MAX];
+    FILE *file;
+    long long backlog;
+    int i, j, type;
+
+    for (i = 0; i < relay_load_num_clients; i++)
+    {
+        if (relay_load_pid_clients[i] > 0)
+            kill (relay_load_pid_clients[i], SIGTERM);
+    }
+    for (i = 0; i < relay_load_num_clients; i++)
+    {
+        if (relay_load_pid_clients[i] > 0)
+            waitpid (relay_load_pid_clients[i], NULL, 0);
+    }
+
+    for (i = 0; i < relay_load_num_clients; i++)
+    {
+        type = (i < relay_load_options.clients[0]) ?
+            RELAY_LOAD_CLIENT_WEECHAT : RELAY_LOAD_CLIENT_IRC;
+        snprintf (filename, sizeof (filename), "%s/client_%d.stats",
+                  RELAY_LOAD_DIR, i);
+        file = fopen (filename, "rb");
+        if (!file)
+            continue;
+        if (fread (&client_stats, sizeof (client_stats), 1, file) == 1)
+        {
+            stats[type].lines += client_stats.lines;
+            stats[type].bytes += client_stats.bytes;
+            if (client_stats.latency_max > stats[type].latency_max)
+                stats[type].latency_max = client_stats.latency_max;
+            for (j = 0; j < RELAY_LOAD_HIST_SIZE; j++)
+            {
+                stats[type].hist[j] += client_stats.hist[j];
+            }
+            if (type == RELAY_LOAD_CLIENT_IRC)
+            {
+                backlog = (client_stats.backlog_first == 0) ?
+                    client_stats.backlog_last + 1 : 0;
+                if ((relay_load_backlog_min < 0)
+                    || (backlog < relay_load_backlog_min))
+                {
+                    relay_load_backlog_min = backlog;
+                }
+            }
+        }
+        fclose (file);
+        unlink (filename);
+    }
+}
+
+/*
+ * Returns a percentile of latency (in milliseconds).
+ */
+
+double
+relay_load_stats_percentile (struct t_relay_load_stats *stats,
+                             double percentile)
+{
+    long long target, count;
+    int i;
+
+    if (stats->lines == 0)
+        return 0;
+
+    target = (long long)((stats->lines * percentile) / 100.0);
+    if (target >= stats->lines)
+        target = stats->lines - 1;
+
+    count = 0;
+    for (i = 0; i < RELAY_LOAD_HIST_SIZE; i++)
+    {
+        count += stats->hist[i];
+        if (count > target)
+            return relay_load_stats_hist_value (i) / 1000.0;
+    }
+
+    return stats->latency_max / 1000.0;
+}
+
+/*
+ * Displays report.
+ */
+
+void
+relay_load_report (struct t_relay_load_stats *stats)
+{
+    long long expected;
+    double cpu, elapsed;
+    int type;
+
+    expected = (long long)relay_load_options.rate * relay_load_options.duration;
+    elapsed = relay_load_options.duration + RELAY_LOAD_DRAIN_DELAY;
+
+    printf ("\n");
+    printf ("Relay load test: %d weechat client(s), %d irc client(s)%s\n",
+            relay_load_options.clients[RELAY_LOAD_CLIENT_WEECHAT],
+            relay_load_options.clients[RELAY_LOAD_CLIENT_IRC],
+            (relay_load_options.websocket) ? " (websocket)" : "");
+    printf ("Messages sent: %lld (%d/s during %d s, %d bytes of text)\n",
+            expected, relay_load_options.rate, relay_load_options.duration,
+            relay_load_options.size);
+    printf ("\n");
+    printf ("%-8s %8s %7s %10s %9s %9s %9s %9s %9s\n",
+            "protocol", "clients", "lines%", "bytes/line",
+            "p50 (ms)", "p90 (ms)", "p99 (ms)", "p99.9(ms)", "max (ms)");
+    for (type = 0; type < RELAY_LOAD_NUM_CLIENT_TYPES; type++)
+    {
+        if (relay_load_options.clients[type] == 0)
+            continue;
+        printf ("%-8s %8d %6.1f%% %10.1f %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+                relay_load_client_type_string[type],
+                relay_load_options.clients[type],
+                (expected > 0) ?
+                (100.0 * stats[type].lines) / (expected * relay_load_options.clients[type]) : 0,
+                (stats[type].lines > 0) ?
+                (double)stats[type].bytes / stats[type].lines : 0,
+                relay_load_stats_percentile (&stats[type], 50),
+                relay_load_stats_percentile (&stats[type], 90),
+                relay_load_stats_percentile (&stats[type], 99),
+                relay_load_stats_percentile (&stats[type], 99.9),
+                stats[type].latency_max / 1000.0);
+    }
+
+    cpu = (relay_load_rusage_end.ru_utime.tv_sec - relay_load_rusage_start.ru_utime.tv_sec)
+        + ((relay_load_rusage_end.ru_utime.tv_usec - relay_load_rusage_start.ru_utime.tv_usec) / 1000000.0)
+        + (relay_load_rusage_end.ru_stime.tv_sec - relay_load_rusage_start.ru_stime.tv_sec)
+        + ((relay_load_rusage_end.ru_stime.tv_usec - relay_load_rusage_start.ru_stime.tv_usec) / 1000000.0);
+    printf ("\n");
+    printf ("WeeChat CPU: %.3f s (%.1f%% of one core), %.2f ms per client\n",
+            cpu,
+            (elapsed > 0) ? (100.0 * cpu) / elapsed : 0,
+            (relay_load_num_clients > 0) ?
+            (cpu * 1000.0) / relay_load_num_clients : 0);
+    printf ("WeeChat memory (RSS): %ld KB -> %ld KB (%+ld KB)\n",
+            relay_load_rss_start, relay_load_rss_end,
+            relay_load_rss_end - relay_load_rss_start);
+
+    if ((relay_load_options.backlog > 0)
+        && (relay_load_options.clients[RELAY_LOAD_CLIENT_IRC] > 0))
+    {
+        printf ("Backlog: %lld/%d lines received by each irc client "
+                "(lines kept uncompressed: %d)\n",
+                relay_load_backlog_min, relay_load_options.backlog,
+                relay_load_options.compress);
+        if (relay_load_backlog_min != relay_load_options.backlog)
+        {
+            fprintf (stderr, "Error: backlog is incomplete\n");
+            relay_load_error = 1;
+        }
+    }
+}
+
+/*
+ * Callback for timer: end of test.
+ */
+
+int
+relay_load_timer_end_cb (const void *pointer, void *data, int remaining_calls)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) remaining_calls;
+
+    getrusage (RUSAGE_SELF, &relay_load_rusage_end);
+    relay_load_rss_end = relay_load_rss ();
+
+    weechat_quit = 1;
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Callback for data on pipe "ready": a client is ready, start the test when
+ * all clients are ready.
+ */
+
+int
+relay_load_fd_ready_cb (const void *pointer, void *data, int fd)
+{
+    char buffer[256];
+    int num_read;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+
+    num_read = read (fd, buffer, sizeof (buffer));
+    if (num_read > 0)
+        relay_load_clients_ready += num_read;
+
+    if (!relay_load_running
+        && (relay_load_clients_ready >= relay_load_num_clients))
+    {
+        relay_load_running = 1;
+        printf ("All clients are ready, sending messages during %d s...\n",
+                relay_load_options.duration);
+        getrusage (RUSAGE_SELF, &relay_load_rusage_start);
+        relay_load_rss_start = relay_load_rss ();
+        kill (relay_load_pid_ircd, SIGUSR1);
+        /* wait a few more seconds to receive the last messages */
+        hook_timer (NULL,
+                    (relay_load_options.duration + RELAY_LOAD_DRAIN_DELAY) * 1000,
+                    0, 1,
+                    &relay_load_timer_end_cb, NULL, NULL);
+    }
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Callback for timer: waits until WeeChat has joined the channel, then
+ * starts the clients.
+ */
+
+int
+relay_load_timer_wait_cb (const void *pointer, void *data, int remaining_calls)
+{
+    struct t_gui_buffer *ptr_buffer;
+    char name[256], marker[64];
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+
+    if (relay_load_pid_clients)
+    {
+        /* clients started but not all ready */
+        if (!relay_load_running && (remaining_calls == 0))
+        {
+            fprintf (stderr, "Timeout: only %d/%d clients are ready\n",
+                     relay_load_clients_ready, relay_load_num_clients);
+            relay_load_error = 1;
+            weechat_quit = 1;
+        }
+        return WEECHAT_RC_OK;
+    }
+
+    snprintf (name, sizeof (name), "irc.load.%s", RELAY_LOAD_CHANNEL);
+    ptr_buffer = gui_buffer_search_by_full_name (name);
+
+    /* wait for the last message sent before clients (backlog) */
+    if (ptr_buffer && (relay_load_options.backlog > 0))
+    {
+        snprintf (marker, sizeof (marker), RELAY_LOAD_MARKER_BACKLOG "%d:",
+                  relay_load_options.backlog - 1);
+        if (!ptr_buffer->own_lines->last_line
+            || !ptr_buffer->own_lines->last_line->data->message
+            || !strstr (ptr_buffer->own_lines->last_line->data->message,
+                        marker))
+        {
+            ptr_buffer = NULL;
+        }
+    }
+
+    if (ptr_buffer)
+    {
+        printf ("WeeChat has joined %s, starting %d client(s)...\n",
+                RELAY_LOAD_CHANNEL,
+                relay_load_options.clients[0] + relay_load_options.clients[1]);
+        relay_load_clients_start ();
+    }
+    else if (remaining_calls == 0)
+    {
+        fprintf (stderr, "Timeout: WeeChat has not joined %s\n",
+                 RELAY_LOAD_CHANNEL);
+        relay_load_error = 1;
+        weechat_quit = 1;
+    }
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Initializes GUI (Curses library is not used, calls are made with the fake
+ * ncurses library).
+ */
+
+void
+relay_load_gui_init ()
+{
+    gui_main_init ();
+}
+
+/*
+ * Displays help.
+ */
+
+void
+relay_load_help (const char *name)
+{
+    printf ("Usage: %s [options]\n"
+            "\n"
+            "Load test of relay plugin: WeeChat is connected to a fake IRC "
+            "server which sends\n"
+            "messages in a channel, synthetic clients receive them with "
+            "relay.\n"
+            "\n"
+            "  -c, --weechat <n>      number of clients with weechat "
+            "protocol (default: 10)\n"
+            "  -i, --irc <n>          number of clients with irc "
+            "protocol (default: 0)\n"
+            "  -w, --websocket        clients use websocket\n"
+            "  -r, --rate <n>         messages per second (default: 100)\n"
+            "  -d, --duration <n>     duration in seconds (default: 10)\n"
+            "  -s, --size <n>         size of messages (default: 100)\n"
+            "  -b, --backlog <n>      messages sent before clients "
+            "connect, irc clients must\n"
+            "                         receive them in backlog (default: 0, "
+            "max: %d)\n"
+            "  -z, --compress <n>     lines kept uncompressed in buffer, "
+            "older lines are\n"
+            "                         compressed (default: 0 = no "
+            "compression)\n"
+            "  -p, --port <n>         ports used: n (weechat), n+1 (irc), "
+            "n+2 (fake IRC server)\n"
+            "                         (default: 19000)\n"
+            "  -P, --plugins <dir>    directory with irc/irc.so and "
+            "relay/relay.so\n"
+            "                         (default: %s)\n"
+            "  -h, --help             display this help\n",
+            name, RELAY_LOAD_BACKLOG_MAX, RELAY_LOAD_PLUGINS_DIR);
+}
+
+/*
+ * Parses command line arguments.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error or help displayed
+ */
+
+int
+relay_load_parse_args (int argc, char *argv[])
+{
+    struct option long_options[] = {
+        { "weechat",   required_argument, NULL, 'c' },
+        { "irc",       required_argument, NULL, 'i' },
+        { "websocket", no_argument,       NULL, 'w' },
+        { "rate",      required_argument, NULL, 'r' },
+        { "duration",  required_argument, NULL, 'd' },
+        { "size",      required_argument, NULL, 's' },
+        { "backlog",   required_argument, NULL, 'b' },
+        { "compress",  required_argument, NULL, 'z' },
+        { "port",      required_argument, NULL, 'p' },
+        { "plugins",   required_argument, NULL, 'P' },
+        { "help",      no_argument,       NULL, 'h' },
+        { NULL,        0,                 NULL, 0   },
+    };
+    int opt;
+
+    relay_load_options.clients[RELAY_LOAD_CLIENT_WEECHAT] = 10;
+    relay_load_options.clients[RELAY_LOAD_CLIENT_IRC] = 0;
+    relay_load_options.websocket = 0;
+    relay_load_options.rate = 100;
+    relay_load_options.duration = 10;
+    relay_load_options.size = 100;
+    relay_load_options.backlog = 0;
+    relay_load_options.compress = 0;
+    relay_load_options.port = 19000;
+    relay_load_options.plugins_dir = RELAY_LOAD_PLUGINS_DIR;
+
+    while ((opt = getopt_long (argc, argv, "c:i:wr:d:s:b:z:p:P:h",
+                               long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+            case 'c':
+                relay_load_options.clients[RELAY_LOAD_CLIENT_WEECHAT] = atoi (optarg);
+                break;
+            case 'i':
+                relay_load_options.clients[RELAY_LOAD_CLIENT_IRC] = atoi (optarg);
+                break;
+            case 'w':
+                relay_load_options.websocket = 1;
+                break;
+            case 'r':
+                relay_load_options.rate = atoi (optarg);
+                break;
+            case 'd':
+                relay_load_options.duration = atoi (optarg);
+                break;
+            case 's':
+                relay_load_options.size = atoi (optarg);
+                break;
+            case 'b':
+                relay_load_options.backlog = atoi (optarg);
+                break;
+            case 'z':
+                relay_load_options.compress = atoi (optarg);
+                break;
+            case 'p':
+                relay_load_options.port = atoi (optarg);
+                break;
+            case 'P':
+                relay_load_options.plugins_dir = optarg;
+                break;
+            default:
+                relay_load_help (argv[0]);
+                return 0;
+        }
+    }
+
+    if ((relay_load_options.clients[0] < 0)
+        || (relay_load_options.clients[1] < 0)
+        || (relay_load_options.clients[0] + relay_load_options.clients[1] <= 0)
+        || (relay_load_options.rate <= 0)
+        || (relay_load_options.duration <= 0)
+        || (relay_load_options.size < 0)
+        || (relay_load_options.size > 400)
+        || (relay_load_options.backlog < 0)
+        || (relay_load_options.backlog > RELAY_LOAD_BACKLOG_MAX)
+        || (relay_load_options.compress < 0)
+        || (relay_load_options.port <= 0)
+        || (relay_load_options.port > 65533))
+    {
+        fprintf (stderr, "Invalid arguments (see %s --help)\n", argv[0]);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Runs WeeChat commands to load plugins, connect to the fake IRC server and
+ * add relays.
+ */
+
+void
+relay_load_setup_weechat ()
+{
+    struct t_gui_buffer *ptr_buffer;
+    char command[PATH_MAX + 64];
+
+    ptr_buffer = gui_buffer_search_main ();
+
+    snprintf (command, sizeof (command), "/plugin load %s/irc/irc.so",
+              relay_load_options.plugins_dir);
+    input_data (ptr_buffer, command);
+    snprintf (command, sizeof (command), "/plugin load %s/relay/relay.so",
+              relay_load_options.plugins_dir);
+    input_data (ptr_buffer, command);
+
+    input_data (ptr_buffer,
+                "/set relay.network.password \"" RELAY_LOAD_PASSWORD "\"");
+    input_data (ptr_buffer, "/set relay.network.max_clients 0");
+    snprintf (command, sizeof (command),
+              "/set relay.irc.backlog_max_number %d",
+              relay_load_options.backlog);
+    input_data (ptr_buffer, command);
+    input_data (ptr_buffer, "/set relay.irc.backlog_max_minutes 0");
+    input_data (ptr_buffer, "/set relay.irc.backlog_since_last_disconnect off");
+    snprintf (command, sizeof (command),
+              "/set weechat.history.compress_buffer_lines_number %d",
+              relay_load_options.compress);
+    input_data (ptr_buffer, command);
+    snprintf (command, sizeof (command), "/relay add weechat %d",
+              relay_load_options.port);
+    input_data (ptr_buffer, command);
+    snprintf (command, sizeof (command), "/relay add irc.load %d",
+              relay_load_options.port + 1);
+    input_data (ptr_buffer, command);
+
+    snprintf (command, sizeof (command),
+              "/server add load 127.0.0.1/%d -nicks=weechat -autojoin="
+              RELAY_LOAD_CHANNEL,
+              relay_load_options.port + 2);
+    input_data (ptr_buffer, command);
+    input_data (ptr_buffer, "/connect load");
+}
+
+/*
+ * Main loop: executes timers and file descriptors hooks until the end of
+ * test.
+ */
+
+void
+relay_load_main_loop ()
+{
+    while (!weechat_quit)
+    {
+        hook_timer_exec ();
+        hook_fd_exec ();
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+    struct t_relay_load_stats stats[RELAY_LOAD_NUM_CLIENT_TYPES];
+    struct sigaction action;
+    char *weechat_argv[5];
+
+    if (!relay_load_parse_args (argc, argv))
+        return 1;
+
+    /* setup environment: English language, no specific timezone */
+    setenv ("LC_ALL", "en_US.UTF-8", 1);
+    setenv ("TZ", "", 1);
+
+    /* signals used by child processes */
+    memset (&action, 0, sizeof (action));
+    action.sa_handler = &relay_load_signal_cb;
+    sigaction (SIGUSR1, &action, NULL);
+
+    if (pipe (relay_load_pipe_ready) < 0)
+        return 1;
+
+    if (!relay_load_ircd_start ())
+        return 1;
+
+    /* init WeeChat (without plugins, they are loaded later) */
+    weechat_argv[0] = argv[0];
+    weechat_argv[1] = "--dir";
+    weechat_argv[2] = RELAY_LOAD_DIR;
+    weechat_argv[3] = "--no-plugin";
+    weechat_argv[4] = NULL;
+    weechat_init (4, weechat_argv, &relay_load_gui_init);
+
+    /* WeeChat catches SIGTERM: restore our handler for child processes */
+    sigaction (SIGTERM, &action, NULL);
+
+    relay_load_setup_weechat ();
+
+    hook_fd (NULL, relay_load_pipe_ready[0], 1, 0, 0,
+             &relay_load_fd_ready_cb, NULL, NULL);
+    hook_timer (NULL, 100, 0, RELAY_LOAD_READY_TIMEOUT * 10,
+                &relay_load_timer_wait_cb, NULL, NULL);
+
+    relay_load_main_loop ();
+
+    memset (stats, 0, sizeof (stats));
+    if (relay_load_pid_clients)
+        relay_load_clients_stop (stats);
+    kill (relay_load_pid_ircd, SIGTERM);
+    waitpid (relay_load_pid_ircd, NULL, 0);
+
+    if (!relay_load_error)
+        relay_load_report (stats);
+
+    weechat_end (&gui_main_end);
+
+    return (relay_load_error) ? 1 : 0;
+}
@@ -449,3 +449,79 @@ TEST(Eval, EvalReplaceRegex)
     hashtable_free (extra_vars);
     hashtable_free (options);
 }
+
+/*
+ * Tests functions:
+ *   eval_compile
+ *   eval_compiled_exec
+ *   eval_compiled_free
+ */
+
+TEST(Eval, EvalCompiled)
+{
+    struct t_hashtable *pointers, *extra_vars, *options;
+    struct t_eval_compiled *compiled;
+    char *value;
+
+    pointers = NULL;
+
+    extra_vars = hashtable_new (32,
+                                WEECHAT_HASHTABLE_STRING,
+                                WEECHAT_HASHTABLE_STRING,
+                                NULL, NULL);
+    CHECK(extra_vars);
+
+    options = hashtable_new (32,
+                             WEECHAT_HASHTABLE_STRING,
+                             WEECHAT_HASHTABLE_STRING,
+                             NULL, NULL);
+    CHECK(options);
+
+    POINTERS_EQUAL(NULL, eval_compile (NULL, NULL));
+    POINTERS_EQUAL(NULL, eval_compiled_exec (NULL, NULL, NULL));
+    eval_compiled_free (NULL);
+
+    /* compiled expression evaluated with different extra variables */
+    compiled = eval_compile ("${test}: ${if:${test}==abc?yes:no}${esc:\\t}",
+                             NULL);
+    CHECK(compiled);
+    hashtable_set (extra_vars, "test", "abc");
+    value = eval_compiled_exec (compiled, NULL, extra_vars);
+    STRCMP_EQUAL("abc: yes\t", value);
+    free (value);
+    hashtable_set (extra_vars, "test", "def");
+    value = eval_compiled_exec (compiled, NULL, extra_vars);
+    STRCMP_EQUAL("def: no\t", value);
+    free (value);
+    eval_compiled_free (compiled);
+
+    /* compiled condition with a regex built with variables */
+    hashtable_set (options, "type", "condition");
+    compiled = eval_compile ("abc =~ ^${test} && (1 == 1 || 1 == 0)", options);
+    CHECK(compiled);
+    hashtable_set (extra_vars, "test", "a");
+    value = eval_compiled_exec (compiled, NULL, extra_vars);
+    STRCMP_EQUAL("1", value);
+    free (value);
+    hashtable_set (extra_vars, "test", "b");
+    value = eval_compiled_exec (compiled, NULL, extra_vars);
+    STRCMP_EQUAL("0", value);
+    free (value);
+    hashtable_set (extra_vars, "test", "(");
+    value = eval_compiled_exec (compiled, NULL, extra_vars);
+    STRCMP_EQUAL("0", value);
+    free (value);
+    eval_compiled_free (compiled);
+
+    /* same expression evaluated many times (compiled expression in cache) */
+    hashtable_set (extra_vars, "test", "a");
+    WEE_CHECK_EVAL("1", "${test} == a");
+    WEE_CHECK_EVAL("1", "${test} == a");
+    hashtable_set (extra_vars, "test", "b");
+    WEE_CHECK_EVAL("0", "${test} == a");
+    hashtable_remove (options, "type");
+    WEE_CHECK_EVAL("b == a", "${test} == a");
+
+    hashtable_free (extra_vars);
+    hashtable_free (options);
+}
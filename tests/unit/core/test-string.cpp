@@ -46,7 +46,10 @@ extern "C"
     LONGS_EQUAL(__result, string_is_word_char_highlight (__str));       \
     LONGS_EQUAL(__result, string_is_word_char_input (__str));
 #define WEE_HAS_HL_STR(__result, __str, __words)                        \
-    LONGS_EQUAL(__result, string_has_highlight (__str, __words));
+    LONGS_EQUAL(__result, string_has_highlight (__str, __words));       \
+    highlight = string_highlight_compile (__words);                     \
+    LONGS_EQUAL(__result, string_highlight_match (highlight, __str));   \
+    string_highlight_free (highlight);
 
 #define WEE_HAS_HL_REGEX(__result_regex, __result_hl, __str, __regex)   \
     LONGS_EQUAL(__result_hl,                                            \
@@ -616,11 +619,15 @@ TEST(String, Regex)
  *   string_has_highlight
  *   string_has_highlight_regex_compiled
  *   string_has_highlight_regex
+ *   string_highlight_compile
+ *   string_highlight_match
+ *   string_highlight_free
  */
 
 TEST(String, Highlight)
 {
     regex_t regex;
+    struct t_string_highlight *highlight;
 
     /* check highlight with a string */
     WEE_HAS_HL_STR(0, NULL, NULL);
@@ -640,6 +647,22 @@ TEST(String, Highlight)
     WEE_HAS_HL_STR(1, "test\u00A0:here", "test");  /* unbreakable space */
     WEE_HAS_HL_STR(1, "this is a test here", "test");
     WEE_HAS_HL_STR(1, "this is a test here", "abc,test");
+    WEE_HAS_HL_STR(1, "this is a TEST here", "abc,test");
+    WEE_HAS_HL_STR(0, "this is a TEST here", "abc,(?-i)test");
+    WEE_HAS_HL_STR(1, "this is a test here", "abc,(?-i)test");
+    WEE_HAS_HL_STR(1, "this is a TEST here", "(?-i)abc,TEST");
+    WEE_HAS_HL_STR(0, "testing here", "test");
+    WEE_HAS_HL_STR(1, "testing here", "test*");
+    WEE_HAS_HL_STR(0, "testing here", "*test");
+    WEE_HAS_HL_STR(1, "unittest here", "*test");
+    WEE_HAS_HL_STR(1, "unittesting here", "*test*");
+    WEE_HAS_HL_STR(0, "aaa", "*aa");
+    WEE_HAS_HL_STR(1, "aa aaa", "*aa");
+    WEE_HAS_HL_STR(1, "she is here", "he,she");
+    WEE_HAS_HL_STR(1, "the hero", "he,hero");
+    WEE_HAS_HL_STR(0, "the heros", "he,hero");
+    WEE_HAS_HL_STR(1, "the heros", "he,hero*");
+    WEE_HAS_HL_STR(0, "x", "*,**");
 
     /*
      * check highlight with a regex, each call of macro